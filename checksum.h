@@ -0,0 +1,26 @@
+/**
+ * checksum.h
+ */
+
+#ifndef GRAPHICS_UTILS_CHECKSUM_H
+#define GRAPHICS_UTILS_CHECKSUM_H
+
+#include <stddef.h>
+
+/** continues the crc32 of png chunks and gzip, using carry-less multiplication where the cpu supports it
+ *	@param		t_crc - the crc32 of the preceding bytes, or 0 to begin
+ *	@param		t_data - the bytes to continue with
+ *	@param		t_size - the number of bytes
+ *	@returns	the crc32 of the preceding bytes followed by t_data
+ */
+unsigned int checksum_crc32(unsigned int t_crc, const unsigned char* t_data, size_t t_size);
+
+/** continues the adler32 of zlib streams, using ssse3 or avx2 where the cpu supports it
+ *	@param		t_adler - the adler32 of the preceding bytes, or 1 to begin
+ *	@param		t_data - the bytes to continue with
+ *	@param		t_size - the number of bytes
+ *	@returns	the adler32 of the preceding bytes followed by t_data
+ */
+unsigned int checksum_adler32(unsigned int t_adler, const unsigned char* t_data, size_t t_size);
+
+#endif
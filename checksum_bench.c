@@ -0,0 +1,105 @@
+/**
+ * checksum_bench.c
+ *
+ * a standalone micro-benchmark of checksum.c against the byte at a time crc32 and scalar adler32 it replaced,
+ * it is not part of the library and is built on its own, e.g. cc -O2 checksum_bench.c checksum.c simd.c
+ */
+
+#include "checksum.h"
+#include "simd.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define CHECKSUM_BENCH_TOTAL (256u << 20)
+
+static unsigned int checksum_bench_table[256];
+
+static unsigned int checksum_bench_crc32(unsigned int t_crc, const unsigned char* t_data, size_t t_size) {
+
+	size_t i;
+	t_crc = ~t_crc;
+	for (i = 0; i < t_size; ++i) {
+
+		t_crc = checksum_bench_table[(t_crc ^ t_data[i]) & 0xff] ^ (t_crc >> 8);
+	}
+	return ~t_crc;
+}
+
+static unsigned int checksum_bench_adler32(unsigned int t_adler, const unsigned char* t_data, size_t t_size) {
+
+	unsigned int s1 = t_adler & 0xffff, s2 = t_adler >> 16;
+	while (t_size) {
+
+		/* 5552 is the most bytes that can be summed before s2 overflows */
+		size_t amount = t_size > 5552 ? 5552 : t_size;
+		t_size -= amount;
+		while (amount--) {
+
+			s1 += *t_data++;
+			s2 += s1;
+		}
+		s1 %= 65521;
+		s2 %= 65521;
+	}
+	return (s2 << 16) | s1;
+}
+
+typedef unsigned int (*checksum_bench_function)(unsigned int t_initial, const unsigned char* t_data, size_t t_size);
+
+/* runs t_function over CHECKSUM_BENCH_TOTAL bytes in t_size passes, prints its throughput and returns its last result */
+static unsigned int checksum_bench_run(const char* t_name, checksum_bench_function t_function, unsigned int t_initial, const unsigned char* t_data, size_t t_size) {
+
+	size_t passes = CHECKSUM_BENCH_TOTAL / t_size, i;
+	unsigned int result = 0;
+	clock_t start = clock();
+	for (i = 0; i < passes; ++i) {
+
+		result = t_function(t_initial, t_data, t_size);
+	}
+	double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+	printf("%-16s %8.2f GB/s\n", t_name, seconds > 0.0 ? (double)t_size * passes / seconds / 1e9 : 0.0);
+	return result;
+}
+
+int main(int argc, char** argv) {
+
+	size_t size = argc > 1 ? (size_t)strtoul(argv[1], 0, 10) : (1u << 20), i;
+	unsigned int features = simd_get_features(), k;
+	if (!size || size > CHECKSUM_BENCH_TOTAL) {
+
+		fprintf(stderr, "usage: %s [bytes, at most %u]\n", argv[0], CHECKSUM_BENCH_TOTAL);
+		return 1;
+	}
+	unsigned char* data = malloc(size);
+	if (!data) {
+
+		return 1;
+	}
+	for (i = 0; i < 256; ++i) {
+
+		unsigned int crc = (unsigned int)i;
+		for (k = 0; k < 8; ++k) {
+
+			crc = crc & 1 ? (crc >> 1) ^ 0xedb88320u : crc >> 1;
+		}
+		checksum_bench_table[i] = crc;
+	}
+	for (i = 0; i < size; ++i) {
+
+		data[i] = (unsigned char)((i * 2654435761u) >> 24);
+	}
+
+	printf("%zu bytes, ssse3 %d, avx2 %d, pclmul %d\n", size, !!(features & SIMD_FEATURE_SSSE3), !!(features & SIMD_FEATURE_AVX2), !!(features & SIMD_FEATURE_PCLMUL));
+	int mismatch = checksum_bench_run("crc32 byte", checksum_bench_crc32, 0, data, size)
+		!= checksum_bench_run("crc32", checksum_crc32, 0, data, size);
+	mismatch |= checksum_bench_run("adler32 scalar", checksum_bench_adler32, 1, data, size)
+		!= checksum_bench_run("adler32", checksum_adler32, 1, data, size);
+	if (mismatch) {
+
+		fprintf(stderr, "checksums differ from the reference\n");
+	}
+	free(data);
+	return mismatch;
+}
@@ -0,0 +1,413 @@
+#include "fbx_animation.h"
+
+#include "simd.h"
+
+#include "assert.h"
+#include "stdlib.h"
+#include "string.h"
+
+#define FBX_ANIMATION_QUANTIZED_RANGE 65535.0f
+#define FBX_ANIMATION_SAMPLE_GRAIN 1024
+
+typedef struct
+{
+	fbx_animation* animation;
+	fbx* fbx;
+	fbx_node_record** curves;
+	unsigned int* raw_offsets;
+	float tolerance;
+	int is_failed;
+} fbx_animation_extract_context;
+
+/* greedily keeps the fewest keys such that every removed key lies within tolerance of the line between its kept neighbours */
+static unsigned int fbx_animation_reduce_keys(const double* t_times, const float* t_values, unsigned int t_count, float t_tolerance, unsigned char* t_out_keep)
+{
+	unsigned int anchor = 0;
+	unsigned int end;
+	unsigned int kept = 1;
+
+	memset(t_out_keep, 0, t_count);
+	t_out_keep[0] = 1;
+	if (t_count < 3 || t_tolerance <= 0.0f)
+	{
+		memset(t_out_keep, 1, t_count);
+		return t_count;
+	}
+
+	for (end = anchor + 2; end < t_count; ++end)
+	{
+		double span = t_times[end] - t_times[anchor];
+		unsigned int i = anchor + 1;
+		for (; i < end; ++i)
+		{
+			double factor = span > 0.0 ? (t_times[i] - t_times[anchor]) / span : 0.0;
+			double fit = t_values[anchor] + (t_values[end] - t_values[anchor]) * factor;
+			double error = fit - t_values[i];
+			if (error > t_tolerance || error < -t_tolerance)
+			{
+				break;
+			}
+		}
+		if (i != end)
+		{
+			anchor = end - 1;
+			t_out_keep[anchor] = 1;
+			++kept;
+		}
+	}
+	if (!t_out_keep[t_count - 1])
+	{
+		t_out_keep[t_count - 1] = 1;
+		++kept;
+	}
+	return kept;
+}
+
+static int fbx_animation_extract_track(fbx_animation_extract_context* t_context, unsigned int t_index)
+{
+	fbx_animation* animation = t_context->animation;
+	fbx_animation_track* track = &animation->tracks[t_index];
+	fbx_node_record* curve = t_context->curves[t_index];
+	unsigned short* key_times = animation->key_times + t_context->raw_offsets[t_index];
+	float* key_values = animation->key_values + t_context->raw_offsets[t_index];
+	unsigned int count = t_context->raw_offsets[t_index + 1] - t_context->raw_offsets[t_index];
+	char typecode = 0;
+	int length = 0;
+	double default_value = 0.0;
+
+	track->key_offset = t_context->raw_offsets[t_index];
+	track->key_count = 0;
+	track->start_time = 0.0f;
+	track->time_scale = 0.0f;
+	track->id = 0;
+	fbx_node_get_id(curve, &track->id);
+	fbx_node_get_child_double(t_context->fbx, curve, "Default", &default_value);
+	track->default_value = (float)default_value;
+	if (!count)
+	{
+		return 1;
+	}
+
+	const long long int* ticks = (const long long int*)fbx_node_get_child_array(t_context->fbx, curve, "KeyTime", &typecode, &length);
+	const float* values = (const float*)fbx_node_get_child_array(t_context->fbx, curve, "KeyValueFloat", &typecode, &length);
+
+	double* times = malloc(sizeof(double) * count);
+	unsigned char* keep = malloc(count);
+	if (!times || !keep)
+	{
+		free(times);
+		free(keep);
+		return 0;
+	}
+
+	unsigned int i = 0;
+	for (; i < count; ++i)
+	{
+		times[i] = (double)ticks[i] / FBX_TICKS_PER_SECOND;
+	}
+	fbx_animation_reduce_keys(times, values, count, t_context->tolerance, keep);
+
+	double duration = times[count - 1] - times[0];
+	track->start_time = (float)times[0];
+	track->time_scale = duration > 0.0 ? (float)(FBX_ANIMATION_QUANTIZED_RANGE / duration) : 0.0f;
+
+	/* keys which collide once quantized are collapsed, keeping the later key */
+	for (i = 0; i < count; ++i)
+	{
+		if (!keep[i])
+		{
+			continue;
+		}
+		unsigned short time = (unsigned short)((times[i] - times[0]) * track->time_scale + 0.5);
+		if (track->key_count && key_times[track->key_count - 1] == time)
+		{
+			--track->key_count;
+		}
+		key_times[track->key_count] = time;
+		key_values[track->key_count] = values[i];
+		++track->key_count;
+	}
+
+	free(times);
+	free(keep);
+	return 1;
+}
+
+static void fbx_animation_extract_range(void* t_context, size_t t_begin, size_t t_end)
+{
+	fbx_animation_extract_context* context = (fbx_animation_extract_context*)t_context;
+	size_t i = t_begin;
+	for (; i < t_end; ++i)
+	{
+		if (!fbx_animation_extract_track(context, (unsigned int)i))
+		{
+			context->is_failed = 1;
+		}
+	}
+}
+
+int fbx_animation_extract(fbx_animation* t_animation, fbx* t_fbx, thread_pool* t_pool, float t_tolerance)
+{
+	assert(t_animation && t_fbx);
+
+	memset(t_animation, 0, sizeof(fbx_animation));
+
+	fbx_node_record* objects = fbx_find_root_node(t_fbx, "Objects");
+	if (!objects)
+	{
+		return 1;
+	}
+
+	unsigned int curve_count = 0;
+	int i = 0;
+	for (; i < objects->children.element_count; ++i)
+	{
+		fbx_node_record* child = fbx_get_node(t_fbx, *((int*)vector_get_index(&objects->children, i)));
+		curve_count += child && strcmp((const char*)child->name.data, "AnimationCurve") == 0;
+	}
+	if (!curve_count)
+	{
+		return 1;
+	}
+
+	fbx_animation_extract_context context;
+	context.animation = t_animation;
+	context.fbx = t_fbx;
+	context.tolerance = t_tolerance;
+	context.is_failed = 0;
+	context.curves = malloc(sizeof(fbx_node_record*) * curve_count);
+	context.raw_offsets = malloc(sizeof(unsigned int) * (curve_count + 1));
+	t_animation->tracks = malloc(sizeof(fbx_animation_track) * curve_count);
+	if (!context.curves || !context.raw_offsets || !t_animation->tracks)
+	{
+		free(context.curves);
+		free(context.raw_offsets);
+		fbx_animation_final(t_animation);
+		return 0;
+	}
+	t_animation->track_count = curve_count;
+
+	/* the raw key counts bound each track's region, tracks are reduced in place then compacted */
+	unsigned int track = 0;
+	context.raw_offsets[0] = 0;
+	for (i = 0; i < objects->children.element_count; ++i)
+	{
+		fbx_node_record* child = fbx_get_node(t_fbx, *((int*)vector_get_index(&objects->children, i)));
+		if (!child || strcmp((const char*)child->name.data, "AnimationCurve") != 0)
+		{
+			continue;
+		}
+		int time_length = 0;
+		int value_length = 0;
+		char time_typecode = 0;
+		char value_typecode = 0;
+		fbx_node_get_child_array(t_fbx, child, "KeyTime", &time_typecode, &time_length);
+		fbx_node_get_child_array(t_fbx, child, "KeyValueFloat", &value_typecode, &value_length);
+		if (time_typecode != 'l' || value_typecode != 'f')
+		{
+			time_length = 0;
+		}
+		context.curves[track] = child;
+		context.raw_offsets[track + 1] = context.raw_offsets[track] + (unsigned int)(time_length < value_length ? time_length : value_length);
+		++track;
+	}
+
+	unsigned int raw_key_count = context.raw_offsets[curve_count];
+	t_animation->key_times = malloc(sizeof(unsigned short) * (raw_key_count ? raw_key_count : 1));
+	t_animation->key_values = malloc(sizeof(float) * (raw_key_count ? raw_key_count : 1));
+	if (!t_animation->key_times || !t_animation->key_values)
+	{
+		free(context.curves);
+		free(context.raw_offsets);
+		fbx_animation_final(t_animation);
+		return 0;
+	}
+
+	thread_pool_parallel_for(t_pool, curve_count, 64, fbx_animation_extract_range, &context);
+
+	free(context.curves);
+	free(context.raw_offsets);
+	if (context.is_failed)
+	{
+		fbx_animation_final(t_animation);
+		return 0;
+	}
+
+	unsigned int key_offset = 0;
+	for (track = 0; track < curve_count; ++track)
+	{
+		fbx_animation_track* current = &t_animation->tracks[track];
+		memmove(t_animation->key_times + key_offset, t_animation->key_times + current->key_offset, sizeof(unsigned short) * current->key_count);
+		memmove(t_animation->key_values + key_offset, t_animation->key_values + current->key_offset, sizeof(float) * current->key_count);
+		current->key_offset = key_offset;
+		key_offset += current->key_count;
+	}
+	t_animation->key_count = key_offset;
+
+	return 1;
+}
+
+int fbx_animation_find_track(fbx_animation* t_animation, long long t_id)
+{
+	assert(t_animation);
+
+	unsigned int i = 0;
+	for (; i < t_animation->track_count; ++i)
+	{
+		if (t_animation->tracks[i].id == t_id)
+		{
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+/* finds the key pair bracketing a quantized time, starting from the caller's previously sampled key if given */
+static void fbx_animation_find_keys(const fbx_animation* t_animation, unsigned int t_track, unsigned int* t_cursors, float t_time, float* t_out_time_0, float* t_out_time_1, float* t_out_value_0, float* t_out_value_1)
+{
+	const fbx_animation_track* track = &t_animation->tracks[t_track];
+	const unsigned short* times = t_animation->key_times + track->key_offset;
+	const float* values = t_animation->key_values + track->key_offset;
+
+	if (track->key_count < 2)
+	{
+		float value = track->key_count ? values[0] : track->default_value;
+		*t_out_time_0 = 0.0f;
+		*t_out_time_1 = 0.0f;
+		*t_out_value_0 = value;
+		*t_out_value_1 = value;
+		return;
+	}
+
+	unsigned int cursor = 0;
+	if (t_cursors)
+	{
+		cursor = t_cursors[t_track];
+		if (cursor >= track->key_count - 1)
+		{
+			cursor = track->key_count - 2;
+		}
+		while (cursor && t_time < (float)times[cursor])
+		{
+			--cursor;
+		}
+		while (cursor < track->key_count - 2 && t_time >= (float)times[cursor + 1])
+		{
+			++cursor;
+		}
+		t_cursors[t_track] = cursor;
+	}
+	else
+	{
+		/* without a cursor the last key not after the time is found by bisection */
+		unsigned int count = track->key_count - 1;
+		while (count > 1)
+		{
+			unsigned int half = count / 2;
+			if (t_time >= (float)times[cursor + half])
+			{
+				cursor += half;
+				count -= half;
+			}
+			else
+			{
+				count = half;
+			}
+		}
+	}
+
+	*t_out_time_0 = (float)times[cursor];
+	*t_out_time_1 = (float)times[cursor + 1];
+	*t_out_value_0 = values[cursor];
+	*t_out_value_1 = values[cursor + 1];
+}
+
+typedef struct
+{
+	const fbx_animation* animation;
+	unsigned int* cursors;
+	float time;
+	float* values;
+} fbx_animation_sample_context;
+
+static void fbx_animation_sample_range(void* t_context, size_t t_begin, size_t t_end)
+{
+	fbx_animation_sample_context* context = (fbx_animation_sample_context*)t_context;
+	const fbx_animation* animation = context->animation;
+	size_t i = t_begin;
+
+#if SIMD_SSE2
+	/* quantize and interpolate four tracks per iteration, only the bracketing search is per track */
+	for (; i + 4 <= t_end; i += 4)
+	{
+		const fbx_animation_track* tracks = &animation->tracks[i];
+		float quantized[4];
+		float time_0[4];
+		float time_1[4];
+		float value_0[4];
+		float value_1[4];
+
+		__m128 start = _mm_setr_ps(tracks[0].start_time, tracks[1].start_time, tracks[2].start_time, tracks[3].start_time);
+		__m128 scale = _mm_setr_ps(tracks[0].time_scale, tracks[1].time_scale, tracks[2].time_scale, tracks[3].time_scale);
+		__m128 time = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(context->time), start), scale);
+		time = _mm_min_ps(_mm_max_ps(time, _mm_setzero_ps()), _mm_set1_ps(FBX_ANIMATION_QUANTIZED_RANGE));
+		_mm_storeu_ps(quantized, time);
+
+		unsigned int lane = 0;
+		for (; lane < 4; ++lane)
+		{
+			fbx_animation_find_keys(animation, (unsigned int)i + lane, context->cursors, quantized[lane], &time_0[lane], &time_1[lane], &value_0[lane], &value_1[lane]);
+		}
+
+		__m128 t0 = _mm_loadu_ps(time_0);
+		__m128 v0 = _mm_loadu_ps(value_0);
+		__m128 span = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(time_1), t0), _mm_set1_ps(1.0f));
+		__m128 factor = _mm_div_ps(_mm_sub_ps(time, t0), span);
+		factor = _mm_min_ps(_mm_max_ps(factor, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		__m128 value = _mm_add_ps(v0, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(value_1), v0), factor));
+		_mm_storeu_ps(context->values + i, value);
+	}
+#endif
+
+	for (; i < t_end; ++i)
+	{
+		const fbx_animation_track* track = &animation->tracks[i];
+		float time_0;
+		float time_1;
+		float value_0;
+		float value_1;
+		float time = (context->time - track->start_time) * track->time_scale;
+		time = time < 0.0f ? 0.0f : (time > FBX_ANIMATION_QUANTIZED_RANGE ? FBX_ANIMATION_QUANTIZED_RANGE : time);
+
+		fbx_animation_find_keys(animation, (unsigned int)i, context->cursors, time, &time_0, &time_1, &value_0, &value_1);
+
+		float span = time_1 - time_0 > 1.0f ? time_1 - time_0 : 1.0f;
+		float factor = (time - time_0) / span;
+		factor = factor < 0.0f ? 0.0f : (factor > 1.0f ? 1.0f : factor);
+		context->values[i] = value_0 + (value_1 - value_0) * factor;
+	}
+}
+
+void fbx_animation_sample(const fbx_animation* t_animation, thread_pool* t_pool, float t_time, unsigned int* t_cursors, float* t_out_values)
+{
+	assert(t_animation && t_out_values);
+
+	fbx_animation_sample_context context;
+	context.animation = t_animation;
+	context.cursors = t_cursors;
+	context.time = t_time;
+	context.values = t_out_values;
+
+	thread_pool_parallel_for(t_pool, t_animation->track_count, FBX_ANIMATION_SAMPLE_GRAIN, fbx_animation_sample_range, &context);
+}
+
+void fbx_animation_final(fbx_animation* t_animation)
+{
+	if (t_animation)
+	{
+		free(t_animation->tracks);
+		free(t_animation->key_times);
+		free(t_animation->key_values);
+		memset(t_animation, 0, sizeof(fbx_animation));
+	}
+}
@@ -0,0 +1,81 @@
+/**
+ * fbx_animation.h
+ */
+
+#ifndef GRAPHICS_UTILS_FBX_ANIMATION_H
+#define GRAPHICS_UTILS_FBX_ANIMATION_H
+
+#include "fbx_import.h"
+#include "thread_pool.h"
+
+/** the number of fbx time ticks per second */
+#define FBX_TICKS_PER_SECOND 46186158000.0
+
+/**	@struct		fbx_animation_track
+ *	@brief		a compact track extracted from a single AnimationCurve node
+ *	@member		fbx_animation_track::id - the object id of the AnimationCurve
+ *	@member		fbx_animation_track::key_offset - the index of the first key within the animation key arrays
+ *	@member		fbx_animation_track::key_count - the number of keys in the track
+ *	@member		fbx_animation_track::start_time - the time of the first key in seconds
+ *	@member		fbx_animation_track::time_scale - quantized time units per second
+ *	@member		fbx_animation_track::default_value - the value used when the track has no keys
+ */
+typedef struct
+{
+	long long id;
+	unsigned int key_offset;
+	unsigned int key_count;
+	float start_time;
+	float time_scale;
+	float default_value;
+} fbx_animation_track;
+
+/**	@struct		fbx_animation
+ *	@brief		every AnimationCurve of an fbx as compact, linearly interpolated tracks
+ *	@member		fbx_animation::track_count - the number of tracks
+ *	@member		fbx_animation::tracks - the tracks
+ *	@member		fbx_animation::key_count - the total number of keys across all tracks
+ *	@member		fbx_animation::key_times - key times quantized to 16 bits across each track's duration
+ *	@member		fbx_animation::key_values - key values
+ */
+typedef struct
+{
+	unsigned int track_count;
+	fbx_animation_track* tracks;
+	unsigned int key_count;
+	unsigned short* key_times;
+	float* key_values;
+} fbx_animation;
+
+/** extracts every AnimationCurve node of a loaded fbx into compact tracks
+ *	@memberof	fbx_animation
+ *	@param		t_animation - an invalid animation to be initialized
+ *	@param		t_fbx - a loaded fbx
+ *	@param		t_pool - an optional thread pool to reduce curves across
+ *	@param		t_tolerance - the maximum value error allowed when removing keys, 0 keeps every key
+ *	@returns	nonzero if extracted successfully
+ */
+int fbx_animation_extract(fbx_animation* t_animation, fbx* t_fbx, thread_pool* t_pool, float t_tolerance);
+
+/** returns the index of the track extracted from the given AnimationCurve id, or -1
+ *	@memberof	fbx_animation
+ */
+int fbx_animation_find_track(fbx_animation* t_animation, long long t_id);
+
+/** samples every track at the given time, the animation is not modified so any number of callers may sample it at once
+ *	@memberof	fbx_animation
+ *	@param		t_animation - a valid animation
+ *	@param		t_pool - an optional thread pool to sample tracks across
+ *	@param		t_time - the time to sample in seconds
+ *	@param		t_cursors - an optional track_count length array of the last key sampled per track, zeroed once and
+ *				kept by each caller between samples, making coherent playback O(1) per track, or 0 to search every track
+ *	@param		t_out_values - a track_count length array to receive the sampled values
+ */
+void fbx_animation_sample(const fbx_animation* t_animation, thread_pool* t_pool, float t_time, unsigned int* t_cursors, float* t_out_values);
+
+/** finalizes an extracted animation
+ *	@memberof	fbx_animation
+ */
+void fbx_animation_final(fbx_animation* t_animation);
+
+#endif
@@ -0,0 +1,393 @@
+#include "fbx_blend_shape.h"
+
+#include "simd.h"
+
+#include "assert.h"
+#include "stdlib.h"
+#include "string.h"
+
+#define FBX_BLEND_SHAPE_QUANTIZED_RANGE 32767.0
+#define FBX_BLEND_SHAPE_VERTEX_GRAIN 4096
+
+typedef struct
+{
+	unsigned int index;
+	unsigned int source;
+} fbx_blend_shape_entry;
+
+typedef struct
+{
+	fbx_blend_shapes* shapes;
+	fbx* fbx;
+	fbx_node_record** nodes;
+	int is_failed;
+} fbx_blend_shapes_extract_context;
+
+static int fbx_blend_shape_compare_entries(const void* t_a, const void* t_b)
+{
+	const fbx_blend_shape_entry* a = (const fbx_blend_shape_entry*)t_a;
+	const fbx_blend_shape_entry* b = (const fbx_blend_shape_entry*)t_b;
+	if (a->index != b->index)
+	{
+		return a->index < b->index ? -1 : 1;
+	}
+	return a->source < b->source ? -1 : (a->source > b->source);
+}
+
+static void fbx_blend_shape_quantize(const double* t_deltas, unsigned int t_count, short* t_out_deltas, float* t_out_scale)
+{
+	double maximum = 0.0;
+	unsigned int i = 0;
+	for (; i < t_count * 3; ++i)
+	{
+		double magnitude = t_deltas[i] < 0.0 ? -t_deltas[i] : t_deltas[i];
+		maximum = magnitude > maximum ? magnitude : maximum;
+	}
+	double scale = maximum > 0.0 ? maximum / FBX_BLEND_SHAPE_QUANTIZED_RANGE : 1.0;
+	for (i = 0; i < t_count; ++i)
+	{
+		unsigned int j = 0;
+		for (; j < 3; ++j)
+		{
+			double value = t_deltas[i * 3 + j] / scale;
+			t_out_deltas[i * 4 + j] = (short)(value < 0.0 ? value - 0.5 : value + 0.5);
+		}
+		t_out_deltas[i * 4 + 3] = 0;
+	}
+	*t_out_scale = (float)scale;
+}
+
+/* sorts, merges and quantizes a single shape's sparse deltas */
+static int fbx_blend_shape_extract_one(fbx_blend_shapes_extract_context* t_context, unsigned int t_index)
+{
+	fbx_blend_shape* shape = &t_context->shapes->shapes[t_index];
+	fbx_node_record* node = t_context->nodes[t_index];
+	char index_typecode = 0;
+	char vertex_typecode = 0;
+	char normal_typecode = 0;
+	int index_length = 0;
+	int vertex_length = 0;
+	int normal_length = 0;
+	const int* indexes = (const int*)fbx_node_get_child_array(t_context->fbx, node, "Indexes", &index_typecode, &index_length);
+	const double* vertices = (const double*)fbx_node_get_child_array(t_context->fbx, node, "Vertices", &vertex_typecode, &vertex_length);
+	const double* normals = (const double*)fbx_node_get_child_array(t_context->fbx, node, "Normals", &normal_typecode, &normal_length);
+
+	fbx_node_get_id(node, &shape->id);
+	if (index_typecode != 'i' || vertex_typecode != 'd' || vertex_length < index_length * 3)
+	{
+		return 1;
+	}
+	int has_normals = normal_typecode == 'd' && normal_length >= index_length * 3;
+
+	fbx_blend_shape_entry* entries = malloc(sizeof(fbx_blend_shape_entry) * (index_length ? index_length : 1));
+	double* position_sums = malloc(sizeof(double) * 3 * (index_length ? index_length : 1));
+	double* normal_sums = has_normals ? malloc(sizeof(double) * 3 * (index_length ? index_length : 1)) : 0;
+	if (!entries || !position_sums || (has_normals && !normal_sums))
+	{
+		free(entries);
+		free(position_sums);
+		free(normal_sums);
+		return 0;
+	}
+
+	unsigned int count = 0;
+	int is_sorted = 1;
+	int i = 0;
+	for (; i < index_length; ++i)
+	{
+		if (indexes[i] < 0 || (unsigned int)indexes[i] >= t_context->shapes->vertex_count)
+		{
+			continue;
+		}
+		entries[count].index = (unsigned int)indexes[i];
+		entries[count].source = (unsigned int)i;
+		is_sorted = is_sorted && (!count || entries[count - 1].index < entries[count].index);
+		++count;
+	}
+	if (!is_sorted)
+	{
+		qsort(entries, count, sizeof(fbx_blend_shape_entry), fbx_blend_shape_compare_entries);
+	}
+
+	/* duplicate indices are merged by summing their deltas */
+	unsigned int merged = 0;
+	unsigned int j = 0;
+	for (; j < count; ++j)
+	{
+		unsigned int source = entries[j].source;
+		unsigned int k = 0;
+		if (!merged || entries[merged - 1].index != entries[j].index)
+		{
+			entries[merged++].index = entries[j].index;
+			for (; k < 3; ++k)
+			{
+				position_sums[(merged - 1) * 3 + k] = 0.0;
+				if (has_normals)
+				{
+					normal_sums[(merged - 1) * 3 + k] = 0.0;
+				}
+			}
+		}
+		for (k = 0; k < 3; ++k)
+		{
+			position_sums[(merged - 1) * 3 + k] += vertices[source * 3 + k];
+			if (has_normals)
+			{
+				normal_sums[(merged - 1) * 3 + k] += normals[source * 3 + k];
+			}
+		}
+	}
+
+	shape->indices = malloc(sizeof(unsigned int) * (merged ? merged : 1));
+	shape->position_deltas = malloc(sizeof(short) * 4 * (merged ? merged : 1));
+	shape->normal_deltas = has_normals ? malloc(sizeof(short) * 4 * (merged ? merged : 1)) : 0;
+	if (!shape->indices || !shape->position_deltas || (has_normals && !shape->normal_deltas))
+	{
+		free(entries);
+		free(position_sums);
+		free(normal_sums);
+		return 0;
+	}
+	for (j = 0; j < merged; ++j)
+	{
+		shape->indices[j] = entries[j].index;
+	}
+	shape->delta_count = merged;
+	fbx_blend_shape_quantize(position_sums, merged, shape->position_deltas, &shape->position_scale);
+	if (has_normals)
+	{
+		fbx_blend_shape_quantize(normal_sums, merged, shape->normal_deltas, &shape->normal_scale);
+	}
+
+	free(entries);
+	free(position_sums);
+	free(normal_sums);
+	return 1;
+}
+
+static void fbx_blend_shapes_extract_range(void* t_context, size_t t_begin, size_t t_end)
+{
+	fbx_blend_shapes_extract_context* context = (fbx_blend_shapes_extract_context*)t_context;
+	size_t i = t_begin;
+	for (; i < t_end; ++i)
+	{
+		if (!fbx_blend_shape_extract_one(context, (unsigned int)i))
+		{
+			context->is_failed = 1;
+		}
+	}
+}
+
+int fbx_blend_shapes_extract(fbx_blend_shapes* t_shapes, fbx* t_fbx, fbx_node_record* t_geometry, thread_pool* t_pool)
+{
+	assert(t_shapes && t_fbx && t_geometry);
+
+	memset(t_shapes, 0, sizeof(fbx_blend_shapes));
+
+	char typecode = 0;
+	int length = 0;
+	fbx_node_get_child_array(t_fbx, t_geometry, "Vertices", &typecode, &length);
+	t_shapes->vertex_count = (unsigned int)(length / 3);
+
+	long long geometry_id;
+	if (!fbx_node_get_id(t_geometry, &geometry_id))
+	{
+		return 0;
+	}
+
+	/* geometry <- BlendShape deformers <- BlendShapeChannels <- Shape geometries */
+	vector deformers;
+	vector channels;
+	vector nodes;
+	vector channel_ids;
+	int result = vector_init(&deformers, sizeof(fbx_node_record*));
+	result &= vector_init(&channels, sizeof(fbx_node_record*));
+	result &= vector_init(&nodes, sizeof(fbx_node_record*));
+	result &= vector_init(&channel_ids, sizeof(long long));
+	result = result && fbx_find_connected_objects(t_fbx, geometry_id, "Deformer", "BlendShape", &deformers);
+	int i = 0;
+	for (; result && i < deformers.element_count; ++i)
+	{
+		long long deformer_id;
+		if (fbx_node_get_id(*((fbx_node_record**)vector_get_index(&deformers, i)), &deformer_id))
+		{
+			result = fbx_find_connected_objects(t_fbx, deformer_id, "Deformer", "BlendShapeChannel", &channels);
+		}
+	}
+	for (i = 0; result && i < channels.element_count; ++i)
+	{
+		long long channel_id;
+		if (!fbx_node_get_id(*((fbx_node_record**)vector_get_index(&channels, i)), &channel_id))
+		{
+			continue;
+		}
+		int first = nodes.element_count;
+		result = fbx_find_connected_objects(t_fbx, channel_id, "Geometry", "Shape", &nodes);
+		for (; result && first < nodes.element_count; ++first)
+		{
+			result = vector_push(&channel_ids, &channel_id);
+		}
+	}
+
+	if (result && nodes.element_count)
+	{
+		t_shapes->shapes = calloc(nodes.element_count, sizeof(fbx_blend_shape));
+		result = t_shapes->shapes != 0;
+	}
+	if (result && nodes.element_count)
+	{
+		t_shapes->shape_count = (unsigned int)nodes.element_count;
+		for (i = 0; i < nodes.element_count; ++i)
+		{
+			t_shapes->shapes[i].channel_id = *((long long*)vector_get_index(&channel_ids, i));
+		}
+
+		fbx_blend_shapes_extract_context context;
+		context.shapes = t_shapes;
+		context.fbx = t_fbx;
+		context.nodes = (fbx_node_record**)nodes.buffer.data;
+		context.is_failed = 0;
+		thread_pool_parallel_for(t_pool, t_shapes->shape_count, 1, fbx_blend_shapes_extract_range, &context);
+		result = !context.is_failed;
+	}
+
+	vector_final(&deformers);
+	vector_final(&channels);
+	vector_final(&nodes);
+	vector_final(&channel_ids);
+	if (!result)
+	{
+		fbx_blend_shapes_final(t_shapes);
+		return 0;
+	}
+	return 1;
+}
+
+typedef struct
+{
+	fbx_blend_shapes* shapes;
+	const float* weights;
+	const float* base_positions;
+	const float* base_normals;
+	float* out_positions;
+	float* out_normals;
+} fbx_blend_shapes_apply_context;
+
+/* adds a shape's quantized deltas from t_first up to vertex t_end to an xyz stream */
+static void fbx_blend_shape_accumulate
+	( const fbx_blend_shape* t_shape
+	, const short* t_deltas
+	, float t_factor
+	, unsigned int t_first
+	, unsigned int t_end
+	, float* t_out)
+{
+	unsigned int i = t_first;
+
+#if SIMD_SSE2
+	/* a four wide add on an xyz stream touches the next vertex's x, which is left intact by adding -0 */
+	const __m128 factor = _mm_set1_ps(t_factor);
+	const __m128 xyz_mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	const __m128 negative_zero = _mm_setr_ps(0.0f, 0.0f, 0.0f, -0.0f);
+	for (; i < t_shape->delta_count && t_shape->indices[i] + 1 < t_end; ++i)
+	{
+		__m128i packed = _mm_loadl_epi64((const __m128i*)(t_deltas + i * 4));
+		__m128 delta = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16));
+		delta = _mm_or_ps(_mm_and_ps(_mm_mul_ps(delta, factor), xyz_mask), negative_zero);
+		float* target = t_out + (size_t)t_shape->indices[i] * 3;
+		_mm_storeu_ps(target, _mm_add_ps(_mm_loadu_ps(target), delta));
+	}
+#endif
+
+	for (; i < t_shape->delta_count && t_shape->indices[i] < t_end; ++i)
+	{
+		float* target = t_out + (size_t)t_shape->indices[i] * 3;
+		target[0] += (float)t_deltas[i * 4 + 0] * t_factor;
+		target[1] += (float)t_deltas[i * 4 + 1] * t_factor;
+		target[2] += (float)t_deltas[i * 4 + 2] * t_factor;
+	}
+}
+
+static void fbx_blend_shapes_apply_range(void* t_context, size_t t_begin, size_t t_end)
+{
+	fbx_blend_shapes_apply_context* context = (fbx_blend_shapes_apply_context*)t_context;
+	fbx_blend_shapes* shapes = context->shapes;
+
+	memcpy(context->out_positions + t_begin * 3, context->base_positions + t_begin * 3, sizeof(float) * 3 * (t_end - t_begin));
+	if (context->out_normals)
+	{
+		memcpy(context->out_normals + t_begin * 3, context->base_normals + t_begin * 3, sizeof(float) * 3 * (t_end - t_begin));
+	}
+
+	unsigned int s = 0;
+	for (; s < shapes->shape_count; ++s)
+	{
+		const fbx_blend_shape* shape = &shapes->shapes[s];
+		float weight = context->weights[s];
+		if (weight == 0.0f || !shape->delta_count)
+		{
+			continue;
+		}
+
+		/* shapes are sorted by index, so each range finds its first delta by binary search */
+		unsigned int low = 0;
+		unsigned int high = shape->delta_count;
+		while (low < high)
+		{
+			unsigned int middle = low + (high - low) / 2;
+			if (shape->indices[middle] < t_begin)
+			{
+				low = middle + 1;
+			}
+			else
+			{
+				high = middle;
+			}
+		}
+
+		fbx_blend_shape_accumulate(shape, shape->position_deltas, weight * shape->position_scale, low, (unsigned int)t_end, context->out_positions);
+		if (context->out_normals && shape->normal_deltas)
+		{
+			fbx_blend_shape_accumulate(shape, shape->normal_deltas, weight * shape->normal_scale, low, (unsigned int)t_end, context->out_normals);
+		}
+	}
+}
+
+void fbx_blend_shapes_apply
+	( fbx_blend_shapes* t_shapes
+	, thread_pool* t_pool
+	, const float* t_weights
+	, const float* t_base_positions
+	, const float* t_base_normals
+	, float* t_out_positions
+	, float* t_out_normals)
+{
+	assert(t_shapes && t_weights && t_base_positions && t_out_positions);
+	assert(!t_out_normals || t_base_normals);
+
+	fbx_blend_shapes_apply_context context;
+	context.shapes = t_shapes;
+	context.weights = t_weights;
+	context.base_positions = t_base_positions;
+	context.base_normals = t_base_normals;
+	context.out_positions = t_out_positions;
+	context.out_normals = t_out_normals;
+
+	thread_pool_parallel_for(t_pool, t_shapes->vertex_count, FBX_BLEND_SHAPE_VERTEX_GRAIN, fbx_blend_shapes_apply_range, &context);
+}
+
+void fbx_blend_shapes_final(fbx_blend_shapes* t_shapes)
+{
+	if (t_shapes)
+	{
+		unsigned int i = 0;
+		for (; t_shapes->shapes && i < t_shapes->shape_count; ++i)
+		{
+			free(t_shapes->shapes[i].indices);
+			free(t_shapes->shapes[i].position_deltas);
+			free(t_shapes->shapes[i].normal_deltas);
+		}
+		free(t_shapes->shapes);
+		memset(t_shapes, 0, sizeof(fbx_blend_shapes));
+	}
+}
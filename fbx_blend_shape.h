@@ -0,0 +1,81 @@
+/**
+ * fbx_blend_shape.h
+ */
+
+#ifndef GRAPHICS_UTILS_FBX_BLEND_SHAPE_H
+#define GRAPHICS_UTILS_FBX_BLEND_SHAPE_H
+
+#include "fbx_import.h"
+#include "thread_pool.h"
+
+/**	@struct		fbx_blend_shape
+ *	@brief		a sparse, quantized Shape geometry
+ *	@member		fbx_blend_shape::id - the object id of the Shape geometry
+ *	@member		fbx_blend_shape::channel_id - the object id of the BlendShapeChannel the shape belongs to
+ *	@member		fbx_blend_shape::delta_count - the number of control points the shape moves
+ *	@member		fbx_blend_shape::indices - delta_count ascending control point indices
+ *	@member		fbx_blend_shape::position_deltas - four shorts per delta, xyz and padding, scaled by position_scale
+ *	@member		fbx_blend_shape::normal_deltas - four shorts per delta scaled by normal_scale, 0 if the shape has no normals
+ *	@member		fbx_blend_shape::position_scale - the dequantization scale of position_deltas
+ *	@member		fbx_blend_shape::normal_scale - the dequantization scale of normal_deltas
+ */
+typedef struct
+{
+	long long id;
+	long long channel_id;
+	unsigned int delta_count;
+	unsigned int* indices;
+	short* position_deltas;
+	short* normal_deltas;
+	float position_scale;
+	float normal_scale;
+} fbx_blend_shape;
+
+/**	@struct		fbx_blend_shapes
+ *	@brief		every Shape connected to a Geometry through its BlendShape deformers
+ *	@member		fbx_blend_shapes::vertex_count - the number of control points in the base geometry
+ *	@member		fbx_blend_shapes::shape_count - the number of shapes
+ *	@member		fbx_blend_shapes::shapes - the shapes, in deformer then channel order
+ */
+typedef struct
+{
+	unsigned int vertex_count;
+	unsigned int shape_count;
+	fbx_blend_shape* shapes;
+} fbx_blend_shapes;
+
+/** extracts the blend shapes of a Geometry node without expanding them to dense arrays
+ *	@memberof	fbx_blend_shapes
+ *	@param		t_shapes - an invalid blend shape set to be initialized
+ *	@param		t_fbx - a loaded fbx
+ *	@param		t_geometry - the base Geometry node
+ *	@param		t_pool - an optional thread pool to quantize shapes across
+ *	@returns	nonzero if extracted successfully, a geometry without shapes extracts an empty set
+ */
+int fbx_blend_shapes_extract(fbx_blend_shapes* t_shapes, fbx* t_fbx, fbx_node_record* t_geometry, thread_pool* t_pool);
+
+/** writes the base mesh plus every weighted shape, the result does not depend upon the thread count
+ *	@memberof	fbx_blend_shapes
+ *	@param		t_shapes - a valid blend shape set
+ *	@param		t_pool - an optional thread pool to process vertex ranges across
+ *	@param		t_weights - shape_count weights, shapes with a zero weight are skipped
+ *	@param		t_base_positions - vertex_count xyz positions
+ *	@param		t_base_normals - vertex_count xyz normals, or 0 to skip normals
+ *	@param		t_out_positions - vertex_count xyz positions to be written
+ *	@param		t_out_normals - vertex_count xyz normals to be written, or 0 to skip normals
+ */
+void fbx_blend_shapes_apply
+	( fbx_blend_shapes* t_shapes
+	, thread_pool* t_pool
+	, const float* t_weights
+	, const float* t_base_positions
+	, const float* t_base_normals
+	, float* t_out_positions
+	, float* t_out_normals);
+
+/** finalizes an extracted blend shape set
+ *	@memberof	fbx_blend_shapes
+ */
+void fbx_blend_shapes_final(fbx_blend_shapes* t_shapes);
+
+#endif
@@ -1,8 +1,10 @@
 
 #include "fbx_import.h"
+#include "checksum.h"
 
 #include "assert.h"
 #include "stdio.h"
+#include "stdlib.h"
 #include "zlib.h"
 
 #define INFLATE_CHUNK 1024
@@ -90,14 +92,24 @@ int inflate_impl(buffer* t_input, buffer* t_output)
 	unsigned have;
 	z_stream strm;
 	int offset = 0;
+	const unsigned char* input = (const unsigned char*)t_input->data;
+	unsigned int adler;
 	buffer_init(t_output, INFLATE_CHUNK);
 	
+	/* the zlib header and adler32 are handled here rather than by zlib, which would checksum every chunk of output on
+	 * its own, so that the whole output is verified at once by the vectorized checksum_adler32 */
+	if (t_input->size < 6 || ((input[0] << 8) | input[1]) % 31 != 0 || (input[0] & 0xf) != Z_DEFLATED || (input[1] & 0x20))
+	{
+		FBX_LOG("\tinvalid zlib header!");
+		return 0;
+	}
+	
 	strm.zalloc = Z_NULL;
 	strm.zfree = Z_NULL;
 	strm.opaque = Z_NULL;
 	strm.avail_in = 0;
 	strm.next_in = Z_NULL;
-	ret = inflateInit(&strm);
+	ret = inflateInit2(&strm, -MAX_WBITS);
 	
 	if (ret != Z_OK)
 	{
@@ -105,14 +117,14 @@ int inflate_impl(buffer* t_input, buffer* t_output)
 	}
 	
 	FBX_LOG("\tbegin decoding...");
+	strm.avail_in = t_input->size - 2;
+	strm.next_in = (Bytef*)input + 2;
 	do
 	{
-		strm.avail_in = t_input->size - offset;
 		if (strm.avail_in == 0)
 		{
 			break;
 		}
-		strm.next_in = t_input->data;
 		
 		do
 		{
@@ -154,6 +166,20 @@ int inflate_impl(buffer* t_input, buffer* t_output)
 		FBX_LOG("\tno stream end yet...");
 	} while (ret != Z_STREAM_END);
 	
+	if (ret != Z_STREAM_END || strm.avail_in < 4)
+	{
+		FBX_LOG("\ttruncated stream!");
+		(void)inflateEnd(&strm);
+		return 0;
+	}
+	adler = ((unsigned int)strm.next_in[0] << 24) | ((unsigned int)strm.next_in[1] << 16) | ((unsigned int)strm.next_in[2] << 8) | strm.next_in[3];
+	(void)inflateEnd(&strm);
+	if (checksum_adler32(1, (const unsigned char*)t_output->data, offset) != adler)
+	{
+		FBX_LOG("\tadler32 mismatch!");
+		return 0;
+	}
+	
 	FBX_LOG("\t... end decoding");
 	return 1;
 }
@@ -262,6 +288,75 @@ int fread_property_array(FILE* t_file, fbx_property* t_property, size_t t_elemen
 	return 1;
 }
 
+static int fbx_compare_objects(const void* t_a, const void* t_b)
+{
+	const fbx_object_entry* a = (const fbx_object_entry*)t_a;
+	const fbx_object_entry* b = (const fbx_object_entry*)t_b;
+	if (a->id != b->id)
+	{
+		return a->id < b->id ? -1 : 1;
+	}
+	return a->node < b->node ? -1 : (a->node > b->node);
+}
+
+static int fbx_compare_connections(const void* t_a, const void* t_b)
+{
+	const fbx_connection_entry* a = (const fbx_connection_entry*)t_a;
+	const fbx_connection_entry* b = (const fbx_connection_entry*)t_b;
+	if (a->parent_id != b->parent_id)
+	{
+		return a->parent_id < b->parent_id ? -1 : 1;
+	}
+	return a->order < b->order ? -1 : (a->order > b->order);
+}
+
+/* indexes objects by id and connections by parent id once, so lookups bisect rather than scan every object or connection */
+static int fbx_build_indices(fbx* t_fbx)
+{
+	fbx_node_record* objects = fbx_find_root_node(t_fbx, "Objects");
+	int i = 0;
+	for (; objects && i < objects->children.element_count; ++i)
+	{
+		fbx_object_entry entry;
+		entry.node = *((int*)vector_get_index(&objects->children, i));
+		fbx_node_record* object = fbx_get_node(t_fbx, entry.node);
+		if (object && fbx_node_get_id(object, &entry.id) && !vector_push(&t_fbx->objects, &entry))
+		{
+			return 0;
+		}
+	}
+	
+	fbx_node_record* connections = fbx_find_root_node(t_fbx, "Connections");
+	for (i = 0; connections && i < connections->children.element_count; ++i)
+	{
+		fbx_node_record* connection = fbx_get_node(t_fbx, *((int*)vector_get_index(&connections->children, i)));
+		fbx_property* child_property = connection ? fbx_node_get_property(connection, 1) : 0;
+		fbx_property* parent_property = connection ? fbx_node_get_property(connection, 2) : 0;
+		if (!child_property || !parent_property || child_property->typecode != 'L' || parent_property->typecode != 'L')
+		{
+			continue;
+		}
+		fbx_connection_entry entry;
+		entry.parent_id = *((long long int*)parent_property->data.data);
+		entry.child_id = *((long long int*)child_property->data.data);
+		entry.order = i;
+		if (!vector_push(&t_fbx->connections, &entry))
+		{
+			return 0;
+		}
+	}
+	
+	if (t_fbx->objects.element_count > 1)
+	{
+		qsort(vector_get_index(&t_fbx->objects, 0), t_fbx->objects.element_count, sizeof(fbx_object_entry), fbx_compare_objects);
+	}
+	if (t_fbx->connections.element_count > 1)
+	{
+		qsort(vector_get_index(&t_fbx->connections, 0), t_fbx->connections.element_count, sizeof(fbx_connection_entry), fbx_compare_connections);
+	}
+	return 1;
+}
+
 int fbx_load(fbx* t_fbx, const char* t_string)
 {
 	assert(t_fbx && t_string);
@@ -319,6 +414,25 @@ int fbx_load(fbx* t_fbx, const char* t_string)
 		fclose(file);
 		return 0;
 	}
+	result = vector_init(&t_fbx->objects, sizeof(fbx_object_entry));
+	if (!result)
+	{
+		FBX_LOAD_ERR_MESSAGE();
+		vector_final(&t_fbx->nodes);
+		vector_final(&t_fbx->root_nodes);
+		fclose(file);
+		return 0;
+	}
+	result = vector_init(&t_fbx->connections, sizeof(fbx_connection_entry));
+	if (!result)
+	{
+		FBX_LOAD_ERR_MESSAGE();
+		vector_final(&t_fbx->nodes);
+		vector_final(&t_fbx->root_nodes);
+		vector_final(&t_fbx->objects);
+		fclose(file);
+		return 0;
+	}
 	
 	FBX_LOG("version_number %u", t_fbx->version);
 	
@@ -621,6 +735,11 @@ node_pop_stack:
 		node = (fbx_node_record*)vector_get_index(&t_fbx->nodes, node_index);
 	}
 	
+	if (!fbx_build_indices(t_fbx))
+	{
+		return FBX_LOAD_FAILURE();
+	}
+	
 	fclose(file);
 	
 	return 1;
@@ -976,6 +1095,243 @@ stringify_fail:
 	return 1;
 }
 
+fbx_node_record* fbx_get_node(fbx* t_fbx, int t_index)
+{
+	assert(t_fbx);
+	
+	if (t_index < 0)
+	{
+		return 0;
+	}
+	return (fbx_node_record*)vector_get_index(&t_fbx->nodes, t_index);
+}
+
+fbx_node_record* fbx_find_root_node(fbx* t_fbx, const char* t_name)
+{
+	assert(t_fbx && t_name);
+	
+	int i = 0;
+	for (; i < t_fbx->root_nodes.element_count; ++i)
+	{
+		fbx_node_record* node = fbx_get_node(t_fbx, *((int*)vector_get_index(&t_fbx->root_nodes, i)));
+		if (node && strcmp((const char*)node->name.data, t_name) == 0)
+		{
+			return node;
+		}
+	}
+	return 0;
+}
+
+fbx_node_record* fbx_node_find_child(fbx* t_fbx, fbx_node_record* t_node, const char* t_name)
+{
+	assert(t_fbx && t_node && t_name);
+	
+	int i = 0;
+	for (; i < t_node->children.element_count; ++i)
+	{
+		fbx_node_record* child = fbx_get_node(t_fbx, *((int*)vector_get_index(&t_node->children, i)));
+		if (child && strcmp((const char*)child->name.data, t_name) == 0)
+		{
+			return child;
+		}
+	}
+	return 0;
+}
+
+fbx_property* fbx_node_get_property(fbx_node_record* t_node, int t_index)
+{
+	assert(t_node);
+	
+	if (t_index < 0 || t_index >= t_node->properties.element_count)
+	{
+		return 0;
+	}
+	return (fbx_property*)vector_get_index(&t_node->properties, t_index);
+}
+
+const void* fbx_property_get_array(fbx_property* t_property, int* t_out_length)
+{
+	assert(t_property && t_out_length);
+	
+	switch (t_property->typecode)
+	{
+		case 'b':
+		case 'i':
+		case 'f':
+		case 'l':
+		case 'd':
+		{
+			fbx_array_property* array_property = (fbx_array_property*)t_property->data.data;
+			*t_out_length = array_property->length;
+			return array_property->data.data;
+		} break;
+		default: break;
+	}
+	*t_out_length = 0;
+	return 0;
+}
+
+const void* fbx_node_get_child_array(fbx* t_fbx, fbx_node_record* t_node, const char* t_name, char* t_out_typecode, int* t_out_length)
+{
+	assert(t_fbx && t_node && t_name && t_out_length);
+	
+	*t_out_length = 0;
+	fbx_node_record* child = fbx_node_find_child(t_fbx, t_node, t_name);
+	if (!child)
+	{
+		return 0;
+	}
+	fbx_property* property = fbx_node_get_property(child, 0);
+	if (!property)
+	{
+		return 0;
+	}
+	if (t_out_typecode)
+	{
+		*t_out_typecode = property->typecode;
+	}
+	return fbx_property_get_array(property, t_out_length);
+}
+
+int fbx_node_get_child_double(fbx* t_fbx, fbx_node_record* t_node, const char* t_name, double* t_out_value)
+{
+	assert(t_fbx && t_node && t_name && t_out_value);
+	
+	fbx_node_record* child = fbx_node_find_child(t_fbx, t_node, t_name);
+	if (!child)
+	{
+		return 0;
+	}
+	fbx_property* property = fbx_node_get_property(child, 0);
+	if (!property)
+	{
+		return 0;
+	}
+	switch (property->typecode)
+	{
+		case 'D': *t_out_value = *((double*)property->data.data); return 1;
+		case 'F': *t_out_value = (double)*((float*)property->data.data); return 1;
+		case 'I': *t_out_value = (double)*((int*)property->data.data); return 1;
+		case 'L': *t_out_value = (double)*((long long int*)property->data.data); return 1;
+		default: break;
+	}
+	return 0;
+}
+
+int fbx_node_get_id(fbx_node_record* t_node, long long* t_out_id)
+{
+	assert(t_node && t_out_id);
+	
+	fbx_property* property = fbx_node_get_property(t_node, 0);
+	if (!property || property->typecode != 'L')
+	{
+		return 0;
+	}
+	*t_out_id = *((long long int*)property->data.data);
+	return 1;
+}
+
+fbx_node_record* fbx_find_object(fbx* t_fbx, long long t_id)
+{
+	assert(t_fbx);
+	
+	/* the first object of the id, in file order, as duplicates are sorted by node */
+	size_t low = 0;
+	size_t high = t_fbx->objects.element_count;
+	while (low < high)
+	{
+		size_t middle = low + (high - low) / 2;
+		if (((fbx_object_entry*)vector_get_index(&t_fbx->objects, middle))->id < t_id)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+	if (low == t_fbx->objects.element_count)
+	{
+		return 0;
+	}
+	fbx_object_entry* entry = (fbx_object_entry*)vector_get_index(&t_fbx->objects, low);
+	return entry->id == t_id ? fbx_get_node(t_fbx, entry->node) : 0;
+}
+
+int fbx_find_connections(fbx* t_fbx, long long t_parent_id, vector* t_out_child_ids)
+{
+	assert(t_fbx && t_out_child_ids);
+	
+	size_t low = 0;
+	size_t high = t_fbx->connections.element_count;
+	while (low < high)
+	{
+		size_t middle = low + (high - low) / 2;
+		if (((fbx_connection_entry*)vector_get_index(&t_fbx->connections, middle))->parent_id < t_parent_id)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+	for (; low < t_fbx->connections.element_count; ++low)
+	{
+		fbx_connection_entry* entry = (fbx_connection_entry*)vector_get_index(&t_fbx->connections, low);
+		if (entry->parent_id != t_parent_id)
+		{
+			break;
+		}
+		int result = vector_push(t_out_child_ids, &entry->child_id);
+		if (!result)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int fbx_node_is_object(fbx_node_record* t_node, const char* t_name, const char* t_class)
+{
+	assert(t_node && t_name);
+	
+	if (strcmp((const char*)t_node->name.data, t_name) != 0)
+	{
+		return 0;
+	}
+	if (!t_class)
+	{
+		return 1;
+	}
+	fbx_property* property = fbx_node_get_property(t_node, 2);
+	return property && property->typecode == 'S' && strcmp((const char*)property->data.data, t_class) == 0;
+}
+
+int fbx_find_connected_objects(fbx* t_fbx, long long t_parent_id, const char* t_name, const char* t_class, vector* t_out_nodes)
+{
+	assert(t_fbx && t_name && t_out_nodes);
+	
+	vector child_ids;
+	int result = vector_init(&child_ids, sizeof(long long));
+	if (!result)
+	{
+		return 0;
+	}
+	result = fbx_find_connections(t_fbx, t_parent_id, &child_ids);
+	int i = 0;
+	for (; result && i < child_ids.element_count; ++i)
+	{
+		fbx_node_record* object = fbx_find_object(t_fbx, *((long long*)vector_get_index(&child_ids, i)));
+		if (object && fbx_node_is_object(object, t_name, t_class))
+		{
+			result = vector_push(t_out_nodes, &object);
+		}
+	}
+	vector_final(&child_ids);
+	return result;
+}
+
 #if !FBX_DEBUG_LOG_FINAL
 #undef FBX_LOG
 #define FBX_LOG(...) FBX_NOP
@@ -1033,5 +1389,7 @@ void fbx_final(fbx* t_fbx)
 		}
 		vector_final(&t_fbx->nodes);
 		vector_final(&t_fbx->root_nodes);
+		vector_final(&t_fbx->objects);
+		vector_final(&t_fbx->connections);
 	}
 }
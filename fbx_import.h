@@ -44,11 +44,26 @@ typedef struct
 	fbx_node_record_header null_record;
 } fbx_node_record;
 
+typedef struct
+{
+	long long id;
+	int node;
+} fbx_object_entry;
+
+typedef struct
+{
+	long long parent_id;
+	long long child_id;
+	int order;
+} fbx_connection_entry;
+
 typedef struct
 {
 	int version;
 	vector nodes;
 	vector root_nodes;
+	vector objects; /* fbx_object_entry of every object, sorted by id */
+	vector connections; /* fbx_connection_entry of every connection, sorted by parent id then file order */
 } fbx;
 
 int fbx_load(fbx* t_fbx, const char* t_string);
@@ -61,6 +76,30 @@ int fbx_stringify(fbx* t_fbx, buffer* t_out_buffer);
 
 int fbx_stringify_without_properties(fbx* t_fbx, buffer* t_out_buffer);
 
+fbx_node_record* fbx_get_node(fbx* t_fbx, int t_index);
+
+fbx_node_record* fbx_find_root_node(fbx* t_fbx, const char* t_name);
+
+fbx_node_record* fbx_node_find_child(fbx* t_fbx, fbx_node_record* t_node, const char* t_name);
+
+fbx_property* fbx_node_get_property(fbx_node_record* t_node, int t_index);
+
+const void* fbx_property_get_array(fbx_property* t_property, int* t_out_length);
+
+const void* fbx_node_get_child_array(fbx* t_fbx, fbx_node_record* t_node, const char* t_name, char* t_out_typecode, int* t_out_length);
+
+int fbx_node_get_child_double(fbx* t_fbx, fbx_node_record* t_node, const char* t_name, double* t_out_value);
+
+int fbx_node_get_id(fbx_node_record* t_node, long long* t_out_id);
+
+fbx_node_record* fbx_find_object(fbx* t_fbx, long long t_id);
+
+int fbx_find_connections(fbx* t_fbx, long long t_parent_id, vector* t_out_child_ids);
+
+int fbx_node_is_object(fbx_node_record* t_node, const char* t_name, const char* t_class);
+
+int fbx_find_connected_objects(fbx* t_fbx, long long t_parent_id, const char* t_name, const char* t_class, vector* t_out_nodes);
+
 void fbx_final(fbx* t_fbx);
 
 #endif
\ No newline at end of file
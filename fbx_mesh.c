@@ -0,0 +1,713 @@
+#include "fbx_mesh.h"
+
+#include "simd.h"
+
+#include "assert.h"
+#include "stdlib.h"
+#include "string.h"
+
+#define FBX_LAYER_GATHER_GRAIN 4096
+#define FBX_MESH_TOPOLOGY_GRAIN 65536
+#define FBX_MESH_TRIANGULATE_GRAIN 4096
+
+typedef struct
+{
+	const char* name;
+	const char* data_name;
+	const char* index_name;
+	unsigned int component_count;
+} fbx_layer_element_description;
+
+static const fbx_layer_element_description g_fbx_layer_element_descriptions[] =
+	{ { "LayerElementNormal", "Normals", "NormalsIndex", 3 }
+	, { "LayerElementBinormal", "Binormals", "BinormalsIndex", 3 }
+	, { "LayerElementTangent", "Tangents", "TangentsIndex", 3 }
+	, { "LayerElementUV", "UV", "UVIndex", 2 }
+	, { "LayerElementColor", "Colors", "ColorIndex", 4 }
+	, { "LayerElementMaterial", "Materials", 0, 1 }
+	, { "LayerElementSmoothing", "Smoothing", 0, 1 }
+	};
+
+typedef struct
+{
+	fbx_mesh_topology* topology;
+	const int* polygon_vertices;
+	unsigned int* chunk_polygons;
+	int is_failed;
+} fbx_mesh_topology_context;
+
+/* first pass, counts the negative terminators of each chunk from the sign bits of four corners at a time */
+static void fbx_mesh_topology_count(void* t_context, size_t t_begin, size_t t_end)
+{
+	fbx_mesh_topology_context* context = (fbx_mesh_topology_context*)t_context;
+	size_t chunk = t_begin;
+	for (; chunk < t_end; ++chunk)
+	{
+		size_t begin = chunk * FBX_MESH_TOPOLOGY_GRAIN;
+		size_t end = begin + FBX_MESH_TOPOLOGY_GRAIN < context->topology->corner_count ? begin + FBX_MESH_TOPOLOGY_GRAIN : context->topology->corner_count;
+		const int* corners = context->polygon_vertices;
+		unsigned int count = 0;
+		size_t corner = begin;
+#if SIMD_SSE2
+		for (; corner + 4 <= end; corner += 4)
+		{
+			int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(corners + corner))));
+			count += (unsigned int)((mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1));
+		}
+#endif
+		for (; corner < end; ++corner)
+		{
+			count += corners[corner] < 0;
+		}
+		context->chunk_polygons[chunk] = count;
+	}
+}
+
+/* second pass, each chunk knows its first polygon from the scanned counts and fills its corners independently */
+static void fbx_mesh_topology_fill(void* t_context, size_t t_begin, size_t t_end)
+{
+	fbx_mesh_topology_context* context = (fbx_mesh_topology_context*)t_context;
+	fbx_mesh_topology* topology = context->topology;
+	size_t chunk = t_begin;
+	for (; chunk < t_end; ++chunk)
+	{
+		unsigned int begin = (unsigned int)chunk * FBX_MESH_TOPOLOGY_GRAIN;
+		unsigned int end = begin + FBX_MESH_TOPOLOGY_GRAIN < topology->corner_count ? begin + FBX_MESH_TOPOLOGY_GRAIN : topology->corner_count;
+		const int* corners = context->polygon_vertices;
+		unsigned int polygon = context->chunk_polygons[chunk];
+		unsigned int corner = begin;
+		int is_invalid = 0;
+#if SIMD_SSE2
+		/* the complement of a terminator is its value xor its sign extension */
+		const __m128i limit = _mm_set1_epi32((int)topology->control_point_count);
+		__m128i valid = _mm_set1_epi32(-1);
+		for (; corner + 4 <= end; corner += 4)
+		{
+			__m128i value = _mm_loadu_si128((const __m128i*)(corners + corner));
+			__m128i sign = _mm_srai_epi32(value, 31);
+			__m128i control_point = _mm_xor_si128(value, sign);
+			valid = _mm_and_si128(valid, _mm_cmplt_epi32(control_point, limit));
+			_mm_storeu_si128((__m128i*)(topology->control_points + corner), control_point);
+			int mask = _mm_movemask_ps(_mm_castsi128_ps(sign));
+			unsigned int lane = 0;
+			for (; lane < 4; ++lane)
+			{
+				topology->polygons[corner + lane] = polygon;
+				if (mask & (1 << lane))
+				{
+					topology->polygon_offsets[++polygon] = corner + lane + 1;
+				}
+			}
+		}
+		is_invalid = _mm_movemask_epi8(valid) != 0xFFFF;
+#endif
+		for (; corner < end; ++corner)
+		{
+			int index = corners[corner];
+			unsigned int control_point = (unsigned int)(index < 0 ? ~index : index);
+			is_invalid |= control_point >= topology->control_point_count;
+			topology->control_points[corner] = control_point;
+			topology->polygons[corner] = polygon;
+			if (index < 0)
+			{
+				topology->polygon_offsets[++polygon] = corner + 1;
+			}
+		}
+		if (is_invalid)
+		{
+			context->is_failed = 1;
+		}
+	}
+}
+
+int fbx_mesh_topology_extract(fbx_mesh_topology* t_topology, fbx* t_fbx, fbx_node_record* t_geometry, thread_pool* t_pool)
+{
+	assert(t_topology && t_fbx && t_geometry);
+
+	memset(t_topology, 0, sizeof(fbx_mesh_topology));
+
+	char typecode = 0;
+	int length = 0;
+	t_topology->positions = (const double*)fbx_node_get_child_array(t_fbx, t_geometry, "Vertices", &typecode, &length);
+	if (!t_topology->positions || typecode != 'd')
+	{
+		return 0;
+	}
+	t_topology->control_point_count = (unsigned int)(length / 3);
+
+	const int* polygon_vertices = (const int*)fbx_node_get_child_array(t_fbx, t_geometry, "PolygonVertexIndex", &typecode, &length);
+	if (!polygon_vertices || typecode != 'i')
+	{
+		return 0;
+	}
+
+	size_t chunk_count = ((size_t)length + FBX_MESH_TOPOLOGY_GRAIN - 1) / FBX_MESH_TOPOLOGY_GRAIN;
+	fbx_mesh_topology_context context;
+	context.topology = t_topology;
+	context.polygon_vertices = polygon_vertices;
+	context.is_failed = 0;
+	context.chunk_polygons = malloc(sizeof(unsigned int) * (chunk_count ? chunk_count : 1));
+
+	t_topology->corner_count = (unsigned int)length;
+	t_topology->control_points = malloc(sizeof(unsigned int) * (length ? length : 1));
+	t_topology->polygons = malloc(sizeof(unsigned int) * (length ? length : 1));
+	t_topology->polygon_offsets = malloc(sizeof(unsigned int) * ((size_t)length + 1));
+	if (!context.chunk_polygons || !t_topology->control_points || !t_topology->polygons || !t_topology->polygon_offsets)
+	{
+		free(context.chunk_polygons);
+		fbx_mesh_topology_final(t_topology);
+		return 0;
+	}
+
+	/* a negative index, stored as its complement, terminates each polygon, so counting terminators per chunk
+	and exclusively scanning the counts gives every chunk its first polygon */
+	thread_pool_parallel_for(t_pool, chunk_count, 1, fbx_mesh_topology_count, &context);
+	unsigned int polygon = 0;
+	size_t chunk = 0;
+	for (; chunk < chunk_count; ++chunk)
+	{
+		unsigned int count = context.chunk_polygons[chunk];
+		context.chunk_polygons[chunk] = polygon;
+		polygon += count;
+	}
+	t_topology->polygon_offsets[0] = 0;
+	thread_pool_parallel_for(t_pool, chunk_count, 1, fbx_mesh_topology_fill, &context);
+	free(context.chunk_polygons);
+	if (context.is_failed)
+	{
+		fbx_mesh_topology_final(t_topology);
+		return 0;
+	}
+
+	/* an unterminated trailing polygon is dropped */
+	t_topology->polygon_count = polygon;
+	t_topology->corner_count = t_topology->polygon_offsets[polygon];
+
+	return 1;
+}
+
+void fbx_mesh_topology_final(fbx_mesh_topology* t_topology)
+{
+	if (t_topology)
+	{
+		free(t_topology->control_points);
+		free(t_topology->polygons);
+		free(t_topology->polygon_offsets);
+		memset(t_topology, 0, sizeof(fbx_mesh_topology));
+	}
+}
+
+typedef struct
+{
+	const fbx_mesh_topology* topology;
+	unsigned int* triangle_offsets;
+	index_buffer* buffer;
+} fbx_mesh_triangulate_context;
+
+static void fbx_mesh_emit_triangle(index_buffer* t_buffer, size_t t_triangle, unsigned int t_a, unsigned int t_b, unsigned int t_c)
+{
+	if (t_buffer->type == GL_UNSIGNED_SHORT)
+	{
+		unsigned short* indices = (unsigned short*)t_buffer->buffer + t_triangle * 3;
+		indices[0] = (unsigned short)t_a;
+		indices[1] = (unsigned short)t_b;
+		indices[2] = (unsigned short)t_c;
+	}
+	else
+	{
+		unsigned int* indices = (unsigned int*)t_buffer->buffer + t_triangle * 3;
+		indices[0] = t_a;
+		indices[1] = t_b;
+		indices[2] = t_c;
+	}
+}
+
+static double fbx_mesh_orient(const double* t_a, const double* t_b, const double* t_c)
+{
+	return (t_b[0] - t_a[0]) * (t_c[1] - t_a[1]) - (t_b[1] - t_a[1]) * (t_c[0] - t_a[0]);
+}
+
+/* projects a polygon onto the plane its newell normal is most aligned with, returning the winding sign */
+static double fbx_mesh_project_polygon(const fbx_mesh_topology* t_topology, unsigned int t_first, unsigned int t_count, double* t_out_points)
+{
+	double normal[3] = { 0.0, 0.0, 0.0 };
+	unsigned int i = 0;
+	for (; i < t_count; ++i)
+	{
+		const double* a = t_topology->positions + (size_t)t_topology->control_points[t_first + i] * 3;
+		const double* b = t_topology->positions + (size_t)t_topology->control_points[t_first + (i + 1) % t_count] * 3;
+		normal[0] += (a[1] - b[1]) * (a[2] + b[2]);
+		normal[1] += (a[2] - b[2]) * (a[0] + b[0]);
+		normal[2] += (a[0] - b[0]) * (a[1] + b[1]);
+	}
+	double x = normal[0] < 0.0 ? -normal[0] : normal[0];
+	double y = normal[1] < 0.0 ? -normal[1] : normal[1];
+	double z = normal[2] < 0.0 ? -normal[2] : normal[2];
+	unsigned int axis = x > y ? (x > z ? 0 : 2) : (y > z ? 1 : 2);
+	for (i = 0; i < t_count; ++i)
+	{
+		const double* position = t_topology->positions + (size_t)t_topology->control_points[t_first + i] * 3;
+		t_out_points[i * 2 + 0] = position[(axis + 1) % 3];
+		t_out_points[i * 2 + 1] = position[(axis + 2) % 3];
+	}
+	return normal[axis] < 0.0 ? -1.0 : 1.0;
+}
+
+/* clips ears until a triangle remains, a polygon with no valid ear left is clipped at its first corner */
+static void fbx_mesh_ear_clip(index_buffer* t_buffer, size_t t_triangle, unsigned int t_first, unsigned int t_count, const double* t_points, double t_winding, unsigned int* t_remaining)
+{
+	unsigned int count = t_count;
+	unsigned int k = 0;
+	unsigned int i;
+	for (i = 0; i < t_count; ++i)
+	{
+		t_remaining[i] = i;
+	}
+
+	while (count > 3)
+	{
+		unsigned int attempts = 0;
+		for (; attempts < count; ++attempts, k = (k + 1) % count)
+		{
+			unsigned int previous = t_remaining[(k + count - 1) % count];
+			unsigned int current = t_remaining[k];
+			unsigned int next = t_remaining[(k + 1) % count];
+			const double* a = t_points + previous * 2;
+			const double* b = t_points + current * 2;
+			const double* c = t_points + next * 2;
+			if (fbx_mesh_orient(a, b, c) * t_winding <= 0.0)
+			{
+				continue;
+			}
+			for (i = 0; i < count; ++i)
+			{
+				const double* p = t_points + t_remaining[i] * 2;
+				if (t_remaining[i] == previous || t_remaining[i] == current || t_remaining[i] == next
+					|| (p[0] == a[0] && p[1] == a[1]) || (p[0] == b[0] && p[1] == b[1]) || (p[0] == c[0] && p[1] == c[1]))
+				{
+					continue;
+				}
+				if (fbx_mesh_orient(a, b, p) * t_winding >= 0.0 && fbx_mesh_orient(b, c, p) * t_winding >= 0.0 && fbx_mesh_orient(c, a, p) * t_winding >= 0.0)
+				{
+					break;
+				}
+			}
+			if (i == count)
+			{
+				break;
+			}
+		}
+		if (attempts == count)
+		{
+			k = 0;
+		}
+
+		fbx_mesh_emit_triangle(t_buffer, t_triangle++, t_first + t_remaining[(k + count - 1) % count], t_first + t_remaining[k], t_first + t_remaining[(k + 1) % count]);
+		memmove(t_remaining + k, t_remaining + k + 1, sizeof(unsigned int) * (count - k - 1));
+		--count;
+		k = k % count;
+	}
+	fbx_mesh_emit_triangle(t_buffer, t_triangle, t_first + t_remaining[0], t_first + t_remaining[1], t_first + t_remaining[2]);
+}
+
+static void fbx_mesh_triangulate_polygon(const fbx_mesh_triangulate_context* t_context, unsigned int t_polygon)
+{
+	const fbx_mesh_topology* topology = t_context->topology;
+	unsigned int first = topology->polygon_offsets[t_polygon];
+	unsigned int count = topology->polygon_offsets[t_polygon + 1] - first;
+	size_t triangle = t_context->triangle_offsets[t_polygon];
+	double stack_points[64 * 2];
+	unsigned int stack_remaining[64];
+	double* points = stack_points;
+	unsigned int* remaining = stack_remaining;
+	unsigned int i;
+
+	if (count < 3)
+	{
+		return;
+	}
+	if (count == 3)
+	{
+		fbx_mesh_emit_triangle(t_context->buffer, triangle, first, first + 1, first + 2);
+		return;
+	}
+	if (count > 64)
+	{
+		points = malloc(sizeof(double) * 2 * count);
+		remaining = malloc(sizeof(unsigned int) * count);
+	}
+
+	/* a polygon with no reflex corner is fanned, a quad with one is split across its reflex corner */
+	unsigned int reflex_count = 0;
+	unsigned int reflex = 0;
+	if (points && remaining)
+	{
+		double winding = fbx_mesh_project_polygon(topology, first, count, points);
+		for (i = 0; i < count; ++i)
+		{
+			if (fbx_mesh_orient(points + ((i + count - 1) % count) * 2, points + i * 2, points + ((i + 1) % count) * 2) * winding < 0.0)
+			{
+				reflex = i;
+				++reflex_count;
+			}
+		}
+		if (reflex_count && count > 4)
+		{
+			fbx_mesh_ear_clip(t_context->buffer, triangle, first, count, points, winding, remaining);
+		}
+	}
+	if (!reflex_count || count == 4 || !points || !remaining)
+	{
+		for (i = 1; i + 1 < count; ++i)
+		{
+			fbx_mesh_emit_triangle(t_context->buffer, triangle++, first + reflex, first + (reflex + i) % count, first + (reflex + i + 1) % count);
+		}
+	}
+
+	if (points != stack_points)
+	{
+		free(points);
+	}
+	if (remaining != stack_remaining)
+	{
+		free(remaining);
+	}
+}
+
+static void fbx_mesh_triangulate_range(void* t_context, size_t t_begin, size_t t_end)
+{
+	const fbx_mesh_triangulate_context* context = (const fbx_mesh_triangulate_context*)t_context;
+	size_t polygon = t_begin;
+	for (; polygon < t_end; ++polygon)
+	{
+		fbx_mesh_triangulate_polygon(context, (unsigned int)polygon);
+	}
+}
+
+int fbx_mesh_triangulate(const fbx_mesh_topology* t_topology, thread_pool* t_pool, index_buffer* t_out_buffer)
+{
+	assert(t_topology && t_out_buffer);
+
+	fbx_mesh_triangulate_context context;
+	context.topology = t_topology;
+	context.buffer = t_out_buffer;
+	context.triangle_offsets = malloc(sizeof(unsigned int) * ((size_t)t_topology->polygon_count + 1));
+	if (!context.triangle_offsets)
+	{
+		return 0;
+	}
+
+	/* every polygon of n corners becomes n - 2 triangles, so each polygon's output position is known up front */
+	unsigned int triangle_count = 0;
+	unsigned int polygon = 0;
+	for (; polygon < t_topology->polygon_count; ++polygon)
+	{
+		unsigned int count = t_topology->polygon_offsets[polygon + 1] - t_topology->polygon_offsets[polygon];
+		context.triangle_offsets[polygon] = triangle_count;
+		triangle_count += count > 2 ? count - 2 : 0;
+	}
+	context.triangle_offsets[t_topology->polygon_count] = triangle_count;
+
+	t_out_buffer->type = t_topology->corner_count <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	t_out_buffer->buffer_size = (size_t)triangle_count * 3 * (t_out_buffer->type == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int));
+	t_out_buffer->buffer = malloc(t_out_buffer->buffer_size ? t_out_buffer->buffer_size : 1);
+	if (!t_out_buffer->buffer)
+	{
+		free(context.triangle_offsets);
+		return 0;
+	}
+
+	thread_pool_parallel_for(t_pool, t_topology->polygon_count, FBX_MESH_TRIANGULATE_GRAIN, fbx_mesh_triangulate_range, &context);
+
+	free(context.triangle_offsets);
+	return 1;
+}
+
+static const char* fbx_mesh_get_child_string(fbx* t_fbx, fbx_node_record* t_node, const char* t_name)
+{
+	fbx_node_record* child = fbx_node_find_child(t_fbx, t_node, t_name);
+	fbx_property* property = child ? fbx_node_get_property(child, 0) : 0;
+	if (!property || property->typecode != 'S')
+	{
+		return "";
+	}
+	return (const char*)property->data.data;
+}
+
+int fbx_layer_element_find(fbx_layer_element* t_element, fbx* t_fbx, fbx_node_record* t_geometry, const char* t_name, int t_layer)
+{
+	assert(t_element && t_fbx && t_geometry && t_name);
+
+	memset(t_element, 0, sizeof(fbx_layer_element));
+
+	const fbx_layer_element_description* description = 0;
+	unsigned int i = 0;
+	for (; i < sizeof(g_fbx_layer_element_descriptions) / sizeof(g_fbx_layer_element_descriptions[0]); ++i)
+	{
+		if (strcmp(g_fbx_layer_element_descriptions[i].name, t_name) == 0)
+		{
+			description = &g_fbx_layer_element_descriptions[i];
+		}
+	}
+	if (!description)
+	{
+		return 0;
+	}
+
+	fbx_node_record* layer = 0;
+	int j = 0;
+	for (; j < t_geometry->children.element_count; ++j)
+	{
+		fbx_node_record* child = fbx_get_node(t_fbx, *((int*)vector_get_index(&t_geometry->children, j)));
+		fbx_property* index = child ? fbx_node_get_property(child, 0) : 0;
+		if (index && index->typecode == 'I' && *((int*)index->data.data) == t_layer && strcmp((const char*)child->name.data, t_name) == 0)
+		{
+			layer = child;
+			break;
+		}
+	}
+	if (!layer)
+	{
+		return 0;
+	}
+
+	const char* mapping = fbx_mesh_get_child_string(t_fbx, layer, "MappingInformationType");
+	if (strcmp(mapping, "ByPolygonVertex") == 0)
+	{
+		t_element->mapping = FBX_MAPPING_BY_POLYGON_VERTEX;
+	}
+	else if (strcmp(mapping, "ByVertice") == 0 || strcmp(mapping, "ByVertex") == 0 || strcmp(mapping, "ByControlPoint") == 0)
+	{
+		t_element->mapping = FBX_MAPPING_BY_CONTROL_POINT;
+	}
+	else if (strcmp(mapping, "ByPolygon") == 0)
+	{
+		t_element->mapping = FBX_MAPPING_BY_POLYGON;
+	}
+	else if (strcmp(mapping, "AllSame") == 0)
+	{
+		t_element->mapping = FBX_MAPPING_ALL_SAME;
+	}
+	else
+	{
+		return 0;
+	}
+
+	/* material and smoothing arrays hold their values directly, whatever their reference claims */
+	const char* reference = fbx_mesh_get_child_string(t_fbx, layer, "ReferenceInformationType");
+	t_element->reference = description->index_name && (strcmp(reference, "IndexToDirect") == 0 || strcmp(reference, "Index") == 0)
+		? FBX_REFERENCE_INDEX_TO_DIRECT
+		: FBX_REFERENCE_DIRECT;
+
+	int length = 0;
+	t_element->component_count = description->component_count;
+	t_element->data = fbx_node_get_child_array(t_fbx, layer, description->data_name, &t_element->typecode, &length);
+	if (!t_element->data || (t_element->typecode != 'd' && t_element->typecode != 'f' && t_element->typecode != 'i'))
+	{
+		return 0;
+	}
+	t_element->data_count = (unsigned int)length / t_element->component_count;
+
+	if (t_element->reference == FBX_REFERENCE_INDEX_TO_DIRECT)
+	{
+		char index_typecode = 0;
+		t_element->indices = (const int*)fbx_node_get_child_array(t_fbx, layer, description->index_name, &index_typecode, &length);
+		if (!t_element->indices || index_typecode != 'i')
+		{
+			return 0;
+		}
+		t_element->index_count = (unsigned int)length;
+	}
+
+	return 1;
+}
+
+/* resolves the direct element of each corner in [t_begin, t_end), -1 marking missing elements */
+static void fbx_layer_resolve(const fbx_mesh_topology* t_topology, const fbx_layer_element* t_element, unsigned int t_begin, unsigned int t_end, int* t_out)
+{
+	unsigned int corner = t_begin;
+	for (; corner < t_end; ++corner)
+	{
+		unsigned int mapped = 0;
+		switch (t_element->mapping)
+		{
+			case FBX_MAPPING_BY_POLYGON_VERTEX: mapped = corner; break;
+			case FBX_MAPPING_BY_CONTROL_POINT: mapped = t_topology->control_points[corner]; break;
+			case FBX_MAPPING_BY_POLYGON: mapped = t_topology->polygons[corner]; break;
+			default: break;
+		}
+		int direct = (int)mapped;
+		if (t_element->reference == FBX_REFERENCE_INDEX_TO_DIRECT)
+		{
+			direct = mapped < t_element->index_count ? t_element->indices[mapped] : -1;
+		}
+		t_out[corner - t_begin] = direct >= 0 && (unsigned int)direct < t_element->data_count ? direct : -1;
+	}
+}
+
+#if SIMD_X86_DISPATCH
+/* the same resolution eight corners at a time, index indirections use hardware gathers */
+SIMD_TARGET("avx2") static void fbx_layer_resolve_avx2(const fbx_mesh_topology* t_topology, const fbx_layer_element* t_element, unsigned int t_begin, unsigned int t_end, int* t_out)
+{
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i missing = _mm256_set1_epi32(-1);
+	const __m256i index_count = _mm256_set1_epi32((int)t_element->index_count);
+	const __m256i data_count = _mm256_set1_epi32((int)t_element->data_count);
+	unsigned int corner = t_begin;
+	for (; corner + 8 <= t_end; corner += 8)
+	{
+		__m256i mapped = _mm256_setzero_si256();
+		switch (t_element->mapping)
+		{
+			case FBX_MAPPING_BY_POLYGON_VERTEX: mapped = _mm256_add_epi32(_mm256_set1_epi32((int)corner), lanes); break;
+			case FBX_MAPPING_BY_CONTROL_POINT: mapped = _mm256_loadu_si256((const __m256i*)(t_topology->control_points + corner)); break;
+			case FBX_MAPPING_BY_POLYGON: mapped = _mm256_loadu_si256((const __m256i*)(t_topology->polygons + corner)); break;
+			default: break;
+		}
+		__m256i direct = mapped;
+		if (t_element->reference == FBX_REFERENCE_INDEX_TO_DIRECT)
+		{
+			__m256i in_range = _mm256_and_si256(_mm256_cmpgt_epi32(index_count, mapped), _mm256_cmpgt_epi32(mapped, missing));
+			direct = _mm256_mask_i32gather_epi32(missing, t_element->indices, mapped, in_range, 4);
+		}
+		__m256i valid = _mm256_and_si256(_mm256_cmpgt_epi32(data_count, direct), _mm256_cmpgt_epi32(direct, missing));
+		_mm256_storeu_si256((__m256i*)(t_out + (corner - t_begin)), _mm256_blendv_epi8(missing, direct, valid));
+	}
+	fbx_layer_resolve(t_topology, t_element, corner, t_end, t_out + (corner - t_begin));
+}
+#endif
+
+/* copies and converts the resolved elements into the flat stream */
+static void fbx_layer_write(const fbx_layer_element* t_element, const int* t_resolved, unsigned int t_begin, unsigned int t_end, void* t_out)
+{
+	unsigned int components = t_element->component_count;
+	unsigned int corner = t_begin;
+	if (t_element->typecode == 'i')
+	{
+		int* out = (int*)t_out + (size_t)t_begin * components;
+		for (; corner < t_end; ++corner, out += components)
+		{
+			int direct = t_resolved[corner - t_begin];
+			unsigned int k = 0;
+			for (; k < components; ++k)
+			{
+				out[k] = direct < 0 ? -1 : ((const int*)t_element->data)[(size_t)direct * components + k];
+			}
+		}
+		return;
+	}
+
+	float* out = (float*)t_out + (size_t)t_begin * components;
+	if (t_element->typecode == 'f')
+	{
+		for (; corner < t_end; ++corner, out += components)
+		{
+			int direct = t_resolved[corner - t_begin];
+			if (direct < 0)
+			{
+				memset(out, 0, sizeof(float) * components);
+			}
+			else
+			{
+				memcpy(out, (const float*)t_element->data + (size_t)direct * components, sizeof(float) * components);
+			}
+		}
+		return;
+	}
+
+	const double* data = (const double*)t_element->data;
+	for (; corner < t_end; ++corner, out += components)
+	{
+		int direct = t_resolved[corner - t_begin];
+		if (direct < 0)
+		{
+			memset(out, 0, sizeof(float) * components);
+			continue;
+		}
+		const double* source = data + (size_t)direct * components;
+#if SIMD_SSE2
+		if (components == 2)
+		{
+			_mm_storel_pi((__m64*)out, _mm_cvtpd_ps(_mm_loadu_pd(source)));
+			continue;
+		}
+		if (components == 4)
+		{
+			_mm_storeu_ps(out, _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(source)), _mm_cvtpd_ps(_mm_loadu_pd(source + 2))));
+			continue;
+		}
+#endif
+		unsigned int k = 0;
+		for (; k < components; ++k)
+		{
+			out[k] = (float)source[k];
+		}
+	}
+}
+
+typedef struct
+{
+	fbx_layer_gather* gathers;
+	unsigned int gather_count;
+	unsigned int* chunk_offsets;
+	int has_avx2;
+} fbx_layer_gather_context;
+
+static void fbx_layer_gather_range(void* t_context, size_t t_begin, size_t t_end)
+{
+	fbx_layer_gather_context* context = (fbx_layer_gather_context*)t_context;
+	int resolved[FBX_LAYER_GATHER_GRAIN];
+	size_t chunk = t_begin;
+	for (; chunk < t_end; ++chunk)
+	{
+		unsigned int gather_index = 0;
+		while (context->chunk_offsets[gather_index + 1] <= chunk)
+		{
+			++gather_index;
+		}
+		fbx_layer_gather* gather = &context->gathers[gather_index];
+		unsigned int begin = (unsigned int)(chunk - context->chunk_offsets[gather_index]) * FBX_LAYER_GATHER_GRAIN;
+		unsigned int end = begin + FBX_LAYER_GATHER_GRAIN < gather->topology->corner_count ? begin + FBX_LAYER_GATHER_GRAIN : gather->topology->corner_count;
+
+#if SIMD_X86_DISPATCH
+		if (context->has_avx2)
+		{
+			fbx_layer_resolve_avx2(gather->topology, gather->element, begin, end, resolved);
+		}
+		else
+#endif
+		{
+			fbx_layer_resolve(gather->topology, gather->element, begin, end, resolved);
+		}
+		fbx_layer_write(gather->element, resolved, begin, end, gather->out);
+	}
+}
+
+int fbx_layer_elements_gather(thread_pool* t_pool, fbx_layer_gather* t_gathers, unsigned int t_gather_count)
+{
+	assert(t_gathers || !t_gather_count);
+
+	fbx_layer_gather_context context;
+	context.gathers = t_gathers;
+	context.gather_count = t_gather_count;
+	context.has_avx2 = (simd_get_features() & SIMD_FEATURE_AVX2) != 0;
+	context.chunk_offsets = malloc(sizeof(unsigned int) * (t_gather_count + 1));
+	if (!context.chunk_offsets)
+	{
+		return 0;
+	}
+
+	/* every gather is split into corner chunks, and all chunks of all gathers share one parallel loop */
+	unsigned int i = 0;
+	context.chunk_offsets[0] = 0;
+	for (; i < t_gather_count; ++i)
+	{
+		unsigned int corners = t_gathers[i].topology->corner_count;
+		context.chunk_offsets[i + 1] = context.chunk_offsets[i] + (corners + FBX_LAYER_GATHER_GRAIN - 1) / FBX_LAYER_GATHER_GRAIN;
+	}
+
+	thread_pool_parallel_for(t_pool, context.chunk_offsets[t_gather_count], 1, fbx_layer_gather_range, &context);
+
+	free(context.chunk_offsets);
+	return 1;
+}
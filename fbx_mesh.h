@@ -0,0 +1,122 @@
+/**
+ * fbx_mesh.h
+ */
+
+#ifndef GRAPHICS_UTILS_FBX_MESH_H
+#define GRAPHICS_UTILS_FBX_MESH_H
+
+#include "graphics.h"
+#include "thread_pool.h"
+
+#define FBX_MAPPING_BY_POLYGON_VERTEX 0
+#define FBX_MAPPING_BY_CONTROL_POINT 1
+#define FBX_MAPPING_BY_POLYGON 2
+#define FBX_MAPPING_ALL_SAME 3
+
+#define FBX_REFERENCE_DIRECT 0
+#define FBX_REFERENCE_INDEX_TO_DIRECT 1
+
+/**	@struct		fbx_mesh_topology
+ *	@brief		the polygon structure of a Geometry node's PolygonVertexIndex array
+ *	@member		fbx_mesh_topology::corner_count - the number of polygon corners
+ *	@member		fbx_mesh_topology::polygon_count - the number of polygons
+ *	@member		fbx_mesh_topology::control_point_count - the number of control points
+ *	@member		fbx_mesh_topology::control_points - the control point of each corner
+ *	@member		fbx_mesh_topology::polygons - the polygon of each corner
+ *	@member		fbx_mesh_topology::polygon_offsets - polygon_count + 1 offsets to the first corner of each polygon
+ *	@member		fbx_mesh_topology::positions - control_point_count xyz positions, a view of the Vertices array
+ */
+typedef struct
+{
+	unsigned int corner_count;
+	unsigned int polygon_count;
+	unsigned int control_point_count;
+	unsigned int* control_points;
+	unsigned int* polygons;
+	unsigned int* polygon_offsets;
+	const double* positions;
+} fbx_mesh_topology;
+
+/**	@struct		fbx_layer_element
+ *	@brief		a view of a LayerElement node's mapping, reference, direct and index arrays
+ *	@member		fbx_layer_element::mapping - one of the FBX_MAPPING values
+ *	@member		fbx_layer_element::reference - one of the FBX_REFERENCE values
+ *	@member		fbx_layer_element::typecode - the typecode of the direct array, 'd', 'f' or 'i'
+ *	@member		fbx_layer_element::component_count - the number of components per element
+ *	@member		fbx_layer_element::data - the direct array
+ *	@member		fbx_layer_element::data_count - the number of elements in the direct array
+ *	@member		fbx_layer_element::indices - the index array when reference is FBX_REFERENCE_INDEX_TO_DIRECT
+ *	@member		fbx_layer_element::index_count - the number of indices
+ */
+typedef struct
+{
+	unsigned int mapping;
+	unsigned int reference;
+	char typecode;
+	unsigned int component_count;
+	const void* data;
+	unsigned int data_count;
+	const int* indices;
+	unsigned int index_count;
+} fbx_layer_element;
+
+/**	@struct		fbx_layer_gather
+ *	@brief		a single layer element to be resolved into a flat per corner stream
+ *	@member		fbx_layer_gather::topology - the topology of the mesh the element belongs to
+ *	@member		fbx_layer_gather::element - the layer element to resolve
+ *	@member		fbx_layer_gather::out - corner_count * component_count floats, or ints for an 'i' element,
+ *				corners referencing missing elements receive zeros, or -1 for ints
+ */
+typedef struct
+{
+	const fbx_mesh_topology* topology;
+	const fbx_layer_element* element;
+	void* out;
+} fbx_layer_gather;
+
+/** extracts the polygon topology of a Geometry node, polygon boundaries are found by a parallel prefix scan
+ *	@memberof	fbx_mesh_topology
+ *	@param		t_topology - an invalid topology to be initialized
+ *	@param		t_fbx - a loaded fbx
+ *	@param		t_geometry - the Geometry node
+ *	@param		t_pool - an optional thread pool to scan corners across
+ *	@returns	nonzero if extracted successfully
+ */
+int fbx_mesh_topology_extract(fbx_mesh_topology* t_topology, fbx* t_fbx, fbx_node_record* t_geometry, thread_pool* t_pool);
+
+/** finalizes an extracted topology
+ *	@memberof	fbx_mesh_topology
+ */
+void fbx_mesh_topology_final(fbx_mesh_topology* t_topology);
+
+/** triangulates every polygon into an index buffer of corner indices, matching the per corner layer streams,
+ *	convex polygons are fanned and concave polygons are ear clipped
+ *	@memberof	fbx_mesh_topology
+ *	@param		t_topology - a valid topology
+ *	@param		t_pool - an optional thread pool to triangulate polygons across
+ *	@param		t_out_buffer - receives a malloc'd GL_UNSIGNED_SHORT or GL_UNSIGNED_INT index buffer
+ *	@returns	nonzero if triangulated successfully
+ */
+int fbx_mesh_triangulate(const fbx_mesh_topology* t_topology, thread_pool* t_pool, index_buffer* t_out_buffer);
+
+/** finds a layer element of a Geometry node
+ *	@memberof	fbx_layer_element
+ *	@param		t_element - the element view to fill
+ *	@param		t_fbx - a loaded fbx
+ *	@param		t_geometry - the Geometry node
+ *	@param		t_name - the layer element node name, such as "LayerElementNormal" or "LayerElementUV"
+ *	@param		t_layer - the layer index, such as the uv set
+ *	@returns	nonzero if the element was found and is supported
+ */
+int fbx_layer_element_find(fbx_layer_element* t_element, fbx* t_fbx, fbx_node_record* t_geometry, const char* t_name, int t_layer);
+
+/** resolves layer elements into flat per corner streams, every gather is processed concurrently
+ *	@memberof	fbx_layer_gather
+ *	@param		t_pool - an optional thread pool to process the gathers across
+ *	@param		t_gathers - the gathers to process
+ *	@param		t_gather_count - the number of gathers
+ *	@returns	nonzero if the gathers were processed
+ */
+int fbx_layer_elements_gather(thread_pool* t_pool, fbx_layer_gather* t_gathers, unsigned int t_gather_count);
+
+#endif
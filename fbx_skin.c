@@ -0,0 +1,341 @@
+#include "fbx_skin.h"
+
+#include "assert.h"
+#include "stdlib.h"
+#include "string.h"
+
+#define FBX_SKIN_CLUSTER_GRAIN 4
+#define FBX_SKIN_VERTEX_GRAIN 4096
+
+typedef struct
+{
+	unsigned int vertex;
+	float weight;
+} fbx_skin_influence;
+
+typedef struct
+{
+	unsigned int bone;
+	float weight;
+} fbx_skin_bone_weight;
+
+typedef struct
+{
+	fbx_skin* skin;
+	fbx* fbx;
+	fbx_node_record** clusters;
+	fbx_skin_influence** cluster_influences;
+	unsigned int* cluster_influence_counts;
+	unsigned int* vertex_offsets;
+	fbx_skin_bone_weight* vertex_influences;
+	int is_failed;
+} fbx_skin_extract_context;
+
+fbx_node_record* fbx_skin_find_deformer(fbx* t_fbx, fbx_node_record* t_geometry)
+{
+	assert(t_fbx && t_geometry);
+
+	long long id;
+	if (!fbx_node_get_id(t_geometry, &id))
+	{
+		return 0;
+	}
+	vector skins;
+	if (!vector_init(&skins, sizeof(fbx_node_record*)))
+	{
+		return 0;
+	}
+	fbx_node_record* skin = 0;
+	if (fbx_find_connected_objects(t_fbx, id, "Deformer", "Skin", &skins) && skins.element_count)
+	{
+		skin = *((fbx_node_record**)vector_get_index(&skins, 0));
+	}
+	vector_final(&skins);
+	return skin;
+}
+
+/* gathers one cluster's valid influences, clusters are independent so this runs in parallel */
+static void fbx_skin_extract_clusters(void* t_context, size_t t_begin, size_t t_end)
+{
+	fbx_skin_extract_context* context = (fbx_skin_extract_context*)t_context;
+	size_t i = t_begin;
+	for (; i < t_end; ++i)
+	{
+		fbx_node_record* cluster = context->clusters[i];
+		char index_typecode = 0;
+		char weight_typecode = 0;
+		int index_length = 0;
+		int weight_length = 0;
+		const int* indexes = (const int*)fbx_node_get_child_array(context->fbx, cluster, "Indexes", &index_typecode, &index_length);
+		const void* weights = fbx_node_get_child_array(context->fbx, cluster, "Weights", &weight_typecode, &weight_length);
+
+		context->skin->bone_ids[i] = 0;
+		long long cluster_id;
+		vector models;
+		if (fbx_node_get_id(cluster, &cluster_id) && vector_init(&models, sizeof(fbx_node_record*)))
+		{
+			if (fbx_find_connected_objects(context->fbx, cluster_id, "Model", 0, &models) && models.element_count)
+			{
+				fbx_node_get_id(*((fbx_node_record**)vector_get_index(&models, 0)), &context->skin->bone_ids[i]);
+			}
+			vector_final(&models);
+		}
+
+		context->cluster_influence_counts[i] = 0;
+		context->cluster_influences[i] = 0;
+		if (index_typecode != 'i' || (weight_typecode != 'd' && weight_typecode != 'f'))
+		{
+			continue;
+		}
+		int count = index_length < weight_length ? index_length : weight_length;
+		if (count <= 0)
+		{
+			continue;
+		}
+		fbx_skin_influence* influences = malloc(sizeof(fbx_skin_influence) * count);
+		if (!influences)
+		{
+			context->is_failed = 1;
+			continue;
+		}
+		unsigned int influence_count = 0;
+		int j = 0;
+		for (; j < count; ++j)
+		{
+			float weight = weight_typecode == 'd' ? (float)((const double*)weights)[j] : ((const float*)weights)[j];
+			if (indexes[j] < 0 || (unsigned int)indexes[j] >= context->skin->vertex_count || !(weight > 0.0f))
+			{
+				continue;
+			}
+			influences[influence_count].vertex = (unsigned int)indexes[j];
+			influences[influence_count].weight = weight;
+			++influence_count;
+		}
+		context->cluster_influences[i] = influences;
+		context->cluster_influence_counts[i] = influence_count;
+	}
+}
+
+/* keeps the four strongest influences of each vertex and quantizes them so they sum exactly to one */
+static void fbx_skin_pack_vertices(void* t_context, size_t t_begin, size_t t_end)
+{
+	fbx_skin_extract_context* context = (fbx_skin_extract_context*)t_context;
+	fbx_skin* skin = context->skin;
+	unsigned int maximum = skin->weight_type == GL_UNSIGNED_BYTE ? 255 : 65535;
+	size_t vertex = t_begin;
+	for (; vertex < t_end; ++vertex)
+	{
+		fbx_skin_bone_weight top[FBX_SKIN_INFLUENCES];
+		unsigned int quantized[FBX_SKIN_INFLUENCES];
+		unsigned int top_count = 0;
+		unsigned int i = context->vertex_offsets[vertex];
+		unsigned int j;
+		for (; i < context->vertex_offsets[vertex + 1]; ++i)
+		{
+			fbx_skin_bone_weight influence = context->vertex_influences[i];
+			if (top_count == FBX_SKIN_INFLUENCES && influence.weight <= top[FBX_SKIN_INFLUENCES - 1].weight)
+			{
+				continue;
+			}
+			j = top_count < FBX_SKIN_INFLUENCES ? top_count++ : FBX_SKIN_INFLUENCES - 1;
+			for (; j && top[j - 1].weight < influence.weight; --j)
+			{
+				top[j] = top[j - 1];
+			}
+			top[j] = influence;
+		}
+
+		float sum = 0.0f;
+		for (j = 0; j < top_count; ++j)
+		{
+			sum += top[j].weight;
+		}
+		unsigned int quantized_sum = 0;
+		for (j = 0; j < FBX_SKIN_INFLUENCES; ++j)
+		{
+			quantized[j] = j < top_count ? (unsigned int)(top[j].weight / sum * (float)maximum + 0.5f) : 0;
+			quantized_sum += quantized[j];
+		}
+		if (top_count)
+		{
+			/* rounding error is absorbed by the strongest influence */
+			quantized[0] = quantized[0] + maximum - quantized_sum;
+		}
+
+		for (j = 0; j < FBX_SKIN_INFLUENCES; ++j)
+		{
+			size_t element = vertex * FBX_SKIN_INFLUENCES + j;
+			unsigned int bone = j < top_count ? top[j].bone : 0;
+			if (skin->index_type == GL_UNSIGNED_BYTE)
+			{
+				((unsigned char*)skin->indices)[element] = (unsigned char)bone;
+			}
+			else
+			{
+				((unsigned short*)skin->indices)[element] = (unsigned short)bone;
+			}
+			if (skin->weight_type == GL_UNSIGNED_BYTE)
+			{
+				((unsigned char*)skin->weights)[element] = (unsigned char)quantized[j];
+			}
+			else
+			{
+				((unsigned short*)skin->weights)[element] = (unsigned short)quantized[j];
+			}
+		}
+	}
+}
+
+int fbx_skin_extract(fbx_skin* t_skin, fbx* t_fbx, fbx_node_record* t_geometry, thread_pool* t_pool, unsigned int t_weight_type)
+{
+	assert(t_skin && t_fbx && t_geometry);
+	assert(t_weight_type == GL_UNSIGNED_BYTE || t_weight_type == GL_UNSIGNED_SHORT);
+
+	memset(t_skin, 0, sizeof(fbx_skin));
+
+	fbx_node_record* deformer = fbx_skin_find_deformer(t_fbx, t_geometry);
+	long long deformer_id;
+	if (!deformer || !fbx_node_get_id(deformer, &deformer_id))
+	{
+		return 0;
+	}
+
+	char typecode = 0;
+	int length = 0;
+	fbx_node_get_child_array(t_fbx, t_geometry, "Vertices", &typecode, &length);
+	t_skin->vertex_count = (unsigned int)(length / 3);
+
+	vector clusters;
+	if (!vector_init(&clusters, sizeof(fbx_node_record*)))
+	{
+		return 0;
+	}
+	if (!fbx_find_connected_objects(t_fbx, deformer_id, "Deformer", "Cluster", &clusters))
+	{
+		vector_final(&clusters);
+		return 0;
+	}
+
+	fbx_skin_extract_context context;
+	memset(&context, 0, sizeof(context));
+	context.skin = t_skin;
+	context.fbx = t_fbx;
+	context.clusters = (fbx_node_record**)clusters.buffer.data;
+
+	t_skin->bone_count = (unsigned int)clusters.element_count;
+	t_skin->index_type = t_skin->bone_count <= 256 ? GL_UNSIGNED_BYTE : GL_UNSIGNED_SHORT;
+	t_skin->weight_type = t_weight_type;
+	t_skin->bone_ids = malloc(sizeof(long long) * (t_skin->bone_count ? t_skin->bone_count : 1));
+	t_skin->indices = malloc((t_skin->index_type == GL_UNSIGNED_BYTE ? 1 : 2) * FBX_SKIN_INFLUENCES * (size_t)(t_skin->vertex_count ? t_skin->vertex_count : 1));
+	t_skin->weights = malloc((t_weight_type == GL_UNSIGNED_BYTE ? 1 : 2) * FBX_SKIN_INFLUENCES * (size_t)(t_skin->vertex_count ? t_skin->vertex_count : 1));
+	context.cluster_influences = calloc(t_skin->bone_count ? t_skin->bone_count : 1, sizeof(fbx_skin_influence*));
+	context.cluster_influence_counts = calloc(t_skin->bone_count ? t_skin->bone_count : 1, sizeof(unsigned int));
+	context.vertex_offsets = calloc((size_t)t_skin->vertex_count + 1, sizeof(unsigned int));
+	if (!t_skin->bone_ids || !t_skin->indices || !t_skin->weights || !context.cluster_influences || !context.cluster_influence_counts || !context.vertex_offsets)
+	{
+		goto skin_extract_fail;
+	}
+
+	thread_pool_parallel_for(t_pool, t_skin->bone_count, FBX_SKIN_CLUSTER_GRAIN, fbx_skin_extract_clusters, &context);
+	if (context.is_failed)
+	{
+		goto skin_extract_fail;
+	}
+
+	/* counting sort the cluster major influences into vertex major order, cluster order keeps it deterministic */
+	unsigned int bone;
+	unsigned int i;
+	for (bone = 0; bone < t_skin->bone_count; ++bone)
+	{
+		for (i = 0; i < context.cluster_influence_counts[bone]; ++i)
+		{
+			++context.vertex_offsets[context.cluster_influences[bone][i].vertex + 1];
+		}
+	}
+	for (i = 0; i < t_skin->vertex_count; ++i)
+	{
+		context.vertex_offsets[i + 1] += context.vertex_offsets[i];
+	}
+	unsigned int influence_total = context.vertex_offsets[t_skin->vertex_count];
+	unsigned int* cursors = malloc(sizeof(unsigned int) * ((size_t)t_skin->vertex_count + 1));
+	context.vertex_influences = malloc(sizeof(fbx_skin_bone_weight) * (influence_total ? influence_total : 1));
+	if (!cursors || !context.vertex_influences)
+	{
+		free(cursors);
+		goto skin_extract_fail;
+	}
+	memcpy(cursors, context.vertex_offsets, sizeof(unsigned int) * ((size_t)t_skin->vertex_count + 1));
+	for (bone = 0; bone < t_skin->bone_count; ++bone)
+	{
+		for (i = 0; i < context.cluster_influence_counts[bone]; ++i)
+		{
+			const fbx_skin_influence* influence = &context.cluster_influences[bone][i];
+			fbx_skin_bone_weight* target = &context.vertex_influences[cursors[influence->vertex]++];
+			target->bone = bone;
+			target->weight = influence->weight;
+		}
+	}
+	free(cursors);
+
+	thread_pool_parallel_for(t_pool, t_skin->vertex_count, FBX_SKIN_VERTEX_GRAIN, fbx_skin_pack_vertices, &context);
+
+	for (bone = 0; bone < t_skin->bone_count; ++bone)
+	{
+		free(context.cluster_influences[bone]);
+	}
+	free(context.cluster_influences);
+	free(context.cluster_influence_counts);
+	free(context.vertex_offsets);
+	free(context.vertex_influences);
+	vector_final(&clusters);
+	return 1;
+
+skin_extract_fail:
+	if (context.cluster_influences)
+	{
+		for (bone = 0; bone < t_skin->bone_count; ++bone)
+		{
+			free(context.cluster_influences[bone]);
+		}
+	}
+	free(context.cluster_influences);
+	free(context.cluster_influence_counts);
+	free(context.vertex_offsets);
+	free(context.vertex_influences);
+	vector_final(&clusters);
+	fbx_skin_final(t_skin);
+	return 0;
+}
+
+void fbx_skin_get_vertex_attributes(fbx_skin* t_skin, vertex_attribute* t_out_indices, vertex_attribute* t_out_weights)
+{
+	assert(t_skin && t_out_indices && t_out_weights);
+
+	unsigned int index_size = t_skin->index_type == GL_UNSIGNED_BYTE ? 1 : 2;
+	unsigned int weight_size = t_skin->weight_type == GL_UNSIGNED_BYTE ? 1 : 2;
+
+	t_out_indices->buffer = t_skin->indices;
+	t_out_indices->buffer_size = (size_t)t_skin->vertex_count * FBX_SKIN_INFLUENCES * index_size;
+	t_out_indices->size = FBX_SKIN_INFLUENCES;
+	t_out_indices->type = t_skin->index_type;
+	t_out_indices->stride = FBX_SKIN_INFLUENCES * index_size;
+	t_out_indices->flags = VERTEX_ATTRIBUTE_INTEGER;
+
+	t_out_weights->buffer = t_skin->weights;
+	t_out_weights->buffer_size = (size_t)t_skin->vertex_count * FBX_SKIN_INFLUENCES * weight_size;
+	t_out_weights->size = FBX_SKIN_INFLUENCES;
+	t_out_weights->type = t_skin->weight_type;
+	t_out_weights->stride = FBX_SKIN_INFLUENCES * weight_size;
+	t_out_weights->flags = VERTEX_ATTRIBUTE_NORMALIZED;
+}
+
+void fbx_skin_final(fbx_skin* t_skin)
+{
+	if (t_skin)
+	{
+		free(t_skin->bone_ids);
+		free(t_skin->indices);
+		free(t_skin->weights);
+		memset(t_skin, 0, sizeof(fbx_skin));
+	}
+}
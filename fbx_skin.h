@@ -0,0 +1,65 @@
+/**
+ * fbx_skin.h
+ */
+
+#ifndef GRAPHICS_UTILS_FBX_SKIN_H
+#define GRAPHICS_UTILS_FBX_SKIN_H
+
+#include "graphics.h"
+#include "thread_pool.h"
+
+/** the number of bone influences stored per vertex */
+#define FBX_SKIN_INFLUENCES 4
+
+/**	@struct		fbx_skin
+ *	@brief		per vertex bone influences extracted from a Skin deformer and its Clusters
+ *	@member		fbx_skin::vertex_count - the number of control points in the skinned geometry
+ *	@member		fbx_skin::bone_count - the number of clusters, bone indices refer to clusters in this order
+ *	@member		fbx_skin::bone_ids - the object id of the Model linked to each cluster, 0 if unlinked
+ *	@member		fbx_skin::index_type - GL_UNSIGNED_BYTE if there are at most 256 bones, otherwise GL_UNSIGNED_SHORT
+ *	@member		fbx_skin::indices - FBX_SKIN_INFLUENCES bone indices per vertex
+ *	@member		fbx_skin::weight_type - GL_UNSIGNED_BYTE or GL_UNSIGNED_SHORT, weights are unsigned normalized
+ *	@member		fbx_skin::weights - FBX_SKIN_INFLUENCES weights per vertex, summing exactly to the type's maximum,
+ *				vertices without influences have zero weights
+ */
+typedef struct
+{
+	unsigned int vertex_count;
+	unsigned int bone_count;
+	long long* bone_ids;
+	unsigned int index_type;
+	void* indices;
+	unsigned int weight_type;
+	void* weights;
+} fbx_skin;
+
+/** returns the first Skin deformer connected to a Geometry node, or 0
+ *	@memberof	fbx_skin
+ */
+fbx_node_record* fbx_skin_find_deformer(fbx* t_fbx, fbx_node_record* t_geometry);
+
+/** extracts the strongest four influences per control point of a skinned Geometry node
+ *	@memberof	fbx_skin
+ *	@param		t_skin - an invalid skin to be initialized
+ *	@param		t_fbx - a loaded fbx
+ *	@param		t_geometry - a Geometry node with a connected Skin deformer
+ *	@param		t_pool - an optional thread pool to process clusters and vertices across
+ *	@param		t_weight_type - GL_UNSIGNED_BYTE or GL_UNSIGNED_SHORT
+ *	@returns	nonzero if extracted successfully
+ */
+int fbx_skin_extract(fbx_skin* t_skin, fbx* t_fbx, fbx_node_record* t_geometry, thread_pool* t_pool, unsigned int t_weight_type);
+
+/** describes the skin's bone indices and weights as vertex attributes, the buffers remain owned by the skin
+ *	@memberof	fbx_skin
+ *	@param		t_skin - a valid skin
+ *	@param		t_out_indices - the vertex attribute to receive the bone indices
+ *	@param		t_out_weights - the vertex attribute to receive the weights
+ */
+void fbx_skin_get_vertex_attributes(fbx_skin* t_skin, vertex_attribute* t_out_indices, vertex_attribute* t_out_weights);
+
+/** finalizes an extracted skin
+ *	@memberof	fbx_skin
+ */
+void fbx_skin_final(fbx_skin* t_skin);
+
+#endif
@@ -0,0 +1,109 @@
+#include "fbx_texture.h"
+
+#include "assert.h"
+#include "stdlib.h"
+#include "string.h"
+
+/* returns the string of a child's first property, or 0 if it is missing or empty */
+static const char* fbx_texture_get_child_string(fbx* t_fbx, fbx_node_record* t_node, const char* t_name)
+{
+	fbx_node_record* child = fbx_node_find_child(t_fbx, t_node, t_name);
+	fbx_property* property = child ? fbx_node_get_property(child, 0) : 0;
+	if (!property || property->typecode != 'S' || !property->data.size || !((const char*)property->data.data)[0])
+	{
+		return 0;
+	}
+	return (const char*)property->data.data;
+}
+
+const unsigned char* fbx_video_get_content(fbx* t_fbx, fbx_node_record* t_video, size_t* t_out_size)
+{
+	assert(t_fbx && t_video && t_out_size);
+
+	*t_out_size = 0;
+	fbx_node_record* content = fbx_node_find_child(t_fbx, t_video, "Content");
+	fbx_property* property = content ? fbx_node_get_property(content, 0) : 0;
+	if (!property || property->typecode != 'R' || !property->data.size)
+	{
+		return 0;
+	}
+	*t_out_size = property->data.size;
+	return (const unsigned char*)property->data.data;
+}
+
+int fbx_video_load_texture(fbx* t_fbx, fbx_node_record* t_video, texture* t_out_texture)
+{
+	assert(t_fbx && t_video && t_out_texture);
+
+	size_t size;
+	const unsigned char* content = fbx_video_get_content(t_fbx, t_video, &size);
+	return content && load_texture_memory(t_out_texture, content, size);
+}
+
+/* queues the file of a Video object, a relative name is joined to the directory of the fbx */
+static int fbx_texture_push_file(fbx* t_fbx, fbx_node_record* t_video, const char* t_path, image_queue* t_queue, unsigned int* t_out_image)
+{
+	const char* relative = fbx_texture_get_child_string(t_fbx, t_video, "RelativeFilename");
+	const char* absolute = fbx_texture_get_child_string(t_fbx, t_video, "Filename");
+	if (!relative)
+	{
+		return absolute ? image_queue_push_file(t_queue, absolute, t_out_image) : -1;
+	}
+
+	size_t directory_length = 0, i;
+	for (i = 0; t_path[i]; ++i)
+	{
+		if (t_path[i] == '/' || t_path[i] == '\\')
+		{
+			directory_length = i + 1;
+		}
+	}
+	size_t relative_length = strlen(relative);
+	char* path = malloc(directory_length + relative_length + 1);
+	if (!path)
+	{
+		return 0;
+	}
+	memcpy(path, t_path, directory_length);
+	memcpy(path + directory_length, relative, relative_length + 1);
+	int result = image_queue_push_file(t_queue, path, t_out_image);
+	free(path);
+	return result;
+}
+
+int fbx_push_videos(fbx* t_fbx, const char* t_path, image_queue* t_queue, vector* t_out_images)
+{
+	assert(t_fbx && t_path && t_queue && t_out_images);
+
+	fbx_node_record* objects = fbx_find_root_node(t_fbx, "Objects");
+	if (!objects)
+	{
+		return 1;
+	}
+	int i = 0;
+	for (; i < objects->children.element_count; ++i)
+	{
+		fbx_node_record* object = fbx_get_node(t_fbx, *((int*)vector_get_index(&objects->children, i)));
+		if (!object || !fbx_node_is_object(object, "Video", 0))
+		{
+			continue;
+		}
+
+		/* every job is queued as soon as it is found, so decoding overlaps the search for the rest */
+		fbx_video_image video_image;
+		size_t size;
+		const unsigned char* content = fbx_video_get_content(t_fbx, object, &size);
+		int result = content ? image_queue_push_memory(t_queue, content, size, &video_image.image)
+			: fbx_texture_push_file(t_fbx, object, t_path, t_queue, &video_image.image);
+		if (result < 0)
+		{
+			continue;
+		}
+		video_image.video = object;
+		if (!result || !vector_push(t_out_images, &video_image))
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
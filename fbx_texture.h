@@ -0,0 +1,48 @@
+/**
+ * fbx_texture.h
+ */
+
+#ifndef GRAPHICS_UTILS_FBX_TEXTURE_H
+#define GRAPHICS_UTILS_FBX_TEXTURE_H
+
+#include "fbx_import.h"
+#include "image_queue.h"
+
+/**	@struct		fbx_video_image
+ *	@brief		the image queued for a Video object
+ *	@member		fbx_video_image::video - the Video node
+ *	@member		fbx_video_image::image - the index of the image in the queue
+ */
+typedef struct
+{
+	fbx_node_record* video;
+	unsigned int image;
+} fbx_video_image;
+
+/** returns the embedded file of a Video node, which is held by its Content raw property, or 0 if it has none
+ *	@param		t_fbx - a loaded fbx
+ *	@param		t_video - a Video node
+ *	@param		t_out_size - receives the size of the embedded file
+ */
+const unsigned char* fbx_video_get_content(fbx* t_fbx, fbx_node_record* t_video, size_t* t_out_size);
+
+/** decodes the embedded file of a Video node straight from its Content raw property into a texture, this must be
+ *	called from the thread owning the GL context
+ *	@param		t_fbx - a loaded fbx
+ *	@param		t_video - a Video node with embedded content
+ *	@param		t_out_texture - an invalid texture to be initialized
+ *	@returns	nonzero if the video had embedded content which decoded successfully
+ */
+int fbx_video_load_texture(fbx* t_fbx, fbx_node_record* t_video, texture* t_out_texture);
+
+/** queues the image of every Video object, embedded content is decoded in place and anything else is read from
+ *	its RelativeFilename, or failing that its Filename, the fbx must outlive the decoding of embedded images
+ *	@param		t_fbx - a loaded fbx
+ *	@param		t_path - the path the fbx was loaded from, which relative file names are resolved against
+ *	@param		t_queue - a valid image queue
+ *	@param		t_out_images - an initialized vector of fbx_video_image to receive each queued image
+ *	@returns	nonzero if every Video object with an image was queued
+ */
+int fbx_push_videos(fbx* t_fbx, const char* t_path, image_queue* t_queue, vector* t_out_images);
+
+#endif
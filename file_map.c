@@ -0,0 +1,137 @@
+#include "file_map.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+typedef struct {
+
+	HANDLE file;
+	HANDLE mapping;
+} file_map_internal;
+
+int init_file_map(file_map* t_map, const char* t_filepath) {
+
+	assert(t_map && t_filepath);
+
+	LARGE_INTEGER size;
+	file_map_internal* internal = malloc(sizeof(file_map_internal));
+	t_map->data = 0;
+	t_map->size = 0;
+	t_map->internal = internal;
+	if (!internal) {
+
+		return 0;
+	}
+	internal->mapping = 0;
+	internal->file = CreateFileA(t_filepath, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 0);
+	if (internal->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(internal->file, &size)) {
+
+		final_file_map(t_map);
+		return 0;
+	}
+	t_map->size = (size_t)size.QuadPart;
+	if (!t_map->size) {
+
+		return 1;
+	}
+	internal->mapping = CreateFileMappingA(internal->file, 0, PAGE_READONLY, 0, 0, 0);
+	t_map->data = internal->mapping ? MapViewOfFile(internal->mapping, FILE_MAP_READ, 0, 0, 0) : 0;
+	if (!t_map->data) {
+
+		final_file_map(t_map);
+		return 0;
+	}
+
+	return 1;
+}
+
+void final_file_map(file_map* t_map) {
+
+	assert(t_map);
+
+	file_map_internal* internal = t_map->internal;
+	if (t_map->data) {
+
+		UnmapViewOfFile(t_map->data);
+	}
+	if (internal) {
+
+		if (internal->mapping) {
+
+			CloseHandle(internal->mapping);
+		}
+		if (internal->file != INVALID_HANDLE_VALUE) {
+
+			CloseHandle(internal->file);
+		}
+		free(internal);
+	}
+	t_map->data = 0;
+	t_map->size = 0;
+	t_map->internal = 0;
+}
+
+#else
+
+int init_file_map(file_map* t_map, const char* t_filepath) {
+
+	assert(t_map && t_filepath);
+
+	struct stat status;
+	int descriptor = open(t_filepath, O_RDONLY);
+	t_map->data = 0;
+	t_map->size = 0;
+	t_map->internal = 0;
+	if (descriptor < 0) {
+
+		return 0;
+	}
+	if (fstat(descriptor, &status) != 0) {
+
+		close(descriptor);
+		return 0;
+	}
+	t_map->size = (size_t)status.st_size;
+	if (t_map->size) {
+
+		void* data = mmap(0, t_map->size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		if (data == MAP_FAILED) {
+
+			close(descriptor);
+			t_map->size = 0;
+			return 0;
+		}
+		madvise(data, t_map->size, MADV_WILLNEED);
+		t_map->data = data;
+	}
+
+	/* the mapping stays valid once the descriptor is closed */
+	close(descriptor);
+	return 1;
+}
+
+void final_file_map(file_map* t_map) {
+
+	assert(t_map);
+
+	if (t_map->data) {
+
+		munmap((void*)t_map->data, t_map->size);
+	}
+	t_map->data = 0;
+	t_map->size = 0;
+	t_map->internal = 0;
+}
+
+#endif
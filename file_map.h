@@ -0,0 +1,37 @@
+/**
+ * file_map.h
+ */
+
+#ifndef GRAPHICS_UTILS_FILE_MAP_H
+#define GRAPHICS_UTILS_FILE_MAP_H
+
+#include <stddef.h>
+
+/**	@struct		file_map
+ *	@brief		a read only view of a whole file mapped into memory
+ *	@member		file_map::data - the base address of the file's contents, 0 for an empty file
+ *	@member		file_map::size - the size of the file in bytes
+ *	@member		file_map::internal - the platform specific file and mapping handles
+ */
+typedef struct {
+
+	const unsigned char* data;
+	size_t size;
+	void* internal;
+} file_map;
+
+/** maps a file into memory for reading
+ *	@memberof	file_map
+ *	@param		t_map - an invalid file map to be initialized
+ *	@param		t_filepath - the path of the file to map
+ *	@returns	nonzero if the file was mapped
+ */
+int init_file_map(file_map* t_map, const char* t_filepath);
+
+/** unmaps a file, every pointer into the mapping becomes invalid
+ *	@memberof	file_map
+ *	@param		t_map - a valid file map to be finalized
+ */
+void final_file_map(file_map* t_map);
+
+#endif
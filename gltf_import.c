@@ -1,33 +1,1597 @@
-
 #include "gltf_import.h"
 
 #include "assert.h"
-#include "stdio.h"
+#include "math.h"
+#include "stdlib.h"
+#include "string.h"
+
+#include "gltf_meshopt.h"
+#include "simd.h"
+
+#define GLTF_GLB_MAGIC 0x46546C67u
+#define GLTF_GLB_CHUNK_JSON 0x4E4F534Au
+#define GLTF_GLB_CHUNK_BIN 0x004E4942u
+#define GLTF_GLB_HEADER_SIZE 12
+#define GLTF_GLB_CHUNK_HEADER_SIZE 8
+
+typedef struct
+{
+	unsigned int buffer;
+	size_t offset;
+	size_t size;
+	size_t stride;
+	size_t count;
+	unsigned int mode;
+	unsigned int filter;
+} gltf_meshopt_source;
+
+typedef struct
+{
+	gltf* gltf;
+	const char* path;
+	const unsigned int* sources;
+	const int* view_extensions;
+	unsigned int buffer;
+	unsigned int buffer_count;
+	int element;
+	int is_pushed;
+	int is_failed;
+	thread_pool_group group;
+} gltf_fetch_context;
+
+typedef struct
+{
+	thread_pool* pool;
+	unsigned int fetch_count;
+	gltf_fetch_context* fetches;
+	unsigned int* sources;
+	int* view_extensions;
+	int* sparse_elements;
+	unsigned char* is_resolved;
+} gltf_load_context;
+
+static const char* g_gltf_attribute_names[GLTF_ATTRIBUTE_COUNT] =
+{
+	"POSITION", "NORMAL", "TANGENT", "TEXCOORD_0", "TEXCOORD_1", "COLOR_0", "JOINTS_0", "WEIGHTS_0"
+};
+
+static unsigned int gltf_get_component_size(unsigned int t_component_type)
+{
+	switch (t_component_type)
+	{
+	case GL_BYTE:
+	case GL_UNSIGNED_BYTE:
+		return 1;
+	case GL_SHORT:
+	case GL_UNSIGNED_SHORT:
+		return 2;
+	case GL_UNSIGNED_INT:
+	case GL_FLOAT:
+		return 4;
+	}
+	return 0;
+}
+
+static unsigned int gltf_get_component_count(const json* t_json, int t_type)
+{
+	static const char* types[7] = { "SCALAR", "VEC2", "VEC3", "VEC4", "MAT2", "MAT3", "MAT4" };
+	static const unsigned int counts[7] = { 1, 2, 3, 4, 4, 9, 16 };
+	unsigned int i;
+	for (i = 0; i < 7; ++i)
+	{
+		if (json_string_equals(t_json, t_type, types[i]))
+		{
+			return counts[i];
+		}
+	}
+	return 0;
+}
+
+static unsigned int gltf_get_array_count(const json* t_json, int t_array)
+{
+	return t_array >= 0 && t_json->tokens[t_array].type == JSON_ARRAY ? t_json->tokens[t_array].count : 0;
+}
+
+/* returns the position of a string token within a list of names, or -1 */
+static int gltf_find_name(const json* t_json, int t_string, const char* const* t_names, unsigned int t_count)
+{
+	unsigned int i;
+	for (i = 0; t_string >= 0 && i < t_count; ++i)
+	{
+		if (json_string_equals(t_json, t_string, t_names[i]))
+		{
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+static int gltf_get_index(const json* t_json, int t_object, const char* t_key, unsigned int t_count)
+{
+	long long index = json_get_integer(t_json, json_find(t_json, t_object, t_key), -1);
+	return index >= 0 && index < (long long)t_count ? (int)index : -1;
+}
+
+#if SIMD_X86_DISPATCH
+/* translates sixteen characters at a time, the high and low nibble tables flag any character outside of the standard
+ * alphabet so the block is left to the scalar decoder, returns the number of characters consumed */
+SIMD_TARGET("ssse3") static size_t gltf_decode_base64_ssse3(const char* t_source, size_t t_length, unsigned char* t_out, size_t t_out_size)
+{
+	const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i mask_2f = _mm_set1_epi8(0x2F);
+	const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	size_t consumed = 0, written = 0;
+	for (; consumed + 16 <= t_length && written + 16 <= t_out_size; consumed += 16, written += 12)
+	{
+		__m128i text = _mm_loadu_si128((const __m128i*)(t_source + consumed));
+		__m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(text, 4), mask_2f);
+		__m128i lo = _mm_shuffle_epi8(lut_lo, _mm_and_si128(text, mask_2f));
+		__m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+		if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())))
+		{
+			break;
+		}
+		__m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(text, mask_2f), hi_nibbles));
+		__m128i values = _mm_add_epi8(text, roll);
+
+		/* merges pairs of sextets into twelve bits, then pairs of those into the three bytes of each group */
+		__m128i merged = _mm_madd_epi16(_mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140)), _mm_set1_epi32(0x00011000));
+		_mm_storeu_si128((__m128i*)(t_out + written), _mm_shuffle_epi8(merged, pack));
+	}
+	return consumed;
+}
+
+SIMD_TARGET("avx2") static size_t gltf_decode_base64_avx2(const char* t_source, size_t t_length, unsigned char* t_out, size_t t_out_size)
+{
+	const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+		0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m256i mask_2f = _mm256_set1_epi8(0x2F);
+	const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+		2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1);
+	size_t consumed = 0, written = 0;
+	for (; consumed + 32 <= t_length && written + 32 <= t_out_size; consumed += 32, written += 24)
+	{
+		__m256i text = _mm256_loadu_si256((const __m256i*)(t_source + consumed));
+		__m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(text, 4), mask_2f);
+		__m256i lo = _mm256_shuffle_epi8(lut_lo, _mm256_and_si256(text, mask_2f));
+		__m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+		if (!_mm256_testz_si256(lo, hi))
+		{
+			break;
+		}
+		__m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(_mm256_cmpeq_epi8(text, mask_2f), hi_nibbles));
+		__m256i values = _mm256_add_epi8(text, roll);
+		__m256i merged = _mm256_madd_epi16(_mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140)), _mm256_set1_epi32(0x00011000));
+		_mm256_storeu_si256((__m256i*)(t_out + written), _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(merged, pack), lanes));
+	}
+	return consumed;
+}
+#endif
+
+/* decodes straight into the destination, whole blocks of the standard alphabet are vectorized and the scalar loop
+ * finishes the tail along with padding, the url safe alphabet and anything invalid */
+static int gltf_decode_base64(const char* t_source, size_t t_length, unsigned char* t_out, size_t t_out_size)
+{
+	size_t i = 0, written;
+	unsigned int bits = 0, bit_count = 0;
+#if SIMD_X86_DISPATCH
+	unsigned int features = simd_get_features();
+	if (features & SIMD_FEATURE_AVX2)
+	{
+		i = gltf_decode_base64_avx2(t_source, t_length, t_out, t_out_size);
+	}
+	else if (features & SIMD_FEATURE_SSSE3)
+	{
+		i = gltf_decode_base64_ssse3(t_source, t_length, t_out, t_out_size);
+	}
+#endif
+	written = i / 4 * 3;
+	for (; i < t_length && t_source[i] != '='; ++i)
+	{
+		char c = t_source[i];
+		unsigned int value;
+		if (c >= 'A' && c <= 'Z') value = (unsigned int)(c - 'A');
+		else if (c >= 'a' && c <= 'z') value = (unsigned int)(c - 'a' + 26);
+		else if (c >= '0' && c <= '9') value = (unsigned int)(c - '0' + 52);
+		else if (c == '+' || c == '-') value = 62;
+		else if (c == '/' || c == '_') value = 63;
+		else return 0;
+
+		bits = (bits << 6) | value;
+		bit_count += 6;
+		if (bit_count >= 8)
+		{
+			bit_count -= 8;
+			if (written == t_out_size)
+			{
+				return 0;
+			}
+			t_out[written++] = (unsigned char)(bits >> bit_count);
+		}
+	}
+	return written == t_out_size;
+}
+
+/* decodes a data uri into owned memory, only base64 encoded data is supported */
+static int gltf_load_data_uri(gltf_buffer* t_buffer, const char* t_uri, size_t t_uri_length)
+{
+	const char* data = memchr(t_uri, ',', t_uri_length);
+	if (!data || data - t_uri < 12 || memcmp(data - 7, ";base64", 7) != 0)
+	{
+		return 0;
+	}
+	++data;
+	t_buffer->owned = malloc(t_buffer->size ? t_buffer->size : 1);
+	t_buffer->data = t_buffer->owned;
+	return t_buffer->owned && gltf_decode_base64(data, t_uri_length - (size_t)(data - t_uri), t_buffer->owned, t_buffer->size);
+}
+
+static unsigned int gltf_read_u32(const unsigned char* t_data)
+{
+	return (unsigned int)t_data[0] | ((unsigned int)t_data[1] << 8) | ((unsigned int)t_data[2] << 16) | ((unsigned int)t_data[3] << 24);
+}
+
+/* splits a mapped .glb file into its JSON and BIN chunks, both of which are left in place */
+static int gltf_read_glb(gltf* t_gltf, const char** t_out_json, size_t* t_out_json_length)
+{
+	const unsigned char* data = t_gltf->map.data;
+	size_t size = t_gltf->map.size;
+	if (size < GLTF_GLB_HEADER_SIZE + GLTF_GLB_CHUNK_HEADER_SIZE
+		|| gltf_read_u32(data + 4) != 2 || gltf_read_u32(data + 8) > size)
+	{
+		return 0;
+	}
+	size = gltf_read_u32(data + 8);
+
+	size_t json_length = gltf_read_u32(data + GLTF_GLB_HEADER_SIZE);
+	size_t offset = GLTF_GLB_HEADER_SIZE + GLTF_GLB_CHUNK_HEADER_SIZE;
+	if (gltf_read_u32(data + GLTF_GLB_HEADER_SIZE + 4) != GLTF_GLB_CHUNK_JSON || json_length > size - offset)
+	{
+		return 0;
+	}
+	*t_out_json = (const char*)data + offset;
+	*t_out_json_length = json_length;
+
+	/* chunks are padded to four bytes, so the BIN chunk and everything in it keeps the alignment of the mapping */
+	offset += (json_length + 3) & ~(size_t)3;
+	if (offset + GLTF_GLB_CHUNK_HEADER_SIZE <= size && gltf_read_u32(data + offset + 4) == GLTF_GLB_CHUNK_BIN)
+	{
+		size_t binary_size = gltf_read_u32(data + offset);
+		offset += GLTF_GLB_CHUNK_HEADER_SIZE;
+		if (binary_size > size - offset)
+		{
+			return 0;
+		}
+		t_gltf->binary = data + offset;
+		t_gltf->binary_size = binary_size;
+	}
+	return 1;
+}
+
+/* resolves a buffer uri relative to the .gltf file, percent escapes are decoded */
+static int gltf_resolve_uri(const char* t_path, const char* t_uri, size_t t_uri_length, char* t_out, size_t t_out_size)
+{
+	size_t directory_length = 0, i, length;
+	for (i = 0; t_path[i]; ++i)
+	{
+		if (t_path[i] == '/' || t_path[i] == '\\')
+		{
+			directory_length = i + 1;
+		}
+	}
+	if (directory_length + t_uri_length >= t_out_size)
+	{
+		return 0;
+	}
+	memcpy(t_out, t_path, directory_length);
+	length = directory_length;
+	for (i = 0; i < t_uri_length; ++i)
+	{
+		char c = t_uri[i];
+		if (c == '%' && i + 2 < t_uri_length)
+		{
+			char hex[3] = { t_uri[i + 1], t_uri[i + 2], 0 };
+			c = (char)strtol(hex, 0, 16);
+			i += 2;
+		}
+		t_out[length++] = c;
+	}
+	t_out[length] = 0;
+	return 1;
+}
+
+/* every extension the asset requires must be one the loader implements */
+static int gltf_check_extensions(const gltf* t_gltf)
+{
+	static const char* supported[3] = { "KHR_mesh_quantization", "EXT_meshopt_compression", "EXT_mesh_gpu_instancing" };
+	const json* document = &t_gltf->document;
+	int required = json_find(document, 0, "extensionsRequired");
+	unsigned int count = gltf_get_array_count(document, required), i;
+	int element = required + 1;
+	for (i = 0; i < count; ++i, element = (int)document->tokens[element].next)
+	{
+		if (gltf_find_name(document, element, supported, 3) < 0)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int gltf_get_meshopt_extension(const json* t_json, int t_object)
+{
+	return json_find(t_json, json_find(t_json, t_object, "extensions"), "EXT_meshopt_compression");
+}
+
+/* loads a declared buffer from its uri, buffers without one are the BIN chunk or a fallback and need nothing loaded */
+static int gltf_load_buffer_uri(gltf* t_gltf, gltf_buffer* t_buffer, int t_element, const char* t_path)
+{
+	const json* document = &t_gltf->document;
+	int uri = json_find(document, t_element, "uri");
+	if (uri < 0)
+	{
+		return 1;
+	}
+
+	/* a data uri is decoded from the document in place unless escapes force the string to be decoded first */
+	const char* text = document->source + document->tokens[uri].offset;
+	size_t text_length = document->tokens[uri].length;
+	if (text_length > 5 && memcmp(text, "data:", 5) == 0 && !memchr(text, '\\', text_length))
+	{
+		return gltf_load_data_uri(t_buffer, text, text_length);
+	}
+
+	size_t uri_length = document->tokens[uri].length;
+	char* uri_string = malloc(uri_length + 1);
+	if (!uri_string || !json_get_string(document, uri, uri_string, uri_length + 1, &uri_length))
+	{
+		free(uri_string);
+		return 0;
+	}
+
+	int result = 0;
+	if (uri_length > 5 && memcmp(uri_string, "data:", 5) == 0)
+	{
+		result = gltf_load_data_uri(t_buffer, uri_string, uri_length);
+	}
+	else if (!strstr(uri_string, "://"))
+	{
+		size_t path_size = strlen(t_path) + uri_length + 1;
+		char* path = malloc(path_size);
+		result = path && gltf_resolve_uri(t_path, uri_string, uri_length, path, path_size)
+			&& init_file_map(&t_buffer->map, path) && t_buffer->map.size >= t_buffer->size;
+		t_buffer->data = t_buffer->map.data;
+		free(path);
+	}
+	free(uri_string);
+	return result;
+}
+
+/* reads and validates the source range and encoding of a compressed view */
+static int gltf_read_meshopt_source(const gltf* t_gltf, int t_extension, unsigned int t_buffer_count, size_t t_view_size, gltf_meshopt_source* t_out_source)
+{
+	static const char* modes[3] = { "ATTRIBUTES", "TRIANGLES", "INDICES" };
+	static const char* filters[4] = { "NONE", "OCTAHEDRAL", "QUATERNION", "EXPONENTIAL" };
+	const json* document = &t_gltf->document;
+	int buffer = gltf_get_index(document, t_extension, "buffer", t_buffer_count);
+	long long offset = json_get_integer(document, json_find(document, t_extension, "byteOffset"), 0);
+	long long size = json_get_integer(document, json_find(document, t_extension, "byteLength"), -1);
+	long long stride = json_get_integer(document, json_find(document, t_extension, "byteStride"), -1);
+	long long count = json_get_integer(document, json_find(document, t_extension, "count"), -1);
+	int mode = gltf_find_name(document, json_find(document, t_extension, "mode"), modes, 3);
+	int filter = json_find(document, t_extension, "filter");
+	filter = filter < 0 ? GLTF_MESHOPT_FILTER_NONE : gltf_find_name(document, filter, filters, 4);
+	if (buffer < 0 || offset < 0 || size < 0 || stride <= 0 || stride > 256
+		|| count < 0 || count > 0xFFFFFFFFll || mode < 0 || filter < 0
+		|| (mode != GLTF_MESHOPT_MODE_ATTRIBUTES && filter != GLTF_MESHOPT_FILTER_NONE)
+		|| (unsigned long long)(offset + size) > t_gltf->buffers[buffer].size
+		|| (unsigned long long)(count * stride) > t_view_size)
+	{
+		return 0;
+	}
+	t_out_source->buffer = (unsigned int)buffer;
+	t_out_source->offset = (size_t)offset;
+	t_out_source->size = (size_t)size;
+	t_out_source->stride = (size_t)stride;
+	t_out_source->count = (size_t)count;
+	t_out_source->mode = (unsigned int)mode;
+	t_out_source->filter = (unsigned int)filter;
+	return 1;
+}
+
+/* decodes the source range of a compressed view into the buffer set aside for it */
+static int gltf_decode_buffer_view(gltf* t_gltf, const gltf_buffer_view* t_view, int t_extension, unsigned int t_buffer_count)
+{
+	gltf_meshopt_source source;
+	gltf_buffer* decoded = t_gltf->buffers + t_view->buffer;
+	if (!gltf_read_meshopt_source(t_gltf, t_extension, t_buffer_count, t_view->size, &source)
+		|| !t_gltf->buffers[source.buffer].data)
+	{
+		return 0;
+	}
+	decoded->owned = calloc(decoded->size ? decoded->size : 1, 1);
+	decoded->data = decoded->owned;
+	if (!decoded->owned)
+	{
+		return 0;
+	}
+
+	const unsigned char* data = t_gltf->buffers[source.buffer].data + source.offset;
+	switch (source.mode)
+	{
+	case GLTF_MESHOPT_MODE_ATTRIBUTES:
+		return gltf_meshopt_decode_vertices(decoded->owned, source.count, source.stride, data, source.size)
+			&& gltf_meshopt_apply_filter(decoded->owned, source.count, source.stride, source.filter);
+	case GLTF_MESHOPT_MODE_TRIANGLES:
+		return gltf_meshopt_decode_triangles(decoded->owned, source.count, source.stride, data, source.size);
+	}
+	return gltf_meshopt_decode_indices(decoded->owned, source.count, source.stride, data, source.size);
+}
+
+/* loads a declared buffer and then decodes every compressed view whose source lies within it */
+static void gltf_fetch_buffer(void* t_context)
+{
+	gltf_fetch_context* context = (gltf_fetch_context*)t_context;
+	gltf* gltf = context->gltf;
+	unsigned int i;
+	if (!gltf_load_buffer_uri(gltf, gltf->buffers + context->buffer, context->element, context->path))
+	{
+		context->is_failed = 1;
+		return;
+	}
+	for (i = 0; i < gltf->buffer_view_count; ++i)
+	{
+		const gltf_buffer_view* view = gltf->buffer_views + i;
+		if (context->view_extensions[i] >= 0 && context->sources[view->buffer] == context->buffer
+			&& !gltf_decode_buffer_view(gltf, view, context->view_extensions[i], context->buffer_count))
+		{
+			context->is_failed = 1;
+			return;
+		}
+	}
+}
+
+/* runs the fetch of a buffer on the pool if it has not been already, without a pool it completes before returning */
+static void gltf_push_fetch(gltf_load_context* t_context, gltf_fetch_context* t_fetch)
+{
+	if (t_fetch->is_pushed)
+	{
+		return;
+	}
+	t_fetch->is_pushed = 1;
+	if (!thread_pool_push(t_context->pool, &t_fetch->group, gltf_fetch_buffer, t_fetch))
+	{
+		gltf_fetch_buffer(t_fetch);
+	}
+}
+
+static int gltf_wait_fetch(gltf_load_context* t_context, gltf_fetch_context* t_fetch)
+{
+	thread_pool_wait(t_context->pool, &t_fetch->group);
+	return !t_fetch->is_failed;
+}
+
+/* reads the size and kind of every buffer, their data is fetched once the rest of the document is loaded */
+static int gltf_load_buffers(gltf* t_gltf, const char* t_path, gltf_load_context* t_context)
+{
+	const json* document = &t_gltf->document;
+	int buffers = json_find(document, 0, "buffers");
+	int views = json_find(document, 0, "bufferViews");
+	unsigned int i, compressed = 0;
+
+	/* every compressed view is decoded into a buffer of its own, appended after those of the document */
+	int element = views + 1;
+	for (i = 0; i < gltf_get_array_count(document, views); ++i, element = (int)document->tokens[element].next)
+	{
+		compressed += gltf_get_meshopt_extension(document, element) >= 0;
+	}
+
+	t_gltf->buffer_count = gltf_get_array_count(document, buffers);
+	t_gltf->buffers = calloc(t_gltf->buffer_count + compressed ? t_gltf->buffer_count + compressed : 1, sizeof(gltf_buffer));
+	t_context->fetch_count = t_gltf->buffer_count;
+	t_context->fetches = calloc(t_gltf->buffer_count ? t_gltf->buffer_count : 1, sizeof(gltf_fetch_context));
+	t_context->sources = malloc(sizeof(unsigned int) * (t_gltf->buffer_count + compressed ? t_gltf->buffer_count + compressed : 1));
+	if (!t_gltf->buffers || !t_context->fetches || !t_context->sources)
+	{
+		return 0;
+	}
+
+	element = buffers + 1;
+	for (i = 0; i < t_gltf->buffer_count; ++i, element = (int)document->tokens[element].next)
+	{
+		gltf_buffer* buffer = t_gltf->buffers + i;
+		gltf_fetch_context* fetch = t_context->fetches + i;
+		long long size = json_get_integer(document, json_find(document, element, "byteLength"), -1);
+		int uri = json_find(document, element, "uri");
+		if (size < 0)
+		{
+			return 0;
+		}
+		buffer->size = (size_t)size;
+		fetch->gltf = t_gltf;
+		fetch->path = t_path;
+		fetch->sources = t_context->sources;
+		fetch->buffer = i;
+		fetch->buffer_count = t_gltf->buffer_count;
+		fetch->element = element;
+		t_context->sources[i] = i;
+
+		/* the first buffer of a .glb file may omit its uri to refer to the BIN chunk, which is used without a copy */
+		if (uri < 0 && i == 0 && t_gltf->binary && buffer->size <= t_gltf->binary_size)
+		{
+			buffer->data = t_gltf->binary;
+			continue;
+		}
+
+		/* a fallback for compressed views needs no storage, views may only refer to it through the extension */
+		if (uri < 0 ? !json_get_bool(document, json_find(document, gltf_get_meshopt_extension(document, element), "fallback"), 0)
+			: document->tokens[uri].type != JSON_STRING)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int gltf_load_buffer_views(gltf* t_gltf, gltf_load_context* t_context)
+{
+	const json* document = &t_gltf->document;
+	int views = json_find(document, 0, "bufferViews");
+	unsigned int i, buffer_count = t_gltf->buffer_count;
+
+	t_gltf->buffer_view_count = gltf_get_array_count(document, views);
+	t_gltf->buffer_views = malloc(sizeof(gltf_buffer_view) * (t_gltf->buffer_view_count ? t_gltf->buffer_view_count : 1));
+	t_context->view_extensions = malloc(sizeof(int) * (t_gltf->buffer_view_count ? t_gltf->buffer_view_count : 1));
+	if (!t_gltf->buffer_views || !t_context->view_extensions)
+	{
+		return 0;
+	}
+	for (i = 0; i < t_context->fetch_count; ++i)
+	{
+		t_context->fetches[i].view_extensions = t_context->view_extensions;
+	}
+
+	int element = views + 1;
+	for (i = 0; i < t_gltf->buffer_view_count; ++i, element = (int)document->tokens[element].next)
+	{
+		gltf_buffer_view* view = t_gltf->buffer_views + i;
+		int buffer = gltf_get_index(document, element, "buffer", buffer_count);
+		long long offset = json_get_integer(document, json_find(document, element, "byteOffset"), 0);
+		long long size = json_get_integer(document, json_find(document, element, "byteLength"), -1);
+		long long stride = json_get_integer(document, json_find(document, element, "byteStride"), 0);
+		int extension = gltf_get_meshopt_extension(document, element);
+		if (buffer < 0 || offset < 0 || size < 0 || stride < 0 || stride > 252
+			|| (unsigned long long)(offset + size) > t_gltf->buffers[buffer].size)
+		{
+			return 0;
+		}
+		view->buffer = (unsigned int)buffer;
+		view->offset = (size_t)offset;
+		view->size = (size_t)size;
+		view->stride = (unsigned int)stride;
+		t_context->view_extensions[i] = extension;
+
+		/* the buffer a compressed view decodes into is set aside now and filled by the fetch of its source */
+		gltf_meshopt_source source;
+		if (extension >= 0)
+		{
+			if (!gltf_read_meshopt_source(t_gltf, extension, buffer_count, view->size, &source))
+			{
+				return 0;
+			}
+			t_gltf->buffers[t_gltf->buffer_count].size = view->size;
+			t_context->sources[t_gltf->buffer_count] = source.buffer;
+			view->buffer = t_gltf->buffer_count++;
+			view->offset = 0;
+		}
+	}
+	return 1;
+}
+
+/* returns the address of a tightly packed range of a view, or 0 if the range is out of bounds or misaligned */
+static const unsigned char* gltf_get_packed_range(gltf* t_gltf, int t_view, long long t_offset, size_t t_size, unsigned int t_alignment)
+{
+	if (t_view < 0 || t_offset < 0)
+	{
+		return 0;
+	}
+	const gltf_buffer_view* view = t_gltf->buffer_views + t_view;
+	if (!t_gltf->buffers[view->buffer].data)
+	{
+		return 0;
+	}
+	const unsigned char* data = t_gltf->buffers[view->buffer].data + view->offset + t_offset;
+	if (view->stride || (unsigned long long)t_offset + t_size > view->size || (size_t)data % t_alignment)
+	{
+		return 0;
+	}
+	return data;
+}
+
+static unsigned int gltf_get_sparse_index(const gltf_accessor* t_accessor, unsigned int t_index)
+{
+	switch (t_accessor->sparse_index_type)
+	{
+	case GL_UNSIGNED_BYTE:
+		return t_accessor->sparse_indices[t_index];
+	case GL_UNSIGNED_SHORT:
+		return ((const unsigned short*)t_accessor->sparse_indices)[t_index];
+	}
+	return ((const unsigned int*)t_accessor->sparse_indices)[t_index];
+}
+
+/* the overrides of a sparse accessor stay where they are in their views, the indices must increase strictly so they
+ * can be merged with the base elements in a single pass */
+static int gltf_load_sparse(gltf* t_gltf, gltf_accessor* t_accessor, int t_sparse)
+{
+	const json* document = &t_gltf->document;
+	int indices = json_find(document, t_sparse, "indices");
+	int values = json_find(document, t_sparse, "values");
+	long long count = json_get_integer(document, json_find(document, t_sparse, "count"), -1);
+	unsigned int index_type = (unsigned int)json_get_integer(document, json_find(document, indices, "componentType"), 0);
+	unsigned int index_size = gltf_get_component_size(index_type);
+	unsigned int component_size = gltf_get_component_size(t_accessor->component_type);
+	if (count < 1 || count > (long long)t_accessor->count
+		|| (index_type != GL_UNSIGNED_BYTE && index_type != GL_UNSIGNED_SHORT && index_type != GL_UNSIGNED_INT))
+	{
+		return 0;
+	}
+
+	t_accessor->sparse_count = (unsigned int)count;
+	t_accessor->sparse_index_type = index_type;
+	t_accessor->sparse_indices = gltf_get_packed_range(t_gltf, gltf_get_index(document, indices, "bufferView", t_gltf->buffer_view_count),
+		json_get_integer(document, json_find(document, indices, "byteOffset"), 0), (size_t)count * index_size, index_size);
+	t_accessor->sparse_values = gltf_get_packed_range(t_gltf, gltf_get_index(document, values, "bufferView", t_gltf->buffer_view_count),
+		json_get_integer(document, json_find(document, values, "byteOffset"), 0), (size_t)count * component_size * t_accessor->component_count, component_size);
+	if (!t_accessor->sparse_indices || !t_accessor->sparse_values)
+	{
+		return 0;
+	}
+
+	unsigned int i;
+	for (i = 0; i < t_accessor->sparse_count; ++i)
+	{
+		unsigned int index = gltf_get_sparse_index(t_accessor, i);
+		if (index >= t_accessor->count || (i && index <= gltf_get_sparse_index(t_accessor, i - 1)))
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* images in views are read once their buffer is fetched, data uris are decoded now and files are left to the queue */
+static int gltf_load_images(gltf* t_gltf, const char* t_path)
+{
+	const json* document = &t_gltf->document;
+	int images = json_find(document, 0, "images");
+	unsigned int i;
+
+	t_gltf->image_count = gltf_get_array_count(document, images);
+	t_gltf->images = calloc(t_gltf->image_count ? t_gltf->image_count : 1, sizeof(gltf_image));
+	if (!t_gltf->images)
+	{
+		return 0;
+	}
+
+	int element = images + 1;
+	for (i = 0; i < t_gltf->image_count; ++i, element = (int)document->tokens[element].next)
+	{
+		gltf_image* image = t_gltf->images + i;
+		int uri = json_find(document, element, "uri");
+		image->buffer_view = gltf_get_index(document, element, "bufferView", t_gltf->buffer_view_count);
+		if (image->buffer_view >= 0)
+		{
+			continue;
+		}
+		if (uri < 0 || document->tokens[uri].type != JSON_STRING)
+		{
+			return 0;
+		}
+
+		size_t uri_length = document->tokens[uri].length;
+		char* uri_string = malloc(uri_length + 1);
+		if (!uri_string || !json_get_string(document, uri, uri_string, uri_length + 1, &uri_length))
+		{
+			free(uri_string);
+			return 0;
+		}
+
+		/* the decoded size of a data uri follows from the length of its text once the padding is dropped */
+		int result = 1;
+		if (uri_length > 5 && memcmp(uri_string, "data:", 5) == 0)
+		{
+			const char* data = memchr(uri_string, ',', uri_length);
+			size_t data_length = data ? uri_length - (size_t)(data + 1 - uri_string) : 0;
+			while (data_length && data[data_length] == '=')
+			{
+				--data_length;
+			}
+			gltf_buffer buffer;
+			memset(&buffer, 0, sizeof(gltf_buffer));
+			buffer.size = data_length * 3 / 4;
+			result = gltf_load_data_uri(&buffer, uri_string, uri_length);
+			image->owned = buffer.owned;
+			image->size = buffer.size;
+		}
+		else if (!strstr(uri_string, "://"))
+		{
+			size_t path_size = strlen(t_path) + uri_length + 1;
+			image->path = malloc(path_size);
+			result = image->path && gltf_resolve_uri(t_path, uri_string, uri_length, image->path, path_size);
+		}
+		free(uri_string);
+		if (!result)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* reads the layout of every accessor, those referring to views are resolved against the data once it is fetched */
+static int gltf_load_accessors(gltf* t_gltf, gltf_load_context* t_context)
+{
+	const json* document = &t_gltf->document;
+	int accessors = json_find(document, 0, "accessors");
+	unsigned int i;
+
+	t_gltf->accessor_count = gltf_get_array_count(document, accessors);
+	t_gltf->accessors = malloc(sizeof(gltf_accessor) * (t_gltf->accessor_count ? t_gltf->accessor_count : 1));
+	t_context->sparse_elements = malloc(sizeof(int) * (t_gltf->accessor_count ? t_gltf->accessor_count : 1));
+	t_context->is_resolved = calloc(t_gltf->accessor_count ? t_gltf->accessor_count : 1, 1);
+	if (!t_gltf->accessors || !t_context->sparse_elements || !t_context->is_resolved)
+	{
+		return 0;
+	}
+
+	int element = accessors + 1;
+	for (i = 0; i < t_gltf->accessor_count; ++i, element = (int)document->tokens[element].next)
+	{
+		gltf_accessor* accessor = t_gltf->accessors + i;
+		long long offset = json_get_integer(document, json_find(document, element, "byteOffset"), 0);
+		long long count = json_get_integer(document, json_find(document, element, "count"), -1);
+		accessor->buffer_view = gltf_get_index(document, element, "bufferView", t_gltf->buffer_view_count);
+		accessor->component_type = (unsigned int)json_get_integer(document, json_find(document, element, "componentType"), 0);
+		accessor->component_count = gltf_get_component_count(document, json_find(document, element, "type"));
+		accessor->normalized = json_get_bool(document, json_find(document, element, "normalized"), 0);
+		accessor->sparse_count = 0;
+		accessor->sparse_index_type = 0;
+		accessor->sparse_indices = 0;
+		accessor->sparse_values = 0;
+		t_context->sparse_elements[i] = json_find(document, element, "sparse");
+
+		unsigned int element_size = gltf_get_component_size(accessor->component_type) * accessor->component_count;
+		if (offset < 0 || count < 0 || count > 0xFFFFFFFFll || !element_size)
+		{
+			return 0;
+		}
+		accessor->offset = (size_t)offset;
+		accessor->count = (unsigned int)count;
+
+		/* every element must lie within the buffer view so views can be handed out without bounds checks */
+		if (accessor->buffer_view >= 0 && accessor->count)
+		{
+			const gltf_buffer_view* view = t_gltf->buffer_views + accessor->buffer_view;
+			size_t stride = view->stride ? view->stride : element_size;
+			if (accessor->offset + stride * (accessor->count - 1) + element_size > view->size)
+			{
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+/* checks an accessor against its fetched data, elements must be aligned to their component so the view can be read
+ * in place or passed straight to the GL */
+static int gltf_resolve_accessor(gltf* t_gltf, unsigned int t_accessor, int t_sparse)
+{
+	gltf_accessor* accessor = t_gltf->accessors + t_accessor;
+	if (accessor->buffer_view >= 0)
+	{
+		const gltf_buffer_view* view = t_gltf->buffer_views + accessor->buffer_view;
+		const unsigned char* data = t_gltf->buffers[view->buffer].data;
+		unsigned int component_size = gltf_get_component_size(accessor->component_type);
+		if (!data || (size_t)(data + view->offset + accessor->offset) % component_size || view->stride % component_size)
+		{
+			return 0;
+		}
+	}
+	return t_sparse < 0 || gltf_load_sparse(t_gltf, accessor, t_sparse);
+}
+
+/* queues the fetches an accessor depends upon, then if waiting resolves the accessor once they complete */
+static int gltf_prepare_accessor(gltf* t_gltf, gltf_load_context* t_context, int t_accessor, int t_is_waiting)
+{
+	if (t_accessor < 0 || t_context->is_resolved[t_accessor])
+	{
+		return 1;
+	}
+
+	const json* document = &t_gltf->document;
+	int sparse = t_context->sparse_elements[t_accessor];
+	int views[3] =
+	{
+		t_gltf->accessors[t_accessor].buffer_view,
+		gltf_get_index(document, json_find(document, sparse, "indices"), "bufferView", t_gltf->buffer_view_count),
+		gltf_get_index(document, json_find(document, sparse, "values"), "bufferView", t_gltf->buffer_view_count)
+	};
+	unsigned int i;
+	for (i = 0; i < 3; ++i)
+	{
+		if (views[i] < 0)
+		{
+			continue;
+		}
+		gltf_fetch_context* fetch = t_context->fetches + t_context->sources[t_gltf->buffer_views[views[i]].buffer];
+		gltf_push_fetch(t_context, fetch);
+		if (t_is_waiting && !gltf_wait_fetch(t_context, fetch))
+		{
+			return 0;
+		}
+	}
+	if (!t_is_waiting)
+	{
+		return 1;
+	}
+	t_context->is_resolved[t_accessor] = 1;
+	return gltf_resolve_accessor(t_gltf, (unsigned int)t_accessor, sparse);
+}
+
+static int gltf_prepare_primitive(gltf* t_gltf, gltf_load_context* t_context, const gltf_primitive* t_primitive, int t_is_waiting)
+{
+	unsigned int i;
+	int result = gltf_prepare_accessor(t_gltf, t_context, t_primitive->indices, t_is_waiting);
+	for (i = 0; result && i < GLTF_ATTRIBUTE_COUNT; ++i)
+	{
+		result = gltf_prepare_accessor(t_gltf, t_context, t_primitive->attributes[i], t_is_waiting);
+	}
+	for (i = 0; result && i < t_primitive->target_count; ++i)
+	{
+		const gltf_target* target = t_gltf->targets + t_primitive->target_offset + i;
+		result = gltf_prepare_accessor(t_gltf, t_context, target->position, t_is_waiting)
+			&& gltf_prepare_accessor(t_gltf, t_context, target->normal, t_is_waiting);
+	}
+	return result;
+}
+
+static void gltf_get_floats(const json* t_json, int t_array, float* t_out, unsigned int t_count)
+{
+	unsigned int i;
+	int element = t_array + 1;
+	for (i = 0; i < t_count && i < gltf_get_array_count(t_json, t_array); ++i, element = (int)t_json->tokens[element].next)
+	{
+		t_out[i] = (float)json_get_number(t_json, element, t_out[i]);
+	}
+}
+
+static int gltf_load_meshes(gltf* t_gltf)
+{
+	const json* document = &t_gltf->document;
+	int meshes = json_find(document, 0, "meshes");
+	unsigned int i, j, k;
+
+	t_gltf->mesh_count = gltf_get_array_count(document, meshes);
+	t_gltf->meshes = malloc(sizeof(gltf_mesh) * (t_gltf->mesh_count ? t_gltf->mesh_count : 1));
+	if (!t_gltf->meshes)
+	{
+		return 0;
+	}
+
+	int element = meshes + 1;
+	for (i = 0; i < t_gltf->mesh_count; ++i, element = (int)document->tokens[element].next)
+	{
+		int primitives = json_find(document, element, "primitives");
+		int primitive_element = primitives + 1;
+		t_gltf->primitive_count += gltf_get_array_count(document, primitives);
+		t_gltf->weight_count += gltf_get_array_count(document, json_find(document, element, "weights"));
+		for (j = 0; j < gltf_get_array_count(document, primitives); ++j, primitive_element = (int)document->tokens[primitive_element].next)
+		{
+			t_gltf->target_count += gltf_get_array_count(document, json_find(document, primitive_element, "targets"));
+		}
+	}
+	t_gltf->primitives = malloc(sizeof(gltf_primitive) * (t_gltf->primitive_count ? t_gltf->primitive_count : 1));
+	t_gltf->targets = malloc(sizeof(gltf_target) * (t_gltf->target_count ? t_gltf->target_count : 1));
+	t_gltf->weights = calloc(t_gltf->weight_count ? t_gltf->weight_count : 1, sizeof(float));
+	if (!t_gltf->primitives || !t_gltf->targets || !t_gltf->weights)
+	{
+		return 0;
+	}
+
+	unsigned int primitive_offset = 0, target_offset = 0, weight_offset = 0;
+	element = meshes + 1;
+	for (i = 0; i < t_gltf->mesh_count; ++i, element = (int)document->tokens[element].next)
+	{
+		int primitives = json_find(document, element, "primitives");
+		int weights = json_find(document, element, "weights");
+		gltf_mesh* mesh = t_gltf->meshes + i;
+		mesh->primitive_offset = primitive_offset;
+		mesh->primitive_count = gltf_get_array_count(document, primitives);
+		mesh->weight_offset = weight_offset;
+		mesh->weight_count = gltf_get_array_count(document, weights);
+		gltf_get_floats(document, weights, t_gltf->weights + weight_offset, mesh->weight_count);
+		weight_offset += mesh->weight_count;
+
+		int primitive_element = primitives + 1;
+		for (j = 0; j < mesh->primitive_count; ++j, primitive_element = (int)document->tokens[primitive_element].next)
+		{
+			gltf_primitive* primitive = t_gltf->primitives + primitive_offset++;
+			int attributes = json_find(document, primitive_element, "attributes");
+			for (k = 0; k < GLTF_ATTRIBUTE_COUNT; ++k)
+			{
+				primitive->attributes[k] = gltf_get_index(document, attributes, g_gltf_attribute_names[k], t_gltf->accessor_count);
+			}
+			primitive->indices = gltf_get_index(document, primitive_element, "indices", t_gltf->accessor_count);
+			primitive->material = (int)json_get_integer(document, json_find(document, primitive_element, "material"), -1);
+			primitive->mode = (unsigned int)json_get_integer(document, json_find(document, primitive_element, "mode"), GL_TRIANGLES);
+
+			/* every primitive of a mesh has the same number of targets, matching the mesh's weights if it has any */
+			int targets = json_find(document, primitive_element, "targets");
+			int target_element = targets + 1;
+			primitive->target_offset = target_offset;
+			primitive->target_count = gltf_get_array_count(document, targets);
+			if ((mesh->weight_count && primitive->target_count != mesh->weight_count)
+				|| (j && primitive->target_count != primitive[-1].target_count))
+			{
+				return 0;
+			}
+			for (k = 0; k < primitive->target_count; ++k, target_element = (int)document->tokens[target_element].next)
+			{
+				gltf_target* target = t_gltf->targets + target_offset++;
+				target->position = gltf_get_index(document, target_element, "POSITION", t_gltf->accessor_count);
+				target->normal = gltf_get_index(document, target_element, "NORMAL", t_gltf->accessor_count);
+			}
+		}
+	}
+	return 1;
+}
+
+static void gltf_compose_matrix(const float* t_translation, const float* t_rotation, const float* t_scale, float* t_out)
+{
+	float x = t_rotation[0], y = t_rotation[1], z = t_rotation[2], w = t_rotation[3];
+	t_out[0] = (1.0f - 2.0f * (y * y + z * z)) * t_scale[0];
+	t_out[1] = (2.0f * (x * y + z * w)) * t_scale[0];
+	t_out[2] = (2.0f * (x * z - y * w)) * t_scale[0];
+	t_out[3] = 0.0f;
+	t_out[4] = (2.0f * (x * y - z * w)) * t_scale[1];
+	t_out[5] = (1.0f - 2.0f * (x * x + z * z)) * t_scale[1];
+	t_out[6] = (2.0f * (y * z + x * w)) * t_scale[1];
+	t_out[7] = 0.0f;
+	t_out[8] = (2.0f * (x * z + y * w)) * t_scale[2];
+	t_out[9] = (2.0f * (y * z - x * w)) * t_scale[2];
+	t_out[10] = (1.0f - 2.0f * (x * x + y * y)) * t_scale[2];
+	t_out[11] = 0.0f;
+	t_out[12] = t_translation[0];
+	t_out[13] = t_translation[1];
+	t_out[14] = t_translation[2];
+	t_out[15] = 1.0f;
+}
+
+/* the instance attributes of a node must share a count, and every instance must be a complete transform */
+static int gltf_load_instances(gltf* t_gltf, gltf_node* t_node, int t_element)
+{
+	const json* document = &t_gltf->document;
+	int instancing = json_find(document, json_find(document, t_element, "extensions"), "EXT_mesh_gpu_instancing");
+	int attributes = json_find(document, instancing, "attributes");
+	t_node->instance_count = 0;
+	t_node->instance_translation = gltf_get_index(document, attributes, "TRANSLATION", t_gltf->accessor_count);
+	t_node->instance_rotation = gltf_get_index(document, attributes, "ROTATION", t_gltf->accessor_count);
+	t_node->instance_scale = gltf_get_index(document, attributes, "SCALE", t_gltf->accessor_count);
+	if (instancing < 0)
+	{
+		return 1;
+	}
+
+	int accessors[3] = { t_node->instance_translation, t_node->instance_rotation, t_node->instance_scale };
+	unsigned int component_counts[3] = { 3, 4, 3 }, i;
+	int is_first = 1;
+	for (i = 0; i < 3; ++i)
+	{
+		if (accessors[i] < 0)
+		{
+			continue;
+		}
+		const gltf_accessor* accessor = t_gltf->accessors + accessors[i];
+		if (accessor->component_count != component_counts[i] || (!is_first && accessor->count != t_node->instance_count))
+		{
+			return 0;
+		}
+		t_node->instance_count = accessor->count;
+		is_first = 0;
+	}
+	return !is_first && t_node->mesh >= 0;
+}
+
+static int gltf_load_nodes(gltf* t_gltf)
+{
+	const json* document = &t_gltf->document;
+	int nodes = json_find(document, 0, "nodes");
+	unsigned int i, j, child_count = 0;
+
+	t_gltf->node_count = gltf_get_array_count(document, nodes);
+	t_gltf->nodes = malloc(sizeof(gltf_node) * (t_gltf->node_count ? t_gltf->node_count : 1));
+	if (!t_gltf->nodes)
+	{
+		return 0;
+	}
+
+	int element = nodes + 1;
+	for (i = 0; i < t_gltf->node_count; ++i, element = (int)document->tokens[element].next)
+	{
+		t_gltf->nodes[i].parent = -1;
+		child_count += gltf_get_array_count(document, json_find(document, element, "children"));
+	}
+	t_gltf->node_children = malloc(sizeof(unsigned int) * (child_count ? child_count : 1));
+	if (!t_gltf->node_children)
+	{
+		return 0;
+	}
+
+	unsigned int child_offset = 0;
+	element = nodes + 1;
+	for (i = 0; i < t_gltf->node_count; ++i, element = (int)document->tokens[element].next)
+	{
+		gltf_node* node = t_gltf->nodes + i;
+		node->mesh = gltf_get_index(document, element, "mesh", t_gltf->mesh_count);
+
+		float translation[3] = { 0.0f, 0.0f, 0.0f };
+		float rotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		float scale[3] = { 1.0f, 1.0f, 1.0f };
+		int matrix = json_find(document, element, "matrix");
+		if (matrix >= 0)
+		{
+			gltf_compose_matrix(translation, rotation, scale, node->matrix);
+			gltf_get_floats(document, matrix, node->matrix, 16);
+		}
+		else
+		{
+			gltf_get_floats(document, json_find(document, element, "translation"), translation, 3);
+			gltf_get_floats(document, json_find(document, element, "rotation"), rotation, 4);
+			gltf_get_floats(document, json_find(document, element, "scale"), scale, 3);
+			gltf_compose_matrix(translation, rotation, scale, node->matrix);
+		}
+		if (!gltf_load_instances(t_gltf, node, element))
+		{
+			return 0;
+		}
+
+		int children = json_find(document, element, "children");
+		node->child_offset = child_offset;
+		node->child_count = gltf_get_array_count(document, children);
+		int child_element = children + 1;
+		for (j = 0; j < node->child_count; ++j, child_element = (int)document->tokens[child_element].next)
+		{
+			long long child = json_get_integer(document, child_element, -1);
+			if (child < 0 || child >= (long long)t_gltf->node_count || t_gltf->nodes[child].parent >= 0 || child == (long long)i)
+			{
+				return 0;
+			}
+			t_gltf->nodes[child].parent = (int)i;
+			t_gltf->node_children[child_offset++] = (unsigned int)child;
+		}
+	}
+
+	/* a node parented twice was rejected above, a cycle would leave every node of it with a parent */
+	for (i = 0; i < t_gltf->node_count; ++i)
+	{
+		unsigned int depth = 0;
+		int ancestor = t_gltf->nodes[i].parent;
+		while (ancestor >= 0 && depth++ < t_gltf->node_count)
+		{
+			ancestor = t_gltf->nodes[ancestor].parent;
+		}
+		if (ancestor >= 0)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int gltf_load_scene(gltf* t_gltf)
+{
+	const json* document = &t_gltf->document;
+	int scenes = json_find(document, 0, "scenes");
+	unsigned int i;
+
+	t_gltf->scene = gltf_get_index(document, 0, "scene", gltf_get_array_count(document, scenes));
+	if (t_gltf->scene < 0 && gltf_get_array_count(document, scenes))
+	{
+		t_gltf->scene = 0;
+	}
+
+	int roots = json_find(document, json_get_index(document, scenes, t_gltf->scene < 0 ? 0 : (unsigned int)t_gltf->scene), "nodes");
+	t_gltf->root_count = t_gltf->scene < 0 ? 0 : gltf_get_array_count(document, roots);
+	t_gltf->roots = malloc(sizeof(unsigned int) * (t_gltf->root_count ? t_gltf->root_count : 1));
+	if (!t_gltf->roots)
+	{
+		return 0;
+	}
+
+	int element = roots + 1;
+	for (i = 0; i < t_gltf->root_count; ++i, element = (int)document->tokens[element].next)
+	{
+		long long node = json_get_integer(document, element, -1);
+		if (node < 0 || node >= (long long)t_gltf->node_count)
+		{
+			return 0;
+		}
+		t_gltf->roots[i] = (unsigned int)node;
+	}
+	return 1;
+}
+
+/* hands out each mesh as soon as every accessor of its primitives is resolved, with a pool every fetch is queued up
+ * front in the order the meshes first need them, without one each fetch runs only once a mesh waits upon it */
+static int gltf_stream_meshes(gltf* t_gltf, gltf_load_context* t_context, gltf_mesh_function t_function, void* t_function_context)
+{
+	unsigned int i, j;
+	if (t_context->pool)
+	{
+		for (i = 0; i < t_gltf->primitive_count; ++i)
+		{
+			gltf_prepare_primitive(t_gltf, t_context, t_gltf->primitives + i, 0);
+		}
+		for (i = 0; i < t_context->fetch_count; ++i)
+		{
+			gltf_push_fetch(t_context, t_context->fetches + i);
+		}
+	}
+
+	for (i = 0; i < t_gltf->mesh_count; ++i)
+	{
+		const gltf_mesh* mesh = t_gltf->meshes + i;
+		for (j = 0; j < mesh->primitive_count; ++j)
+		{
+			if (!gltf_prepare_primitive(t_gltf, t_context, t_gltf->primitives + mesh->primitive_offset + j, 1))
+			{
+				return 0;
+			}
+		}
+		if (t_function)
+		{
+			t_function(t_function_context, t_gltf, i);
+		}
+	}
+
+	/* accessors no mesh refers to and buffers no accessor refers to still have to load for the asset to be valid */
+	for (i = 0; i < t_gltf->accessor_count; ++i)
+	{
+		if (!gltf_prepare_accessor(t_gltf, t_context, (int)i, 1))
+		{
+			return 0;
+		}
+	}
+	for (i = 0; i < t_context->fetch_count; ++i)
+	{
+		gltf_push_fetch(t_context, t_context->fetches + i);
+		if (!gltf_wait_fetch(t_context, t_context->fetches + i))
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* every fetch is waited upon before the context goes, a failed load may still have some in flight */
+static void gltf_final_load_context(gltf_load_context* t_context)
+{
+	unsigned int i;
+	for (i = 0; t_context->fetches && i < t_context->fetch_count; ++i)
+	{
+		thread_pool_wait(t_context->pool, &t_context->fetches[i].group);
+	}
+	free(t_context->fetches);
+	free(t_context->sources);
+	free(t_context->view_extensions);
+	free(t_context->sparse_elements);
+	free(t_context->is_resolved);
+}
 
 int gltf_load(gltf* t_gltf, const char* t_string)
+{
+	return gltf_load_progressive(t_gltf, t_string, 0, 0, 0);
+}
+
+int gltf_load_progressive(gltf* t_gltf, const char* t_string, thread_pool* t_pool, gltf_mesh_function t_function, void* t_context)
 {
 	assert(t_gltf && t_string);
-	
-	FILE* file = fopen(t_string, "rb");
-	if (!file)
+
+	memset(t_gltf, 0, sizeof(gltf));
+	t_gltf->scene = -1;
+	if (!init_file_map(&t_gltf->map, t_string))
 	{
 		return 0;
 	}
-	
-	fseek(file, 0, SEEK_END);
-	long int file_length = ftell(file);
-	(void)file_length;
-	
-	fseek(file, 0, SEEK_SET);
-	
-	/* do the rest here */
-	
-	fclose(file);
-	
+
+	const char* source = (const char*)t_gltf->map.data;
+	size_t length = t_gltf->map.size;
+	if (length >= 4 && gltf_read_u32(t_gltf->map.data) == GLTF_GLB_MAGIC && !gltf_read_glb(t_gltf, &source, &length))
+	{
+		gltf_final(t_gltf);
+		return 0;
+	}
+
+	const json* document = &t_gltf->document;
+	if (!json_parse(&t_gltf->document, source, length)
+		|| document->tokens[0].type != JSON_OBJECT)
+	{
+		gltf_final(t_gltf);
+		return 0;
+	}
+
+	/* only the major version is binding, minor versions are backwards compatible */
+	char version[16];
+	int asset = json_find(document, 0, "asset");
+	if (!json_get_string(document, json_find(document, asset, "version"), version, sizeof(version), 0)
+		|| version[0] != '2' || version[1] != '.')
+	{
+		gltf_final(t_gltf);
+		return 0;
+	}
+
+	/* the whole document is loaded before any buffer is fetched, so meshes only ever wait upon data */
+	gltf_load_context context;
+	memset(&context, 0, sizeof(gltf_load_context));
+	context.pool = t_pool;
+	int result = gltf_check_extensions(t_gltf)
+		&& gltf_load_buffers(t_gltf, t_string, &context)
+		&& gltf_load_buffer_views(t_gltf, &context)
+		&& gltf_load_images(t_gltf, t_string)
+		&& gltf_load_accessors(t_gltf, &context)
+		&& gltf_load_meshes(t_gltf)
+		&& gltf_load_nodes(t_gltf)
+		&& gltf_load_scene(t_gltf)
+		&& gltf_stream_meshes(t_gltf, &context, t_function, t_context);
+	gltf_final_load_context(&context);
+	if (!result)
+	{
+		gltf_final(t_gltf);
+		return 0;
+	}
+
+	return 1;
+}
+
+/* the elements of the view, a sparse accessor's overrides are not applied */
+const unsigned char* gltf_accessor_get_data(gltf* t_gltf, unsigned int t_accessor, unsigned int* t_out_stride)
+{
+	assert(t_gltf && t_accessor < t_gltf->accessor_count);
+
+	const gltf_accessor* accessor = t_gltf->accessors + t_accessor;
+	if (accessor->buffer_view < 0)
+	{
+		return 0;
+	}
+
+	const gltf_buffer_view* view = t_gltf->buffer_views + accessor->buffer_view;
+	if (t_out_stride)
+	{
+		*t_out_stride = view->stride ? view->stride : gltf_get_component_size(accessor->component_type) * accessor->component_count;
+	}
+	return t_gltf->buffers[view->buffer].data + view->offset + accessor->offset;
+}
+
+static float gltf_convert_component(const unsigned char* t_data, unsigned int t_component_type, int t_normalized)
+{
+	float value;
+	switch (t_component_type)
+	{
+	case GL_BYTE:
+		value = (float)*(const signed char*)t_data;
+		return t_normalized ? (value / 127.0f > -1.0f ? value / 127.0f : -1.0f) : value;
+	case GL_UNSIGNED_BYTE:
+		value = (float)*t_data;
+		return t_normalized ? value / 255.0f : value;
+	case GL_SHORT:
+		value = (float)*(const short*)t_data;
+		return t_normalized ? (value / 32767.0f > -1.0f ? value / 32767.0f : -1.0f) : value;
+	case GL_UNSIGNED_SHORT:
+		value = (float)*(const unsigned short*)t_data;
+		return t_normalized ? value / 65535.0f : value;
+	case GL_UNSIGNED_INT:
+		return (float)*(const unsigned int*)t_data;
+	}
+	memcpy(&value, t_data, sizeof(value));
+	return value;
+}
+
+/* converts elements to tightly packed floats, dequantizing normalized integers as the specification requires */
+static void gltf_convert_floats(const gltf_accessor* t_accessor, const unsigned char* t_data, size_t t_stride, unsigned int t_count, float* t_out)
+{
+	unsigned int component_size = gltf_get_component_size(t_accessor->component_type), i, j;
+	if (t_accessor->component_type == GL_FLOAT && t_stride == component_size * t_accessor->component_count)
+	{
+		memcpy(t_out, t_data, t_stride * t_count);
+		return;
+	}
+	for (i = 0; i < t_count; ++i, t_data += t_stride)
+	{
+		for (j = 0; j < t_accessor->component_count; ++j)
+		{
+			*t_out++ = gltf_convert_component(t_data + j * component_size, t_accessor->component_type, t_accessor->normalized);
+		}
+	}
+}
+
+void gltf_accessor_read_floats(gltf* t_gltf, unsigned int t_accessor, float* t_out)
+{
+	assert(t_gltf && t_accessor < t_gltf->accessor_count && t_out);
+
+	const gltf_accessor* accessor = t_gltf->accessors + t_accessor;
+	unsigned int stride, i;
+	const unsigned char* data = gltf_accessor_get_data(t_gltf, t_accessor, &stride);
+	if (data)
+	{
+		gltf_convert_floats(accessor, data, stride, accessor->count, t_out);
+	}
+	else
+	{
+		memset(t_out, 0, sizeof(float) * accessor->component_count * accessor->count);
+	}
+
+	size_t element_size = (size_t)gltf_get_component_size(accessor->component_type) * accessor->component_count;
+	for (i = 0; i < accessor->sparse_count; ++i)
+	{
+		gltf_convert_floats(accessor, accessor->sparse_values + element_size * i, element_size, 1,
+			t_out + (size_t)gltf_get_sparse_index(accessor, i) * accessor->component_count);
+	}
+}
+
+int gltf_accessor_read_sparse(gltf* t_gltf, unsigned int t_accessor, unsigned int* t_out_indices, float* t_out_values)
+{
+	assert(t_gltf && t_accessor < t_gltf->accessor_count && t_out_indices && t_out_values);
+
+	const gltf_accessor* accessor = t_gltf->accessors + t_accessor;
+	unsigned int i;
+	if (!accessor->sparse_count)
+	{
+		return 0;
+	}
+	for (i = 0; i < accessor->sparse_count; ++i)
+	{
+		t_out_indices[i] = gltf_get_sparse_index(accessor, i);
+	}
+	gltf_convert_floats(accessor, accessor->sparse_values, (size_t)gltf_get_component_size(accessor->component_type) * accessor->component_count,
+		accessor->sparse_count, t_out_values);
+	return 1;
+}
+
+int gltf_accessor_get_vertex_attribute(gltf* t_gltf, unsigned int t_accessor, vertex_attribute* t_out_attribute)
+{
+	assert(t_gltf && t_accessor < t_gltf->accessor_count && t_out_attribute);
+
+	const gltf_accessor* accessor = t_gltf->accessors + t_accessor;
+	unsigned int stride;
+	const unsigned char* data = gltf_accessor_get_data(t_gltf, t_accessor, &stride);
+	if (!data || accessor->sparse_count || accessor->component_count > 4 || !accessor->count)
+	{
+		return 0;
+	}
+
+	/* the attribute spans from its first to the end of its last element, interleaved views share their bytes */
+	unsigned int element_size = gltf_get_component_size(accessor->component_type) * accessor->component_count;
+	t_out_attribute->buffer = (void*)data;
+	t_out_attribute->buffer_size = (size_t)stride * (accessor->count - 1) + element_size;
+	t_out_attribute->size = accessor->component_count;
+	t_out_attribute->type = accessor->component_type;
+	t_out_attribute->stride = stride;
+	t_out_attribute->flags = accessor->normalized ? VERTEX_ATTRIBUTE_NORMALIZED : 0;
+	return 1;
+}
+
+int gltf_accessor_get_index_buffer(gltf* t_gltf, unsigned int t_accessor, index_buffer* t_out_buffer)
+{
+	assert(t_gltf && t_accessor < t_gltf->accessor_count && t_out_buffer);
+
+	const gltf_accessor* accessor = t_gltf->accessors + t_accessor;
+	unsigned int stride, size = gltf_get_component_size(accessor->component_type);
+	const unsigned char* data = gltf_accessor_get_data(t_gltf, t_accessor, &stride);
+	if (!data || accessor->sparse_count || accessor->component_count != 1 || stride != size
+		|| (accessor->component_type != GL_UNSIGNED_BYTE && accessor->component_type != GL_UNSIGNED_SHORT && accessor->component_type != GL_UNSIGNED_INT))
+	{
+		return 0;
+	}
+
+	t_out_buffer->buffer = (void*)data;
+	t_out_buffer->buffer_size = (size_t)size * accessor->count;
+	t_out_buffer->type = accessor->component_type;
+	return 1;
+}
+
+int gltf_primitive_get_vertex_attributes(gltf* t_gltf, const gltf_primitive* t_primitive, vertex_attribute* t_out_attributes, unsigned int* t_out_count)
+{
+	assert(t_gltf && t_primitive && t_out_attributes && t_out_count);
+
+	unsigned int i;
+	*t_out_count = 0;
+	for (i = 0; i < GLTF_ATTRIBUTE_COUNT; ++i)
+	{
+		if (t_primitive->attributes[i] < 0)
+		{
+			continue;
+		}
+		vertex_attribute* attribute = t_out_attributes + (*t_out_count)++;
+		if (!gltf_accessor_get_vertex_attribute(t_gltf, (unsigned int)t_primitive->attributes[i], attribute))
+		{
+			return 0;
+		}
+		if (i == GLTF_ATTRIBUTE_JOINTS_0)
+		{
+			attribute->flags = VERTEX_ATTRIBUTE_INTEGER;
+		}
+	}
+	return 1;
+}
+
+void gltf_node_get_world_matrix(gltf* t_gltf, unsigned int t_node, float* t_out_matrix)
+{
+	assert(t_gltf && t_node < t_gltf->node_count && t_out_matrix);
+
+	unsigned int i, j, k;
+	int ancestor = t_gltf->nodes[t_node].parent;
+	memcpy(t_out_matrix, t_gltf->nodes[t_node].matrix, sizeof(float) * 16);
+	while (ancestor >= 0)
+	{
+		float product[16];
+		const float* parent = t_gltf->nodes[ancestor].matrix;
+		for (i = 0; i < 4; ++i)
+		{
+			for (j = 0; j < 4; ++j)
+			{
+				float sum = 0.0f;
+				for (k = 0; k < 4; ++k)
+				{
+					sum += parent[k * 4 + j] * t_out_matrix[i * 4 + k];
+				}
+				product[i * 4 + j] = sum;
+			}
+		}
+		memcpy(t_out_matrix, product, sizeof(product));
+		ancestor = t_gltf->nodes[ancestor].parent;
+	}
+}
+
+/* each instance is composed from its translation, rotation and scale, then placed by the node's world transform and
+ * written as the three rows of an affine matrix */
+int gltf_node_get_instance_transforms(gltf* t_gltf, unsigned int t_node, float* t_out_transforms)
+{
+	assert(t_gltf && t_node < t_gltf->node_count && t_out_transforms);
+
+	const gltf_node* node = t_gltf->nodes + t_node;
+	unsigned int count = node->instance_count, i, j, k;
+	float* translations = node->instance_translation >= 0 ? malloc(sizeof(float) * 3 * (count ? count : 1)) : 0;
+	float* rotations = node->instance_rotation >= 0 ? malloc(sizeof(float) * 4 * (count ? count : 1)) : 0;
+	float* scales = node->instance_scale >= 0 ? malloc(sizeof(float) * 3 * (count ? count : 1)) : 0;
+	if ((node->instance_translation >= 0 && !translations) || (node->instance_rotation >= 0 && !rotations)
+		|| (node->instance_scale >= 0 && !scales))
+	{
+		free(translations);
+		free(rotations);
+		free(scales);
+		return 0;
+	}
+	if (translations)
+	{
+		gltf_accessor_read_floats(t_gltf, (unsigned int)node->instance_translation, translations);
+	}
+	if (rotations)
+	{
+		gltf_accessor_read_floats(t_gltf, (unsigned int)node->instance_rotation, rotations);
+	}
+	if (scales)
+	{
+		gltf_accessor_read_floats(t_gltf, (unsigned int)node->instance_scale, scales);
+	}
+
+	static const float identity_translation[3] = { 0.0f, 0.0f, 0.0f };
+	static const float identity_rotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	static const float identity_scale[3] = { 1.0f, 1.0f, 1.0f };
+	float world[16];
+	gltf_node_get_world_matrix(t_gltf, t_node, world);
+	for (i = 0; i < count; ++i)
+	{
+		float local[16];
+		float* out = t_out_transforms + (size_t)i * 12;
+		gltf_compose_matrix(translations ? translations + (size_t)i * 3 : identity_translation,
+			rotations ? rotations + (size_t)i * 4 : identity_rotation, scales ? scales + (size_t)i * 3 : identity_scale, local);
+		for (j = 0; j < 3; ++j)
+		{
+			for (k = 0; k < 4; ++k)
+			{
+				out[j * 4 + k] = world[j] * local[k * 4] + world[4 + j] * local[k * 4 + 1] + world[8 + j] * local[k * 4 + 2]
+					+ world[12 + j] * local[k * 4 + 3];
+			}
+		}
+	}
+
+	free(translations);
+	free(rotations);
+	free(scales);
+	return 1;
+}
+
+/* the encoded bytes of an image in a view or a data uri, or 0 for an image file */
+const unsigned char* gltf_image_get_data(gltf* t_gltf, unsigned int t_image, size_t* t_out_size)
+{
+	assert(t_gltf && t_image < t_gltf->image_count && t_out_size);
+
+	const gltf_image* image = t_gltf->images + t_image;
+	if (image->buffer_view >= 0)
+	{
+		const gltf_buffer_view* view = t_gltf->buffer_views + image->buffer_view;
+		*t_out_size = view->size;
+		return t_gltf->buffers[view->buffer].data + view->offset;
+	}
+	*t_out_size = image->size;
+	return image->owned;
+}
+
+/* queues every image in order, so image i is queued at *t_out_first + i, the gltf must outlive their decoding */
+int gltf_push_images(gltf* t_gltf, image_queue* t_queue, unsigned int* t_out_first)
+{
+	assert(t_gltf && t_queue);
+
+	static const unsigned char empty[1] = { 0 };
+	unsigned int i;
+	if (t_out_first)
+	{
+		*t_out_first = t_queue->image_count;
+	}
+	for (i = 0; i < t_gltf->image_count; ++i)
+	{
+		/* an image that cannot be read, such as a remote uri, is still queued so that it fails in its place */
+		size_t size;
+		const unsigned char* data = gltf_image_get_data(t_gltf, i, &size);
+		int result = t_gltf->images[i].path ? image_queue_push_file(t_queue, t_gltf->images[i].path, 0)
+			: image_queue_push_memory(t_queue, data ? data : empty, data ? size : 0, 0);
+		if (!result)
+		{
+			return 0;
+		}
+	}
 	return 1;
 }
 
 void gltf_final(gltf* t_gltf)
 {
 	assert(t_gltf);
-}
\ No newline at end of file
+
+	unsigned int i;
+	for (i = 0; t_gltf->buffers && i < t_gltf->buffer_count; ++i)
+	{
+		if (t_gltf->buffers[i].map.data || t_gltf->buffers[i].map.internal)
+		{
+			final_file_map(&t_gltf->buffers[i].map);
+		}
+		free(t_gltf->buffers[i].owned);
+	}
+	free(t_gltf->buffers);
+	free(t_gltf->buffer_views);
+	for (i = 0; t_gltf->images && i < t_gltf->image_count; ++i)
+	{
+		free(t_gltf->images[i].path);
+		free(t_gltf->images[i].owned);
+	}
+	free(t_gltf->images);
+	free(t_gltf->accessors);
+	free(t_gltf->meshes);
+	free(t_gltf->primitives);
+	free(t_gltf->targets);
+	free(t_gltf->weights);
+	free(t_gltf->nodes);
+	free(t_gltf->node_children);
+	free(t_gltf->roots);
+	json_final(&t_gltf->document);
+	final_file_map(&t_gltf->map);
+	memset(t_gltf, 0, sizeof(gltf));
+	t_gltf->scene = -1;
+}
@@ -1,4 +1,3 @@
-
 /**
  * gltf_import.h
  */
@@ -6,15 +5,246 @@
 #ifndef GRAPHICS_UTILS_GLTF_IMPORT_H
 #define GRAPHICS_UTILS_GLTF_IMPORT_H
 
-#include "data_structures.h"
+#include "file_map.h"
+#include "graphics.h"
+#include "image_queue.h"
+#include "json.h"
+#include "thread_pool.h"
+
+#define GLTF_ATTRIBUTE_POSITION 0
+#define GLTF_ATTRIBUTE_NORMAL 1
+#define GLTF_ATTRIBUTE_TANGENT 2
+#define GLTF_ATTRIBUTE_TEXCOORD_0 3
+#define GLTF_ATTRIBUTE_TEXCOORD_1 4
+#define GLTF_ATTRIBUTE_COLOR_0 5
+#define GLTF_ATTRIBUTE_JOINTS_0 6
+#define GLTF_ATTRIBUTE_WEIGHTS_0 7
+#define GLTF_ATTRIBUTE_COUNT 8
 
-typedef struct {
-	
-	int placeholder;
+/**	@struct		gltf_buffer
+ *	@brief		the bytes of a buffer, either a mapped file or a decoded data uri
+ *	@member		gltf_buffer::data - the base address of the buffer
+ *	@member		gltf_buffer::size - the byteLength of the buffer
+ *	@member		gltf_buffer::map - the mapping of an external buffer file
+ *	@member		gltf_buffer::owned - the malloc'd bytes of a decoded buffer, or 0
+ */
+typedef struct
+{
+	const unsigned char* data;
+	size_t size;
+	file_map map;
+	void* owned;
+} gltf_buffer;
+
+/**	@struct		gltf_buffer_view
+ *	@brief		a range of a buffer
+ *	@member		gltf_buffer_view::buffer - the index of the buffer
+ *	@member		gltf_buffer_view::offset - the byteOffset of the range
+ *	@member		gltf_buffer_view::size - the byteLength of the range
+ *	@member		gltf_buffer_view::stride - the byteStride of interleaved elements, or 0 if tightly packed
+ */
+typedef struct
+{
+	unsigned int buffer;
+	size_t offset;
+	size_t size;
+	unsigned int stride;
+} gltf_buffer_view;
+
+/**	@struct		gltf_accessor
+ *	@brief		a typed view of a buffer view
+ *	@member		gltf_accessor::buffer_view - the index of the buffer view, or -1 for an accessor of zeros
+ *	@member		gltf_accessor::offset - the byteOffset within the buffer view
+ *	@member		gltf_accessor::component_type - the componentType, which is also the matching GL type
+ *	@member		gltf_accessor::component_count - the number of components of the element type
+ *	@member		gltf_accessor::count - the number of elements
+ *	@member		gltf_accessor::normalized - nonzero if integer components are normalized
+ *	@member		gltf_accessor::sparse_count - the number of elements overridden by a sparse accessor, or 0
+ *	@member		gltf_accessor::sparse_index_type - the component type of the sparse indices
+ *	@member		gltf_accessor::sparse_indices - sparse_count strictly increasing element indices
+ *	@member		gltf_accessor::sparse_values - sparse_count tightly packed elements replacing those of the view, or of zeros
+ */
+typedef struct
+{
+	int buffer_view;
+	size_t offset;
+	unsigned int component_type;
+	unsigned int component_count;
+	unsigned int count;
+	int normalized;
+	unsigned int sparse_count;
+	unsigned int sparse_index_type;
+	const unsigned char* sparse_indices;
+	const unsigned char* sparse_values;
+} gltf_accessor;
+
+/**	@struct		gltf_primitive
+ *	@brief		a single draw of a mesh
+ *	@member		gltf_primitive::attributes - the accessor of each GLTF_ATTRIBUTE, or -1 if absent
+ *	@member		gltf_primitive::indices - the accessor of the indices, or -1 if the primitive is not indexed
+ *	@member		gltf_primitive::material - the index of the material, or -1
+ *	@member		gltf_primitive::mode - the topology, which is also the matching GL draw mode
+ *	@member		gltf_primitive::target_offset - the index of the primitive's first morph target in gltf::targets
+ *	@member		gltf_primitive::target_count - the number of morph targets
+ */
+typedef struct
+{
+	int attributes[GLTF_ATTRIBUTE_COUNT];
+	int indices;
+	int material;
+	unsigned int mode;
+	unsigned int target_offset;
+	unsigned int target_count;
+} gltf_primitive;
+
+/**	@struct		gltf_target
+ *	@brief		the displacements of a morph target
+ *	@member		gltf_target::position - the accessor of the position displacements, or -1
+ *	@member		gltf_target::normal - the accessor of the normal displacements, or -1
+ */
+typedef struct
+{
+	int position;
+	int normal;
+} gltf_target;
+
+/**	@struct		gltf_mesh
+ *	@brief		a range of primitives
+ *	@member		gltf_mesh::primitive_offset - the index of the mesh's first primitive
+ *	@member		gltf_mesh::primitive_count - the number of primitives in the mesh
+ *	@member		gltf_mesh::weight_offset - the index of the mesh's first default morph weight in gltf::weights
+ *	@member		gltf_mesh::weight_count - the number of default morph weights
+ */
+typedef struct
+{
+	unsigned int primitive_offset;
+	unsigned int primitive_count;
+	unsigned int weight_offset;
+	unsigned int weight_count;
+} gltf_mesh;
+
+/**	@struct		gltf_node
+ *	@brief		a node of the scene hierarchy
+ *	@member		gltf_node::parent - the index of the parent node, or -1 for a root
+ *	@member		gltf_node::mesh - the index of the mesh, or -1
+ *	@member		gltf_node::child_offset - the offset of the node's children in gltf::node_children
+ *	@member		gltf_node::child_count - the number of children
+ *	@member		gltf_node::matrix - the column major local transform, composed from translation, rotation and scale if given
+ *	@member		gltf_node::instance_count - the number of EXT_mesh_gpu_instancing instances of the mesh, or 0
+ *	@member		gltf_node::instance_translation - the accessor of the instance translations, or -1
+ *	@member		gltf_node::instance_rotation - the accessor of the instance rotation quaternions, or -1
+ *	@member		gltf_node::instance_scale - the accessor of the instance scales, or -1
+ */
+typedef struct
+{
+	int parent;
+	int mesh;
+	unsigned int child_offset;
+	unsigned int child_count;
+	float matrix[16];
+	unsigned int instance_count;
+	int instance_translation;
+	int instance_rotation;
+	int instance_scale;
+} gltf_node;
+
+/**	@struct		gltf_image
+ *	@brief		an image of the asset, kept encoded until it is pushed to an image queue
+ *	@member		gltf_image::buffer_view - the index of the buffer view holding the image, or -1
+ *	@member		gltf_image::path - the resolved path of an image file, or 0
+ *	@member		gltf_image::owned - the malloc'd bytes of a decoded data uri, or 0
+ *	@member		gltf_image::size - the size of the decoded data uri
+ */
+typedef struct
+{
+	int buffer_view;
+	char* path;
+	unsigned char* owned;
+	size_t size;
+} gltf_image;
+
+/**	@struct		gltf
+ *	@brief		a loaded glTF asset, the document is parsed in place and every buffer is mapped rather than read
+ *	@member		gltf::map - the mapping of the .gltf or .glb file
+ *	@member		gltf::document - the parsed JSON, referencing the mapping
+ *	@member		gltf::binary - the BIN chunk of a .glb file within the mapping, or 0
+ *	@member		gltf::binary_size - the length of the BIN chunk
+ *	@member		gltf::scene - the default scene, or -1
+ *	@member		gltf::root_count - the number of root nodes of the default scene
+ *	@member		gltf::roots - the root nodes of the default scene
+ */
+typedef struct
+{
+	file_map map;
+	json document;
+	const unsigned char* binary;
+	size_t binary_size;
+	unsigned int buffer_count;
+	gltf_buffer* buffers;
+	unsigned int buffer_view_count;
+	gltf_buffer_view* buffer_views;
+	unsigned int image_count;
+	gltf_image* images;
+	unsigned int accessor_count;
+	gltf_accessor* accessors;
+	unsigned int mesh_count;
+	gltf_mesh* meshes;
+	unsigned int primitive_count;
+	gltf_primitive* primitives;
+	unsigned int target_count;
+	gltf_target* targets;
+	unsigned int weight_count;
+	float* weights;
+	unsigned int node_count;
+	gltf_node* nodes;
+	unsigned int* node_children;
+	int scene;
+	unsigned int root_count;
+	unsigned int* roots;
 } gltf;
 
-int gltf_load(gltf* t_fbx, const char* t_string);
+/** a function receiving each mesh of a progressive load as soon as every accessor of its primitives is resolved
+ *	@param		t_context - the context given to gltf_load_progressive
+ *	@param		t_gltf - the loading gltf, whose nodes, meshes and the accessors of meshes handed out so far may be read
+ *	@param		t_mesh - the index of the mesh
+ */
+typedef void (*gltf_mesh_function)(void* t_context, gltf* t_gltf, unsigned int t_mesh);
+
+int gltf_load(gltf* t_gltf, const char* t_string);
+
+/** loads a glTF asset while fetching and decoding its buffers across a pool, meshes are handed out in order on the
+ *	calling thread so they may be uploaded while later buffers stream in, if the load fails anything created from the
+ *	meshes handed out must be discarded as the gltf is finalized
+ *	@memberof	gltf
+ *	@param		t_gltf - an invalid gltf to be loaded
+ *	@param		t_string - the path of the .gltf or .glb file
+ *	@param		t_pool - an optional thread pool to fetch buffers across
+ *	@param		t_function - an optional function to receive each mesh
+ *	@param		t_context - the context passed to the function
+ *	@returns	nonzero if every buffer and accessor loaded successfully
+ */
+int gltf_load_progressive(gltf* t_gltf, const char* t_string, thread_pool* t_pool, gltf_mesh_function t_function, void* t_context);
+
+const unsigned char* gltf_accessor_get_data(gltf* t_gltf, unsigned int t_accessor, unsigned int* t_out_stride);
+
+void gltf_accessor_read_floats(gltf* t_gltf, unsigned int t_accessor, float* t_out);
+
+int gltf_accessor_read_sparse(gltf* t_gltf, unsigned int t_accessor, unsigned int* t_out_indices, float* t_out_values);
+
+int gltf_accessor_get_vertex_attribute(gltf* t_gltf, unsigned int t_accessor, vertex_attribute* t_out_attribute);
+
+int gltf_accessor_get_index_buffer(gltf* t_gltf, unsigned int t_accessor, index_buffer* t_out_buffer);
+
+int gltf_primitive_get_vertex_attributes(gltf* t_gltf, const gltf_primitive* t_primitive, vertex_attribute* t_out_attributes, unsigned int* t_out_count);
+
+void gltf_node_get_world_matrix(gltf* t_gltf, unsigned int t_node, float* t_out_matrix);
+
+int gltf_node_get_instance_transforms(gltf* t_gltf, unsigned int t_node, float* t_out_transforms);
+
+const unsigned char* gltf_image_get_data(gltf* t_gltf, unsigned int t_image, size_t* t_out_size);
+
+int gltf_push_images(gltf* t_gltf, image_queue* t_queue, unsigned int* t_out_first);
 
-void gltf_final(gltf* t_fbx);
+void gltf_final(gltf* t_gltf);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,726 @@
+#include "gltf_meshopt.h"
+
+#include "assert.h"
+#include "math.h"
+#include "string.h"
+
+#include "simd.h"
+
+#define GLTF_MESHOPT_VERTEX_HEADER 0xA0
+#define GLTF_MESHOPT_TRIANGLE_HEADER 0xE0
+#define GLTF_MESHOPT_SEQUENCE_HEADER 0xD0
+#define GLTF_MESHOPT_BLOCK_BYTES 8192
+#define GLTF_MESHOPT_BLOCK_MAX_SIZE 256
+#define GLTF_MESHOPT_GROUP_SIZE 16
+#define GLTF_MESHOPT_GROUP_DECODE_LIMIT 24
+#define GLTF_MESHOPT_TAIL_MAX_SIZE 32
+#define GLTF_MESHOPT_TRIANGLE_TAIL 16
+#define GLTF_MESHOPT_SEQUENCE_TAIL 4
+
+typedef const unsigned char* (*gltf_meshopt_group_decoder)(const unsigned char*, unsigned char*, unsigned int);
+
+/* vertices are encoded in blocks of up to 8 KB, a whole number of byte groups long */
+static size_t gltf_meshopt_get_block_size(size_t t_stride)
+{
+	size_t size = (GLTF_MESHOPT_BLOCK_BYTES / t_stride) & ~(size_t)(GLTF_MESHOPT_GROUP_SIZE - 1);
+	return size < GLTF_MESHOPT_BLOCK_MAX_SIZE ? size : GLTF_MESHOPT_BLOCK_MAX_SIZE;
+}
+
+/* a group of sixteen bytes is stored as zeros, raw bytes, or as 2 or 4 bit values where the largest value escapes to
+ * a byte following the packed values, the first value occupies the highest bits */
+static const unsigned char* gltf_meshopt_decode_group(const unsigned char* t_data, unsigned char* t_out, unsigned int t_bits_log2)
+{
+	if (t_bits_log2 == 0)
+	{
+		memset(t_out, 0, GLTF_MESHOPT_GROUP_SIZE);
+		return t_data;
+	}
+	if (t_bits_log2 == 3)
+	{
+		memcpy(t_out, t_data, GLTF_MESHOPT_GROUP_SIZE);
+		return t_data + GLTF_MESHOPT_GROUP_SIZE;
+	}
+
+	unsigned int bits = 1u << t_bits_log2, escape = (1u << bits) - 1, i;
+	const unsigned char* escaped = t_data + bits * 2;
+	for (i = 0; i < GLTF_MESHOPT_GROUP_SIZE; ++i)
+	{
+		unsigned int value = (t_data[i * bits / 8] >> (8 - bits - (i * bits) % 8)) & escape;
+		t_out[i] = value == escape ? *escaped++ : (unsigned char)value;
+	}
+	return escaped;
+}
+
+#if SIMD_X86_DISPATCH
+/* for each mask of escaped values in eight bytes, the shuffle placing consecutive escape bytes at those positions,
+ * spelled out by the preprocessor so the tables are constant and need no building before the first decode */
+#define GLTF_MESHOPT_COUNT(T_MASK) \
+	(((T_MASK) & 1) + (((T_MASK) >> 1) & 1) + (((T_MASK) >> 2) & 1) + (((T_MASK) >> 3) & 1) \
+	+ (((T_MASK) >> 4) & 1) + (((T_MASK) >> 5) & 1) + (((T_MASK) >> 6) & 1) + (((T_MASK) >> 7) & 1))
+#define GLTF_MESHOPT_SHUFFLE_BYTE(T_MASK, T_INDEX) \
+	(((T_MASK) >> (T_INDEX)) & 1 ? GLTF_MESHOPT_COUNT((T_MASK) & ((1 << (T_INDEX)) - 1)) : 0x80)
+#define GLTF_MESHOPT_SHUFFLE(T_MASK) { \
+	GLTF_MESHOPT_SHUFFLE_BYTE(T_MASK, 0), GLTF_MESHOPT_SHUFFLE_BYTE(T_MASK, 1), \
+	GLTF_MESHOPT_SHUFFLE_BYTE(T_MASK, 2), GLTF_MESHOPT_SHUFFLE_BYTE(T_MASK, 3), \
+	GLTF_MESHOPT_SHUFFLE_BYTE(T_MASK, 4), GLTF_MESHOPT_SHUFFLE_BYTE(T_MASK, 5), \
+	GLTF_MESHOPT_SHUFFLE_BYTE(T_MASK, 6), GLTF_MESHOPT_SHUFFLE_BYTE(T_MASK, 7) }
+#define GLTF_MESHOPT_REPEAT4(T_MACRO, T_MASK) \
+	T_MACRO(T_MASK), T_MACRO((T_MASK) + 1), T_MACRO((T_MASK) + 2), T_MACRO((T_MASK) + 3)
+#define GLTF_MESHOPT_REPEAT16(T_MACRO, T_MASK) \
+	GLTF_MESHOPT_REPEAT4(T_MACRO, T_MASK), GLTF_MESHOPT_REPEAT4(T_MACRO, (T_MASK) + 4), \
+	GLTF_MESHOPT_REPEAT4(T_MACRO, (T_MASK) + 8), GLTF_MESHOPT_REPEAT4(T_MACRO, (T_MASK) + 12)
+#define GLTF_MESHOPT_REPEAT64(T_MACRO, T_MASK) \
+	GLTF_MESHOPT_REPEAT16(T_MACRO, T_MASK), GLTF_MESHOPT_REPEAT16(T_MACRO, (T_MASK) + 16), \
+	GLTF_MESHOPT_REPEAT16(T_MACRO, (T_MASK) + 32), GLTF_MESHOPT_REPEAT16(T_MACRO, (T_MASK) + 48)
+#define GLTF_MESHOPT_REPEAT256(T_MACRO) \
+	GLTF_MESHOPT_REPEAT64(T_MACRO, 0), GLTF_MESHOPT_REPEAT64(T_MACRO, 64), \
+	GLTF_MESHOPT_REPEAT64(T_MACRO, 128), GLTF_MESHOPT_REPEAT64(T_MACRO, 192)
+
+static const unsigned char g_gltf_meshopt_shuffles[256][8] = { GLTF_MESHOPT_REPEAT256(GLTF_MESHOPT_SHUFFLE) };
+static const unsigned char g_gltf_meshopt_counts[256] = { GLTF_MESHOPT_REPEAT256(GLTF_MESHOPT_COUNT) };
+
+/* the packed values are widened to one per byte, then the escape bytes are shuffled into the escaped positions */
+SIMD_TARGET("ssse3") static const unsigned char* gltf_meshopt_decode_group_ssse3(const unsigned char* t_data, unsigned char* t_out, unsigned int t_bits_log2)
+{
+	__m128i values, escape;
+	unsigned int header;
+	switch (t_bits_log2)
+	{
+	case 0:
+		_mm_storeu_si128((__m128i*)t_out, _mm_setzero_si128());
+		return t_data;
+	case 1:
+	{
+		int packed;
+		memcpy(&packed, t_data, sizeof(packed));
+		__m128i selectors = _mm_cvtsi32_si128(packed);
+		__m128i nibbles = _mm_unpacklo_epi8(_mm_srli_epi16(selectors, 4), selectors);
+		values = _mm_and_si128(_mm_unpacklo_epi8(_mm_srli_epi16(nibbles, 2), nibbles), _mm_set1_epi8(3));
+		escape = _mm_set1_epi8(3);
+		header = 4;
+		break;
+	}
+	case 2:
+	{
+		__m128i selectors = _mm_loadl_epi64((const __m128i*)t_data);
+		values = _mm_and_si128(_mm_unpacklo_epi8(_mm_srli_epi16(selectors, 4), selectors), _mm_set1_epi8(15));
+		escape = _mm_set1_epi8(15);
+		header = 8;
+		break;
+	}
+	default:
+		_mm_storeu_si128((__m128i*)t_out, _mm_loadu_si128((const __m128i*)t_data));
+		return t_data + GLTF_MESHOPT_GROUP_SIZE;
+	}
+
+	__m128i is_escaped = _mm_cmpeq_epi8(values, escape);
+	unsigned int mask = (unsigned int)_mm_movemask_epi8(is_escaped), low = mask & 255, high = mask >> 8;
+	__m128i shuffle = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)g_gltf_meshopt_shuffles[low]),
+		_mm_add_epi8(_mm_loadl_epi64((const __m128i*)g_gltf_meshopt_shuffles[high]), _mm_set1_epi8((char)g_gltf_meshopt_counts[low])));
+	__m128i escaped = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(t_data + header)), shuffle);
+	_mm_storeu_si128((__m128i*)t_out, _mm_or_si128(escaped, _mm_andnot_si128(is_escaped, values)));
+	return t_data + header + g_gltf_meshopt_counts[low] + g_gltf_meshopt_counts[high];
+}
+#endif
+
+/* decodes a stream of byte groups preceded by the 2 bit mode of each group */
+static const unsigned char* gltf_meshopt_decode_bytes(const unsigned char* t_data, const unsigned char* t_end, unsigned char* t_out, size_t t_size, gltf_meshopt_group_decoder t_decode_group)
+{
+	size_t header_size = (t_size / GLTF_MESHOPT_GROUP_SIZE + 3) / 4, i;
+	if ((size_t)(t_end - t_data) < header_size)
+	{
+		return 0;
+	}
+
+	const unsigned char* header = t_data;
+	t_data += header_size;
+	for (i = 0; i < t_size; i += GLTF_MESHOPT_GROUP_SIZE)
+	{
+		/* the decoders may read a whole group beyond their packed values, the tail of the stream keeps that in bounds */
+		if ((size_t)(t_end - t_data) < GLTF_MESHOPT_GROUP_DECODE_LIMIT)
+		{
+			return 0;
+		}
+		size_t group = i / GLTF_MESHOPT_GROUP_SIZE;
+		t_data = t_decode_group(t_data, t_out + i, (header[group / 4] >> ((group % 4) * 2)) & 3);
+	}
+	return t_data;
+}
+
+/* each byte of a vertex is a separate stream of zigzag deltas from the same byte of the previous vertex */
+static const unsigned char* gltf_meshopt_decode_block(const unsigned char* t_data, const unsigned char* t_end, unsigned char* t_out, size_t t_count, size_t t_stride, unsigned char* t_last)
+{
+	unsigned char deltas[GLTF_MESHOPT_BLOCK_MAX_SIZE];
+	size_t aligned = (t_count + GLTF_MESHOPT_GROUP_SIZE - 1) & ~(size_t)(GLTF_MESHOPT_GROUP_SIZE - 1), i, k;
+	for (k = 0; k < t_stride; ++k)
+	{
+		t_data = gltf_meshopt_decode_bytes(t_data, t_end, deltas, aligned, gltf_meshopt_decode_group);
+		if (!t_data)
+		{
+			return 0;
+		}
+		unsigned char previous = t_last[k];
+		for (i = 0; i < t_count; ++i)
+		{
+			previous = (unsigned char)(previous + ((deltas[i] >> 1) ^ (0u - (deltas[i] & 1u))));
+			t_out[i * t_stride + k] = previous;
+		}
+		t_last[k] = previous;
+	}
+	return t_data;
+}
+
+#if SIMD_X86_DISPATCH
+/* four byte streams at a time are transposed into sixteen vertices of four bytes, after which the deltas of four
+ * consecutive vertices are summed in two shifted additions */
+SIMD_TARGET("ssse3") static const unsigned char* gltf_meshopt_decode_block_ssse3(const unsigned char* t_data, const unsigned char* t_end, unsigned char* t_out, size_t t_count, size_t t_stride, unsigned char* t_last)
+{
+	unsigned char deltas[4][GLTF_MESHOPT_BLOCK_MAX_SIZE];
+	size_t aligned = (t_count + GLTF_MESHOPT_GROUP_SIZE - 1) & ~(size_t)(GLTF_MESHOPT_GROUP_SIZE - 1), i, j, k;
+	for (k = 0; k < t_stride; k += 4)
+	{
+		for (j = 0; j < 4; ++j)
+		{
+			t_data = gltf_meshopt_decode_bytes(t_data, t_end, deltas[j], aligned, gltf_meshopt_decode_group_ssse3);
+			if (!t_data)
+			{
+				return 0;
+			}
+		}
+
+		int last;
+		memcpy(&last, t_last + k, sizeof(last));
+		__m128i previous = _mm_set1_epi32(last);
+		for (i = 0; i < t_count; i += GLTF_MESHOPT_GROUP_SIZE)
+		{
+			__m128i r0 = _mm_loadu_si128((const __m128i*)(deltas[0] + i));
+			__m128i r1 = _mm_loadu_si128((const __m128i*)(deltas[1] + i));
+			__m128i r2 = _mm_loadu_si128((const __m128i*)(deltas[2] + i));
+			__m128i r3 = _mm_loadu_si128((const __m128i*)(deltas[3] + i));
+			__m128i t0 = _mm_unpacklo_epi8(r0, r1), t1 = _mm_unpackhi_epi8(r0, r1);
+			__m128i t2 = _mm_unpacklo_epi8(r2, r3), t3 = _mm_unpackhi_epi8(r2, r3);
+			__m128i vertices[4];
+			vertices[0] = _mm_unpacklo_epi16(t0, t2);
+			vertices[1] = _mm_unpackhi_epi16(t0, t2);
+			vertices[2] = _mm_unpacklo_epi16(t1, t3);
+			vertices[3] = _mm_unpackhi_epi16(t1, t3);
+
+			for (j = 0; j < 4 && i + j * 4 < t_count; ++j)
+			{
+				__m128i delta = vertices[j];
+				__m128i sign = _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(delta, _mm_set1_epi8(1)));
+				delta = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(delta, 1), _mm_set1_epi8(0x7F)), sign);
+				delta = _mm_add_epi8(delta, _mm_slli_si128(delta, 4));
+				delta = _mm_add_epi8(delta, _mm_slli_si128(delta, 8));
+				delta = _mm_add_epi8(delta, previous);
+				previous = _mm_shuffle_epi32(delta, 0xFF);
+
+				size_t lane, vertex = i + j * 4;
+				for (lane = 0; lane < 4 && vertex + lane < t_count; ++lane)
+				{
+					int value = _mm_cvtsi128_si32(delta);
+					memcpy(t_out + (vertex + lane) * t_stride + k, &value, sizeof(value));
+					delta = _mm_srli_si128(delta, 4);
+				}
+			}
+		}
+		memcpy(t_last + k, t_out + (t_count - 1) * t_stride + k, 4);
+	}
+	return t_data;
+}
+#endif
+
+int gltf_meshopt_decode_vertices(void* t_out, size_t t_count, size_t t_stride, const unsigned char* t_data, size_t t_size)
+{
+	assert((t_out || !t_count) && (t_data || !t_size));
+
+	unsigned char last[GLTF_MESHOPT_BLOCK_MAX_SIZE];
+	size_t tail = t_stride < GLTF_MESHOPT_TAIL_MAX_SIZE ? GLTF_MESHOPT_TAIL_MAX_SIZE : t_stride;
+	if (!t_stride || t_stride > GLTF_MESHOPT_BLOCK_MAX_SIZE || t_size < 1 + tail
+		|| (t_data[0] & 0xF0) != GLTF_MESHOPT_VERTEX_HEADER || (t_data[0] & 0x0F) != 0)
+	{
+		return 0;
+	}
+
+	const unsigned char* end = t_data + t_size;
+	const unsigned char* (*decode_block)(const unsigned char*, const unsigned char*, unsigned char*, size_t, size_t, unsigned char*) = gltf_meshopt_decode_block;
+#if SIMD_X86_DISPATCH
+	if ((simd_get_features() & SIMD_FEATURE_SSSE3) && t_stride % 4 == 0)
+	{
+		decode_block = gltf_meshopt_decode_block_ssse3;
+	}
+#endif
+
+	/* the first vertex is predicted from the tail, which holds a copy of it */
+	memcpy(last, end - t_stride, t_stride);
+	++t_data;
+
+	size_t block_size = gltf_meshopt_get_block_size(t_stride), offset;
+	for (offset = 0; offset < t_count; offset += block_size)
+	{
+		size_t count = t_count - offset < block_size ? t_count - offset : block_size;
+		t_data = decode_block(t_data, end, (unsigned char*)t_out + offset * t_stride, count, t_stride, last);
+		if (!t_data)
+		{
+			return 0;
+		}
+	}
+	return (size_t)(end - t_data) == tail;
+}
+
+static unsigned int gltf_meshopt_decode_vbyte(const unsigned char** t_data)
+{
+	const unsigned char* data = *t_data;
+	unsigned int lead = *data++, result, shift = 7, i;
+	if (lead < 128)
+	{
+		*t_data = data;
+		return lead;
+	}
+	result = lead & 127;
+	for (i = 0; i < 4; ++i)
+	{
+		unsigned int group = *data++;
+		result |= (group & 127) << shift;
+		shift += 7;
+		if (group < 128)
+		{
+			break;
+		}
+	}
+	*t_data = data;
+	return result;
+}
+
+static unsigned int gltf_meshopt_decode_index(const unsigned char** t_data, unsigned int t_last)
+{
+	unsigned int value = gltf_meshopt_decode_vbyte(t_data);
+	return t_last + ((value >> 1) ^ (0u - (value & 1)));
+}
+
+static void gltf_meshopt_write_triangle(void* t_out, size_t t_offset, size_t t_stride, unsigned int t_a, unsigned int t_b, unsigned int t_c)
+{
+	if (t_stride == 2)
+	{
+		unsigned short* out = (unsigned short*)t_out + t_offset;
+		out[0] = (unsigned short)t_a;
+		out[1] = (unsigned short)t_b;
+		out[2] = (unsigned short)t_c;
+	}
+	else
+	{
+		unsigned int* out = (unsigned int*)t_out + t_offset;
+		out[0] = t_a;
+		out[1] = t_b;
+		out[2] = t_c;
+	}
+}
+
+static void gltf_meshopt_push_edge(unsigned int t_edges[16][2], unsigned int* t_offset, unsigned int t_a, unsigned int t_b)
+{
+	t_edges[*t_offset][0] = t_a;
+	t_edges[*t_offset][1] = t_b;
+	*t_offset = (*t_offset + 1) & 15;
+}
+
+static void gltf_meshopt_push_vertex(unsigned int t_vertices[16], unsigned int* t_offset, unsigned int t_vertex, int t_condition)
+{
+	t_vertices[*t_offset] = t_vertex;
+	*t_offset = (*t_offset + (t_condition ? 1 : 0)) & 15;
+}
+
+/* triangles are coded against fifos of recent edges and vertices, with new vertices numbered in order of first use,
+ * the decoder must update the fifos exactly as the encoder did */
+int gltf_meshopt_decode_triangles(void* t_out, size_t t_count, size_t t_stride, const unsigned char* t_data, size_t t_size)
+{
+	assert((t_out || !t_count) && (t_data || !t_size));
+
+	unsigned int edges[16][2], vertices[16], edge_offset = 0, vertex_offset = 0, next = 0, last = 0;
+	size_t i;
+	if ((t_stride != 2 && t_stride != 4) || t_count % 3 != 0 || t_size < 1 + t_count / 3 + GLTF_MESHOPT_TRIANGLE_TAIL
+		|| (t_data[0] & 0xF0) != GLTF_MESHOPT_TRIANGLE_HEADER || (t_data[0] & 0x0F) > 1)
+	{
+		return 0;
+	}
+
+	/* version 1 codes the previous free index plus or minus one without a vbyte */
+	unsigned int fec_max = (t_data[0] & 0x0F) >= 1 ? 13 : 15;
+	const unsigned char* code = t_data + 1;
+	const unsigned char* data = code + t_count / 3;
+	const unsigned char* data_safe_end = t_data + t_size - GLTF_MESHOPT_TRIANGLE_TAIL;
+	const unsigned char* codeaux_table = data_safe_end;
+	memset(edges, 0xFF, sizeof(edges));
+	memset(vertices, 0xFF, sizeof(vertices));
+
+	for (i = 0; i < t_count; i += 3)
+	{
+		if (data > data_safe_end)
+		{
+			return 0;
+		}
+
+		unsigned int codetri = *code++;
+		if (codetri < 0xF0)
+		{
+			/* a triangle sharing an edge from the fifo, with its third vertex new, from the fifo or coded freely */
+			unsigned int fe = codetri >> 4, fec = codetri & 15;
+			unsigned int a = edges[(edge_offset - 1 - fe) & 15][0];
+			unsigned int b = edges[(edge_offset - 1 - fe) & 15][1];
+			unsigned int c;
+			int is_new = 0;
+			if (fec < fec_max)
+			{
+				is_new = fec == 0;
+				c = is_new ? next++ : vertices[(vertex_offset - 1 - fec) & 15];
+			}
+			else
+			{
+				c = last = fec != 15 ? last + (fec - (fec ^ 3)) : gltf_meshopt_decode_index(&data, last);
+				is_new = 1;
+			}
+			gltf_meshopt_write_triangle(t_out, i, t_stride, a, b, c);
+			gltf_meshopt_push_vertex(vertices, &vertex_offset, c, is_new);
+			gltf_meshopt_push_edge(edges, &edge_offset, c, b);
+			gltf_meshopt_push_edge(edges, &edge_offset, a, c);
+			continue;
+		}
+
+		unsigned int a, b, c;
+		int is_b_new, is_c_new;
+		if (codetri < 0xFE)
+		{
+			/* a triangle with a new first vertex, the other two described by the auxiliary table */
+			unsigned int codeaux = codeaux_table[codetri & 15];
+			unsigned int feb = codeaux >> 4, fec = codeaux & 15;
+			a = next++;
+			b = feb == 0 ? next : vertices[(vertex_offset - feb) & 15];
+			is_b_new = feb == 0;
+			next += is_b_new;
+			c = fec == 0 ? next : vertices[(vertex_offset - fec) & 15];
+			is_c_new = fec == 0;
+			next += is_c_new;
+		}
+		else
+		{
+			/* the same with the description inline, where 15 codes a free index and 0xFF does so for the first vertex */
+			unsigned int codeaux = *data++;
+			unsigned int fea = codetri == 0xFE ? 0 : 15, feb = codeaux >> 4, fec = codeaux & 15;
+			if (codeaux == 0)
+			{
+				next = 0;
+			}
+			a = fea == 0 ? next++ : 0;
+			b = feb == 0 ? next++ : vertices[(vertex_offset - feb) & 15];
+			c = fec == 0 ? next++ : vertices[(vertex_offset - fec) & 15];
+			if (fea == 15)
+			{
+				last = a = gltf_meshopt_decode_index(&data, last);
+			}
+			if (feb == 15)
+			{
+				last = b = gltf_meshopt_decode_index(&data, last);
+			}
+			if (fec == 15)
+			{
+				last = c = gltf_meshopt_decode_index(&data, last);
+			}
+			is_b_new = feb == 0 || feb == 15;
+			is_c_new = fec == 0 || fec == 15;
+		}
+		gltf_meshopt_write_triangle(t_out, i, t_stride, a, b, c);
+		gltf_meshopt_push_vertex(vertices, &vertex_offset, a, 1);
+		gltf_meshopt_push_vertex(vertices, &vertex_offset, b, is_b_new);
+		gltf_meshopt_push_vertex(vertices, &vertex_offset, c, is_c_new);
+		gltf_meshopt_push_edge(edges, &edge_offset, b, a);
+		gltf_meshopt_push_edge(edges, &edge_offset, c, b);
+		gltf_meshopt_push_edge(edges, &edge_offset, a, c);
+	}
+	return data == data_safe_end;
+}
+
+/* each index is a zigzag delta from one of two baselines, the low bit of its vbyte selecting which */
+int gltf_meshopt_decode_indices(void* t_out, size_t t_count, size_t t_stride, const unsigned char* t_data, size_t t_size)
+{
+	assert((t_out || !t_count) && (t_data || !t_size));
+
+	unsigned int last[2] = { 0, 0 };
+	size_t i;
+	if ((t_stride != 2 && t_stride != 4) || t_size < 1 + t_count + GLTF_MESHOPT_SEQUENCE_TAIL
+		|| (t_data[0] & 0xF0) != GLTF_MESHOPT_SEQUENCE_HEADER || (t_data[0] & 0x0F) > 1)
+	{
+		return 0;
+	}
+
+	const unsigned char* data = t_data + 1;
+	const unsigned char* data_safe_end = t_data + t_size - GLTF_MESHOPT_SEQUENCE_TAIL;
+	for (i = 0; i < t_count; ++i)
+	{
+		if (data >= data_safe_end)
+		{
+			return 0;
+		}
+		unsigned int value = gltf_meshopt_decode_vbyte(&data);
+		unsigned int baseline = value & 1;
+		value >>= 1;
+		unsigned int index = last[baseline] + ((value >> 1) ^ (0u - (value & 1)));
+		last[baseline] = index;
+		if (t_stride == 2)
+		{
+			((unsigned short*)t_out)[i] = (unsigned short)index;
+		}
+		else
+		{
+			((unsigned int*)t_out)[i] = index;
+		}
+	}
+	return data == data_safe_end;
+}
+
+static float gltf_meshopt_round(float t_value)
+{
+	return t_value + (t_value >= 0.0f ? 0.5f : -0.5f);
+}
+
+/* unit vectors stored as the x and y of their octahedral projection, with z holding the scale of one */
+static void gltf_meshopt_filter_octahedral(void* t_data, size_t t_begin, size_t t_count, size_t t_stride)
+{
+	size_t i;
+	for (i = t_begin; i < t_count; ++i)
+	{
+		int components[3], k;
+		if (t_stride == 4)
+		{
+			const signed char* element = (const signed char*)t_data + i * 4;
+			components[0] = element[0];
+			components[1] = element[1];
+			components[2] = element[2];
+		}
+		else
+		{
+			const short* element = (const short*)t_data + i * 4;
+			components[0] = element[0];
+			components[1] = element[1];
+			components[2] = element[2];
+		}
+
+		float maximum = t_stride == 4 ? 127.0f : 32767.0f;
+		float x = (float)components[0], y = (float)components[1];
+		float z = (float)components[2] - fabsf(x) - fabsf(y);
+		float t = z >= 0.0f ? 0.0f : z;
+		x += x >= 0.0f ? t : -t;
+		y += y >= 0.0f ? t : -t;
+		float length = sqrtf(x * x + y * y + z * z);
+		float scale = length > 0.0f ? maximum / length : 0.0f;
+		components[0] = (int)gltf_meshopt_round(x * scale);
+		components[1] = (int)gltf_meshopt_round(y * scale);
+		components[2] = (int)gltf_meshopt_round(z * scale);
+
+		for (k = 0; k < 3; ++k)
+		{
+			if (t_stride == 4)
+			{
+				((signed char*)t_data)[i * 4 + k] = (signed char)components[k];
+			}
+			else
+			{
+				((short*)t_data)[i * 4 + k] = (short)components[k];
+			}
+		}
+	}
+}
+
+/* writes a decoded quaternion into the order given by the index of its omitted, largest, component */
+static void gltf_meshopt_store_quaternion(short* t_element, int t_x, int t_y, int t_z, int t_w)
+{
+	int largest = t_element[3] & 3;
+	t_element[(largest + 1) & 3] = (short)t_x;
+	t_element[(largest + 2) & 3] = (short)t_y;
+	t_element[(largest + 3) & 3] = (short)t_z;
+	t_element[largest] = (short)t_w;
+}
+
+/* quaternions stored as their three smallest components, scaled by the bits given alongside the largest's index */
+static void gltf_meshopt_filter_quaternion(short* t_data, size_t t_begin, size_t t_count)
+{
+	const float scale = 1.0f / sqrtf(2.0f);
+	size_t i;
+	for (i = t_begin; i < t_count; ++i)
+	{
+		short* element = t_data + i * 4;
+		float component_scale = scale / (float)(element[3] | 3);
+		float x = (float)element[0] * component_scale;
+		float y = (float)element[1] * component_scale;
+		float z = (float)element[2] * component_scale;
+		float ww = 1.0f - x * x - y * y - z * z;
+		float w = sqrtf(ww >= 0.0f ? ww : 0.0f);
+		gltf_meshopt_store_quaternion(element, (int)gltf_meshopt_round(x * 32767.0f), (int)gltf_meshopt_round(y * 32767.0f),
+			(int)gltf_meshopt_round(z * 32767.0f), (int)(w * 32767.0f + 0.5f));
+	}
+}
+
+/* floats stored as a 24 bit mantissa and an 8 bit exponent */
+static void gltf_meshopt_filter_exponential(unsigned int* t_data, size_t t_begin, size_t t_count)
+{
+	size_t i;
+	for (i = t_begin; i < t_count; ++i)
+	{
+		int mantissa = (int)(t_data[i] << 8) >> 8;
+		int exponent = (int)t_data[i] >> 24;
+		unsigned int bits = (unsigned int)(exponent + 127) << 23;
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		value *= (float)mantissa;
+		memcpy(t_data + i, &value, sizeof(value));
+	}
+}
+
+#if SIMD_SSE2
+static __m128 gltf_meshopt_round_sse2(__m128 t_value)
+{
+	__m128 half = _mm_or_ps(_mm_set1_ps(0.5f), _mm_and_ps(_mm_cmplt_ps(t_value, _mm_setzero_ps()), _mm_set1_ps(-0.0f)));
+	return _mm_add_ps(t_value, half);
+}
+
+/* the same arithmetic four elements at a time, in the same order so the results match the scalar filter exactly */
+static void gltf_meshopt_octahedral_sse2(__m128i* t_x, __m128i* t_y, __m128i* t_z, float t_maximum)
+{
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	__m128 x = _mm_cvtepi32_ps(*t_x), y = _mm_cvtepi32_ps(*t_y);
+	__m128 z = _mm_sub_ps(_mm_sub_ps(_mm_cvtepi32_ps(*t_z), _mm_andnot_ps(sign, x)), _mm_andnot_ps(sign, y));
+	__m128 t = _mm_min_ps(z, _mm_setzero_ps());
+	x = _mm_add_ps(x, _mm_xor_ps(t, _mm_and_ps(_mm_cmplt_ps(x, _mm_setzero_ps()), sign)));
+	y = _mm_add_ps(y, _mm_xor_ps(t, _mm_and_ps(_mm_cmplt_ps(y, _mm_setzero_ps()), sign)));
+	__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+	__m128 scale = _mm_and_ps(_mm_div_ps(_mm_set1_ps(t_maximum), length), _mm_cmpgt_ps(length, _mm_setzero_ps()));
+	*t_x = _mm_cvttps_epi32(gltf_meshopt_round_sse2(_mm_mul_ps(x, scale)));
+	*t_y = _mm_cvttps_epi32(gltf_meshopt_round_sse2(_mm_mul_ps(y, scale)));
+	*t_z = _mm_cvttps_epi32(gltf_meshopt_round_sse2(_mm_mul_ps(z, scale)));
+}
+
+static size_t gltf_meshopt_filter_octahedral_sse2(void* t_data, size_t t_count, size_t t_stride)
+{
+	const __m128i low_byte = _mm_set1_epi32(0xFF), low_short = _mm_set1_epi32(0xFFFF);
+	size_t i = 0;
+	if (t_stride == 4)
+	{
+		for (; i + 4 <= t_count; i += 4)
+		{
+			__m128i* element = (__m128i*)((signed char*)t_data + i * 4);
+			__m128i packed = _mm_loadu_si128(element);
+			__m128i x = _mm_srai_epi32(_mm_slli_epi32(packed, 24), 24);
+			__m128i y = _mm_srai_epi32(_mm_slli_epi32(packed, 16), 24);
+			__m128i z = _mm_srai_epi32(_mm_slli_epi32(packed, 8), 24);
+			gltf_meshopt_octahedral_sse2(&x, &y, &z, 127.0f);
+			__m128i result = _mm_or_si128(_mm_and_si128(x, low_byte), _mm_slli_epi32(_mm_and_si128(y, low_byte), 8));
+			result = _mm_or_si128(result, _mm_slli_epi32(_mm_and_si128(z, low_byte), 16));
+			_mm_storeu_si128(element, _mm_or_si128(result, _mm_andnot_si128(_mm_set1_epi32(0xFFFFFF), packed)));
+		}
+		return i;
+	}
+
+	for (; i + 4 <= t_count; i += 4)
+	{
+		__m128i* element = (__m128i*)((short*)t_data + i * 4);
+		__m128i first = _mm_loadu_si128(element), second = _mm_loadu_si128(element + 1);
+		__m128i xy = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(first), _mm_castsi128_ps(second), _MM_SHUFFLE(2, 0, 2, 0)));
+		__m128i zw = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(first), _mm_castsi128_ps(second), _MM_SHUFFLE(3, 1, 3, 1)));
+		__m128i x = _mm_srai_epi32(_mm_slli_epi32(xy, 16), 16), y = _mm_srai_epi32(xy, 16), z = _mm_srai_epi32(_mm_slli_epi32(zw, 16), 16);
+		gltf_meshopt_octahedral_sse2(&x, &y, &z, 32767.0f);
+		xy = _mm_or_si128(_mm_and_si128(x, low_short), _mm_slli_epi32(y, 16));
+		zw = _mm_or_si128(_mm_and_si128(z, low_short), _mm_andnot_si128(low_short, zw));
+		_mm_storeu_si128(element, _mm_unpacklo_epi32(xy, zw));
+		_mm_storeu_si128(element + 1, _mm_unpackhi_epi32(xy, zw));
+	}
+	return i;
+}
+
+static size_t gltf_meshopt_filter_quaternion_sse2(short* t_data, size_t t_count)
+{
+	const __m128 maximum = _mm_set1_ps(32767.0f);
+	const float scale = 1.0f / sqrtf(2.0f);
+	size_t i = 0;
+	for (; i + 4 <= t_count; i += 4)
+	{
+		__m128i* element = (__m128i*)(t_data + i * 4);
+		__m128i first = _mm_loadu_si128(element), second = _mm_loadu_si128(element + 1);
+		__m128i xy = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(first), _mm_castsi128_ps(second), _MM_SHUFFLE(2, 0, 2, 0)));
+		__m128i zw = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(first), _mm_castsi128_ps(second), _MM_SHUFFLE(3, 1, 3, 1)));
+		__m128 component_scale = _mm_div_ps(_mm_set1_ps(scale), _mm_cvtepi32_ps(_mm_or_si128(_mm_srai_epi32(zw, 16), _mm_set1_epi32(3))));
+		__m128 x = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(xy, 16), 16)), component_scale);
+		__m128 y = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(xy, 16)), component_scale);
+		__m128 z = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(zw, 16), 16)), component_scale);
+		__m128 ww = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(x, x)), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+		__m128 w = _mm_sqrt_ps(_mm_max_ps(ww, _mm_setzero_ps()));
+
+		int xs[4], ys[4], zs[4], ws[4];
+		_mm_storeu_si128((__m128i*)xs, _mm_cvttps_epi32(gltf_meshopt_round_sse2(_mm_mul_ps(x, maximum))));
+		_mm_storeu_si128((__m128i*)ys, _mm_cvttps_epi32(gltf_meshopt_round_sse2(_mm_mul_ps(y, maximum))));
+		_mm_storeu_si128((__m128i*)zs, _mm_cvttps_epi32(gltf_meshopt_round_sse2(_mm_mul_ps(z, maximum))));
+		_mm_storeu_si128((__m128i*)ws, _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(w, maximum), _mm_set1_ps(0.5f))));
+
+		/* the order of the output depends on each element, so the final permutation is scalar */
+		unsigned int k;
+		for (k = 0; k < 4; ++k)
+		{
+			gltf_meshopt_store_quaternion(t_data + (i + k) * 4, xs[k], ys[k], zs[k], ws[k]);
+		}
+	}
+	return i;
+}
+
+static size_t gltf_meshopt_filter_exponential_sse2(unsigned int* t_data, size_t t_count)
+{
+	size_t i = 0;
+	for (; i + 4 <= t_count; i += 4)
+	{
+		__m128i packed = _mm_loadu_si128((const __m128i*)(t_data + i));
+		__m128i mantissa = _mm_srai_epi32(_mm_slli_epi32(packed, 8), 8);
+		__m128i exponent = _mm_slli_epi32(_mm_add_epi32(_mm_srai_epi32(packed, 24), _mm_set1_epi32(127)), 23);
+		_mm_storeu_ps((float*)(t_data + i), _mm_mul_ps(_mm_castsi128_ps(exponent), _mm_cvtepi32_ps(mantissa)));
+	}
+	return i;
+}
+#endif
+
+int gltf_meshopt_apply_filter(void* t_data, size_t t_count, size_t t_stride, unsigned int t_filter)
+{
+	assert(t_data || !t_count);
+
+	size_t begin = 0;
+	switch (t_filter)
+	{
+	case GLTF_MESHOPT_FILTER_NONE:
+		return 1;
+	case GLTF_MESHOPT_FILTER_OCTAHEDRAL:
+		if (t_stride != 4 && t_stride != 8)
+		{
+			return 0;
+		}
+#if SIMD_SSE2
+		begin = gltf_meshopt_filter_octahedral_sse2(t_data, t_count, t_stride);
+#endif
+		gltf_meshopt_filter_octahedral(t_data, begin, t_count, t_stride);
+		return 1;
+	case GLTF_MESHOPT_FILTER_QUATERNION:
+		if (t_stride != 8)
+		{
+			return 0;
+		}
+#if SIMD_SSE2
+		begin = gltf_meshopt_filter_quaternion_sse2(t_data, t_count);
+#endif
+		gltf_meshopt_filter_quaternion(t_data, begin, t_count);
+		return 1;
+	case GLTF_MESHOPT_FILTER_EXPONENTIAL:
+		if (t_stride % 4 != 0)
+		{
+			return 0;
+		}
+#if SIMD_SSE2
+		begin = gltf_meshopt_filter_exponential_sse2(t_data, t_count * t_stride / 4);
+#endif
+		gltf_meshopt_filter_exponential(t_data, begin, t_count * t_stride / 4);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,27 @@
+/**
+ * gltf_meshopt.h
+ */
+
+#ifndef GRAPHICS_UTILS_GLTF_MESHOPT_H
+#define GRAPHICS_UTILS_GLTF_MESHOPT_H
+
+#include <stddef.h>
+
+#define GLTF_MESHOPT_MODE_ATTRIBUTES 0
+#define GLTF_MESHOPT_MODE_TRIANGLES 1
+#define GLTF_MESHOPT_MODE_INDICES 2
+
+#define GLTF_MESHOPT_FILTER_NONE 0
+#define GLTF_MESHOPT_FILTER_OCTAHEDRAL 1
+#define GLTF_MESHOPT_FILTER_QUATERNION 2
+#define GLTF_MESHOPT_FILTER_EXPONENTIAL 3
+
+int gltf_meshopt_decode_vertices(void* t_out, size_t t_count, size_t t_stride, const unsigned char* t_data, size_t t_size);
+
+int gltf_meshopt_decode_triangles(void* t_out, size_t t_count, size_t t_stride, const unsigned char* t_data, size_t t_size);
+
+int gltf_meshopt_decode_indices(void* t_out, size_t t_count, size_t t_stride, const unsigned char* t_data, size_t t_size);
+
+int gltf_meshopt_apply_filter(void* t_data, size_t t_count, size_t t_stride, unsigned int t_filter);
+
+#endif
@@ -0,0 +1,382 @@
+#include "gltf_morph.h"
+
+#include "simd.h"
+
+#include "assert.h"
+#include "stdlib.h"
+#include "string.h"
+
+#define GLTF_MORPH_CHUNK_SIZE 1024
+#define GLTF_MORPH_CHUNK_GRAIN 4
+#define GLTF_MORPH_SPARSE_RATIO 4
+
+typedef struct
+{
+	gltf_morph* morph;
+	gltf* gltf;
+	const gltf_primitive* primitive;
+	int is_failed;
+} gltf_morph_extract_context;
+
+typedef struct
+{
+	const gltf_morph_instance* instances;
+	const unsigned int* chunk_offsets;
+	unsigned int instance_count;
+} gltf_morph_apply_context;
+
+static int gltf_morph_is_vec3(gltf* t_gltf, int t_accessor, unsigned int t_count)
+{
+	return t_gltf->accessors[t_accessor].component_count == 3 && t_gltf->accessors[t_accessor].count == t_count;
+}
+
+/* a sparse accessor without a view is read as it is, a dense one is compacted when few enough of its vertices move */
+static int gltf_morph_extract_deltas(gltf* t_gltf, int t_accessor, unsigned int t_vertex_count, gltf_morph_deltas* t_out)
+{
+	if (t_accessor < 0)
+	{
+		return 1;
+	}
+	if (!gltf_morph_is_vec3(t_gltf, t_accessor, t_vertex_count))
+	{
+		return 0;
+	}
+
+	const gltf_accessor* accessor = t_gltf->accessors + t_accessor;
+	if (accessor->buffer_view < 0)
+	{
+		if (!accessor->sparse_count)
+		{
+			return 1;
+		}
+		t_out->count = accessor->sparse_count;
+		t_out->indices = malloc(sizeof(unsigned int) * t_out->count);
+		t_out->deltas = malloc(sizeof(float) * 3 * t_out->count);
+		return t_out->indices && t_out->deltas && gltf_accessor_read_sparse(t_gltf, (unsigned int)t_accessor, t_out->indices, t_out->deltas);
+	}
+
+	t_out->deltas = malloc(sizeof(float) * 3 * (t_vertex_count ? t_vertex_count : 1));
+	if (!t_out->deltas)
+	{
+		return 0;
+	}
+	gltf_accessor_read_floats(t_gltf, (unsigned int)t_accessor, t_out->deltas);
+	t_out->count = t_vertex_count;
+
+	unsigned int moved = 0, i;
+	for (i = 0; i < t_vertex_count; ++i)
+	{
+		const float* delta = t_out->deltas + (size_t)i * 3;
+		moved += delta[0] != 0.0f || delta[1] != 0.0f || delta[2] != 0.0f;
+	}
+	if (moved > t_vertex_count / GLTF_MORPH_SPARSE_RATIO)
+	{
+		return 1;
+	}
+
+	t_out->indices = malloc(sizeof(unsigned int) * (moved ? moved : 1));
+	if (!t_out->indices)
+	{
+		return 0;
+	}
+	t_out->count = 0;
+	for (i = 0; i < t_vertex_count; ++i)
+	{
+		const float* delta = t_out->deltas + (size_t)i * 3;
+		if (delta[0] != 0.0f || delta[1] != 0.0f || delta[2] != 0.0f)
+		{
+			memmove(t_out->deltas + (size_t)t_out->count * 3, delta, sizeof(float) * 3);
+			t_out->indices[t_out->count++] = i;
+		}
+	}
+	return 1;
+}
+
+static void gltf_morph_extract_range(void* t_context, size_t t_begin, size_t t_end)
+{
+	gltf_morph_extract_context* context = (gltf_morph_extract_context*)t_context;
+	size_t i = t_begin;
+	for (; i < t_end; ++i)
+	{
+		const gltf_target* target = context->gltf->targets + context->primitive->target_offset + i;
+		gltf_morph_target* out = context->morph->targets + i;
+		if (!gltf_morph_extract_deltas(context->gltf, target->position, context->morph->vertex_count, &out->positions)
+			|| (context->morph->base_normals && !gltf_morph_extract_deltas(context->gltf, target->normal, context->morph->vertex_count, &out->normals)))
+		{
+			context->is_failed = 1;
+		}
+	}
+}
+
+int gltf_morph_extract(gltf_morph* t_morph, gltf* t_gltf, const gltf_primitive* t_primitive, thread_pool* t_pool)
+{
+	assert(t_morph && t_gltf && t_primitive);
+
+	memset(t_morph, 0, sizeof(gltf_morph));
+
+	int position = t_primitive->attributes[GLTF_ATTRIBUTE_POSITION];
+	int normal = t_primitive->attributes[GLTF_ATTRIBUTE_NORMAL];
+	if (position < 0)
+	{
+		return 0;
+	}
+	t_morph->vertex_count = t_gltf->accessors[position].count;
+	if (!gltf_morph_is_vec3(t_gltf, position, t_morph->vertex_count)
+		|| (normal >= 0 && !gltf_morph_is_vec3(t_gltf, normal, t_morph->vertex_count)))
+	{
+		return 0;
+	}
+
+	size_t size = sizeof(float) * 3 * (t_morph->vertex_count ? t_morph->vertex_count : 1);
+	t_morph->base_positions = malloc(size);
+	t_morph->base_normals = normal >= 0 ? malloc(size) : 0;
+	t_morph->targets = calloc(t_primitive->target_count ? t_primitive->target_count : 1, sizeof(gltf_morph_target));
+	if (!t_morph->base_positions || (normal >= 0 && !t_morph->base_normals) || !t_morph->targets)
+	{
+		gltf_morph_final(t_morph);
+		return 0;
+	}
+	gltf_accessor_read_floats(t_gltf, (unsigned int)position, t_morph->base_positions);
+	if (normal >= 0)
+	{
+		gltf_accessor_read_floats(t_gltf, (unsigned int)normal, t_morph->base_normals);
+	}
+
+	gltf_morph_extract_context context;
+	context.morph = t_morph;
+	context.gltf = t_gltf;
+	context.primitive = t_primitive;
+	context.is_failed = 0;
+	t_morph->target_count = t_primitive->target_count;
+	thread_pool_parallel_for(t_pool, t_morph->target_count, 1, gltf_morph_extract_range, &context);
+	if (context.is_failed)
+	{
+		gltf_morph_final(t_morph);
+		return 0;
+	}
+	return 1;
+}
+
+#if SIMD_X86_DISPATCH
+SIMD_TARGET("avx2") static size_t gltf_morph_add_dense_avx2(float* t_out, const float* t_deltas, float t_weight, size_t t_count)
+{
+	const __m256 weight = _mm256_set1_ps(t_weight);
+	size_t i = 0;
+	for (; i + 8 <= t_count; i += 8)
+	{
+		__m256 delta = _mm256_mul_ps(_mm256_loadu_ps(t_deltas + i), weight);
+		_mm256_storeu_ps(t_out + i, _mm256_add_ps(_mm256_loadu_ps(t_out + i), delta));
+	}
+	return i;
+}
+#endif
+
+/* adds weighted displacements to t_count consecutive floats, multiplying and adding separately in every path so the
+ * result never depends on the instruction set */
+static void gltf_morph_add_dense(float* t_out, const float* t_deltas, float t_weight, size_t t_count)
+{
+	size_t i = 0;
+
+#if SIMD_X86_DISPATCH
+	if (simd_get_features() & SIMD_FEATURE_AVX2)
+	{
+		i = gltf_morph_add_dense_avx2(t_out, t_deltas, t_weight, t_count);
+	}
+#endif
+#if SIMD_SSE2
+	const __m128 weight = _mm_set1_ps(t_weight);
+	for (; i + 4 <= t_count; i += 4)
+	{
+		__m128 delta = _mm_mul_ps(_mm_loadu_ps(t_deltas + i), weight);
+		_mm_storeu_ps(t_out + i, _mm_add_ps(_mm_loadu_ps(t_out + i), delta));
+	}
+#endif
+
+	for (; i < t_count; ++i)
+	{
+		t_out[i] += t_deltas[i] * t_weight;
+	}
+}
+
+/* adds the weighted displacements of the vertices from t_begin up to t_end to an xyz stream starting at t_begin, the
+ * stream must have a float of padding after its last vertex */
+static void gltf_morph_add_sparse(float* t_out, const gltf_morph_deltas* t_deltas, float t_weight, unsigned int t_begin, unsigned int t_end)
+{
+	unsigned int low = 0, high = t_deltas->count;
+	while (low < high)
+	{
+		unsigned int middle = low + (high - low) / 2;
+		if (t_deltas->indices[middle] < t_begin)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	unsigned int i = low;
+
+#if SIMD_SSE2
+	/* a four wide add touches the next vertex's x, which is left intact by adding -0 */
+	const __m128 weight = _mm_set1_ps(t_weight);
+	const __m128 xyz_mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	const __m128 negative_zero = _mm_setr_ps(0.0f, 0.0f, 0.0f, -0.0f);
+	for (; i + 1 < t_deltas->count && t_deltas->indices[i] < t_end; ++i)
+	{
+		__m128 delta = _mm_loadu_ps(t_deltas->deltas + (size_t)i * 3);
+		delta = _mm_or_ps(_mm_and_ps(_mm_mul_ps(delta, weight), xyz_mask), negative_zero);
+		float* target = t_out + (size_t)(t_deltas->indices[i] - t_begin) * 3;
+		_mm_storeu_ps(target, _mm_add_ps(_mm_loadu_ps(target), delta));
+	}
+#endif
+
+	for (; i < t_deltas->count && t_deltas->indices[i] < t_end; ++i)
+	{
+		const float* delta = t_deltas->deltas + (size_t)i * 3;
+		float* target = t_out + (size_t)(t_deltas->indices[i] - t_begin) * 3;
+		target[0] += delta[0] * t_weight;
+		target[1] += delta[1] * t_weight;
+		target[2] += delta[2] * t_weight;
+	}
+}
+
+static void gltf_morph_add(float* t_out, const gltf_morph_deltas* t_deltas, float t_weight, unsigned int t_begin, unsigned int t_end)
+{
+	if (!t_deltas->count)
+	{
+		return;
+	}
+	if (t_deltas->indices)
+	{
+		gltf_morph_add_sparse(t_out, t_deltas, t_weight, t_begin, t_end);
+	}
+	else
+	{
+		gltf_morph_add_dense(t_out, t_deltas->deltas + (size_t)t_begin * 3, t_weight, (size_t)(t_end - t_begin) * 3);
+	}
+}
+
+/* accumulates a chunk in cache before writing it out once, as the output may be write combined memory */
+static void gltf_morph_apply_chunk(const gltf_morph_instance* t_instance, unsigned int t_begin, unsigned int t_end)
+{
+	float positions[GLTF_MORPH_CHUNK_SIZE * 3 + 1];
+	float normals[GLTF_MORPH_CHUNK_SIZE * 3 + 1];
+	const gltf_morph* morph = t_instance->morph;
+	size_t size = sizeof(float) * 3 * (t_end - t_begin);
+	unsigned int i;
+
+	memcpy(positions, morph->base_positions + (size_t)t_begin * 3, size);
+	if (t_instance->out_normals)
+	{
+		memcpy(normals, morph->base_normals + (size_t)t_begin * 3, size);
+	}
+	for (i = 0; i < morph->target_count; ++i)
+	{
+		const gltf_morph_target* target = morph->targets + i;
+		float weight = t_instance->weights[i];
+		if (weight == 0.0f)
+		{
+			continue;
+		}
+		gltf_morph_add(positions, &target->positions, weight, t_begin, t_end);
+		if (t_instance->out_normals)
+		{
+			gltf_morph_add(normals, &target->normals, weight, t_begin, t_end);
+		}
+	}
+
+	memcpy(t_instance->out_positions + (size_t)t_begin * 3, positions, size);
+	if (t_instance->out_normals)
+	{
+		memcpy(t_instance->out_normals + (size_t)t_begin * 3, normals, size);
+	}
+}
+
+static void gltf_morph_apply_range(void* t_context, size_t t_begin, size_t t_end)
+{
+	gltf_morph_apply_context* context = (gltf_morph_apply_context*)t_context;
+
+	/* the chunks of every instance are numbered consecutively, the instance owning the first is found by search */
+	unsigned int low = 0, high = context->instance_count;
+	while (low + 1 < high)
+	{
+		unsigned int middle = low + (high - low) / 2;
+		if (context->chunk_offsets[middle] <= t_begin)
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	size_t i = t_begin;
+	unsigned int instance = low;
+	for (; i < t_end; ++i)
+	{
+		while (context->chunk_offsets[instance + 1] <= i)
+		{
+			++instance;
+		}
+		const gltf_morph_instance* current = context->instances + instance;
+		unsigned int begin = (unsigned int)(i - context->chunk_offsets[instance]) * GLTF_MORPH_CHUNK_SIZE;
+		unsigned int end = current->morph->vertex_count - begin < GLTF_MORPH_CHUNK_SIZE ? current->morph->vertex_count : begin + GLTF_MORPH_CHUNK_SIZE;
+		gltf_morph_apply_chunk(current, begin, end);
+	}
+}
+
+int gltf_morph_apply(const gltf_morph_instance* t_instances, unsigned int t_instance_count, thread_pool* t_pool)
+{
+	assert(t_instances || !t_instance_count);
+
+	unsigned int* offsets = malloc(sizeof(unsigned int) * (t_instance_count + 1));
+	unsigned int i;
+	if (!offsets)
+	{
+		return 0;
+	}
+
+	offsets[0] = 0;
+	for (i = 0; i < t_instance_count; ++i)
+	{
+		const gltf_morph_instance* instance = t_instances + i;
+		assert(instance->morph && (instance->weights || !instance->morph->target_count) && instance->out_positions);
+		assert(!instance->out_normals || instance->morph->base_normals);
+		offsets[i + 1] = offsets[i] + (instance->morph->vertex_count + GLTF_MORPH_CHUNK_SIZE - 1) / GLTF_MORPH_CHUNK_SIZE;
+	}
+
+	gltf_morph_apply_context context;
+	context.instances = t_instances;
+	context.chunk_offsets = offsets;
+	context.instance_count = t_instance_count;
+	thread_pool_parallel_for(t_pool, offsets[t_instance_count], GLTF_MORPH_CHUNK_GRAIN, gltf_morph_apply_range, &context);
+
+	free(offsets);
+	return 1;
+}
+
+static void gltf_morph_deltas_final(gltf_morph_deltas* t_deltas)
+{
+	free(t_deltas->indices);
+	free(t_deltas->deltas);
+}
+
+void gltf_morph_final(gltf_morph* t_morph)
+{
+	if (t_morph)
+	{
+		unsigned int i = 0;
+		for (; t_morph->targets && i < t_morph->target_count; ++i)
+		{
+			gltf_morph_deltas_final(&t_morph->targets[i].positions);
+			gltf_morph_deltas_final(&t_morph->targets[i].normals);
+		}
+		free(t_morph->targets);
+		free(t_morph->base_positions);
+		free(t_morph->base_normals);
+		memset(t_morph, 0, sizeof(gltf_morph));
+	}
+}
@@ -0,0 +1,92 @@
+/**
+ * gltf_morph.h
+ */
+
+#ifndef GRAPHICS_UTILS_GLTF_MORPH_H
+#define GRAPHICS_UTILS_GLTF_MORPH_H
+
+#include "gltf_import.h"
+#include "thread_pool.h"
+
+/**	@struct		gltf_morph_deltas
+ *	@brief		the displacements of one attribute by a morph target, kept sparse where few vertices move
+ *	@member		gltf_morph_deltas::count - the number of displaced vertices
+ *	@member		gltf_morph_deltas::indices - count ascending vertex indices, or 0 if every vertex is displaced in order
+ *	@member		gltf_morph_deltas::deltas - count xyz displacements, or 0 if the target leaves the attribute alone
+ */
+typedef struct
+{
+	unsigned int count;
+	unsigned int* indices;
+	float* deltas;
+} gltf_morph_deltas;
+
+/**	@struct		gltf_morph_target
+ *	@brief		a morph target of a primitive
+ *	@member		gltf_morph_target::positions - the position displacements
+ *	@member		gltf_morph_target::normals - the normal displacements
+ */
+typedef struct
+{
+	gltf_morph_deltas positions;
+	gltf_morph_deltas normals;
+} gltf_morph_target;
+
+/**	@struct		gltf_morph
+ *	@brief		the base positions and normals of a primitive along with its morph targets
+ *	@member		gltf_morph::vertex_count - the number of vertices in the primitive
+ *	@member		gltf_morph::target_count - the number of targets
+ *	@member		gltf_morph::targets - the targets, in the order of the mesh's weights
+ *	@member		gltf_morph::base_positions - vertex_count xyz positions
+ *	@member		gltf_morph::base_normals - vertex_count xyz normals, or 0 if the primitive has no normals
+ */
+typedef struct
+{
+	unsigned int vertex_count;
+	unsigned int target_count;
+	gltf_morph_target* targets;
+	float* base_positions;
+	float* base_normals;
+} gltf_morph;
+
+/**	@struct		gltf_morph_instance
+ *	@brief		one evaluation of a morph, any number of which are evaluated together
+ *	@member		gltf_morph_instance::morph - the morph to evaluate
+ *	@member		gltf_morph_instance::weights - target_count weights, targets with a zero weight are skipped
+ *	@member		gltf_morph_instance::out_positions - vertex_count xyz positions to be written
+ *	@member		gltf_morph_instance::out_normals - vertex_count xyz normals to be written, or 0 to skip normals
+ */
+typedef struct
+{
+	const gltf_morph* morph;
+	const float* weights;
+	float* out_positions;
+	float* out_normals;
+} gltf_morph_instance;
+
+/** extracts the base attributes and morph targets of a primitive, converting quantized and sparse accessors to floats
+ *	@memberof	gltf_morph
+ *	@param		t_morph - an invalid morph to be initialized
+ *	@param		t_gltf - a loaded gltf
+ *	@param		t_primitive - the primitive, which must have float3 compatible positions
+ *	@param		t_pool - an optional thread pool to extract targets across
+ *	@returns	nonzero if extracted successfully, a primitive without targets extracts only its base attributes
+ */
+int gltf_morph_extract(gltf_morph* t_morph, gltf* t_gltf, const gltf_primitive* t_primitive, thread_pool* t_pool);
+
+/** writes the base attributes plus every weighted target of each instance, the output of every instance is written
+ *	once in order so it may be a mapped streaming vertex buffer, and does not depend upon the thread count
+ *	@memberof	gltf_morph
+ *	@param		t_instances - the instances to evaluate
+ *	@param		t_instance_count - the number of instances
+ *	@param		t_pool - an optional thread pool to process vertex ranges of every instance across
+ *	@returns	nonzero if evaluated, zero if out of memory
+ */
+int gltf_morph_apply(const gltf_morph_instance* t_instances, unsigned int t_instance_count, thread_pool* t_pool);
+
+/** finalizes an extracted morph
+ *	@memberof	gltf_morph
+ */
+void gltf_morph_final(gltf_morph* t_morph);
+
+#endif
@@ -1,9 +1,11 @@
 
 #include "graphics.h"
 
+#include "file_map.h"
 #include "lode_png.h"
 
 #include <assert.h>
+#include <math.h>
 #include <stdio.h>
 #include <GL/wglext.h>
 
@@ -261,6 +263,12 @@ int init_mesh
 	t_mesh->vertex_usage = t_vertex_usage;
 	t_mesh->index_buffer = *t_index_buffer;
 	t_mesh->index_usage = t_index_usage;
+	t_mesh->lod_count = 0;
+	t_mesh->lods = 0;
+	t_mesh->meshlet_count = 0;
+	t_mesh->meshlets = 0;
+	t_mesh->instance_id = 0;
+	t_mesh->instance_count = 0;
 	
 	size_t total_size = 0;
 	for (i = 0; i < t_vertex_attribute_count; ++i) {
@@ -282,7 +290,14 @@ int init_mesh
 		const vertex_attribute* attribute = &t_mesh->vertex_attributes[i];
 		glBufferSubData(GL_ARRAY_BUFFER, offset_size, attribute->buffer_size, attribute->buffer);
 		glEnableVertexAttribArray(i);
-		glVertexAttribPointer(i, attribute->size, attribute->type, 0, attribute->stride, (void*)(offset_size));
+		if (attribute->flags & VERTEX_ATTRIBUTE_INTEGER) {
+			
+			glVertexAttribIPointer(i, attribute->size, attribute->type, attribute->stride, (void*)(offset_size));
+		}
+		else {
+			
+			glVertexAttribPointer(i, attribute->size, attribute->type, (attribute->flags & VERTEX_ATTRIBUTE_NORMALIZED) != 0, attribute->stride, (void*)(offset_size));
+		}
 		offset_size += t_mesh->vertex_attributes[i].buffer_size;
 	}
 	
@@ -301,6 +316,10 @@ void final_mesh(mesh* t_mesh, int t_free_buffers) {
 	glDeleteVertexArrays(1, &t_mesh->id);
 	glDeleteBuffers(1, &t_mesh->vertex_id);
 	glDeleteBuffers(1, &t_mesh->index_id);
+	if (t_mesh->instance_id) {
+		
+		glDeleteBuffers(1, &t_mesh->instance_id);
+	}
 	
 	if (t_free_buffers) {
 		
@@ -313,6 +332,14 @@ void final_mesh(mesh* t_mesh, int t_free_buffers) {
 	}
 	
 	free(t_mesh->vertex_attributes);
+	free(t_mesh->lods);
+	free(t_mesh->meshlets);
+	t_mesh->lod_count = 0;
+	t_mesh->lods = 0;
+	t_mesh->meshlet_count = 0;
+	t_mesh->meshlets = 0;
+	t_mesh->instance_id = 0;
+	t_mesh->instance_count = 0;
 }
 
 void mesh_render(mesh* t_mesh) {
@@ -328,9 +355,253 @@ void mesh_render_part(mesh* t_mesh, unsigned int t_offset, unsigned int t_count)
 	
 	assert(t_mesh && (t_offset + t_count) <= index_buffer_get_element_count(&t_mesh->index_buffer));
 	
+	size_t index_size = t_mesh->index_buffer.type == GL_UNSIGNED_BYTE ? sizeof(char)
+		: (t_mesh->index_buffer.type == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int));
+	
+	glBindVertexArray(t_mesh->id);
+	glDrawElements(GL_TRIANGLES, t_count, t_mesh->index_buffer.type, (void*)(t_offset * index_size));
+	glBindVertexArray(0);
+}
+
+int mesh_set_instances(mesh* t_mesh, unsigned int t_instance_count, const float* t_transforms, unsigned int t_usage) {
+	
+	assert(t_mesh);
+	
+	if (!t_mesh->instance_id) {
+		
+		glGenBuffers(1, &t_mesh->instance_id);
+		if (!t_mesh->instance_id) {
+			
+			return 0;
+		}
+	}
+	t_mesh->instance_count = t_instance_count;
+	
 	glBindVertexArray(t_mesh->id);
-	glDrawElements(GL_TRIANGLES, t_count, t_mesh->index_buffer.type, (void*)t_offset);
+	glBindBuffer(GL_ARRAY_BUFFER, t_mesh->instance_id);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 12 * t_instance_count, t_transforms, t_usage);
+	
+	/* the rows advance once per instance rather than once per vertex */
+	unsigned int i;
+	for (i = 0; i < 3; ++i) {
+		
+		unsigned int location = t_mesh->vertex_attribute_count + i;
+		glEnableVertexAttribArray(location);
+		glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 12, (void*)(sizeof(float) * 4 * i));
+		glVertexAttribDivisor(location, 1);
+	}
+	
 	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return 1;
+}
+
+void mesh_render_instanced(mesh* t_mesh) {
+	
+	assert(t_mesh);
+	
+	glBindVertexArray(t_mesh->id);
+	glDrawElementsInstanced(GL_TRIANGLES, index_buffer_get_element_count(&t_mesh->index_buffer), t_mesh->index_buffer.type, 0, t_mesh->instance_count);
+	glBindVertexArray(0);
+}
+
+float* mesh_map_instances(mesh* t_mesh) {
+	
+	assert(t_mesh && t_mesh->instance_id);
+	
+	if (!t_mesh->instance_count) {
+		
+		return 0;
+	}
+	
+	glBindBuffer(GL_ARRAY_BUFFER, t_mesh->instance_id);
+	float* data = glMapBufferRange(GL_ARRAY_BUFFER, 0, sizeof(float) * 12 * t_mesh->instance_count, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return data;
+}
+
+int mesh_unmap_instances(mesh* t_mesh) {
+	
+	assert(t_mesh && t_mesh->instance_id);
+	
+	glBindBuffer(GL_ARRAY_BUFFER, t_mesh->instance_id);
+	int result = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return result;
+}
+
+void* mesh_map_vertex_attributes(mesh* t_mesh, unsigned int t_first, unsigned int t_count) {
+	
+	assert(t_mesh && t_count && t_first + t_count <= t_mesh->vertex_attribute_count);
+	
+	/* attributes are laid out one after another in the order they were given */
+	size_t offset = 0, size = 0;
+	unsigned int i;
+	for (i = 0; i < t_first; ++i) {
+		
+		offset += t_mesh->vertex_attributes[i].buffer_size;
+	}
+	for (; i < t_first + t_count; ++i) {
+		
+		size += t_mesh->vertex_attributes[i].buffer_size;
+	}
+	
+	glBindBuffer(GL_ARRAY_BUFFER, t_mesh->vertex_id);
+	void* data = glMapBufferRange(GL_ARRAY_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return data;
+}
+
+int mesh_unmap_vertex_attributes(mesh* t_mesh) {
+	
+	assert(t_mesh);
+	
+	glBindBuffer(GL_ARRAY_BUFFER, t_mesh->vertex_id);
+	int result = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return result;
+}
+
+int mesh_set_lods(mesh* t_mesh, unsigned int t_lod_count, const mesh_lod* t_lods) {
+	
+	assert(t_mesh && (t_lods || !t_lod_count));
+	
+	unsigned int i;
+	mesh_lod* lods = 0;
+	
+	if (t_lod_count) {
+		
+		lods = malloc(sizeof(mesh_lod) * t_lod_count);
+		if (!lods) {
+			
+			GRAPHICS_ERROR("failed to allocate mesh levels of detail");
+			return 0;
+		}
+		for (i = 0; i < t_lod_count; ++i) {
+			
+			assert(t_lods[i].index_offset + t_lods[i].index_count <= index_buffer_get_element_count(&t_mesh->index_buffer));
+			lods[i] = t_lods[i];
+		}
+	}
+	
+	free(t_mesh->lods);
+	t_mesh->lod_count = t_lod_count;
+	t_mesh->lods = lods;
+	
+	return 1;
+}
+
+unsigned int mesh_select_lod(mesh* t_mesh, float t_max_error) {
+	
+	assert(t_mesh);
+	
+	unsigned int lod = 0;
+	while (lod + 1 < t_mesh->lod_count && t_mesh->lods[lod + 1].error <= t_max_error) {
+		
+		++lod;
+	}
+	
+	return lod;
+}
+
+void mesh_render_lod(mesh* t_mesh, unsigned int t_lod) {
+	
+	assert(t_mesh && (!t_mesh->lod_count || t_lod < t_mesh->lod_count));
+	
+	if (!t_mesh->lod_count) {
+		
+		mesh_render(t_mesh);
+		return;
+	}
+	
+	mesh_render_part(t_mesh, t_mesh->lods[t_lod].index_offset, t_mesh->lods[t_lod].index_count);
+}
+
+int mesh_set_meshlets(mesh* t_mesh, unsigned int t_meshlet_count, const meshlet* t_meshlets) {
+	
+	assert(t_mesh && (t_meshlets || !t_meshlet_count));
+	
+	unsigned int i;
+	meshlet* meshlets = 0;
+	
+	if (t_meshlet_count) {
+		
+		meshlets = malloc(sizeof(meshlet) * t_meshlet_count);
+		if (!meshlets) {
+			
+			GRAPHICS_ERROR("failed to allocate mesh clusters");
+			return 0;
+		}
+		for (i = 0; i < t_meshlet_count; ++i) {
+			
+			assert(t_meshlets[i].index_offset + t_meshlets[i].index_count <= index_buffer_get_element_count(&t_mesh->index_buffer));
+			meshlets[i] = t_meshlets[i];
+		}
+	}
+	
+	free(t_mesh->meshlets);
+	t_mesh->meshlet_count = t_meshlet_count;
+	t_mesh->meshlets = meshlets;
+	
+	return 1;
+}
+
+int meshlet_is_visible(const meshlet* t_meshlet, const float* t_camera_position, unsigned int t_plane_count, const float* t_planes) {
+	
+	assert(t_meshlet && t_camera_position && (t_planes || !t_plane_count));
+	
+	unsigned int i;
+	const float* center = t_meshlet->center;
+	
+	for (i = 0; i < t_plane_count; ++i) {
+		
+		const float* plane = t_planes + i * 4;
+		if (plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3] < -t_meshlet->radius) {
+			
+			return 0;
+		}
+	}
+	
+	/* the cluster is back facing if the view direction lies within the normal cone widened by the sphere */
+	float view[3] = { center[0] - t_camera_position[0], center[1] - t_camera_position[1], center[2] - t_camera_position[2] };
+	float distance = sqrtf(view[0] * view[0] + view[1] * view[1] + view[2] * view[2]);
+	float facing = view[0] * t_meshlet->cone_axis[0] + view[1] * t_meshlet->cone_axis[1] + view[2] * t_meshlet->cone_axis[2];
+	
+	return facing < t_meshlet->cone_cutoff * distance + t_meshlet->radius;
+}
+
+unsigned int mesh_render_meshlets(mesh* t_mesh, const float* t_camera_position, unsigned int t_plane_count, const float* t_planes) {
+	
+	assert(t_mesh && t_camera_position && (t_planes || !t_plane_count));
+	
+	unsigned int i, drawn = 0, offset = 0, count = 0;
+	
+	for (i = 0; i < t_mesh->meshlet_count; ++i) {
+		
+		const meshlet* cluster = t_mesh->meshlets + i;
+		if (!meshlet_is_visible(cluster, t_camera_position, t_plane_count, t_planes)) {
+			
+			continue;
+		}
+		++drawn;
+		if (count && offset + count == cluster->index_offset) {
+			
+			count += cluster->index_count;
+			continue;
+		}
+		if (count) {
+			
+			mesh_render_part(t_mesh, offset, count);
+		}
+		offset = cluster->index_offset;
+		count = cluster->index_count;
+	}
+	if (count) {
+		
+		mesh_render_part(t_mesh, offset, count);
+	}
+	
+	return drawn;
 }
 
 int init_texture_impl
@@ -394,6 +665,84 @@ int load_texture(texture* t_texture, const char* t_filepath) {
 	return init_texture_impl(t_texture, t_texture->filepath, t_texture->buffer, t_texture->width, t_texture->height, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE);
 }
 
+int load_texture_memory(texture* t_texture, const unsigned char* t_data, size_t t_size) {
+	
+	assert(t_texture && t_data);
+	
+	unsigned char* pixels;
+	unsigned int width, height;
+	unsigned int error = lodepng_decode_memory(&pixels, &width, &height, t_data, t_size, LCT_RGBA, 8);
+	if (error) {
+		
+		GRAPHICS_ERROR("failed to load texture: %s", lodepng_error_text(error));
+		
+		return 0;
+	}
+	
+	return init_texture_impl(t_texture, 0, pixels, width, height, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE);
+}
+
+int load_texture_streamed(texture* t_texture, const char* t_filepath) {
+	
+	assert(t_texture && t_filepath);
+	
+	file_map map;
+	if (!init_file_map(&map, t_filepath)) {
+		
+		GRAPHICS_ERROR("failed to map texture file: %s", t_filepath);
+		
+		return 0;
+	}
+	
+	LodePNGState state;
+	lodepng_state_init(&state);
+	unsigned int width = 0, height = 0, pixel_buffer = 0;
+	int mapped = 0, unmapped = 0;
+	unsigned int error = lodepng_inspect(&width, &height, &state, map.data, map.size);
+	if (!error) {
+		
+		/* the rows are decoded straight into the mapped unpack buffer, the image is never held in client memory */
+		size_t pitch = (size_t)width * 4, size = pitch * height;
+		glGenBuffers(1, &pixel_buffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, 0, GL_STREAM_DRAW);
+		unsigned char* pixels = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (pixels) {
+			
+			mapped = 1;
+			error = lodepng_decode_into(pixels, size, pitch, &width, &height, &state, map.data, map.size);
+			unmapped = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+		}
+	}
+	lodepng_state_cleanup(&state);
+	final_file_map(&map);
+	
+	if (error || !mapped || !unmapped) {
+		
+		if (error) {
+			
+			GRAPHICS_ERROR("failed to load texture: %s", lodepng_error_text(error));
+		} else if (!mapped) {
+			
+			GRAPHICS_ERROR("failed to map texture pixel buffer");
+		} else {
+			
+			GRAPHICS_ERROR("texture pixel buffer was lost while decoding");
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &pixel_buffer);
+		
+		return 0;
+	}
+	
+	/* with an unpack buffer bound, the data pointer is an offset into it */
+	init_texture_impl(t_texture, 0, 0, width, height, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glDeleteBuffers(1, &pixel_buffer);
+	
+	return 1;
+}
+
 void final_texture(texture* t_texture) {
 	
 	assert(t_texture);
@@ -447,3 +796,33 @@ int texture_save(texture* t_texture, const char* t_filepath) {
 	return 1;
 }
 
+int texture_save_parallel(texture* t_texture, const char* t_filepath, thread_pool* t_pool) {
+	
+	assert(t_texture && t_pool);
+	
+	unsigned char* png = 0;
+	size_t png_size = 0;
+	LodePNGState state;
+	lodepng_state_init(&state);
+	
+	/* large textures such as screenshots spend most of their time in deflate, so it is spread across the pool */
+	state.encoder.zlibsettings.numthreads = t_pool->thread_count + 1;
+	state.encoder.zlibsettings.pool = t_pool;
+	
+	unsigned int error = lodepng_encode(&png, &png_size, (unsigned char*)t_texture->buffer, t_texture->width, t_texture->height, &state);
+	if (!error) {
+		
+		error = lodepng_save_file(png, png_size, t_filepath);
+	}
+	lodepng_state_cleanup(&state);
+	free(png);
+	if (error) {
+		
+		GRAPHICS_ERROR("failed to save texture: %s", lodepng_error_text(error));
+		
+		return 0;
+	}
+	
+	return 1;
+}
+
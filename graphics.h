@@ -7,6 +7,7 @@
 
 #include <data_structures.h>
 #include "fbx_import.h"
+#include "thread_pool.h"
 
 /** @struct		graphics
  *	@brief		a struct containign graphical context information
@@ -133,6 +134,11 @@ int init_program(program* t_program, unsigned int t_shader_count, shader** t_sha
  */
 void final_program(program* t_program);
 
+/* integer components are mapped to [0, 1] or [-1, 1] floats rather than converted directly */
+#define VERTEX_ATTRIBUTE_NORMALIZED 0x1
+/* integer components reach the shader as integers, through glVertexAttribIPointer */
+#define VERTEX_ATTRIBUTE_INTEGER 0x2
+
 /**	@struct		vertex_attribute
  *	@brief		a struct containign vertex attribute data
  *	@member		vertex_attribute::buffer - the base address of the vertex data
@@ -140,6 +146,7 @@ void final_program(program* t_program);
  *	@member		vertex_attribute::size - the size of a single element in components
  *	@member		vertex_attribute::type - the type of components in an element
  *	@member		vertex_attribute::stride - the stride of a single element
+ *	@member		vertex_attribute::flags - VERTEX_ATTRIBUTE flags describing how integer components reach the shader
  */
 typedef struct {
 	
@@ -148,6 +155,7 @@ typedef struct {
 	unsigned int size;
 	unsigned int type;
 	unsigned int stride;
+	unsigned int flags;
 } vertex_attribute;
 
 /**	@struct		index_buffer
@@ -170,6 +178,40 @@ typedef struct {
  */
 unsigned int index_buffer_get_element_count(index_buffer* t_buffer);
 
+/**	@struct		mesh_lod
+ *	@brief		a struct describing one level of detail as a range of a mesh's index buffer
+ *	@member		mesh_lod::index_offset - the offset of the first index of the level
+ *	@member		mesh_lod::index_count - the count of indices in the level
+ *	@member		mesh_lod::error - the simplification error of the level relative to the mesh extent
+ */
+typedef struct {
+	
+	unsigned int index_offset;
+	unsigned int index_count;
+	float error;
+} mesh_lod;
+
+/**	@struct		meshlet
+ *	@brief		a struct describing a small cluster of triangles as a range of a mesh's index buffer
+ *	@member		meshlet::index_offset - the offset of the first index of the cluster
+ *	@member		meshlet::index_count - the count of indices in the cluster
+ *	@member		meshlet::vertex_count - the count of unique vertices referenced by the cluster
+ *	@member		meshlet::center - the center of the cluster's bounding sphere
+ *	@member		meshlet::radius - the radius of the cluster's bounding sphere
+ *	@member		meshlet::cone_axis - the average facing of the cluster's triangles
+ *	@member		meshlet::cone_cutoff - the sine of the normal cone's half angle, 1 if the cluster cannot be cone culled
+ */
+typedef struct {
+	
+	unsigned int index_offset;
+	unsigned int index_count;
+	unsigned int vertex_count;
+	float center[3];
+	float radius;
+	float cone_axis[3];
+	float cone_cutoff;
+} meshlet;
+
 /**	@struct		mesh
  *	@brief		a struct for containing a renderable mesh
  *	@member		mesh::id - the internal id of the mesh
@@ -180,6 +222,12 @@ unsigned int index_buffer_get_element_count(index_buffer* t_buffer);
  *	@member		mesh::vertex_attribute_count - the number of vertex attributes in the mesh
  *	@member		mesh::vertex_attributes - an array of the vertex attributes in the mesh
  *	@member		mesh::index_buffer - the index buffer data in the mesh
+ *	@member		mesh::lod_count - the number of levels of detail in lods
+ *	@member		mesh::lods - an array of levels of detail from finest to coarsest, or 0
+ *	@member		mesh::meshlet_count - the number of clusters in meshlets
+ *	@member		mesh::meshlets - an array of clusters ranging within the index buffer, or 0
+ *	@member		mesh::instance_id - the internal id of the per instance transform buffer, or 0
+ *	@member		mesh::instance_count - the number of instances drawn by mesh_render_instanced
  */
 typedef struct {
 	
@@ -191,6 +239,12 @@ typedef struct {
 	unsigned int vertex_attribute_count;
 	vertex_attribute* vertex_attributes;
 	index_buffer index_buffer;
+	unsigned int lod_count;
+	mesh_lod* lods;
+	unsigned int meshlet_count;
+	meshlet* meshlets;
+	unsigned int instance_id;
+	unsigned int instance_count;
 } mesh;
 
 /**	initializes a renderable mesh
@@ -231,6 +285,108 @@ void mesh_render(mesh* t_mesh);
  */
 void mesh_render_part(mesh* t_mesh, unsigned int t_offset, unsigned int t_count);
 
+/** sets the per instance transforms of a renderable mesh, each instance is the three rows of an affine matrix read as
+ *	vec4s by the three attribute locations following the mesh's vertex attributes
+ *	@memberof	mesh
+ *	@param		t_mesh - the mesh to set the instances of
+ *	@param		t_instance_count - the number of instances
+ *	@param		t_transforms - twelve floats per instance, or 0 to leave them to be written through mesh_map_instances
+ *	@param		t_usage - the usage of the transform buffer
+ *	@returns	nonzero if the instances were set
+ */
+int mesh_set_instances(mesh* t_mesh, unsigned int t_instance_count, const float* t_transforms, unsigned int t_usage);
+
+/** draws every instance of a renderable mesh in a single draw
+ *	@memberof	mesh
+ *	@param		t_mesh - the mesh to render
+ */
+void mesh_render_instanced(mesh* t_mesh);
+
+/** maps the per instance transforms of a renderable mesh for rewriting, their previous contents are discarded so
+ *	transforms set with a GL_STREAM_DRAW usage can be refilled every frame without waiting on draws still reading them
+ *	@memberof	mesh
+ *	@param		t_mesh - the mesh to map the instances of, after mesh_set_instances
+ *	@returns	the write only twelve floats per instance, or 0 if the buffer could not be mapped
+ */
+float* mesh_map_instances(mesh* t_mesh);
+
+/** unmaps the instances mapped by mesh_map_instances
+ *	@memberof	mesh
+ *	@param		t_mesh - the mesh to unmap
+ *	@returns	nonzero if the written contents are intact, zero if they were lost and must be written again
+ */
+int mesh_unmap_instances(mesh* t_mesh);
+
+/** maps a range of vertex attributes of a renderable mesh for rewriting, their previous contents are discarded so a
+ *	mesh with a GL_STREAM_DRAW vertex buffer can be refilled every frame without waiting on draws still reading it
+ *	@memberof	mesh
+ *	@param		t_mesh - the mesh to map vertex attributes of
+ *	@param		t_first - the index of the first vertex attribute
+ *	@param		t_count - the number of vertex attributes, each follows the last's buffer_size bytes
+ *	@returns	the write only bytes of the attributes, or 0 if the buffer could not be mapped
+ */
+void* mesh_map_vertex_attributes(mesh* t_mesh, unsigned int t_first, unsigned int t_count);
+
+/** unmaps the vertex attributes mapped by mesh_map_vertex_attributes
+ *	@memberof	mesh
+ *	@param		t_mesh - the mesh to unmap
+ *	@returns	nonzero if the written contents are intact, zero if they were lost and must be written again
+ */
+int mesh_unmap_vertex_attributes(mesh* t_mesh);
+
+/** sets the levels of detail of a renderable mesh
+ *	@memberof	mesh
+ *	@param		t_mesh - the mesh to set the levels of detail of
+ *	@param		t_lod_count - the number of levels of detail pointed to by t_lods
+ *	@param		t_lods - an array of levels of detail from finest to coarsest, ranging within the index buffer
+ *	@returns	nonzero if the levels of detail were set
+ */
+int mesh_set_lods(mesh* t_mesh, unsigned int t_lod_count, const mesh_lod* t_lods);
+
+/** selects the coarsest level of detail whose error is within a threshold
+ *	@memberof	mesh
+ *	@param		t_mesh - the mesh to select a level of detail of
+ *	@param		t_max_error - the largest acceptable error relative to the mesh extent
+ *	@returns	the index of the selected level of detail, 0 if the mesh has none
+ */
+unsigned int mesh_select_lod(mesh* t_mesh, float t_max_error);
+
+/** draws a level of detail of a renderable mesh, or the whole mesh if it has no levels of detail
+ *	@memberof	mesh
+ *	@param		t_mesh - the mesh to render
+ *	@param		t_lod - the index of the level of detail to render
+ */
+void mesh_render_lod(mesh* t_mesh, unsigned int t_lod);
+
+/** sets the clusters of a renderable mesh
+ *	@memberof	mesh
+ *	@param		t_mesh - the mesh to set the clusters of
+ *	@param		t_meshlet_count - the number of clusters pointed to by t_meshlets
+ *	@param		t_meshlets - an array of clusters ranging within the index buffer
+ *	@returns	nonzero if the clusters were set
+ */
+int mesh_set_meshlets(mesh* t_mesh, unsigned int t_meshlet_count, const meshlet* t_meshlets);
+
+/** tests a cluster against a camera, both in the mesh's space
+ *	@memberof	meshlet
+ *	@param		t_meshlet - the cluster to test
+ *	@param		t_camera_position - the xyz position of the camera
+ *	@param		t_plane_count - the number of planes pointed to by t_planes
+ *	@param		t_planes - an array of abcd planes whose positive sides bound the visible space, or 0
+ *	@returns	nonzero if the cluster is within every plane and faces the camera
+ */
+int meshlet_is_visible(const meshlet* t_meshlet, const float* t_camera_position, unsigned int t_plane_count, const float* t_planes);
+
+/** draws the visible clusters of a renderable mesh, adjacent visible clusters are drawn together
+ *	@memberof	mesh
+ *	@param		t_mesh - the mesh to render
+ *	@param		t_camera_position - the xyz position of the camera in the mesh's space
+ *	@param		t_plane_count - the number of planes pointed to by t_planes
+ *	@param		t_planes - an array of abcd planes in the mesh's space whose positive sides bound the visible space, or 0
+ *	@returns	the number of clusters drawn
+ */
+unsigned int mesh_render_meshlets(mesh* t_mesh, const float* t_camera_position, unsigned int t_plane_count, const float* t_planes);
+
 /**
  *
  */
@@ -266,6 +422,24 @@ int init_texture
  */
 int load_texture(texture* t_texture, const char* t_filepath);
 
+/** decodes a PNG image held in memory to RGBA8 and uploads it, without going through a file
+ *	@memberof	texture
+ *	@param		t_texture - an invalid texture to be initialized
+ *	@param		t_data - the encoded image
+ *	@param		t_size - the size of the encoded image
+ *	@returns	nonzero if decoded and initialized
+ */
+int load_texture_memory(texture* t_texture, const unsigned char* t_data, size_t t_size);
+
+/** decodes a PNG file to RGBA8 row by row into a mapped pixel unpack buffer and uploads it from there, so that
+ *	neither the file nor the decoded image is copied into client memory, for very large images such as heightmaps
+ *	@memberof	texture
+ *	@param		t_texture - an invalid texture to be initialized
+ *	@param		t_filepath - the path of the PNG file
+ *	@returns	nonzero if decoded and initialized, the texture keeps no copy of the pixels
+ */
+int load_texture_streamed(texture* t_texture, const char* t_filepath);
+
 /**
  */
 void final_texture(texture* t_texture);
@@ -287,4 +461,13 @@ void texture_bind(texture* t_texture, unsigned int t_index);
  */
 int texture_save(texture* t_texture, const char* t_filepath);
 
+/** saves a texture as png as texture_save does, compressing it in chunks across a thread pool and the calling thread
+ *	@memberof	texture
+ *	@param		t_texture - the texture to save
+ *	@param		t_filepath - the path of the png file to write
+ *	@param		t_pool - the thread pool to compress across
+ *	@returns	nonzero if the texture was saved
+ */
+int texture_save_parallel(texture* t_texture, const char* t_filepath, thread_pool* t_pool);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "image_queue.h"
+
+#include "lode_png.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void image_queue_decode(void* t_context) {
+
+	image_queue_image* image = (image_queue_image*)t_context;
+	const unsigned char* data = image->data;
+	unsigned char* file = 0;
+	size_t size = image->size;
+	if (image->filepath) {
+
+		image->error = lodepng_load_file(&file, &size, image->filepath);
+		data = file;
+	}
+	if (!image->error) {
+
+		/* a large image is decoded as a pipeline across the pool, so idle workers shorten its latency */
+		LodePNGState state;
+		lodepng_state_init(&state);
+		state.decoder.pool = image->pool;
+		image->error = lodepng_decode(&image->pixels, &image->width, &image->height, &state, data, size);
+		lodepng_state_cleanup(&state);
+	}
+	free(file);
+}
+
+static int image_queue_push(image_queue* t_queue, image_queue_image* t_image, unsigned int* t_out_image) {
+
+	if (t_queue->image_count == t_queue->image_capacity) {
+
+		unsigned int capacity = t_queue->image_capacity ? t_queue->image_capacity * 2 : 16;
+		image_queue_image** images = realloc(t_queue->images, sizeof(image_queue_image*) * capacity);
+		if (!images) {
+
+			free(t_image->filepath);
+			free(t_image);
+			return 0;
+		}
+		t_queue->images = images;
+		t_queue->image_capacity = capacity;
+	}
+	if (t_out_image) {
+
+		*t_out_image = t_queue->image_count;
+	}
+	t_queue->images[t_queue->image_count++] = t_image;
+	t_image->pool = t_queue->pool;
+
+	if (!thread_pool_push(t_queue->pool, &t_image->group, image_queue_decode, t_image)) {
+
+		image_queue_decode(t_image);
+	}
+
+	return 1;
+}
+
+int init_image_queue(image_queue* t_queue, thread_pool* t_pool) {
+
+	assert(t_queue);
+
+	t_queue->pool = t_pool;
+	t_queue->image_count = 0;
+	t_queue->image_capacity = 0;
+	t_queue->images = 0;
+
+	return 1;
+}
+
+int image_queue_push_memory(image_queue* t_queue, const unsigned char* t_data, size_t t_size, unsigned int* t_out_image) {
+
+	assert(t_queue && t_data);
+
+	image_queue_image* image = calloc(1, sizeof(image_queue_image));
+	if (!image) {
+
+		return 0;
+	}
+	image->data = t_data;
+	image->size = t_size;
+
+	return image_queue_push(t_queue, image, t_out_image);
+}
+
+int image_queue_push_file(image_queue* t_queue, const char* t_filepath, unsigned int* t_out_image) {
+
+	assert(t_queue && t_filepath);
+
+	image_queue_image* image = calloc(1, sizeof(image_queue_image));
+	size_t length = strlen(t_filepath);
+	if (!image || !(image->filepath = malloc(length + 1))) {
+
+		free(image);
+		return 0;
+	}
+	memcpy(image->filepath, t_filepath, length + 1);
+
+	return image_queue_push(t_queue, image, t_out_image);
+}
+
+int image_queue_is_done(image_queue* t_queue, unsigned int t_image) {
+
+	assert(t_queue && t_image < t_queue->image_count);
+
+	return thread_pool_is_done(t_queue->pool, &t_queue->images[t_image]->group);
+}
+
+int image_queue_wait(image_queue* t_queue, unsigned int t_image) {
+
+	assert(t_queue && t_image < t_queue->image_count);
+
+	image_queue_image* image = t_queue->images[t_image];
+	thread_pool_wait(t_queue->pool, &image->group);
+
+	return !image->error;
+}
+
+int image_queue_init_texture(image_queue* t_queue, unsigned int t_image, texture* t_out_texture) {
+
+	assert(t_queue && t_image < t_queue->image_count && t_out_texture);
+
+	image_queue_image* image = t_queue->images[t_image];
+	if (!image_queue_wait(t_queue, t_image) || !image->pixels) {
+
+		return 0;
+	}
+
+	/* the texture frees its buffer and path when finalized, so both are handed over rather than copied */
+	if (!init_texture(t_out_texture, image->pixels, image->width, image->height, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE)) {
+
+		return 0;
+	}
+	t_out_texture->filepath = image->filepath;
+	image->pixels = 0;
+	image->filepath = 0;
+
+	return 1;
+}
+
+void final_image_queue(image_queue* t_queue) {
+
+	assert(t_queue);
+
+	unsigned int i;
+	for (i = 0; i < t_queue->image_count; ++i) {
+
+		thread_pool_wait(t_queue->pool, &t_queue->images[i]->group);
+		free(t_queue->images[i]->pixels);
+		free(t_queue->images[i]->filepath);
+		free(t_queue->images[i]);
+	}
+	free(t_queue->images);
+	t_queue->image_count = 0;
+	t_queue->image_capacity = 0;
+	t_queue->images = 0;
+}
@@ -0,0 +1,104 @@
+/**
+ * image_queue.h
+ */
+
+#ifndef GRAPHICS_UTILS_IMAGE_QUEUE_H
+#define GRAPHICS_UTILS_IMAGE_QUEUE_H
+
+#include "graphics.h"
+#include "thread_pool.h"
+
+/**	@struct		image_queue_image
+ *	@brief		a PNG image queued for decoding to RGBA8
+ *	@member		image_queue_image::data - the encoded image, which must stay valid until decoded, or 0 if read from a file
+ *	@member		image_queue_image::size - the size of the encoded image
+ *	@member		image_queue_image::filepath - the file the image is read from, or 0
+ *	@member		image_queue_image::pixels - the decoded pixels, or 0 once taken by a texture
+ *	@member		image_queue_image::width - the width in pixels
+ *	@member		image_queue_image::height - the height in pixels
+ *	@member		image_queue_image::error - the lodepng error, or 0 if decoded successfully
+ *	@member		image_queue_image::group - the group the decoding job is counted against
+ *	@member		image_queue_image::pool - the pool of the queue, which the stages of a large image are spread across
+ */
+typedef struct {
+
+	const unsigned char* data;
+	size_t size;
+	char* filepath;
+	unsigned char* pixels;
+	unsigned int width;
+	unsigned int height;
+	unsigned int error;
+	thread_pool_group group;
+	thread_pool* pool;
+} image_queue_image;
+
+/**	@struct		image_queue
+ *	@brief		decodes images across a thread pool as they are pushed, leaving their upload to the graphics thread
+ *	@member		image_queue::pool - the pool images are decoded across, or 0 to decode them as they are pushed
+ *	@member		image_queue::image_count - the number of images pushed
+ *	@member		image_queue::image_capacity - the number of images there is room for
+ *	@member		image_queue::images - the images, allocated individually so they stay in place while being decoded
+ */
+typedef struct {
+
+	thread_pool* pool;
+	unsigned int image_count;
+	unsigned int image_capacity;
+	image_queue_image** images;
+} image_queue;
+
+/** initializes an empty image queue
+ *	@memberof	image_queue
+ *	@param		t_queue - an invalid image queue to be initialized
+ *	@param		t_pool - an optional thread pool to decode images across
+ *	@returns	nonzero if initialized successfully
+ */
+int init_image_queue(image_queue* t_queue, thread_pool* t_pool);
+
+/** queues an encoded image held in memory
+ *	@memberof	image_queue
+ *	@param		t_queue - a valid image queue
+ *	@param		t_data - the encoded image, which must stay valid until the image is waited upon
+ *	@param		t_size - the size of the encoded image
+ *	@param		t_out_image - optionally receives the index of the image
+ *	@returns	nonzero if queued
+ */
+int image_queue_push_memory(image_queue* t_queue, const unsigned char* t_data, size_t t_size, unsigned int* t_out_image);
+
+/** queues an image file
+ *	@memberof	image_queue
+ *	@param		t_queue - a valid image queue
+ *	@param		t_filepath - the path of the file, which is copied
+ *	@param		t_out_image - optionally receives the index of the image
+ *	@returns	nonzero if queued
+ */
+int image_queue_push_file(image_queue* t_queue, const char* t_filepath, unsigned int* t_out_image);
+
+/** returns nonzero if an image has finished decoding, without blocking
+ *	@memberof	image_queue
+ */
+int image_queue_is_done(image_queue* t_queue, unsigned int t_image);
+
+/** waits for an image to be decoded, decoding queued images on the calling thread meanwhile
+ *	@memberof	image_queue
+ *	@returns	nonzero if the image decoded successfully
+ */
+int image_queue_wait(image_queue* t_queue, unsigned int t_image);
+
+/** waits for an image and uploads it to a texture, which takes ownership of its pixels and path,
+ *	this must be called from the thread owning the GL context
+ *	@memberof	image_queue
+ *	@param		t_queue - a valid image queue
+ *	@param		t_image - the index of an image not already taken
+ *	@param		t_out_texture - an invalid texture to be initialized
+ *	@returns	nonzero if the image decoded and the texture was initialized
+ */
+int image_queue_init_texture(image_queue* t_queue, unsigned int t_image, texture* t_out_texture);
+
+/** finalizes an image queue, waiting for every image and freeing those not taken
+ *	@memberof	image_queue
+ */
+void final_image_queue(image_queue* t_queue);
+
+#endif
@@ -0,0 +1,765 @@
+#include "json.h"
+
+#include "assert.h"
+#include "math.h"
+#include "stddef.h"
+#include "stdlib.h"
+#include "string.h"
+
+#include "simd.h"
+
+#if defined(_MSC_VER)
+#include "intrin.h"
+#endif
+
+#define JSON_BLOCK_SIZE 64
+#define JSON_EVEN_BITS 0x5555555555555555ull
+#define JSON_INDEX_CAPACITY 4096
+#define JSON_INDEX_LOOKAHEAD 4
+#define JSON_MAX_LENGTH 0x1FFFFFFFu
+
+/* the character classes of a block of source, one bit per byte */
+typedef struct
+{
+	unsigned long long quote;
+	unsigned long long backslash;
+	unsigned long long operators;
+	unsigned long long whitespace;
+	unsigned long long control;
+} json_block;
+
+/* stage one, the source is classified a block at a time into a window of structural offsets that stage two
+ * consumes as it goes, so the offsets never exist for the whole document at once */
+typedef struct
+{
+	const char* source;
+	size_t length;
+	size_t offset;
+	void (*classify)(const unsigned char*, json_block*);
+	unsigned long long is_escaped;
+	unsigned long long in_string;
+	unsigned long long in_scalar;
+	unsigned long long error;
+	unsigned int index_count;
+	unsigned int indices[JSON_INDEX_CAPACITY];
+} json_scanner;
+
+/* the innermost open container and its element count are kept out of the tokens while it is open, the stack holds
+ * the same pair for each enclosing container */
+typedef struct
+{
+	json* document;
+	unsigned int token_capacity;
+	unsigned int container;
+	unsigned int count;
+	unsigned int depth;
+	unsigned int stack_capacity;
+	unsigned int* stack;
+} json_parser;
+
+static unsigned int json_trailing_zeros(unsigned long long t_bits)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, t_bits);
+	return (unsigned int)index;
+#else
+	return (unsigned int)__builtin_ctzll(t_bits);
+#endif
+}
+
+static void json_classify_block(const unsigned char* t_source, json_block* t_out)
+{
+	unsigned int i;
+	memset(t_out, 0, sizeof(json_block));
+	for (i = 0; i < JSON_BLOCK_SIZE; ++i)
+	{
+		unsigned char c = t_source[i];
+		unsigned long long bit = 1ull << i;
+		t_out->quote |= c == '"' ? bit : 0;
+		t_out->backslash |= c == '\\' ? bit : 0;
+		t_out->operators |= c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',' ? bit : 0;
+		t_out->whitespace |= c == ' ' || c == '\t' || c == '\n' || c == '\r' ? bit : 0;
+		t_out->control |= c < 0x20 ? bit : 0;
+	}
+}
+
+#if SIMD_SSE2
+/* braces and brackets differ from each other only in bit 5, so each pair is found with one comparison */
+static unsigned long long json_classify_sse2(__m128i t_a, __m128i t_b, __m128i t_c, __m128i t_d, __m128i t_value)
+{
+	return (unsigned long long)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(t_a, t_value))
+		| ((unsigned long long)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(t_b, t_value)) << 16)
+		| ((unsigned long long)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(t_c, t_value)) << 32)
+		| ((unsigned long long)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(t_d, t_value)) << 48);
+}
+
+static void json_classify_block_sse2(const unsigned char* t_source, json_block* t_out)
+{
+	const __m128i case_bit = _mm_set1_epi8(0x20);
+	const __m128i control = _mm_set1_epi8(0x1F);
+	__m128i a = _mm_loadu_si128((const __m128i*)t_source);
+	__m128i b = _mm_loadu_si128((const __m128i*)(t_source + 16));
+	__m128i c = _mm_loadu_si128((const __m128i*)(t_source + 32));
+	__m128i d = _mm_loadu_si128((const __m128i*)(t_source + 48));
+	__m128i lower_a = _mm_or_si128(a, case_bit), lower_b = _mm_or_si128(b, case_bit);
+	__m128i lower_c = _mm_or_si128(c, case_bit), lower_d = _mm_or_si128(d, case_bit);
+
+	t_out->quote = json_classify_sse2(a, b, c, d, _mm_set1_epi8('"'));
+	t_out->backslash = json_classify_sse2(a, b, c, d, _mm_set1_epi8('\\'));
+	t_out->operators = json_classify_sse2(lower_a, lower_b, lower_c, lower_d, _mm_set1_epi8('{'))
+		| json_classify_sse2(lower_a, lower_b, lower_c, lower_d, _mm_set1_epi8('}'))
+		| json_classify_sse2(a, b, c, d, _mm_set1_epi8(':'))
+		| json_classify_sse2(a, b, c, d, _mm_set1_epi8(','));
+	t_out->whitespace = json_classify_sse2(a, b, c, d, _mm_set1_epi8(' '))
+		| json_classify_sse2(a, b, c, d, _mm_set1_epi8('\t'))
+		| json_classify_sse2(a, b, c, d, _mm_set1_epi8('\n'))
+		| json_classify_sse2(a, b, c, d, _mm_set1_epi8('\r'));
+	t_out->control = json_classify_sse2(_mm_max_epu8(a, control), _mm_max_epu8(b, control),
+		_mm_max_epu8(c, control), _mm_max_epu8(d, control), control);
+}
+#endif
+
+#if SIMD_X86_DISPATCH
+SIMD_TARGET("avx2") static unsigned long long json_classify_avx2(__m256i t_low, __m256i t_high, __m256i t_value)
+{
+	return (unsigned long long)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(t_low, t_value))
+		| ((unsigned long long)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(t_high, t_value)) << 32);
+}
+
+SIMD_TARGET("avx2") static void json_classify_block_avx2(const unsigned char* t_source, json_block* t_out)
+{
+	const __m256i case_bit = _mm256_set1_epi8(0x20);
+	const __m256i control = _mm256_set1_epi8(0x1F);
+	__m256i low = _mm256_loadu_si256((const __m256i*)t_source);
+	__m256i high = _mm256_loadu_si256((const __m256i*)(t_source + 32));
+	__m256i lower_low = _mm256_or_si256(low, case_bit), lower_high = _mm256_or_si256(high, case_bit);
+
+	t_out->quote = json_classify_avx2(low, high, _mm256_set1_epi8('"'));
+	t_out->backslash = json_classify_avx2(low, high, _mm256_set1_epi8('\\'));
+	t_out->operators = json_classify_avx2(lower_low, lower_high, _mm256_set1_epi8('{'))
+		| json_classify_avx2(lower_low, lower_high, _mm256_set1_epi8('}'))
+		| json_classify_avx2(low, high, _mm256_set1_epi8(':'))
+		| json_classify_avx2(low, high, _mm256_set1_epi8(','));
+	t_out->whitespace = json_classify_avx2(low, high, _mm256_set1_epi8(' '))
+		| json_classify_avx2(low, high, _mm256_set1_epi8('\t'))
+		| json_classify_avx2(low, high, _mm256_set1_epi8('\n'))
+		| json_classify_avx2(low, high, _mm256_set1_epi8('\r'));
+	t_out->control = json_classify_avx2(_mm256_max_epu8(low, control), _mm256_max_epu8(high, control), control);
+}
+#endif
+
+/* finds the characters escaped by a backslash, runs of backslashes escape alternately so the parity of where
+ * each run starts decides which of its successors are escaped, runs may continue from the previous block */
+static unsigned long long json_find_escaped(json_scanner* t_scanner, unsigned long long t_backslash)
+{
+	if (!t_backslash)
+	{
+		unsigned long long escaped = t_scanner->is_escaped;
+		t_scanner->is_escaped = 0;
+		return escaped;
+	}
+	t_backslash &= ~t_scanner->is_escaped;
+	unsigned long long follows_escape = (t_backslash << 1) | t_scanner->is_escaped;
+	unsigned long long odd_starts = t_backslash & ~JSON_EVEN_BITS & ~follows_escape;
+	unsigned long long sequences = odd_starts + t_backslash;
+	t_scanner->is_escaped = sequences < odd_starts;
+	return (JSON_EVEN_BITS ^ (sequences << 1)) & follows_escape;
+}
+
+static unsigned long long json_prefix_xor(unsigned long long t_bits)
+{
+	t_bits ^= t_bits << 1;
+	t_bits ^= t_bits << 2;
+	t_bits ^= t_bits << 4;
+	t_bits ^= t_bits << 8;
+	t_bits ^= t_bits << 16;
+	t_bits ^= t_bits << 32;
+	return t_bits;
+}
+
+/* returns the structural characters of a block, the operators outside of strings, every unescaped quote, and the
+ * first character of each number or literal */
+static unsigned long long json_scan_block(json_scanner* t_scanner, const json_block* t_block)
+{
+	unsigned long long quote = t_block->quote & ~json_find_escaped(t_scanner, t_block->backslash);
+	unsigned long long in_string = json_prefix_xor(quote) ^ t_scanner->in_string;
+	t_scanner->in_string = (unsigned long long)((long long)in_string >> 63);
+
+	unsigned long long scalar = ~(t_block->operators | t_block->whitespace | quote | in_string);
+	unsigned long long scalar_start = scalar & ~((scalar << 1) | t_scanner->in_scalar);
+	t_scanner->in_scalar = scalar >> 63;
+
+	/* control characters are never valid within strings, nor outside of them other than as whitespace */
+	t_scanner->error |= t_block->control & (in_string | ~t_block->whitespace);
+	return (t_block->operators & ~in_string) | quote | scalar_start;
+}
+
+static void json_init_scanner(json_scanner* t_scanner, const char* t_source, size_t t_length)
+{
+	memset(t_scanner, 0, offsetof(json_scanner, indices));
+	t_scanner->source = t_source;
+	t_scanner->length = t_length;
+	t_scanner->classify = json_classify_block;
+#if SIMD_SSE2
+	t_scanner->classify = json_classify_block_sse2;
+#endif
+#if SIMD_X86_DISPATCH
+	if (simd_get_features() & SIMD_FEATURE_AVX2)
+	{
+		t_scanner->classify = json_classify_block_avx2;
+	}
+#endif
+}
+
+/* ensures the window holds the structurals needed to parse the next step from t_index onwards, consumed offsets
+ * are discarded and t_index is moved to the front of the window */
+static void json_scanner_fill(json_scanner* t_scanner, unsigned int* t_index)
+{
+	json_block block;
+	unsigned char tail[JSON_BLOCK_SIZE];
+	if (t_scanner->index_count - *t_index >= JSON_INDEX_LOOKAHEAD || t_scanner->offset >= t_scanner->length)
+	{
+		return;
+	}
+
+	t_scanner->index_count -= *t_index;
+	memmove(t_scanner->indices, t_scanner->indices + *t_index, sizeof(unsigned int) * t_scanner->index_count);
+	*t_index = 0;
+	while (t_scanner->offset < t_scanner->length && t_scanner->index_count <= JSON_INDEX_CAPACITY - JSON_BLOCK_SIZE)
+	{
+		/* the last partial block is padded with whitespace, which is neither structural nor part of a scalar */
+		const unsigned char* source = (const unsigned char*)t_scanner->source + t_scanner->offset;
+		if (t_scanner->length - t_scanner->offset < JSON_BLOCK_SIZE)
+		{
+			memset(tail, ' ', sizeof(tail));
+			memcpy(tail, source, t_scanner->length - t_scanner->offset);
+			source = tail;
+		}
+		t_scanner->classify(source, &block);
+
+		unsigned long long structurals = json_scan_block(t_scanner, &block);
+		while (structurals)
+		{
+			t_scanner->indices[t_scanner->index_count++] = (unsigned int)t_scanner->offset + json_trailing_zeros(structurals);
+			structurals &= structurals - 1;
+		}
+		t_scanner->offset += JSON_BLOCK_SIZE;
+	}
+}
+
+static int json_push_token(json_parser* t_parser, unsigned int t_type, size_t t_offset, size_t t_length)
+{
+	json* document = t_parser->document;
+	if (document->token_count == t_parser->token_capacity)
+	{
+		unsigned int capacity = t_parser->token_capacity * 2;
+		json_token* tokens = realloc(document->tokens, sizeof(json_token) * capacity);
+		if (!tokens)
+		{
+			return -1;
+		}
+		document->tokens = tokens;
+		t_parser->token_capacity = capacity;
+	}
+
+	/* built whole so the packed type and count are written once rather than read back */
+	json_token token;
+	token.type = t_type;
+	token.count = 0;
+	token.offset = (unsigned int)t_offset;
+	token.length = (unsigned int)t_length;
+	token.next = document->token_count + 1;
+	document->tokens[document->token_count] = token;
+	return (int)document->token_count++;
+}
+
+static int json_open_container(json_parser* t_parser, unsigned int t_token)
+{
+	if (t_parser->depth == t_parser->stack_capacity)
+	{
+		unsigned int capacity = t_parser->stack_capacity * 2;
+		unsigned int* stack = realloc(t_parser->stack, sizeof(unsigned int) * 2 * capacity);
+		if (!stack)
+		{
+			return 0;
+		}
+		t_parser->stack = stack;
+		t_parser->stack_capacity = capacity;
+	}
+	t_parser->stack[t_parser->depth * 2] = t_parser->container;
+	t_parser->stack[t_parser->depth * 2 + 1] = t_parser->count;
+	++t_parser->depth;
+	t_parser->container = t_token;
+	t_parser->count = 0;
+	return 1;
+}
+
+static void json_close_container(json_parser* t_parser, size_t t_offset)
+{
+	json* document = t_parser->document;
+	json_token* container = document->tokens + t_parser->container;
+	container->count = t_parser->count;
+	container->next = document->token_count;
+	container->length = (unsigned int)(t_offset + 1 - container->offset);
+	--t_parser->depth;
+	t_parser->container = t_parser->stack[t_parser->depth * 2];
+	t_parser->count = t_parser->stack[t_parser->depth * 2 + 1];
+}
+
+/* parses the key of an object member and the colon that follows it, leaving t_index at the member's value */
+static int json_parse_key(json_parser* t_parser, const json_scanner* t_scanner, unsigned int* t_index)
+{
+	const char* source = t_scanner->source;
+	const unsigned int* indices = t_scanner->indices;
+	unsigned int n = *t_index;
+	if (n + 2 >= t_scanner->index_count || source[indices[n]] != '"' || source[indices[n + 2]] != ':'
+		|| json_push_token(t_parser, JSON_STRING, indices[n] + 1, indices[n + 1] - indices[n] - 1) < 0)
+	{
+		return 0;
+	}
+	*t_index = n + 3;
+	return 1;
+}
+
+static size_t json_scan_digits(const char* t_source, size_t t_length, size_t t_offset)
+{
+	while (t_offset < t_length && (unsigned char)(t_source[t_offset] - '0') < 10)
+	{
+		++t_offset;
+	}
+	return t_offset;
+}
+
+/* returns the end of the number at t_offset following the JSON grammar, or t_offset if there is none */
+static size_t json_scan_number(const char* t_source, size_t t_length, size_t t_offset)
+{
+	size_t i = t_offset + (t_source[t_offset] == '-'), end;
+	end = i < t_length && t_source[i] == '0' ? i + 1 : json_scan_digits(t_source, t_length, i);
+	if (end == i)
+	{
+		return t_offset;
+	}
+	i = end;
+	if (i < t_length && t_source[i] == '.')
+	{
+		end = json_scan_digits(t_source, t_length, ++i);
+		if (end == i)
+		{
+			return t_offset;
+		}
+		i = end;
+	}
+	if (i < t_length && (t_source[i] == 'e' || t_source[i] == 'E'))
+	{
+		i += i + 1 < t_length && (t_source[i + 1] == '+' || t_source[i + 1] == '-') ? 2 : 1;
+		end = json_scan_digits(t_source, t_length, i);
+		if (end == i)
+		{
+			return t_offset;
+		}
+		i = end;
+	}
+	return i;
+}
+
+int json_parse(json* t_json, const char* t_source, size_t t_length)
+{
+	assert(t_json && (t_source || !t_length));
+
+	json_parser parser;
+	json_scanner scanner;
+	const unsigned int* indices = scanner.indices;
+	unsigned int n = 0;
+
+	t_json->source = t_source;
+	t_json->length = t_length;
+	t_json->token_count = 0;
+	t_json->tokens = 0;
+	if (t_length > JSON_MAX_LENGTH)
+	{
+		return 0;
+	}
+
+	/* stage two, walks the structural characters only, every token begins at one */
+	json_init_scanner(&scanner, t_source, t_length);
+	parser.document = t_json;
+	parser.token_capacity = (unsigned int)(t_length / 16) + 16;
+	parser.container = 0;
+	parser.count = 0;
+	parser.depth = 0;
+	parser.stack_capacity = 32;
+	parser.stack = malloc(sizeof(unsigned int) * 2 * parser.stack_capacity);
+	t_json->tokens = malloc(sizeof(json_token) * parser.token_capacity);
+	if (!parser.stack || !t_json->tokens)
+	{
+		goto parse_fail;
+	}
+
+	while (1)
+	{
+		json_scanner_fill(&scanner, &n);
+		if (n >= scanner.index_count)
+		{
+			goto parse_fail;
+		}
+
+		/* a value, an object has one per member so members and elements are counted alike */
+		size_t i = indices[n];
+		char c = t_source[i];
+		++parser.count;
+		if (c == '{' || c == '[')
+		{
+			int token = json_push_token(&parser, c == '{' ? JSON_OBJECT : JSON_ARRAY, i, 1);
+			if (token < 0 || !json_open_container(&parser, (unsigned int)token))
+			{
+				goto parse_fail;
+			}
+			if (++n < scanner.index_count && t_source[indices[n]] != (c == '{' ? '}' : ']'))
+			{
+				if (c == '{' && !json_parse_key(&parser, &scanner, &n))
+				{
+					goto parse_fail;
+				}
+				continue;
+			}
+		}
+		else if (c == '"')
+		{
+			/* the structural following an opening quote is always its closing quote, as nothing within a string is */
+			if (n + 1 >= scanner.index_count || json_push_token(&parser, JSON_STRING, i + 1, indices[n + 1] - i - 1) < 0)
+			{
+				goto parse_fail;
+			}
+			n += 2;
+		}
+		else
+		{
+			/* a scalar runs up to the next structural, less any whitespace, and must be exactly one literal */
+			size_t end = n + 1 < scanner.index_count ? indices[n + 1] : t_length;
+			unsigned int type;
+			while (t_source[end - 1] == ' ' || t_source[end - 1] == '\t' || t_source[end - 1] == '\n' || t_source[end - 1] == '\r')
+			{
+				--end;
+			}
+			if (c == '-' || (c >= '0' && c <= '9'))
+			{
+				type = json_scan_number(t_source, end, i) == end ? JSON_NUMBER : JSON_OBJECT;
+			}
+			else if (end - i == 4 && memcmp(t_source + i, "true", 4) == 0)
+			{
+				type = JSON_TRUE;
+			}
+			else if (end - i == 5 && memcmp(t_source + i, "false", 5) == 0)
+			{
+				type = JSON_FALSE;
+			}
+			else if (end - i == 4 && memcmp(t_source + i, "null", 4) == 0)
+			{
+				type = JSON_NULL;
+			}
+			else
+			{
+				goto parse_fail;
+			}
+			if (type == JSON_OBJECT || json_push_token(&parser, type, i, end - i) < 0)
+			{
+				goto parse_fail;
+			}
+			++n;
+		}
+
+		/* after a value, closes any finished containers then moves on to the next element or member */
+		while (parser.depth)
+		{
+			int is_object = t_json->tokens[parser.container].type == JSON_OBJECT;
+			json_scanner_fill(&scanner, &n);
+			if (n >= scanner.index_count)
+			{
+				goto parse_fail;
+			}
+			c = t_source[indices[n]];
+			if (c == ',')
+			{
+				++n;
+				if (is_object && !json_parse_key(&parser, &scanner, &n))
+				{
+					goto parse_fail;
+				}
+				break;
+			}
+			if (c != (is_object ? '}' : ']'))
+			{
+				goto parse_fail;
+			}
+			json_close_container(&parser, indices[n++]);
+		}
+		if (!parser.depth)
+		{
+			break;
+		}
+	}
+
+	/* nothing may follow the root value, and the scan must have found no invalid characters or open strings */
+	json_scanner_fill(&scanner, &n);
+	if (n != scanner.index_count || scanner.offset < t_length || scanner.error || scanner.in_string)
+	{
+		goto parse_fail;
+	}
+	free(parser.stack);
+	return 1;
+
+parse_fail:
+	free(parser.stack);
+	json_final(t_json);
+	return 0;
+}
+
+int json_find(const json* t_json, int t_object, const char* t_key)
+{
+	assert(t_json && t_key);
+
+	if (t_object < 0 || t_json->tokens[t_object].type != JSON_OBJECT)
+	{
+		return -1;
+	}
+
+	unsigned int i, key = (unsigned int)t_object + 1;
+	for (i = 0; i < t_json->tokens[t_object].count; ++i)
+	{
+		if (json_string_equals(t_json, (int)key, t_key))
+		{
+			return (int)key + 1;
+		}
+		key = t_json->tokens[key + 1].next;
+	}
+	return -1;
+}
+
+int json_get_index(const json* t_json, int t_array, unsigned int t_index)
+{
+	assert(t_json);
+
+	if (t_array < 0 || t_json->tokens[t_array].type != JSON_ARRAY || t_index >= t_json->tokens[t_array].count)
+	{
+		return -1;
+	}
+
+	unsigned int i, element = (unsigned int)t_array + 1;
+	for (i = 0; i < t_index; ++i)
+	{
+		element = t_json->tokens[element].next;
+	}
+	return (int)element;
+}
+
+double json_get_number(const json* t_json, int t_token, double t_default)
+{
+	assert(t_json);
+
+	if (t_token < 0 || t_json->tokens[t_token].type != JSON_NUMBER)
+	{
+		return t_default;
+	}
+
+	const json_token* token = t_json->tokens + t_token;
+	const char* text = t_json->source + token->offset;
+	unsigned int i = text[0] == '-', digits = 0;
+	unsigned long long integer = 0;
+	while (i < token->length && text[i] >= '0' && text[i] <= '9' && digits < 19)
+	{
+		integer = integer * 10 + (unsigned long long)(text[i++] - '0');
+		++digits;
+	}
+	if (i == token->length && digits)
+	{
+		return text[0] == '-' ? -(double)integer : (double)integer;
+	}
+
+	/* fractions and exponents are rare in the structure of a document, the source is not terminated so is copied */
+	char number[64];
+	if (token->length >= sizeof(number))
+	{
+		return t_default;
+	}
+	memcpy(number, text, token->length);
+	number[token->length] = 0;
+	return strtod(number, 0);
+}
+
+long long json_get_integer(const json* t_json, int t_token, long long t_default)
+{
+	assert(t_json);
+
+	if (t_token < 0 || t_json->tokens[t_token].type != JSON_NUMBER)
+	{
+		return t_default;
+	}
+	double number = json_get_number(t_json, t_token, (double)t_default);
+
+	/* fractions, overflow and nan are not integers, and casting them to long long is undefined */
+	if (!isfinite(number) || floor(number) != number || number < -9223372036854775808.0 || number >= 9223372036854775808.0)
+	{
+		return t_default;
+	}
+	return (long long)number;
+}
+
+int json_get_bool(const json* t_json, int t_token, int t_default)
+{
+	assert(t_json);
+
+	if (t_token < 0 || (t_json->tokens[t_token].type != JSON_TRUE && t_json->tokens[t_token].type != JSON_FALSE))
+	{
+		return t_default;
+	}
+	return t_json->tokens[t_token].type == JSON_TRUE;
+}
+
+static unsigned int json_parse_hex(const char* t_text)
+{
+	unsigned int i, value = 0;
+	for (i = 0; i < 4; ++i)
+	{
+		char c = t_text[i];
+		value = value * 16 + (unsigned int)(c >= '0' && c <= '9' ? c - '0' : (c >= 'a' && c <= 'f' ? c - 'a' + 10 : (c >= 'A' && c <= 'F' ? c - 'A' + 10 : 0)));
+	}
+	return value;
+}
+
+/* decodes the escapes of a string token, the decoded string is never longer than its source */
+static size_t json_decode_string(const json* t_json, const json_token* t_token, char* t_out)
+{
+	const char* text = t_json->source + t_token->offset;
+	size_t i = 0, length = 0;
+	while (i < t_token->length)
+	{
+		if (text[i] != '\\')
+		{
+			t_out[length++] = text[i++];
+			continue;
+		}
+		char escape = text[i + 1];
+		i += 2;
+		switch (escape)
+		{
+		case 'b': t_out[length++] = '\b'; break;
+		case 'f': t_out[length++] = '\f'; break;
+		case 'n': t_out[length++] = '\n'; break;
+		case 'r': t_out[length++] = '\r'; break;
+		case 't': t_out[length++] = '\t'; break;
+		case 'u':
+		{
+			unsigned int code = i + 4 <= t_token->length ? json_parse_hex(text + i) : 0xFFFD;
+			i += 4;
+			if (code >= 0xD800 && code < 0xDC00 && i + 6 <= t_token->length && text[i] == '\\' && text[i + 1] == 'u')
+			{
+				unsigned int low = json_parse_hex(text + i + 2);
+				if (low >= 0xDC00 && low < 0xE000)
+				{
+					code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+					i += 6;
+				}
+			}
+			if (code < 0x80)
+			{
+				t_out[length++] = (char)code;
+			}
+			else if (code < 0x800)
+			{
+				t_out[length++] = (char)(0xC0 | (code >> 6));
+				t_out[length++] = (char)(0x80 | (code & 0x3F));
+			}
+			else if (code < 0x10000)
+			{
+				t_out[length++] = (char)(0xE0 | (code >> 12));
+				t_out[length++] = (char)(0x80 | ((code >> 6) & 0x3F));
+				t_out[length++] = (char)(0x80 | (code & 0x3F));
+			}
+			else
+			{
+				t_out[length++] = (char)(0xF0 | (code >> 18));
+				t_out[length++] = (char)(0x80 | ((code >> 12) & 0x3F));
+				t_out[length++] = (char)(0x80 | ((code >> 6) & 0x3F));
+				t_out[length++] = (char)(0x80 | (code & 0x3F));
+			}
+			break;
+		}
+		default: t_out[length++] = escape; break;
+		}
+	}
+	return length;
+}
+
+int json_get_string(const json* t_json, int t_token, char* t_out, size_t t_out_size, size_t* t_out_length)
+{
+	assert(t_json && t_out && t_out_size);
+
+	if (t_token < 0 || t_json->tokens[t_token].type != JSON_STRING)
+	{
+		return 0;
+	}
+
+	const json_token* token = t_json->tokens + t_token;
+	if (token->length >= t_out_size)
+	{
+		char* decoded = malloc(token->length + 1);
+		if (!decoded)
+		{
+			return 0;
+		}
+		size_t length = json_decode_string(t_json, token, decoded);
+		int result = length < t_out_size;
+		if (result)
+		{
+			memcpy(t_out, decoded, length);
+			t_out[length] = 0;
+			if (t_out_length)
+			{
+				*t_out_length = length;
+			}
+		}
+		free(decoded);
+		return result;
+	}
+
+	size_t length = json_decode_string(t_json, token, t_out);
+	t_out[length] = 0;
+	if (t_out_length)
+	{
+		*t_out_length = length;
+	}
+	return 1;
+}
+
+int json_string_equals(const json* t_json, int t_token, const char* t_string)
+{
+	assert(t_json && t_string);
+
+	if (t_token < 0 || t_json->tokens[t_token].type != JSON_STRING)
+	{
+		return 0;
+	}
+
+	const json_token* token = t_json->tokens + t_token;
+	const char* text = t_json->source + token->offset;
+	size_t length = strlen(t_string);
+	if (!memchr(text, '\\', token->length))
+	{
+		return token->length == length && memcmp(text, t_string, length) == 0;
+	}
+
+	char decoded[256];
+	size_t decoded_length;
+	return json_get_string(t_json, t_token, decoded, sizeof(decoded), &decoded_length)
+		&& decoded_length == length && memcmp(decoded, t_string, length) == 0;
+}
+
+void json_final(json* t_json)
+{
+	assert(t_json);
+
+	free(t_json->tokens);
+	t_json->tokens = 0;
+	t_json->token_count = 0;
+}
@@ -0,0 +1,70 @@
+/**
+ * json.h
+ */
+
+#ifndef GRAPHICS_UTILS_JSON_H
+#define GRAPHICS_UTILS_JSON_H
+
+#include <stddef.h>
+
+#define JSON_NULL 0
+#define JSON_FALSE 1
+#define JSON_TRUE 2
+#define JSON_NUMBER 3
+#define JSON_STRING 4
+#define JSON_ARRAY 5
+#define JSON_OBJECT 6
+
+/**	@struct		json_token
+ *	@brief		a single value of a parsed document, tokens are stored in document order so the children of a
+ *				container follow it directly, object members being a string key token followed by the value
+ *	@member		json_token::type - one of the JSON values
+ *	@member		json_token::offset - the offset of the value in the source, after the opening quote of a string
+ *	@member		json_token::length - the length of the value in the source, excluding the quotes of a string
+ *	@member		json_token::count - the number of elements of an array or members of an object
+ *	@member		json_token::next - the index of the token following this token and all of its children
+ */
+typedef struct
+{
+	unsigned int type : 4;
+	unsigned int count : 28;
+	unsigned int offset;
+	unsigned int length;
+	unsigned int next;
+} json_token;
+
+/**	@struct		json
+ *	@brief		a parsed document referencing its source in place, strings and numbers are decoded on demand, documents
+ *				are limited to 512 MB so that the counts of containers fit their tokens
+ *	@member		json::source - the source text, which must outlive the document
+ *	@member		json::length - the length of the source text
+ *	@member		json::token_count - the number of tokens
+ *	@member		json::tokens - the tokens, the root value being the first
+ */
+typedef struct
+{
+	const char* source;
+	size_t length;
+	unsigned int token_count;
+	json_token* tokens;
+} json;
+
+int json_parse(json* t_json, const char* t_source, size_t t_length);
+
+int json_find(const json* t_json, int t_object, const char* t_key);
+
+int json_get_index(const json* t_json, int t_array, unsigned int t_index);
+
+double json_get_number(const json* t_json, int t_token, double t_default);
+
+long long json_get_integer(const json* t_json, int t_token, long long t_default);
+
+int json_get_bool(const json* t_json, int t_token, int t_default);
+
+int json_get_string(const json* t_json, int t_token, char* t_out, size_t t_out_size, size_t* t_out_length);
+
+int json_string_equals(const json* t_json, int t_token, const char* t_string);
+
+void json_final(json* t_json);
+
+#endif
@@ -29,6 +29,9 @@ Rename this file to lodepng.cpp to use it for C++, or to lodepng.c to use it for
 */
 
 #include "lode_png.h"
+#include "checksum.h"
+#include "simd.h"
+#include "thread_pool.h"
 
 #ifdef LODEPNG_COMPILE_DISK
 #include <limits.h> /* LONG_MAX */
@@ -39,6 +42,8 @@ Rename this file to lodepng.cpp to use it for C++, or to lodepng.c to use it for
 #include <stdlib.h> /* allocations */
 #endif /* LODEPNG_COMPILE_ALLOCATORS */
 
+#include <string.h> /* memmove */
+
 #if defined(_MSC_VER) && (_MSC_VER >= 1310) /*Visual Studio: A few warning types are not desired here.*/
 #pragma warning( disable : 4244 ) /*implicit conversions: not warned by gcc -Wall -Wextra and requires too much casts*/
 #pragma warning( disable : 4996 ) /*VS does not like fopen, but fopen_s is not standard C so unusable here*/
@@ -122,6 +127,11 @@ static void lodepng_memcpy(void* LODEPNG_RESTRICT dst,
   for(i = 0; i < size; i++) ((char*)dst)[i] = ((const char*)src)[i];
 }
 
+/* for overlapping ranges, such as compacting a window, where the library call is much faster than a byte loop */
+static void lodepng_memmove(void* dst, const void* src, size_t size) {
+  memmove(dst, src, size);
+}
+
 /* does not check memory out of bounds, do not use on untrusted data */
 static size_t lodepng_strlen(const char* a) {
   const char* orig = a;
@@ -1467,6 +1477,617 @@ unsigned lodepng_inflate(unsigned char** out, size_t* outsize,
   return error;
 }
 
+/* ////////////////////////////////////////////////////////////////////////// */
+/* / Fast Inflator                                                          / */
+/* ////////////////////////////////////////////////////////////////////////// */
+
+/*
+Table driven inflate, the default custom_inflate. Bits are read LSB first from a 64-bit buffer that is refilled with
+a whole 8-byte load while enough input remains, so that one refill covers a length code, its extra bits, a distance
+code and its extra bits. Codes are decoded with one lookup in a table indexed by the next FASTBITS_LL or FASTBITS_D
+bits, longer codes continue in a secondary table. An entry of a literal whose code leaves room in the index for the
+code of a second literal decodes both literals at once. While the out buffer has room to spare, matches are copied
+16 or 8 bytes at a time, overshooting their end, so no byte loop is needed except to start short repeating patterns.
+*/
+
+#define FASTBITS_LL 11u
+#define FASTBITS_D 8u
+#define FASTBITS_CL 7u
+/*the first table, then a secondary table of at most 15 - FASTBITS bits for each code longer than FASTBITS*/
+#define FASTSIZE_LL ((1u << FASTBITS_LL) + NUM_DEFLATE_CODE_SYMBOLS * (1u << (15u - FASTBITS_LL)))
+#define FASTSIZE_D ((1u << FASTBITS_D) + NUM_DISTANCE_SYMBOLS * (1u << (15u - FASTBITS_D)))
+/*bytes a match copy may write past its end*/
+#define FASTSLACK 32u
+
+/*
+A table entry: bits 0-4 are the amount of bits to consume, bits 12-15 the flags below, and bits 16-31 the value: the
+literal(s), the base length or distance, or the position of the secondary table. A length or distance, which has no
+flags, consumes its code and extra bits at once, and bits 8-11 are the code length, so its extra bits start there.
+Where the extra bits fit in the first table too, an entry per extra value holds the whole length or distance. Bits
+8-11 of a secondary table pointer are its index bits.
+*/
+#define FAST_LITERAL 0x8000u /*the literal in bits 16-23*/
+#define FAST_LITERAL2 0x1000u /*with FAST_LITERAL, a second literal in bits 24-31*/
+#define FAST_EXCEPTIONAL 0x4000u /*neither a literal nor a length, alone an invalid symbol*/
+#define FAST_TABLE 0x2000u /*with FAST_EXCEPTIONAL, a pointer to a secondary table*/
+#define FAST_END 0x1000u /*with FAST_EXCEPTIONAL, the end code*/
+
+/*where decoding resumes*/
+#define FAST_STATE_HEADER 0u /*at the header of the next block*/
+#define FAST_STATE_HUFFMAN 1u /*within a huffman block*/
+#define FAST_STATE_STORED 2u /*within a stored block*/
+#define FAST_STATE_END 3u /*past the final block*/
+
+typedef struct FastInflator {
+  const unsigned char* in; /*next input byte that is not yet in the bit buffer*/
+  const unsigned char* end;
+  unsigned long long bits; /*the bit buffer, the next bit to read is the LSB*/
+  unsigned numbits; /*amount of valid bits in the buffer, bits above it may hold a part of the next input byte*/
+  unsigned overrun; /*amount of zero bytes put in the buffer after the input ran out*/
+  ucvector out; /*the allocation for the output, its size is not kept up to date*/
+  size_t pos; /*amount of bytes decoded into out*/
+  size_t limit; /*decoding pauses between symbols once pos reaches this, out must have 258 bytes of room past it*/
+  unsigned state; /*one of FAST_STATE_*/
+  unsigned final; /*whether the current block is the final block*/
+  size_t stored; /*bytes of the current stored block not yet copied*/
+  unsigned fixed; /*whether the tables hold the fixed trees*/
+  unsigned values_ll[NUM_DEFLATE_CODE_SYMBOLS]; /*the entry of each symbol, with the amount of extra bits*/
+  unsigned values_d[NUM_DISTANCE_SYMBOLS];
+  unsigned table_ll[FASTSIZE_LL];
+  unsigned table_d[FASTSIZE_D];
+} FastInflator;
+
+static LODEPNG_INLINE unsigned long long fastRead64(const unsigned char* p) {
+  return (unsigned long long)p[0] | ((unsigned long long)p[1] << 8u) | ((unsigned long long)p[2] << 16u) |
+         ((unsigned long long)p[3] << 24u) | ((unsigned long long)p[4] << 32u) |
+         ((unsigned long long)p[5] << 40u) | ((unsigned long long)p[6] << 48u) |
+         ((unsigned long long)p[7] << 56u);
+}
+
+/*fills the bit buffer up to at least 56 bits, with zero bytes once the input ran out*/
+static LODEPNG_INLINE void fastRefill(FastInflator* f) {
+  if(f->end - f->in >= 8) {
+    /*loads 8 bytes but only counts the whole bytes that fit, the partial byte is loaded again by the next refill*/
+    f->bits |= fastRead64(f->in) << f->numbits;
+    f->in += (63u - f->numbits) >> 3u;
+    f->numbits |= 56u;
+  } else {
+    f->bits &= (1ull << f->numbits) - 1u;
+    while(f->numbits < 56u) {
+      if(f->in != f->end) f->bits |= (unsigned long long)(*f->in++) << f->numbits;
+      else ++f->overrun;
+      f->numbits += 8u;
+    }
+  }
+}
+
+static LODEPNG_INLINE void fastAdvance(FastInflator* f, unsigned num) {
+  f->bits >>= num;
+  f->numbits -= num;
+}
+
+/*whether bits past the end of the input were read*/
+static LODEPNG_INLINE unsigned fastOverrun(const FastInflator* f) {
+  return f->numbits < (f->overrun << 3u);
+}
+
+/*reverses the order of the len lowest bits of code*/
+static LODEPNG_INLINE unsigned fastReverseBits(unsigned code, unsigned len) {
+  code = ((code & 0x5555u) << 1u) | ((code >> 1u) & 0x5555u);
+  code = ((code & 0x3333u) << 2u) | ((code >> 2u) & 0x3333u);
+  code = ((code & 0x0f0fu) << 4u) | ((code >> 4u) & 0x0f0fu);
+  code = ((code & 0x00ffu) << 8u) | ((code >> 8u) & 0x00ffu);
+  return code >> (16u - len);
+}
+
+/*the entry of a symbol with a code of len bits, from its value with the amount of extra bits in bits 8-11*/
+static LODEPNG_INLINE unsigned fastEntry(unsigned value, unsigned len) {
+  if(value & (FAST_LITERAL | FAST_EXCEPTIONAL)) return value | len;
+  return (value & ~0xf00u) | (len << 8u) | (len + ((value >> 8u) & 15u));
+}
+
+/*builds the decoding table of a code from its code lengths, values holds the entry of each symbol*/
+static unsigned fastBuildTable(unsigned* table, unsigned tablebits, const unsigned* lengths,
+                               const unsigned* values, unsigned numcodes) {
+  unsigned count[16], next[16];
+  unsigned i, j, len, left = 1, maxlen = 0, numpresent = 0;
+  unsigned headsize = 1u << tablebits;
+  unsigned pointer = headsize;
+  for(i = 0; i != 16; ++i) count[i] = 0;
+  for(i = 0; i != numcodes; ++i) ++count[lengths[i]];
+  for(len = 1; len != 16; ++len) {
+    left <<= 1u;
+    if(count[len] > left) return 55; /*invalid tree: oversubscribed*/
+    left -= count[len];
+    numpresent += count[len];
+    if(count[len]) maxlen = len;
+  }
+  /*like HuffmanTree_makeTable, only a code of less than 2 symbols may leave bit combinations unused*/
+  if(left && numpresent >= 2) return 55;
+
+  next[1] = 0;
+  for(len = 1; len != 15; ++len) next[len + 1] = (next[len] + count[len]) << 1u;
+  for(i = 0; i != headsize; ++i) table[i] = FAST_EXCEPTIONAL;
+
+  for(i = 0; i != numcodes; ++i) {
+    unsigned reverse;
+    len = lengths[i];
+    if(!len) continue;
+    reverse = fastReverseBits(next[len]++, len);
+    if(len <= tablebits) {
+      unsigned extra = (values[i] & (FAST_LITERAL | FAST_EXCEPTIONAL)) ? 0 : (values[i] >> 8u) & 15u;
+      if(extra && len + extra <= tablebits) {
+        /*the value of the extra bits picks the entry, the bits after them are free*/
+        unsigned k;
+        for(k = 0; k != (1u << extra); ++k) {
+          unsigned entry = fastEntry(((values[i] >> 16u) + k) << 16u, len + extra);
+          for(j = reverse | (k << len); j < headsize; j += 1u << (len + extra)) table[j] = entry;
+        }
+      } else {
+        for(j = reverse; j < headsize; j += 1u << len) table[j] = fastEntry(values[i], len);
+      }
+    } else {
+      /*all long codes sharing the first tablebits bits go in one secondary table*/
+      unsigned index = reverse & (headsize - 1u);
+      unsigned subbits = maxlen - tablebits;
+      unsigned* sub;
+      if(!(table[index] & FAST_TABLE)) {
+        table[index] = (pointer << 16u) | FAST_EXCEPTIONAL | FAST_TABLE | (subbits << 8u) | tablebits;
+        for(j = 0; j != (1u << subbits); ++j) table[pointer + j] = FAST_EXCEPTIONAL;
+        pointer += 1u << subbits;
+      }
+      sub = table + (table[index] >> 16u);
+      for(j = reverse >> tablebits; j < (1u << subbits); j += 1u << (len - tablebits)) {
+        sub[j] = fastEntry(values[i], len - tablebits);
+      }
+    }
+  }
+  return 0;
+}
+
+/*lets each entry of a literal decode the literal after it too, if both codes fit in the first table*/
+static void fastPairLiterals(unsigned* table) {
+  unsigned i = 1u << FASTBITS_LL;
+  /*downwards, so that the single entry at i >> len, which is never above i, is not yet paired*/
+  while(i--) {
+    unsigned e = table[i], len = e & 31u, e2;
+    if(!(e & FAST_LITERAL) || len >= FASTBITS_LL) continue;
+    /*the lookup only sees FASTBITS_LL - len bits of the second code, fine if it is no longer than that*/
+    e2 = table[i >> len];
+    if(!(e2 & FAST_LITERAL) || len + (e2 & 31u) > FASTBITS_LL) continue;
+    table[i] = ((e2 >> 16u) << 24u) | (e & 0x00ff0000u) | FAST_LITERAL | FAST_LITERAL2 | (len + (e2 & 31u));
+  }
+}
+
+static void fastInit(FastInflator* f, const unsigned char* in, size_t insize) {
+  unsigned i;
+  f->in = in;
+  f->end = in + insize;
+  f->bits = 0;
+  f->numbits = 0;
+  f->overrun = 0;
+  f->pos = 0;
+  f->limit = (size_t)(-1);
+  f->state = FAST_STATE_HEADER;
+  f->final = 0;
+  f->stored = 0;
+  f->fixed = 0;
+  for(i = 0; i != 256; ++i) f->values_ll[i] = (i << 16u) | FAST_LITERAL;
+  f->values_ll[256] = FAST_EXCEPTIONAL | FAST_END;
+  for(i = FIRST_LENGTH_CODE_INDEX; i != NUM_DEFLATE_CODE_SYMBOLS; ++i) {
+    unsigned code = i - FIRST_LENGTH_CODE_INDEX;
+    f->values_ll[i] = (i <= LAST_LENGTH_CODE_INDEX) ? (LENGTHBASE[code] << 16u) | (LENGTHEXTRA[code] << 8u)
+                                                     : FAST_EXCEPTIONAL;
+  }
+  for(i = 0; i != NUM_DISTANCE_SYMBOLS; ++i) {
+    f->values_d[i] = (i < 30) ? (DISTANCEBASE[i] << 16u) | (DISTANCEEXTRA[i] << 8u) : FAST_EXCEPTIONAL;
+  }
+}
+
+static unsigned fastTablesFixed(FastInflator* f) {
+  unsigned lengths[NUM_DEFLATE_CODE_SYMBOLS];
+  unsigned i, error;
+  if(f->fixed) return 0;
+  for(i = 0; i != NUM_DEFLATE_CODE_SYMBOLS; ++i) lengths[i] = (i < 144) ? 8 : (i < 256) ? 9 : (i < 280) ? 7 : 8;
+  error = fastBuildTable(f->table_ll, FASTBITS_LL, lengths, f->values_ll, NUM_DEFLATE_CODE_SYMBOLS);
+  if(error) return error;
+  fastPairLiterals(f->table_ll);
+  for(i = 0; i != NUM_DISTANCE_SYMBOLS; ++i) lengths[i] = 5;
+  error = fastBuildTable(f->table_d, FASTBITS_D, lengths, f->values_d, NUM_DISTANCE_SYMBOLS);
+  if(error) return error;
+  f->fixed = 1;
+  return 0;
+}
+
+/*reads the code lengths of a dynamic block, see getTreeInflateDynamic, and builds its tables*/
+static unsigned fastTablesDynamic(FastInflator* f) {
+  unsigned lengths[NUM_DEFLATE_CODE_SYMBOLS + NUM_DISTANCE_SYMBOLS];
+  unsigned lengths_d[NUM_DISTANCE_SYMBOLS];
+  unsigned bitlen_cl[NUM_CODE_LENGTH_CODES], values_cl[NUM_CODE_LENGTH_CODES];
+  unsigned table_cl[1u << FASTBITS_CL];
+  unsigned HLIT, HDIST, HCLEN, i, n, error;
+
+  f->fixed = 0;
+  fastRefill(f);
+  HLIT = (unsigned)(f->bits & 31u) + 257u;
+  HDIST = (unsigned)((f->bits >> 5u) & 31u) + 1u;
+  HCLEN = (unsigned)((f->bits >> 10u) & 15u) + 4u;
+  fastAdvance(f, 14);
+  if(fastOverrun(f)) return 49; /*error: the bit pointer is or will go past the memory*/
+
+  for(i = 0; i != NUM_CODE_LENGTH_CODES; ++i) {
+    if(i < HCLEN) {
+      fastRefill(f);
+      bitlen_cl[CLCL_ORDER[i]] = (unsigned)(f->bits & 7u);
+      fastAdvance(f, 3);
+    } else {
+      bitlen_cl[CLCL_ORDER[i]] = 0;
+    }
+    values_cl[i] = (i << 16u) | FAST_LITERAL;
+  }
+  if(fastOverrun(f)) return 50; /*error: the bit pointer is or will go past the memory*/
+  error = fastBuildTable(table_cl, FASTBITS_CL, bitlen_cl, values_cl, NUM_CODE_LENGTH_CODES);
+  if(error) return error;
+
+  /*the lit,len and dist code lengths follow each other, and repeats may cross from one into the other*/
+  i = 0;
+  while(i < HLIT + HDIST) {
+    unsigned e, code, value = 0, replength;
+    fastRefill(f);
+    e = table_cl[f->bits & ((1u << FASTBITS_CL) - 1u)];
+    if(!(e & FAST_LITERAL)) return 16; /*error: tried to read disallowed huffman symbol*/
+    fastAdvance(f, e & 31u);
+    code = e >> 16u;
+    if(code <= 15) /*a length code*/ {
+      lengths[i++] = code;
+      replength = 0;
+    } else if(code == 16) /*repeat previous 3-6 times*/ {
+      if(i == 0) return 54; /*can't repeat previous if i is 0*/
+      value = lengths[i - 1];
+      replength = 3u + (unsigned)(f->bits & 3u);
+      fastAdvance(f, 2);
+      if(i + replength > HLIT + HDIST) return 13; /*error: i is larger than the amount of codes*/
+    } else if(code == 17) /*repeat "0" 3-10 times*/ {
+      replength = 3u + (unsigned)(f->bits & 7u);
+      fastAdvance(f, 3);
+      if(i + replength > HLIT + HDIST) return 14; /*error: i is larger than the amount of codes*/
+    } else /*code == 18, repeat "0" 11-138 times*/ {
+      replength = 11u + (unsigned)(f->bits & 127u);
+      fastAdvance(f, 7);
+      if(i + replength > HLIT + HDIST) return 15; /*error: i is larger than the amount of codes*/
+    }
+    for(n = 0; n != replength; ++n) lengths[i++] = value;
+    if(fastOverrun(f)) return 50; /*error, bit pointer jumps past memory*/
+  }
+
+  if(lengths[256] == 0) return 64; /*the length of the end code 256 must be larger than 0*/
+
+  for(i = 0; i != NUM_DISTANCE_SYMBOLS; ++i) lengths_d[i] = (i < HDIST) ? lengths[HLIT + i] : 0;
+  for(i = HLIT; i != NUM_DEFLATE_CODE_SYMBOLS; ++i) lengths[i] = 0;
+  error = fastBuildTable(f->table_ll, FASTBITS_LL, lengths, f->values_ll, NUM_DEFLATE_CODE_SYMBOLS);
+  if(error) return error;
+  fastPairLiterals(f->table_ll);
+  return fastBuildTable(f->table_d, FASTBITS_D, lengths_d, f->values_d, NUM_DISTANCE_SYMBOLS);
+}
+
+static LODEPNG_INLINE void fastCopy8(unsigned char* dst, const unsigned char* src) {
+#if SIMD_SSE2
+  _mm_storel_epi64((__m128i*)dst, _mm_loadl_epi64((const __m128i*)src));
+#else
+  lodepng_memcpy(dst, src, 8);
+#endif
+}
+
+static LODEPNG_INLINE void fastCopy16(unsigned char* dst, const unsigned char* src) {
+#if SIMD_SSE2
+  _mm_storeu_si128((__m128i*)dst, _mm_loadu_si128((const __m128i*)src));
+#else
+  lodepng_memcpy(dst, src, 8);
+  lodepng_memcpy(dst + 8, src + 8, 8);
+#endif
+}
+
+/*copies a match of length bytes from distance bytes back, writing up to FASTSLACK bytes past its end*/
+static LODEPNG_INLINE void fastCopyMatch(unsigned char* dst, size_t distance, size_t length) {
+  const unsigned char* src = dst - distance;
+  unsigned char* end = dst + length;
+  if(distance >= 16) {
+    do {
+      fastCopy16(dst, src);
+      fastCopy16(dst + 16, src + 16);
+      dst += 32;
+      src += 32;
+    } while(dst < end);
+  } else if(distance >= 8) {
+    do {
+      fastCopy8(dst, src);
+      dst += 8;
+      src += 8;
+    } while(dst < end);
+  } else if(distance == 1) {
+#if SIMD_SSE2
+    __m128i value = _mm_set1_epi8((char)src[0]);
+    do {
+      _mm_storeu_si128((__m128i*)dst, value);
+      dst += 16;
+    } while(dst < end);
+#else
+    unsigned char value = src[0];
+    while(dst < end) *dst++ = value;
+#endif
+  } else {
+    /*a repeating pattern of distance bytes: extend it byte by byte until a whole number of its periods spans 8
+    bytes, then copy 8 bytes at a time from that many periods back*/
+    size_t period = distance * ((8u + distance - 1u) / distance);
+    unsigned char* bytewise = dst + (period - distance);
+    while(dst < end && dst < bytewise) *dst++ = *src++;
+    src = dst - period;
+    while(dst < end) {
+      fastCopy8(dst, src);
+      dst += 8;
+      src += 8;
+    }
+  }
+}
+
+/*decodes symbols while at least 8 input bytes and a maximal match plus FASTSLACK bytes of output room remain,
+without checking either per symbol. The state is kept in locals, stores to out can't alias them*/
+static unsigned fastInflateSymbols(FastInflator* f, unsigned* done) {
+  const unsigned* table_ll = f->table_ll;
+  const unsigned* table_d = f->table_d;
+  const unsigned char* in = f->in;
+  unsigned long long bits = f->bits;
+  unsigned numbits = f->numbits;
+  unsigned char* out = f->out.data;
+  size_t pos = f->pos;
+  const unsigned char* inlast; /*last position at which 8 bytes can be loaded*/
+  size_t outlast; /*last position at which a maximal match fits*/
+  unsigned e, error = 0;
+
+  if(f->end - f->in < 8 || f->out.allocsize - f->pos < 258u + FASTSLACK) return 0;
+  inlast = f->end - 8;
+  outlast = f->out.allocsize - (258u + FASTSLACK);
+  if(outlast > f->limit) outlast = f->limit;
+  if(pos >= outlast) return 0;
+
+  /*every iteration starts refilled with the entry of the next symbol looked up, after a match that is done before
+  copying it*/
+  bits |= fastRead64(in) << numbits;
+  in += (63u - numbits) >> 3u;
+  numbits |= 56u;
+  e = table_ll[bits & ((1u << FASTBITS_LL) - 1u)];
+  for(;;) {
+    unsigned length, distance;
+    unsigned char* dst;
+    if(e & FAST_LITERAL) {
+      /*decode literals until the bits of this refill run out, at most 2 bytes per bit fit in the out room*/
+      do {
+        bits >>= e & 31u;
+        numbits -= e & 31u;
+        out[pos] = (unsigned char)(e >> 16u);
+        out[pos + 1] = (unsigned char)(e >> 24u);
+        pos += 1u + ((e >> 12u) & 1u);
+        e = table_ll[bits & ((1u << FASTBITS_LL) - 1u)];
+      } while((e & FAST_LITERAL) && numbits >= FASTBITS_LL);
+      if(in > inlast || pos > outlast) break;
+      bits |= fastRead64(in) << numbits;
+      in += (63u - numbits) >> 3u;
+      numbits |= 56u;
+      e = table_ll[bits & ((1u << FASTBITS_LL) - 1u)];
+      continue;
+    }
+    if(e & FAST_EXCEPTIONAL) {
+      if(e & FAST_TABLE) {
+        bits >>= e & 31u;
+        numbits -= e & 31u;
+        e = table_ll[(e >> 16u) + (unsigned)(bits & ((1u << ((e >> 8u) & 15u)) - 1u))];
+        if(e & FAST_LITERAL) {
+          bits >>= e & 31u;
+          numbits -= e & 31u;
+          out[pos++] = (unsigned char)(e >> 16u);
+          if(in > inlast || pos > outlast) break;
+          bits |= fastRead64(in) << numbits;
+          in += (63u - numbits) >> 3u;
+          numbits |= 56u;
+          e = table_ll[bits & ((1u << FASTBITS_LL) - 1u)];
+          continue;
+        }
+      }
+      if(e & FAST_EXCEPTIONAL) {
+        if(e & FAST_END) {
+          bits >>= e & 31u;
+          numbits -= e & 31u;
+          *done = 1;
+        } else {
+          error = 16; /*error: tried to read disallowed huffman symbol*/
+        }
+        break;
+      }
+    }
+    length = (e >> 16u) + (((unsigned)bits & ((1u << (e & 31u)) - 1u)) >> ((e >> 8u) & 15u));
+    bits >>= e & 31u;
+    numbits -= e & 31u;
+
+    e = table_d[bits & ((1u << FASTBITS_D) - 1u)];
+    if(e & FAST_EXCEPTIONAL) {
+      if(e & FAST_TABLE) {
+        bits >>= e & 31u;
+        numbits -= e & 31u;
+        e = table_d[(e >> 16u) + (unsigned)(bits & ((1u << ((e >> 8u) & 15u)) - 1u))];
+      }
+      if(e & FAST_EXCEPTIONAL) {
+        error = 18; /*error: invalid distance code (30-31 are never used)*/
+        break;
+      }
+    }
+    distance = (e >> 16u) + (((unsigned)bits & ((1u << (e & 31u)) - 1u)) >> ((e >> 8u) & 15u));
+    bits >>= e & 31u;
+    numbits -= e & 31u;
+    if(distance > pos) {
+      error = 52; /*too long backward distance*/
+      break;
+    }
+    dst = out + pos;
+    pos += length;
+    if(in > inlast || pos > outlast) {
+      fastCopyMatch(dst, distance, length);
+      break;
+    }
+    bits |= fastRead64(in) << numbits;
+    in += (63u - numbits) >> 3u;
+    numbits |= 56u;
+    e = table_ll[bits & ((1u << FASTBITS_LL) - 1u)];
+    fastCopyMatch(dst, distance, length);
+  }
+
+  f->in = in;
+  f->bits = bits;
+  f->numbits = numbits;
+  f->pos = pos;
+  return error;
+}
+
+/*decodes one symbol, checking the input and output bounds*/
+static unsigned fastInflateSymbol(FastInflator* f, unsigned* done) {
+  unsigned e, length, distance;
+  fastRefill(f);
+  e = f->table_ll[f->bits & ((1u << FASTBITS_LL) - 1u)];
+  if(e & FAST_TABLE) {
+    fastAdvance(f, e & 31u);
+    e = f->table_ll[(e >> 16u) + (unsigned)(f->bits & ((1u << ((e >> 8u) & 15u)) - 1u))];
+  }
+  if(e & FAST_LITERAL) {
+    size_t num = 1u + ((e >> 12u) & 1u);
+    fastAdvance(f, e & 31u);
+    if(f->out.allocsize - f->pos < num && !ucvector_reserve(&f->out, f->pos + num)) return 83; /*alloc fail*/
+    f->out.data[f->pos] = (unsigned char)(e >> 16u);
+    if(num == 2) f->out.data[f->pos + 1] = (unsigned char)(e >> 24u);
+    f->pos += num;
+  } else if(!(e & FAST_EXCEPTIONAL)) {
+    length = (e >> 16u) + (((unsigned)f->bits & ((1u << (e & 31u)) - 1u)) >> ((e >> 8u) & 15u));
+    fastAdvance(f, e & 31u);
+
+    e = f->table_d[f->bits & ((1u << FASTBITS_D) - 1u)];
+    if(e & FAST_TABLE) {
+      fastAdvance(f, e & 31u);
+      e = f->table_d[(e >> 16u) + (unsigned)(f->bits & ((1u << ((e >> 8u) & 15u)) - 1u))];
+    }
+    if(e & FAST_EXCEPTIONAL) return 18; /*error: invalid distance code (30-31 are never used)*/
+    distance = (e >> 16u) + (((unsigned)f->bits & ((1u << (e & 31u)) - 1u)) >> ((e >> 8u) & 15u));
+    fastAdvance(f, e & 31u);
+    if(distance > f->pos) return 52; /*too long backward distance*/
+
+    if(f->out.allocsize - f->pos >= length + FASTSLACK) {
+      fastCopyMatch(f->out.data + f->pos, distance, length);
+    } else {
+      /*near the end of the buffer, copy exactly and grow it only when the match does not fit*/
+      unsigned char* dst;
+      const unsigned char* src;
+      size_t n;
+      if(f->out.allocsize - f->pos < length && !ucvector_reserve(&f->out, f->pos + length)) return 83; /*alloc fail*/
+      dst = f->out.data + f->pos;
+      src = dst - distance;
+      for(n = 0; n != length; ++n) dst[n] = src[n];
+    }
+    f->pos += length;
+  } else if(e & FAST_END) {
+    fastAdvance(f, e & 31u);
+    *done = 1;
+  } else {
+    return 16; /*error: tried to read disallowed huffman symbol*/
+  }
+  return fastOverrun(f) ? 51 : 0; /*error, bit pointer jumps past memory*/
+}
+
+static unsigned fastInflateNoCompression(FastInflator* f, const LodePNGDecompressSettings* settings) {
+  unsigned LEN, NLEN;
+  /*go to first boundary of byte, and give the whole bytes left in the bit buffer back to the input*/
+  fastAdvance(f, f->numbits & 7u);
+  if((f->numbits >> 3u) < f->overrun) return 52; /*error, bit pointer will jump past memory*/
+  f->in -= (f->numbits >> 3u) - f->overrun;
+  f->bits = 0;
+  f->numbits = 0;
+  f->overrun = 0;
+
+  /*read LEN (2 bytes) and NLEN (2 bytes)*/
+  if(f->end - f->in < 4) return 52; /*error, bit pointer will jump past memory*/
+  LEN = (unsigned)f->in[0] + ((unsigned)f->in[1] << 8u);
+  NLEN = (unsigned)f->in[2] + ((unsigned)f->in[3] << 8u);
+  f->in += 4;
+
+  /*check if 16-bit NLEN is really the one's complement of LEN*/
+  if(!settings->ignore_nlen && LEN + NLEN != 65535) {
+    return 21; /*error: NLEN is not one's complement of LEN*/
+  }
+  if((size_t)(f->end - f->in) < LEN) return 23; /*error: reading outside of in buffer*/
+  f->stored = LEN;
+  return 0;
+}
+
+/*copies the rest of the current stored block, or as much of it as reaches the limit*/
+static unsigned fastInflateStored(FastInflator* f) {
+  size_t num = f->stored;
+  if(f->limit - f->pos < num) num = f->limit - f->pos;
+  if(f->out.allocsize - f->pos < num && !ucvector_reserve(&f->out, f->pos + num)) return 83; /*alloc fail*/
+  lodepng_memcpy(f->out.data + f->pos, f->in, num);
+  f->pos += num;
+  f->in += num;
+  f->stored -= num;
+  return 0;
+}
+
+/*decodes blocks until the final one ends or pos reaches the limit, resuming where the previous call paused*/
+static unsigned fastInflateRun(FastInflator* f, const LodePNGDecompressSettings* settings) {
+  unsigned error = 0;
+  while(!error && f->state != FAST_STATE_END && f->pos < f->limit) {
+    if(f->state == FAST_STATE_HEADER) {
+      unsigned BTYPE;
+      fastRefill(f);
+      f->final = (unsigned)(f->bits & 1u);
+      BTYPE = (unsigned)((f->bits >> 1u) & 3u);
+      fastAdvance(f, 3);
+      if(fastOverrun(f)) error = 52; /*error, bit pointer will jump past memory*/
+      else if(BTYPE == 3) error = 20; /*error: invalid BTYPE*/
+      else if(BTYPE == 0) {
+        error = fastInflateNoCompression(f, settings); /*no compression*/
+        f->state = FAST_STATE_STORED;
+      } else {
+        error = (BTYPE == 1) ? fastTablesFixed(f) : fastTablesDynamic(f);
+        f->state = FAST_STATE_HUFFMAN;
+      }
+    } else if(f->state == FAST_STATE_STORED) {
+      error = fastInflateStored(f);
+      if(!f->stored) f->state = f->final ? FAST_STATE_END : FAST_STATE_HEADER;
+    } else {
+      /*the symbols of a huffman block, without bound checks until near either end*/
+      unsigned done = 0;
+      error = fastInflateSymbols(f, &done);
+      if(!error && !done && f->pos < f->limit) error = fastInflateSymbol(f, &done);
+      if(done) f->state = f->final ? FAST_STATE_END : FAST_STATE_HEADER;
+    }
+  }
+  return error;
+}
+
+unsigned lodepng_inflate_fast(unsigned char** out, size_t* outsize,
+                              const unsigned char* in, size_t insize,
+                              const LodePNGDecompressSettings* settings) {
+  unsigned error = 0;
+  FastInflator* f = (FastInflator*)lodepng_malloc(sizeof(FastInflator));
+  if(!f) return 83; /*alloc fail*/
+
+  fastInit(f, in, insize);
+  /*like lodepng_inflate, the given buffer is storage for the output, which starts at its beginning*/
+  ucvector_init_buffer(&f->out, *out, *out ? *outsize : 0);
+  if(f->out.allocsize < insize && !ucvector_reserve(&f->out, insize * 4u)) error = 83; /*alloc fail*/
+  if(!error) error = fastInflateRun(f, settings);
+
+  *out = f->out.data;
+  *outsize = f->pos;
+  lodepng_free(f);
+  return error;
+}
+
 static unsigned inflate(unsigned char** out, size_t* outsize,
                         const unsigned char* in, size_t insize,
                         const LodePNGDecompressSettings* settings) {
@@ -2147,13 +2768,198 @@ static unsigned lodepng_deflatev(ucvector* out, const unsigned char* in, size_t
   return error;
 }
 
+/*
+Parallel deflate, pigz style: the input is split into chunks of whole blocks which are compressed independently, each
+with its hash primed by the window of input preceding it so that matches reach back across the chunk boundary as they
+would in one stream. Every chunk but the last ends with an empty stored block to bring it to a byte boundary, and the
+chunks are then concatenated. The split depends only on the input size and the settings, never on the thread count,
+so the output is the same for any nonzero numthreads and any pool.
+*/
+
+/*minimum amount of input per chunk, a chunk holds as many whole blocks as it takes to reach this*/
+#define DEFLATE_CHUNKSIZE 262144u
+
+static unsigned update_adler32(unsigned adler, const unsigned char* data, unsigned len);
+
+typedef struct DeflateChunks {
+  const unsigned char* in;
+  size_t insize;
+  size_t chunksize;
+  size_t blocksize;
+  size_t numchunks;
+  size_t numlanes; /*at most this many chunks are compressed at once, lane i takes chunks i, i + numlanes, ...*/
+  const LodePNGCompressSettings* settings;
+  ucvector* outs; /*the deflate data of each chunk*/
+  unsigned* adlers; /*the adler32 of the input of each chunk*/
+  unsigned* errors;
+} DeflateChunks;
+
+/*deflates in[start..end-1] into its own byte aligned sequence of blocks, only the block ending at insize is final*/
+static unsigned deflateChunk(ucvector* out, const unsigned char* in, size_t start, size_t end, size_t insize,
+                             size_t blocksize, const LodePNGCompressSettings* settings) {
+  unsigned error;
+  size_t pos;
+  Hash hash;
+  LodePNGBitWriter writer;
+
+  LodePNGBitWriter_init(&writer, out);
+
+  error = hash_init(&hash, settings->windowsize);
+  if(!error && settings->use_lz77) {
+    /*insert the preceding window like encodeLZ77 would have at the end of the previous block*/
+    unsigned windowsize = settings->windowsize;
+    unsigned numzeros = 0;
+    for(pos = start > windowsize ? start - windowsize : 0; pos != start; ++pos) {
+      unsigned hashval = getHash(in, start, pos);
+      if(hashval == 0) {
+        if(numzeros == 0) numzeros = countZeros(in, start, pos);
+        else if(pos + numzeros > start || in[pos + numzeros - 1] != 0) --numzeros;
+      } else {
+        numzeros = 0;
+      }
+      updateHashChain(&hash, pos & (windowsize - 1), hashval, (unsigned short)numzeros);
+    }
+  }
+
+  for(pos = start; pos < end && !error; pos += blocksize) {
+    size_t blockend = end - pos > blocksize ? pos + blocksize : end;
+    unsigned final = (blockend == insize);
+    if(settings->btype == 1) error = deflateFixed(&writer, &hash, in, pos, blockend, settings, final);
+    else error = deflateDynamic(&writer, &hash, in, pos, blockend, settings, final);
+  }
+
+  if(!error && end != insize) {
+    /*empty stored block: BFINAL 0, BTYPE 00, padding to the byte boundary, LEN 0 and NLEN 65535*/
+    writeBits(&writer, 0, 3);
+    if(!ucvector_resize(out, out->size + 4)) error = 83; /*alloc fail*/
+    else {
+      out->data[out->size - 4] = 0;
+      out->data[out->size - 3] = 0;
+      out->data[out->size - 2] = 255;
+      out->data[out->size - 1] = 255;
+    }
+  }
+
+  hash_cleanup(&hash);
+  return error;
+}
+
+static void deflateChunkRange(void* context, size_t begin, size_t end) {
+  DeflateChunks* chunks = (DeflateChunks*)context;
+  size_t lane, i;
+  for(lane = begin; lane != end; ++lane) {
+    for(i = lane; i < chunks->numchunks; i += chunks->numlanes) {
+      size_t start = i * chunks->chunksize;
+      size_t stop = chunks->insize - start > chunks->chunksize ? start + chunks->chunksize : chunks->insize;
+      chunks->errors[i] = deflateChunk(&chunks->outs[i], chunks->in, start, stop, chunks->insize,
+                                       chunks->blocksize, chunks->settings);
+      chunks->adlers[i] = update_adler32(1u, &chunks->in[start], (unsigned)(stop - start));
+    }
+  }
+}
+
+/*Return the adler32 of the concatenation of two byte sequences, given their adler32s and the length of the second*/
+static unsigned adler32_combine(unsigned adler1, unsigned adler2, size_t len2) {
+  unsigned rem = (unsigned)(len2 % 65521u);
+  unsigned s1 = adler1 & 0xffffu;
+  unsigned s2 = (rem * s1) % 65521u;
+  s1 += (adler2 & 0xffffu) + 65521u - 1u;
+  s2 += ((adler1 >> 16u) & 0xffffu) + ((adler2 >> 16u) & 0xffffu) + 65521u - rem;
+  if(s1 >= 65521u) s1 -= 65521u;
+  if(s1 >= 65521u) s1 -= 65521u;
+  if(s2 >= 65521u * 2u) s2 -= 65521u * 2u;
+  if(s2 >= 65521u) s2 -= 65521u;
+  return (s2 << 16u) | s1;
+}
+
+/*
+Deflates in chunks across settings->pool, appending to out. If adler is not NULL, it receives the
+adler32 of the input, combined from the adler32s the threads compute of their chunks.
+*/
+static unsigned lodepng_deflatev_parallel(ucvector* out, unsigned* adler, const unsigned char* in, size_t insize,
+                                          const LodePNGCompressSettings* settings) {
+  unsigned error = 0;
+  size_t i, blocksize, chunksize, numchunks, total;
+  DeflateChunks chunks;
+
+  if(settings->btype > 2) return 61;
+  if(settings->use_lz77) {
+    if(settings->windowsize == 0 || settings->windowsize > 32768) return 60; /*error: windowsize smaller/larger than allowed*/
+    if((settings->windowsize & (settings->windowsize - 1)) != 0) return 90; /*error: must be power of two*/
+  }
+
+  if(settings->btype == 2) {
+    /*the same blocks as lodepng_deflatev, so that input of a single chunk compresses identically*/
+    blocksize = insize / 8u + 8;
+    if(blocksize < 65536) blocksize = 65536;
+    if(blocksize > 262144) blocksize = 262144;
+  } else {
+    blocksize = DEFLATE_CHUNKSIZE;
+  }
+  chunksize = (DEFLATE_CHUNKSIZE + blocksize - 1) / blocksize * blocksize;
+  numchunks = (insize + chunksize - 1) / chunksize;
+
+  /*stored blocks cost no more than a copy and gain nothing from threads*/
+  if(settings->btype == 0 || numchunks <= 1) {
+    error = lodepng_deflatev(out, in, insize, settings);
+    if(!error && adler) *adler = update_adler32(1u, in, (unsigned)insize);
+    return error;
+  }
+
+  chunks.in = in;
+  chunks.insize = insize;
+  chunks.chunksize = chunksize;
+  chunks.blocksize = blocksize;
+  chunks.numchunks = numchunks;
+  chunks.numlanes = settings->numthreads < numchunks ? settings->numthreads : numchunks;
+  chunks.settings = settings;
+  chunks.outs = (ucvector*)lodepng_malloc(numchunks * sizeof(ucvector));
+  chunks.adlers = (unsigned*)lodepng_malloc(numchunks * sizeof(unsigned));
+  chunks.errors = (unsigned*)lodepng_malloc(numchunks * sizeof(unsigned));
+  if(!chunks.outs || !chunks.adlers || !chunks.errors) {
+    lodepng_free(chunks.outs);
+    lodepng_free(chunks.adlers);
+    lodepng_free(chunks.errors);
+    return 83; /*alloc fail*/
+  }
+  for(i = 0; i != numchunks; ++i) ucvector_init_buffer(&chunks.outs[i], 0, 0);
+
+  /*the calling thread works through the lanes alongside the workers of the pool, so numthreads caps the chunks in
+  flight and with them the memory of their hash tables*/
+  thread_pool_parallel_for(settings->pool, chunks.numlanes, 1, deflateChunkRange, &chunks);
+
+  total = out->size;
+  for(i = 0; i != numchunks && !error; ++i) {
+    error = chunks.errors[i];
+    total += chunks.outs[i].size;
+  }
+  if(!error && !ucvector_reserve(out, total)) error = 83; /*alloc fail*/
+  if(!error) {
+    if(adler) *adler = 1u;
+    for(i = 0; i != numchunks; ++i) {
+      size_t start = i * chunksize;
+      size_t size = insize - start > chunksize ? chunksize : insize - start;
+      lodepng_memcpy(out->data + out->size, chunks.outs[i].data, chunks.outs[i].size);
+      out->size += chunks.outs[i].size;
+      if(adler) *adler = adler32_combine(*adler, chunks.adlers[i], size);
+    }
+  }
+
+  for(i = 0; i != numchunks; ++i) lodepng_free(chunks.outs[i].data);
+  lodepng_free(chunks.outs);
+  lodepng_free(chunks.adlers);
+  lodepng_free(chunks.errors);
+  return error;
+}
+
 unsigned lodepng_deflate(unsigned char** out, size_t* outsize,
                          const unsigned char* in, size_t insize,
                          const LodePNGCompressSettings* settings) {
   unsigned error;
   ucvector v;
   ucvector_init_buffer(&v, *out, *outsize);
-  error = lodepng_deflatev(&v, in, insize, settings);
+  if(settings->numthreads) error = lodepng_deflatev_parallel(&v, 0, in, insize, settings);
+  else error = lodepng_deflatev(&v, in, insize, settings);
   *out = v.data;
   *outsize = v.size;
   return error;
@@ -2176,23 +2982,8 @@ static unsigned deflate(unsigned char** out, size_t* outsize,
 /* ////////////////////////////////////////////////////////////////////////// */
 
 static unsigned update_adler32(unsigned adler, const unsigned char* data, unsigned len) {
-  unsigned s1 = adler & 0xffffu;
-  unsigned s2 = (adler >> 16u) & 0xffffu;
-
-  while(len != 0u) {
-    unsigned i;
-    /*at least 5552 sums can be done before the sums overflow, saving a lot of module divisions*/
-    unsigned amount = len > 5552u ? 5552u : len;
-    len -= amount;
-    for(i = 0; i != amount; ++i) {
-      s1 += (*data++);
-      s2 += s1;
-    }
-    s1 %= 65521u;
-    s2 %= 65521u;
-  }
-
-  return (s2 << 16u) | s1;
+  /*vectorized with ssse3 or avx2 where the cpu supports it*/
+  return checksum_adler32(adler, data, len);
 }
 
 /*Return the adler32 of the bytes data[0..len-1]*/
@@ -2206,9 +2997,8 @@ static unsigned adler32(const unsigned char* data, unsigned len) {
 
 #ifdef LODEPNG_COMPILE_DECODER
 
-unsigned lodepng_zlib_decompress(unsigned char** out, size_t* outsize, const unsigned char* in,
-                                 size_t insize, const LodePNGDecompressSettings* settings) {
-  unsigned error = 0;
+/*checks the 2 byte zlib header at the start of in*/
+static unsigned zlibCheckHeader(const unsigned char* in, size_t insize) {
   unsigned CM, CINFO, FDICT;
 
   if(insize < 2) return 53; /*error, size of zlib data too small*/
@@ -2233,6 +3023,13 @@ unsigned lodepng_zlib_decompress(unsigned char** out, size_t* outsize, const uns
       "The additional flags shall not specify a preset dictionary."*/
     return 26;
   }
+  return 0;
+}
+
+unsigned lodepng_zlib_decompress(unsigned char** out, size_t* outsize, const unsigned char* in,
+                                 size_t insize, const LodePNGDecompressSettings* settings) {
+  unsigned error = zlibCheckHeader(in, insize);
+  if(error) return error;
 
   error = inflate(out, outsize, in + 2, insize - 2, settings);
   if(error) return error;
@@ -2255,6 +3052,112 @@ static unsigned zlib_decompress(unsigned char** out, size_t* outsize, const unsi
   }
 }
 
+/*the output room the window has beyond the 32768 bytes of history and the current line*/
+#define SCANLINE_WINDOW_BATCH 65536u
+
+/*
+Decompresses zlib data one line at a time into a window, which holds the line being handed out and the 32768
+bytes before it that matches may refer to, so that the whole decompressed data is never in memory at once.
+*/
+typedef struct ScanlineStream {
+  const unsigned char* in;
+  size_t insize;
+  FastInflator* f; /*its output is the window, of which pos bytes are decoded*/
+  size_t next; /*position in the window of the first line not yet handed out*/
+  unsigned adler; /*adler32 of the lines handed out so far*/
+} ScanlineStream;
+
+static unsigned scanlineStreamInit(ScanlineStream* s, const unsigned char* in, size_t insize, size_t linesize) {
+  size_t windowsize;
+  unsigned error = zlibCheckHeader(in, insize);
+  s->in = in;
+  s->insize = insize;
+  s->next = 0;
+  s->adler = 1u;
+  s->f = 0;
+  if(error) return error;
+  if(lodepng_addofl(linesize, 32768u + SCANLINE_WINDOW_BATCH + 258u + FASTSLACK, &windowsize)) return 92;
+
+  s->f = (FastInflator*)lodepng_malloc(sizeof(FastInflator));
+  if(!s->f) return 83; /*alloc fail*/
+  fastInit(s->f, in + 2, insize - 2);
+  ucvector_init_buffer(&s->f->out, 0, 0);
+  if(!ucvector_reserve(&s->f->out, windowsize)) return 83; /*alloc fail*/
+  return 0;
+}
+
+static void scanlineStreamCleanup(ScanlineStream* s) {
+  if(!s->f) return;
+  lodepng_free(s->f->out.data);
+  lodepng_free(s->f);
+}
+
+/*decodes as far as the window allows, after discarding what is no longer needed if there is not room for linesize*/
+static unsigned scanlineStreamRun(ScanlineStream* s, size_t linesize, const LodePNGDecompressSettings* settings) {
+  FastInflator* f = s->f;
+  if(f->out.allocsize - f->pos < 258u + FASTSLACK + linesize && f->pos > 32768u) {
+    /*keep the lines not yet handed out, and the 32768 bytes before the end that matches may refer to*/
+    size_t discard = LODEPNG_MIN(s->next, f->pos - 32768u);
+    lodepng_memmove(f->out.data, f->out.data + discard, f->pos - discard);
+    f->pos -= discard;
+    s->next -= discard;
+  }
+  /*the window is sized so that this is past pos while less than linesize bytes past next are decoded*/
+  f->limit = f->out.allocsize - (258u + FASTSLACK);
+  return fastInflateRun(f, settings);
+}
+
+/*
+The decompressed size does not match the image. Like lodepng_zlib_decompress, which checks the adler32 of all of
+the data before the size is compared, inflate the rest to give a corrupt stream or checksum precedence.
+*/
+static unsigned scanlineStreamMismatch(ScanlineStream* s, const LodePNGDecompressSettings* settings) {
+  FastInflator* f = s->f;
+  for(;;) {
+    if(!settings->ignore_adler32) {
+      s->adler = update_adler32(s->adler, f->out.data + s->next, (unsigned)(f->pos - s->next));
+    }
+    s->next = f->pos;
+    if(f->state == FAST_STATE_END) break;
+    CERROR_TRY_RETURN(scanlineStreamRun(s, 1, settings));
+  }
+  if(!settings->ignore_adler32 && s->adler != lodepng_read32bitInt(&s->in[s->insize - 4])) {
+    return 58; /*error, adler checksum not correct, data must be corrupted*/
+  }
+  return 91; /*decompressed size doesn't match prediction*/
+}
+
+/*decodes until linesize bytes past next are available*/
+static unsigned scanlineStreamFill(ScanlineStream* s, size_t linesize, const LodePNGDecompressSettings* settings) {
+  while(s->f->pos - s->next < linesize) {
+    if(s->f->state == FAST_STATE_END) return scanlineStreamMismatch(s, settings);
+    CERROR_TRY_RETURN(scanlineStreamRun(s, linesize, settings));
+  }
+  return 0;
+}
+
+/*hands out the next linesize bytes of the decompressed data, valid until the next call*/
+static unsigned scanlineStreamNext(ScanlineStream* s, unsigned char** line, size_t linesize,
+                                   const LodePNGDecompressSettings* settings) {
+  CERROR_TRY_RETURN(scanlineStreamFill(s, linesize, settings));
+  *line = s->f->out.data + s->next;
+  s->next += linesize;
+  if(!settings->ignore_adler32) s->adler = update_adler32(s->adler, *line, (unsigned)linesize);
+  return 0;
+}
+
+/*checks that the data ends after the lines handed out, and its adler32*/
+static unsigned scanlineStreamFinish(ScanlineStream* s, const LodePNGDecompressSettings* settings) {
+  while(s->f->pos == s->next && s->f->state != FAST_STATE_END) CERROR_TRY_RETURN(scanlineStreamRun(s, 1, settings));
+  if(s->f->pos != s->next) return scanlineStreamMismatch(s, settings);
+
+  if(!settings->ignore_adler32) {
+    unsigned ADLER32 = lodepng_read32bitInt(&s->in[s->insize - 4]);
+    if(s->adler != ADLER32) return 58; /*error, adler checksum not correct, data must be corrupted*/
+  }
+  return 0;
+}
+
 #endif /*LODEPNG_COMPILE_DECODER*/
 
 #ifdef LODEPNG_COMPILE_ENCODER
@@ -2265,8 +3168,19 @@ unsigned lodepng_zlib_compress(unsigned char** out, size_t* outsize, const unsig
   unsigned error;
   unsigned char* deflatedata = 0;
   size_t deflatesize = 0;
-
-  error = deflate(&deflatedata, &deflatesize, in, insize, settings);
+  unsigned ADLER32 = 0;
+
+  if(settings->numthreads && !settings->custom_deflate) {
+    /*the threads compute the adler32 of their chunks along with the deflate data*/
+    ucvector v;
+    ucvector_init_buffer(&v, 0, 0);
+    error = lodepng_deflatev_parallel(&v, &ADLER32, in, insize, settings);
+    deflatedata = v.data;
+    deflatesize = v.size;
+  } else {
+    error = deflate(&deflatedata, &deflatesize, in, insize, settings);
+    if(!error) ADLER32 = adler32(in, (unsigned)insize);
+  }
 
   *out = NULL;
   *outsize = 0;
@@ -2277,7 +3191,6 @@ unsigned lodepng_zlib_compress(unsigned char** out, size_t* outsize, const unsig
   }
 
   if(!error) {
-    unsigned ADLER32 = adler32(in, (unsigned)insize);
     /*zlib data: 1 byte CMF (CM+CINFO), 1 byte FLG, deflate data, 4 byte ADLER32 checksum of the Decompressed data*/
     unsigned CMF = 120; /*0b01111000: CM 8, CINFO 7. With CINFO 7, any window size up to 32768 can be used.*/
     unsigned FLEVEL = 0;
@@ -2342,13 +3255,15 @@ void lodepng_compress_settings_init(LodePNGCompressSettings* settings) {
   settings->minmatch = 3;
   settings->nicematch = 128;
   settings->lazymatching = 1;
+  settings->numthreads = 0;
+  settings->pool = 0;
 
   settings->custom_zlib = 0;
   settings->custom_deflate = 0;
   settings->custom_context = 0;
 }
 
-const LodePNGCompressSettings lodepng_default_compress_settings = {2, 1, DEFAULT_WINDOWSIZE, 3, 128, 1, 0, 0, 0};
+const LodePNGCompressSettings lodepng_default_compress_settings = {2, 1, DEFAULT_WINDOWSIZE, 3, 128, 1, 0, 0, 0, 0, 0};
 
 
 #endif /*LODEPNG_COMPILE_ENCODER*/
@@ -2360,11 +3275,11 @@ void lodepng_decompress_settings_init(LodePNGDecompressSettings* settings) {
   settings->ignore_nlen = 0;
 
   settings->custom_zlib = 0;
-  settings->custom_inflate = 0;
+  settings->custom_inflate = lodepng_inflate_fast;
   settings->custom_context = 0;
 }
 
-const LodePNGDecompressSettings lodepng_default_decompress_settings = {0, 0, 0, 0, 0};
+const LodePNGDecompressSettings lodepng_default_decompress_settings = {0, 0, 0, lodepng_inflate_fast, 0};
 
 #endif /*LODEPNG_COMPILE_DECODER*/
 
@@ -2382,50 +3297,10 @@ const LodePNGDecompressSettings lodepng_default_decompress_settings = {0, 0, 0,
 
 
 #ifndef LODEPNG_NO_COMPILE_CRC
-/* CRC polynomial: 0xedb88320 */
-static unsigned lodepng_crc32_table[256] = {
-           0u, 1996959894u, 3993919788u, 2567524794u,  124634137u, 1886057615u, 3915621685u, 2657392035u,
-   249268274u, 2044508324u, 3772115230u, 2547177864u,  162941995u, 2125561021u, 3887607047u, 2428444049u,
-   498536548u, 1789927666u, 4089016648u, 2227061214u,  450548861u, 1843258603u, 4107580753u, 2211677639u,
-   325883990u, 1684777152u, 4251122042u, 2321926636u,  335633487u, 1661365465u, 4195302755u, 2366115317u,
-   997073096u, 1281953886u, 3579855332u, 2724688242u, 1006888145u, 1258607687u, 3524101629u, 2768942443u,
-   901097722u, 1119000684u, 3686517206u, 2898065728u,  853044451u, 1172266101u, 3705015759u, 2882616665u,
-   651767980u, 1373503546u, 3369554304u, 3218104598u,  565507253u, 1454621731u, 3485111705u, 3099436303u,
-   671266974u, 1594198024u, 3322730930u, 2970347812u,  795835527u, 1483230225u, 3244367275u, 3060149565u,
-  1994146192u,   31158534u, 2563907772u, 4023717930u, 1907459465u,  112637215u, 2680153253u, 3904427059u,
-  2013776290u,  251722036u, 2517215374u, 3775830040u, 2137656763u,  141376813u, 2439277719u, 3865271297u,
-  1802195444u,  476864866u, 2238001368u, 4066508878u, 1812370925u,  453092731u, 2181625025u, 4111451223u,
-  1706088902u,  314042704u, 2344532202u, 4240017532u, 1658658271u,  366619977u, 2362670323u, 4224994405u,
-  1303535960u,  984961486u, 2747007092u, 3569037538u, 1256170817u, 1037604311u, 2765210733u, 3554079995u,
-  1131014506u,  879679996u, 2909243462u, 3663771856u, 1141124467u,  855842277u, 2852801631u, 3708648649u,
-  1342533948u,  654459306u, 3188396048u, 3373015174u, 1466479909u,  544179635u, 3110523913u, 3462522015u,
-  1591671054u,  702138776u, 2966460450u, 3352799412u, 1504918807u,  783551873u, 3082640443u, 3233442989u,
-  3988292384u, 2596254646u,   62317068u, 1957810842u, 3939845945u, 2647816111u,   81470997u, 1943803523u,
-  3814918930u, 2489596804u,  225274430u, 2053790376u, 3826175755u, 2466906013u,  167816743u, 2097651377u,
-  4027552580u, 2265490386u,  503444072u, 1762050814u, 4150417245u, 2154129355u,  426522225u, 1852507879u,
-  4275313526u, 2312317920u,  282753626u, 1742555852u, 4189708143u, 2394877945u,  397917763u, 1622183637u,
-  3604390888u, 2714866558u,  953729732u, 1340076626u, 3518719985u, 2797360999u, 1068828381u, 1219638859u,
-  3624741850u, 2936675148u,  906185462u, 1090812512u, 3747672003u, 2825379669u,  829329135u, 1181335161u,
-  3412177804u, 3160834842u,  628085408u, 1382605366u, 3423369109u, 3138078467u,  570562233u, 1426400815u,
-  3317316542u, 2998733608u,  733239954u, 1555261956u, 3268935591u, 3050360625u,  752459403u, 1541320221u,
-  2607071920u, 3965973030u, 1969922972u,   40735498u, 2617837225u, 3943577151u, 1913087877u,   83908371u,
-  2512341634u, 3803740692u, 2075208622u,  213261112u, 2463272603u, 3855990285u, 2094854071u,  198958881u,
-  2262029012u, 4057260610u, 1759359992u,  534414190u, 2176718541u, 4139329115u, 1873836001u,  414664567u,
-  2282248934u, 4279200368u, 1711684554u,  285281116u, 2405801727u, 4167216745u, 1634467795u,  376229701u,
-  2685067896u, 3608007406u, 1308918612u,  956543938u, 2808555105u, 3495958263u, 1231636301u, 1047427035u,
-  2932959818u, 3654703836u, 1088359270u,  936918000u, 2847714899u, 3736837829u, 1202900863u,  817233897u,
-  3183342108u, 3401237130u, 1404277552u,  615818150u, 3134207493u, 3453421203u, 1423857449u,  601450431u,
-  3009837614u, 3294710456u, 1567103746u,  711928724u, 3020668471u, 3272380065u, 1510334235u,  755167117u
-};
-
 /*Return the CRC of the bytes buf[0..len-1].*/
 unsigned lodepng_crc32(const unsigned char* data, size_t length) {
-  unsigned r = 0xffffffffu;
-  size_t i;
-  for(i = 0; i < length; ++i) {
-    r = lodepng_crc32_table[(r ^ data[i]) & 0xffu] ^ (r >> 8u);
-  }
-  return r ^ 0xffffffffu;
+  /*slice-by-8, or carry-less multiplication folding where the cpu supports it*/
+  return checksum_crc32(0u, data, length);
 }
 #else /* !LODEPNG_NO_COMPILE_CRC */
 unsigned lodepng_crc32(const unsigned char* data, size_t length);
@@ -4068,6 +4943,205 @@ unsigned lodepng_inspect(unsigned* w, unsigned* h, LodePNGState* state,
   return state->error;
 }
 
+#if SIMD_SSE2
+/*
+SIMD unfiltering for the filters and pixel sizes that dominate texture decoding: Up for any pixel size, and Sub,
+Average and Paeth for 3 and 4 byte pixels. Those three depend on the pixel to the left, so pixels are done one after
+another with each one's bytes in parallel, except Sub which forms a prefix sum over a block of pixels.
+Pixels of 3 bytes are loaded and stored as exactly 3 bytes: recon may lag scanline in the same memory (Adam7), so
+nothing past the current pixel may be written before it has been read.
+*/
+static LODEPNG_INLINE __m128i loadPixelSSE2(const unsigned char* p, size_t bytewidth) {
+  int v = 0;
+  if(bytewidth == 4) {
+    memcpy(&v, p, 4);
+  } else {
+    unsigned short low;
+    memcpy(&low, p, 2);
+    v = (int)(low | ((unsigned)p[2] << 16u));
+  }
+  return _mm_cvtsi32_si128(v);
+}
+
+static LODEPNG_INLINE void storePixelSSE2(unsigned char* p, __m128i x, size_t bytewidth) {
+  int v = _mm_cvtsi128_si32(x);
+  if(bytewidth == 4) {
+    memcpy(p, &v, 4);
+  } else {
+    unsigned short low = (unsigned short)v;
+    memcpy(p, &low, 2);
+    p[2] = (unsigned char)(v >> 16);
+  }
+}
+
+static LODEPNG_INLINE void unfilterSubSSE2(unsigned char* recon, const unsigned char* scanline,
+                                           size_t bytewidth, size_t length) {
+  const __m128i mask3 = _mm_cvtsi32_si128(0xFFFFFF);
+  __m128i last = _mm_setzero_si128(); /*the previous pixel in every pixel of the block*/
+  size_t i = 0;
+  if(bytewidth == 4) {
+    for(; i + 16 <= length; i += 16) {
+      __m128i x = _mm_loadu_si128((const __m128i*)(scanline + i));
+      x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+      x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+      x = _mm_add_epi8(x, last);
+      _mm_storeu_si128((__m128i*)(recon + i), x);
+      last = _mm_shuffle_epi32(x, 0xFF);
+    }
+  } else {
+    for(; i + 16 <= length; i += 12) {
+      __m128i x = _mm_loadu_si128((const __m128i*)(scanline + i));
+      x = _mm_add_epi8(x, _mm_slli_si128(x, 3));
+      x = _mm_add_epi8(x, _mm_slli_si128(x, 6));
+      x = _mm_add_epi8(x, last);
+      _mm_storel_epi64((__m128i*)(recon + i), x);
+      storePixelSSE2(recon + i + 8, _mm_srli_si128(x, 8), 4);
+      last = _mm_and_si128(_mm_srli_si128(x, 9), mask3);
+      last = _mm_add_epi8(last, _mm_slli_si128(last, 3));
+      last = _mm_add_epi8(last, _mm_slli_si128(last, 6));
+    }
+  }
+  for(; i != length; ++i) recon[i] = scanline[i] + (i < bytewidth ? 0 : recon[i - bytewidth]);
+}
+
+static void unfilterUpSSE2(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon,
+                           size_t length) {
+  size_t i = 0;
+  for(; i + 16 <= length; i += 16) {
+    __m128i x = _mm_add_epi8(_mm_loadu_si128((const __m128i*)(scanline + i)),
+                             _mm_loadu_si128((const __m128i*)(precon + i)));
+    _mm_storeu_si128((__m128i*)(recon + i), x);
+  }
+  for(; i != length; ++i) recon[i] = scanline[i] + precon[i];
+}
+
+/*_mm_avg_epu8 rounds up, the filter rounds down, which differs exactly when the sum is odd*/
+static LODEPNG_INLINE void unfilterAverageSSE2(unsigned char* recon, const unsigned char* scanline,
+                                               const unsigned char* precon, size_t bytewidth, size_t length) {
+  const __m128i one = _mm_set1_epi8(1);
+  __m128i a = _mm_setzero_si128();
+  size_t i;
+  for(i = 0; i != length; i += bytewidth) {
+    __m128i b = loadPixelSSE2(precon + i, bytewidth);
+    __m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+    a = _mm_add_epi8(loadPixelSSE2(scanline + i, bytewidth), average);
+    storePixelSSE2(recon + i, a, bytewidth);
+  }
+}
+
+/*the predictor is chosen in 16 bit lanes, pa = |b - c|, pb = |a - c| and pc = |a + b - 2c| as in paethPredictor*/
+static LODEPNG_INLINE void unfilterPaethSSE2(unsigned char* recon, const unsigned char* scanline,
+                                             const unsigned char* precon, size_t bytewidth, size_t length) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i a = zero, c = zero;
+  size_t i;
+  for(i = 0; i != length; i += bytewidth) {
+    __m128i b = _mm_unpacklo_epi8(loadPixelSSE2(precon + i, bytewidth), zero);
+    __m128i pa = _mm_sub_epi16(b, c);
+    __m128i pb = _mm_sub_epi16(a, c);
+    __m128i pc = _mm_add_epi16(pa, pb);
+    __m128i use_b, use_c, predictor;
+    pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+    pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+    pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+    use_b = _mm_cmplt_epi16(pb, pa);
+    predictor = _mm_or_si128(_mm_and_si128(use_b, b), _mm_andnot_si128(use_b, a));
+    use_c = _mm_cmplt_epi16(pc, _mm_min_epi16(pa, pb));
+    predictor = _mm_or_si128(_mm_and_si128(use_c, c), _mm_andnot_si128(use_c, predictor));
+    a = _mm_add_epi8(loadPixelSSE2(scanline + i, bytewidth), _mm_packus_epi16(predictor, predictor));
+    storePixelSSE2(recon + i, a, bytewidth);
+    a = _mm_unpacklo_epi8(a, zero);
+    c = b;
+  }
+}
+
+#if SIMD_X86_DISPATCH
+SIMD_TARGET("ssse3") static LODEPNG_INLINE void unfilterPaethPixelsSSSE3(unsigned char* recon,
+    const unsigned char* scanline, const unsigned char* precon, size_t bytewidth, size_t length) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i a = zero, c = zero;
+  size_t i;
+  for(i = 0; i != length; i += bytewidth) {
+    __m128i b = _mm_unpacklo_epi8(loadPixelSSE2(precon + i, bytewidth), zero);
+    __m128i pa = _mm_sub_epi16(b, c);
+    __m128i pb = _mm_sub_epi16(a, c);
+    __m128i pc = _mm_abs_epi16(_mm_add_epi16(pa, pb));
+    __m128i use_b, use_c, predictor;
+    pa = _mm_abs_epi16(pa);
+    pb = _mm_abs_epi16(pb);
+    use_b = _mm_cmplt_epi16(pb, pa);
+    predictor = _mm_or_si128(_mm_and_si128(use_b, b), _mm_andnot_si128(use_b, a));
+    use_c = _mm_cmplt_epi16(pc, _mm_min_epi16(pa, pb));
+    predictor = _mm_or_si128(_mm_and_si128(use_c, c), _mm_andnot_si128(use_c, predictor));
+    a = _mm_add_epi8(loadPixelSSE2(scanline + i, bytewidth), _mm_packus_epi16(predictor, predictor));
+    storePixelSSE2(recon + i, a, bytewidth);
+    a = _mm_unpacklo_epi8(a, zero);
+    c = b;
+  }
+}
+
+SIMD_TARGET("ssse3") static void unfilterPaethSSSE3(unsigned char* recon, const unsigned char* scanline,
+                                                     const unsigned char* precon, size_t bytewidth, size_t length) {
+  if(bytewidth == 4) unfilterPaethPixelsSSSE3(recon, scanline, precon, 4, length);
+  else unfilterPaethPixelsSSSE3(recon, scanline, precon, 3, length);
+}
+
+SIMD_TARGET("avx2") static void unfilterUpAVX2(unsigned char* recon, const unsigned char* scanline,
+                                                const unsigned char* precon, size_t length) {
+  size_t i = 0;
+  for(; i + 32 <= length; i += 32) {
+    __m256i x = _mm256_add_epi8(_mm256_loadu_si256((const __m256i*)(scanline + i)),
+                                _mm256_loadu_si256((const __m256i*)(precon + i)));
+    _mm256_storeu_si256((__m256i*)(recon + i), x);
+  }
+  unfilterUpSSE2(recon + i, scanline + i, precon + i, length - i);
+}
+#endif /*SIMD_X86_DISPATCH*/
+
+/*returns nonzero if the scanline was unfiltered here, otherwise the portable code below handles it.
+The first scanline has no precon, there Paeth is Sub and Up is a copy, and Average is left to the portable code*/
+static int unfilterScanlineSIMD(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon,
+                                size_t bytewidth, unsigned char filterType, size_t length) {
+#if SIMD_X86_DISPATCH
+  unsigned features = simd_get_features();
+#endif
+  if(filterType == 2) {
+    if(!precon) return 0;
+#if SIMD_X86_DISPATCH
+    if(features & SIMD_FEATURE_AVX2) {
+      unfilterUpAVX2(recon, scanline, precon, length);
+      return 1;
+    }
+#endif
+    unfilterUpSSE2(recon, scanline, precon, length);
+    return 1;
+  }
+  if(bytewidth != 3 && bytewidth != 4) return 0;
+  if(filterType == 1 || (filterType == 4 && !precon)) {
+    if(bytewidth == 4) unfilterSubSSE2(recon, scanline, 4, length);
+    else unfilterSubSSE2(recon, scanline, 3, length);
+    return 1;
+  }
+  if(filterType == 3 && precon) {
+    if(bytewidth == 4) unfilterAverageSSE2(recon, scanline, precon, 4, length);
+    else unfilterAverageSSE2(recon, scanline, precon, 3, length);
+    return 1;
+  }
+  if(filterType == 4) {
+#if SIMD_X86_DISPATCH
+    if(features & SIMD_FEATURE_SSSE3) {
+      unfilterPaethSSSE3(recon, scanline, precon, bytewidth, length);
+      return 1;
+    }
+#endif
+    if(bytewidth == 4) unfilterPaethSSE2(recon, scanline, precon, 4, length);
+    else unfilterPaethSSE2(recon, scanline, precon, 3, length);
+    return 1;
+  }
+  return 0;
+}
+#endif /*SIMD_SSE2*/
+
 static unsigned unfilterScanline(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon,
                                  size_t bytewidth, unsigned char filterType, size_t length) {
   /*
@@ -4080,6 +5154,9 @@ static unsigned unfilterScanline(unsigned char* recon, const unsigned char* scan
   */
 
   size_t i;
+#if SIMD_SSE2
+  if(unfilterScanlineSIMD(recon, scanline, precon, bytewidth, filterType, length)) return 0;
+#endif
   switch(filterType) {
     case 0:
       for(i = 0; i != length; ++i) recon[i] = scanline[i];
@@ -4732,17 +5809,11 @@ unsigned lodepng_inspect_chunk(LodePNGState* state, size_t pos,
   return error;
 }
 
-/*read a PNG, the result will be in the same color type as the PNG (hence "generic")*/
-static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
-                          LodePNGState* state,
-                          const unsigned char* in, size_t insize) {
+/*reads the chunks following the header into state->info_png, and appends the data of the IDAT chunks to idat*/
+static void decodeChunks(LodePNGState* state, ucvector* idat, const unsigned char* in, size_t insize) {
   unsigned char IEND = 0;
   const unsigned char* chunk;
   size_t i;
-  ucvector idat; /*the data from idat chunks*/
-  unsigned char* scanlines = 0;
-  size_t scanlines_size = 0, expected_size = 0;
-  size_t outsize = 0;
 
   /*for unknown chunk order*/
   unsigned unknown = 0;
@@ -4750,19 +5821,6 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
   unsigned critical_pos = 1; /*1 = after IHDR, 2 = after PLTE, 3 = after IDAT*/
 #endif /*LODEPNG_COMPILE_ANCILLARY_CHUNKS*/
 
-
-  /* safe output values in case error happens */
-  *out = 0;
-  *w = *h = 0;
-
-  state->error = lodepng_inspect(w, h, state, in, insize); /*reads header and resets other parameters in state->info_png*/
-  if(state->error) return;
-
-  if(lodepng_pixel_overflow(*w, *h, &state->info_png.color, &state->info_raw)) {
-    CERROR_RETURN(state->error, 92); /*overflow possible due to amount of pixels*/
-  }
-
-  ucvector_init(&idat);
   chunk = &in[33]; /*first byte of the first chunk after the header*/
 
   /*loop through the chunks, ignoring unknown chunks and stopping at IEND chunk.
@@ -4795,11 +5853,11 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
 
     /*IDAT chunk, containing compressed image data*/
     if(lodepng_chunk_type_equals(chunk, "IDAT")) {
-      size_t oldsize = idat.size;
+      size_t oldsize = idat->size;
       size_t newsize;
       if(lodepng_addofl(oldsize, chunkLength, &newsize)) CERROR_BREAK(state->error, 95);
-      if(!ucvector_resize(&idat, newsize)) CERROR_BREAK(state->error, 83 /*alloc fail*/);
-      for(i = 0; i != chunkLength; ++i) idat.data[oldsize + i] = data[i];
+      if(!ucvector_resize(idat, newsize)) CERROR_BREAK(state->error, 83 /*alloc fail*/);
+      for(i = 0; i != chunkLength; ++i) idat->data[oldsize + i] = data[i];
 #ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
       critical_pos = 3;
 #endif /*LODEPNG_COMPILE_ANCILLARY_CHUNKS*/
@@ -4888,6 +5946,31 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
       && !state->info_png.color.palette) {
     state->error = 106; /* error: PNG file must have PLTE chunk if color type is palette */
   }
+}
+
+/*read a PNG, the result will be in the same color type as the PNG (hence "generic")*/
+static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
+                          LodePNGState* state,
+                          const unsigned char* in, size_t insize) {
+  size_t i;
+  ucvector idat; /*the data from idat chunks*/
+  unsigned char* scanlines = 0;
+  size_t scanlines_size = 0, expected_size = 0;
+  size_t outsize = 0;
+
+  /* safe output values in case error happens */
+  *out = 0;
+  *w = *h = 0;
+
+  state->error = lodepng_inspect(w, h, state, in, insize); /*reads header and resets other parameters in state->info_png*/
+  if(state->error) return;
+
+  if(lodepng_pixel_overflow(*w, *h, &state->info_png.color, &state->info_raw)) {
+    CERROR_RETURN(state->error, 92); /*overflow possible due to amount of pixels*/
+  }
+
+  ucvector_init(&idat);
+  decodeChunks(state, &idat, in, insize);
 
   /*predict output size, to allocate exact size for output buffer to avoid more dynamic allocation.
   If the decompressed size does not match the prediction, the image must be corrupt.*/
@@ -4933,10 +6016,277 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
   lodepng_free(scanlines);
 }
 
+/*a batch holds as many scanlines as fit in this many bytes, but at least one*/
+#define PIPELINE_BATCH 262144u
+/*amount of batches a ring holds*/
+#define PIPELINE_SLOTS 4u
+/*smaller images are not worth pipelining*/
+#define PIPELINE_MIN_BATCHES 8u
+/*inflate, unfilter and convert*/
+#define PIPELINE_STAGES 3u
+
+/*
+A lock-free ring of batches between two stages of the pipelined decoder, with one producer and one consumer. Each
+counter is only written by the stage on its side and published with release ordering. Nothing waits in here, a
+stage that cannot go on returns, and its thread looks for other work or blocks on the pipeline's event.
+*/
+typedef struct PipelineRing {
+  unsigned char* data; /*PIPELINE_SLOTS batches of batchsize bytes*/
+  size_t batchsize;
+  volatile size_t head; /*amount of batches produced*/
+  volatile size_t tail; /*amount of batches consumed, their slots can be produced into again*/
+  volatile size_t closed; /*set after the last batch, which is early if the producer failed*/
+} PipelineRing;
+
+/*returns the slot the next batch is produced into with pipelineRingPush, or NULL while every slot is in use*/
+static unsigned char* pipelineRingNextFree(PipelineRing* ring) {
+  if(ring->head - thread_pool_load_acquire(&ring->tail) == PIPELINE_SLOTS) return 0;
+  return ring->data + (ring->head % PIPELINE_SLOTS) * ring->batchsize;
+}
+
+static void pipelineRingPush(PipelineRing* ring) {
+  thread_pool_store_release(&ring->head, ring->head + 1u);
+}
+
+static void pipelineRingClose(PipelineRing* ring) {
+  thread_pool_store_release(&ring->closed, 1u);
+}
+
+/*returns the next batch, which stays valid until pipelineRingPop, or NULL while there is none, then *closed tells
+whether none will come anymore*/
+static const unsigned char* pipelineRingNext(PipelineRing* ring, unsigned* closed) {
+  /*the last batch is pushed before closing, so closed is read before head*/
+  *closed = thread_pool_load_acquire(&ring->closed) != 0;
+  if(thread_pool_load_acquire(&ring->head) == ring->tail) return 0;
+  *closed = 0;
+  return ring->data + (ring->tail % PIPELINE_SLOTS) * ring->batchsize;
+}
+
+static void pipelineRingPop(PipelineRing* ring) {
+  thread_pool_store_release(&ring->tail, ring->tail + 1u);
+}
+
+/*
+The stages of the pipelined decoder: inflate fills batches of filtered scanlines, unfilter turns them into rows of
+the PNG's color mode, straight into out if no conversion is needed, and convert puts those into out in the color
+mode of info_raw. A stage that fails keeps consuming without producing more, so that the stages before it still
+run to the end, and the error of the earliest stage is reported, as by the serial decoder. The state of each stage
+lives here rather than on a stack, as successive batches of one stage may be handled by different threads.
+*/
+typedef struct DecodePipeline {
+  const LodePNGState* state;
+  unsigned w, h;
+  unsigned rows; /*scanlines per batch*/
+  size_t bytewidth, linebytes, rowbytes;
+  unsigned convert;
+  unsigned char* out;
+  ScanlineStream stream; /*the compressed image data*/
+  PipelineRing filtered; /*scanlines with their filter type byte*/
+  PipelineRing unfiltered; /*only used if convert*/
+  unsigned inflate_y, unfilter_y, convert_y; /*the first row of the next batch of each stage*/
+  const unsigned char* prevline; /*the row unfiltered last*/
+  unsigned inflate_error, unfilter_error, convert_error;
+  volatile size_t busy[PIPELINE_STAGES]; /*set while a thread runs the stage*/
+  volatile size_t done[PIPELINE_STAGES]; /*set once the stage has finished*/
+  thread_pool_event progress; /*signalled whenever a stage went on*/
+} DecodePipeline;
+
+/*each stage handles at most one batch per call, returning 1 if it went on or finished, or 0 if it has to wait for
+another stage*/
+static unsigned pipelineInflate(DecodePipeline* p) {
+  const LodePNGDecompressSettings* settings = &p->state->decoder.zlibsettings;
+  if(p->inflate_y < p->h && !p->inflate_error) {
+    size_t size = LODEPNG_MIN(p->rows, p->h - p->inflate_y) * (1u + p->linebytes);
+    unsigned char* batch = pipelineRingNextFree(&p->filtered);
+    unsigned char* data;
+    if(!batch) return 0;
+    p->inflate_error = scanlineStreamNext(&p->stream, &data, size, settings);
+    if(!p->inflate_error) {
+      lodepng_memcpy(batch, data, size);
+      pipelineRingPush(&p->filtered);
+      p->inflate_y += p->rows;
+    }
+    return 1;
+  }
+  /*the batches are out already, a wrong adler32 or trailing data still fails the whole image*/
+  if(!p->inflate_error) p->inflate_error = scanlineStreamFinish(&p->stream, settings);
+  pipelineRingClose(&p->filtered);
+  thread_pool_store_release(&p->done[0], 1u);
+  return 1;
+}
+
+static unsigned pipelineUnfilter(DecodePipeline* p) {
+  unsigned closed, rows, i;
+  unsigned char* recon;
+  const unsigned char* batch = pipelineRingNext(&p->filtered, &closed);
+  if(!batch) {
+    if(!closed) return 0;
+    if(p->convert) pipelineRingClose(&p->unfiltered);
+    thread_pool_store_release(&p->done[1], 1u);
+    return 1;
+  }
+  if(!p->unfilter_error) {
+    rows = LODEPNG_MIN(p->rows, p->h - p->unfilter_y);
+    /*the previous batch of unfiltered rows is not produced into again before this one is pushed*/
+    recon = p->convert ? pipelineRingNextFree(&p->unfiltered) : p->out + (size_t)p->unfilter_y * p->rowbytes;
+    if(!recon) return 0;
+    for(i = 0; i != rows && !p->unfilter_error; ++i) {
+      const unsigned char* scanline = batch + i * (1u + p->linebytes);
+      p->unfilter_error = unfilterScanline(recon, scanline + 1, p->prevline, p->bytewidth, scanline[0], p->linebytes);
+      p->prevline = recon;
+      recon += p->linebytes;
+    }
+    if(!p->unfilter_error && p->convert) pipelineRingPush(&p->unfiltered);
+    p->unfilter_y += rows;
+  }
+  pipelineRingPop(&p->filtered);
+  return 1;
+}
+
+static unsigned pipelineConvert(DecodePipeline* p) {
+  unsigned closed;
+  const unsigned char* batch = pipelineRingNext(&p->unfiltered, &closed);
+  if(!batch) {
+    if(!closed) return 0;
+    thread_pool_store_release(&p->done[2], 1u);
+    return 1;
+  }
+  if(!p->convert_error) {
+    unsigned rows = LODEPNG_MIN(p->rows, p->h - p->convert_y);
+    /*rows end at a byte, so a batch converts as one image*/
+    p->convert_error = lodepng_convert(p->out + (size_t)p->convert_y * p->rowbytes, batch, &p->state->info_raw,
+                                       &p->state->info_png.color, p->w, rows);
+    p->convert_y += rows;
+  }
+  pipelineRingPop(&p->unfiltered);
+  return 1;
+}
+
+/*
+Takes part in the pipeline until every stage is done. A stage no thread is running is taken over and run for as
+long as it can go on, so the stages need not get a thread each: if every worker of the pool is busy, the calling
+thread decodes the whole image by itself. A thread finding nothing to do blocks until a stage went on elsewhere.
+*/
+static void pipelineRun(void* context) {
+  static unsigned (*const stages[PIPELINE_STAGES])(DecodePipeline*) = {
+    pipelineInflate, pipelineUnfilter, pipelineConvert
+  };
+  DecodePipeline* p = (DecodePipeline*)context;
+  unsigned i;
+  for(;;) {
+    /*read before looking for work, so that progress made meanwhile ends the wait below*/
+    size_t count = thread_pool_event_get_count(&p->progress);
+    unsigned finished = 1, progressed = 0;
+    for(i = 0; i != PIPELINE_STAGES; ++i) {
+      if(thread_pool_load_acquire(&p->done[i])) continue;
+      finished = 0;
+      if(thread_pool_exchange(&p->busy[i], 1u)) continue;
+      while(!p->done[i] && stages[i](p)) {
+        thread_pool_event_signal(&p->progress);
+        progressed = 1;
+      }
+      thread_pool_store_release(&p->busy[i], 0u);
+    }
+    if(finished) return;
+    if(!progressed) thread_pool_event_wait(&p->progress, count);
+  }
+}
+
+/*
+Decodes like decodeGeneric followed by the color conversion of lodepng_decode, with the stages of DecodePipeline
+spread over the calling thread and the workers of decoder.pool. Returns 0 without decoding if the image is not
+suited to it, then decoding should go on serially.
+*/
+static unsigned decodePipelined(unsigned char** out, unsigned* w, unsigned* h,
+                                LodePNGState* state,
+                                const unsigned char* in, size_t insize) {
+  DecodePipeline p;
+  ucvector idat; /*the data from idat chunks*/
+  thread_pool* pool = state->decoder.pool;
+  thread_pool_group group = { 0 };
+  unsigned bpp, obpp, i, helpers;
+  const LodePNGDecompressSettings* zlibsettings = &state->decoder.zlibsettings;
+
+  *out = 0;
+  if(lodepng_inspect(w, h, state, in, insize)) return 0; /*the serial decoder reports the error*/
+  if(lodepng_pixel_overflow(*w, *h, &state->info_png.color, &state->info_raw)) return 0;
+  if(state->info_png.interlace_method != 0 || zlibsettings->custom_zlib
+     || (zlibsettings->custom_inflate && zlibsettings->custom_inflate != lodepng_inflate_fast)) return 0;
+  bpp = lodepng_get_bpp(&state->info_png.color);
+  obpp = state->decoder.color_convert ? lodepng_get_bpp(&state->info_raw) : bpp;
+  /*batches of rows are contiguous in out only if the rows end at a byte*/
+  if(((size_t)*w * bpp) % 8u != 0 || ((size_t)*w * obpp) % 8u != 0) return 0;
+
+  p.state = state;
+  p.w = *w;
+  p.h = *h;
+  p.bytewidth = (bpp + 7u) / 8u;
+  p.linebytes = (size_t)*w * bpp / 8u;
+  p.rowbytes = (size_t)*w * obpp / 8u;
+  p.rows = (unsigned)LODEPNG_MAX(1u, LODEPNG_MIN(PIPELINE_BATCH / (1u + p.linebytes), *h));
+  if(*h / p.rows < PIPELINE_MIN_BATCHES) return 0;
+  if(!init_thread_pool_event(&p.progress)) return 0;
+
+  ucvector_init(&idat);
+  decodeChunks(state, &idat, in, insize);
+
+  p.convert = state->decoder.color_convert && !lodepng_color_mode_equal(&state->info_raw, &state->info_png.color);
+  if(state->error) {
+    /*already failed reading the chunks*/
+  } else if(!state->decoder.color_convert) {
+    state->error = lodepng_color_mode_copy(&state->info_raw, &state->info_png.color);
+  } else if(p.convert && !(state->info_raw.colortype == LCT_RGB || state->info_raw.colortype == LCT_RGBA)
+            && !(state->info_raw.bitdepth == 8)) {
+    state->error = 56; /*unsupported color mode conversion*/
+  }
+
+  p.filtered.batchsize = p.rows * (1u + p.linebytes);
+  p.unfiltered.batchsize = p.rows * p.linebytes;
+  p.filtered.head = p.filtered.tail = p.filtered.closed = 0;
+  p.unfiltered.head = p.unfiltered.tail = p.unfiltered.closed = 0;
+  p.inflate_y = p.unfilter_y = p.convert_y = 0;
+  p.prevline = 0;
+  p.inflate_error = p.unfilter_error = p.convert_error = 0;
+  for(i = 0; i != PIPELINE_STAGES; ++i) p.busy[i] = p.done[i] = 0;
+  p.done[2] = !p.convert;
+  p.stream.f = 0;
+  p.filtered.data = p.unfiltered.data = 0;
+  p.out = 0;
+  if(!state->error) {
+    p.out = (unsigned char*)lodepng_malloc(lodepng_get_raw_size(*w, *h, &state->info_raw));
+    p.filtered.data = (unsigned char*)lodepng_malloc(PIPELINE_SLOTS * p.filtered.batchsize);
+    if(p.convert) p.unfiltered.data = (unsigned char*)lodepng_malloc(PIPELINE_SLOTS * p.unfiltered.batchsize);
+    if(!p.out || !p.filtered.data || (p.convert && !p.unfiltered.data)) state->error = 83; /*alloc fail*/
+  }
+
+  if(!state->error) {
+    /*a bad zlib header is reported by the inflate stage, after which the pipeline just winds down*/
+    p.inflate_error = scanlineStreamInit(&p.stream, idat.data, idat.size, p.filtered.batchsize);
+    /*the calling thread takes part as well, a job that gets to run after the stages are done returns at once*/
+    helpers = LODEPNG_MIN(pool->thread_count, PIPELINE_STAGES - 1u - p.done[2]);
+    for(i = 0; i != helpers; ++i) thread_pool_push(pool, &group, pipelineRun, &p);
+    pipelineRun(&p);
+    thread_pool_wait(pool, &group);
+    if(p.inflate_error) state->error = p.inflate_error;
+    else if(p.unfilter_error) state->error = p.unfilter_error;
+    else state->error = p.convert_error;
+  }
+
+  if(!state->error) *out = p.out;
+  else lodepng_free(p.out);
+  scanlineStreamCleanup(&p.stream);
+  lodepng_free(p.filtered.data);
+  lodepng_free(p.unfiltered.data);
+  ucvector_cleanup(&idat);
+  final_thread_pool_event(&p.progress);
+  return 1;
+}
+
 unsigned lodepng_decode(unsigned char** out, unsigned* w, unsigned* h,
                         LodePNGState* state,
                         const unsigned char* in, size_t insize) {
   *out = 0;
+  if(state->decoder.pool && decodePipelined(out, w, h, state, in, insize)) return state->error;
   decodeGeneric(out, w, h, state, in, insize);
   if(state->error) return state->error;
   if(!state->decoder.color_convert || lodepng_color_mode_equal(&state->info_raw, &state->info_png.color)) {
@@ -4970,6 +6320,160 @@ unsigned lodepng_decode(unsigned char** out, unsigned* w, unsigned* h,
   return state->error;
 }
 
+/*puts an unfiltered line of w pixels in the color mode of the PNG into row, in the color mode of info_raw*/
+static unsigned rowFromLine(unsigned char* row, const unsigned char* line, unsigned w,
+                            unsigned convert, const LodePNGState* state) {
+  size_t i, numbits, numbytes;
+  if(convert) return lodepng_convert(row, line, &state->info_raw, &state->info_png.color, w, 1);
+  numbits = (size_t)w * lodepng_get_bpp(&state->info_png.color);
+  numbytes = (numbits + 7u) / 8u;
+  for(i = 0; i != numbytes; ++i) row[i] = line[i];
+  /*the padding bits of the line take part in unfiltering the next one, but are cleared in the row*/
+  if(numbits & 7u) row[numbytes - 1] &= (unsigned char)(0xff00u >> (numbits & 7u));
+  return 0;
+}
+
+/*
+Decodes the image a scanline at a time, inflating only as much as the next scanline needs. The rows, in the color
+mode of info_raw, are written rowpitch bytes apart into out if it is not NULL, else given to the callback in order.
+*/
+static void decodeRows(unsigned char* out, size_t outsize, size_t rowpitch,
+                       LodePNGRowCallback callback, void* user,
+                       unsigned* w, unsigned* h, LodePNGState* state,
+                       const unsigned char* in, size_t insize) {
+  ucvector idat; /*the data from idat chunks*/
+  ScanlineStream stream;
+  unsigned char* buffer = 0;
+  unsigned char *prevline, *line, *swap; /*the previous and the current unfiltered line*/
+  unsigned char* row; /*the current line in the color mode of info_raw*/
+  unsigned convert, bpp, obpp, x, y, i;
+  size_t bytewidth, linebytes, rowbytes, lastrow;
+
+  *w = *h = 0;
+  state->error = lodepng_inspect(w, h, state, in, insize); /*reads header and resets other parameters in state->info_png*/
+  if(state->error) return;
+
+  if(lodepng_pixel_overflow(*w, *h, &state->info_png.color, &state->info_raw)) {
+    CERROR_RETURN(state->error, 92); /*overflow possible due to amount of pixels*/
+  }
+  bpp = lodepng_get_bpp(&state->info_png.color);
+  obpp = state->decoder.color_convert ? lodepng_get_bpp(&state->info_raw) : bpp;
+  bytewidth = (bpp + 7u) / 8u;
+  linebytes = ((size_t)*w * bpp + 7u) / 8u;
+  rowbytes = ((size_t)*w * obpp + 7u) / 8u;
+  if(out) {
+    if(rowpitch < rowbytes) CERROR_RETURN(state->error, 109);
+    if(lodepng_mulofl(*h - 1u, rowpitch, &lastrow) || lodepng_gtofl(lastrow, rowbytes, outsize)) {
+      CERROR_RETURN(state->error, 109);
+    }
+  } else if(state->info_png.interlace_method != 0) {
+    CERROR_RETURN(state->error, 110); /*a row is only done after the last pass*/
+  }
+
+  ucvector_init(&idat);
+  decodeChunks(state, &idat, in, insize);
+  if(state->error) {
+    ucvector_cleanup(&idat);
+    return;
+  }
+
+  /*the palette is known now, so the color modes can be compared*/
+  convert = state->decoder.color_convert && !lodepng_color_mode_equal(&state->info_raw, &state->info_png.color);
+  if(!state->decoder.color_convert) {
+    state->error = lodepng_color_mode_copy(&state->info_raw, &state->info_png.color);
+  } else if(convert && !(state->info_raw.colortype == LCT_RGB || state->info_raw.colortype == LCT_RGBA)
+            && !(state->info_raw.bitdepth == 8)) {
+    state->error = 56; /*unsupported color mode conversion*/
+  }
+  if(state->error) {
+    ucvector_cleanup(&idat);
+    return;
+  }
+
+  state->error = scanlineStreamInit(&stream, idat.data, idat.size, 1u + linebytes);
+  if(!state->error) {
+    buffer = (unsigned char*)lodepng_malloc(linebytes * 2u + rowbytes);
+    if(!buffer) state->error = 83; /*alloc fail*/
+  }
+  prevline = buffer;
+  line = buffer + linebytes;
+  row = buffer + linebytes * 2u;
+
+  if(!state->error && state->info_png.interlace_method == 0) {
+    for(y = 0; y != *h && !state->error; ++y) {
+      unsigned char* scanline; /*the filtered line, with the filter type byte*/
+      unsigned char* target = out ? out + (size_t)y * rowpitch : row;
+      state->error = scanlineStreamNext(&stream, &scanline, 1u + linebytes, &state->decoder.zlibsettings);
+      if(!state->error) {
+        state->error = unfilterScanline(line, scanline + 1, y ? prevline : 0, bytewidth, scanline[0], linebytes);
+      }
+      if(!state->error) state->error = rowFromLine(target, line, *w, convert, state);
+      if(!state->error && !out) state->error = callback(user, y, row);
+      swap = prevline;
+      prevline = line;
+      line = swap;
+    }
+  } else if(!state->error) /*Adam7: each pass is a reduced image, its pixels are scattered over the rows of out*/ {
+    unsigned passw[7], passh[7];
+    size_t filter_passstart[8], padded_passstart[8], passstart[8];
+    Adam7_getpassvalues(passw, passh, filter_passstart, padded_passstart, passstart, *w, *h, bpp);
+    for(i = 0; i != 7 && !state->error; ++i) {
+      size_t passbytes = ((size_t)passw[i] * bpp + 7u) / 8u;
+      for(y = 0; y < passh[i]; ++y) {
+        unsigned char* scanline;
+        unsigned char* target = out + (ADAM7_IY[i] + (size_t)y * ADAM7_DY[i]) * rowpitch;
+        state->error = scanlineStreamNext(&stream, &scanline, 1u + passbytes, &state->decoder.zlibsettings);
+        if(!state->error) {
+          state->error = unfilterScanline(line, scanline + 1, y ? prevline : 0, bytewidth, scanline[0], passbytes);
+        }
+        if(!state->error) state->error = rowFromLine(row, line, passw[i], convert, state);
+        if(state->error) break;
+        if(obpp >= 8) {
+          size_t b, pixelbytes = obpp / 8u;
+          for(x = 0; x != passw[i]; ++x) {
+            unsigned char* pixel = target + (ADAM7_IX[i] + (size_t)x * ADAM7_DX[i]) * pixelbytes;
+            for(b = 0; b != pixelbytes; ++b) pixel[b] = row[x * pixelbytes + b];
+          }
+        } else {
+          size_t ibp = 0, obp; /*bit pointers (for row and target)*/
+          unsigned b;
+          for(x = 0; x != passw[i]; ++x) {
+            obp = (ADAM7_IX[i] + (size_t)x * ADAM7_DX[i]) * obpp;
+            for(b = 0; b != obpp; ++b) setBitOfReversedStream(&obp, target, readBitFromReversedStream(&ibp, row));
+          }
+        }
+        swap = prevline;
+        prevline = line;
+        line = swap;
+      }
+    }
+    /*like rowFromLine, clear the bits past the last pixel, which no pass sets*/
+    if(!state->error && (((size_t)*w * obpp) & 7u)) {
+      unsigned char mask = (unsigned char)(0xff00u >> (((size_t)*w * obpp) & 7u));
+      for(y = 0; y != *h; ++y) out[(size_t)y * rowpitch + rowbytes - 1u] &= mask;
+    }
+  }
+  if(!state->error) state->error = scanlineStreamFinish(&stream, &state->decoder.zlibsettings);
+
+  lodepng_free(buffer);
+  scanlineStreamCleanup(&stream);
+  ucvector_cleanup(&idat);
+}
+
+unsigned lodepng_decode_rows(unsigned* w, unsigned* h, LodePNGState* state,
+                             const unsigned char* in, size_t insize,
+                             LodePNGRowCallback callback, void* user) {
+  decodeRows(0, 0, 0, callback, user, w, h, state, in, insize);
+  return state->error;
+}
+
+unsigned lodepng_decode_into(unsigned char* out, size_t outsize, size_t rowpitch,
+                             unsigned* w, unsigned* h, LodePNGState* state,
+                             const unsigned char* in, size_t insize) {
+  decodeRows(out, outsize, rowpitch, 0, 0, w, h, state, in, insize);
+  return state->error;
+}
+
 unsigned lodepng_decode_memory(unsigned char** out, unsigned* w, unsigned* h, const unsigned char* in,
                                size_t insize, LodePNGColorType colortype, unsigned bitdepth) {
   unsigned error;
@@ -5016,6 +6520,7 @@ unsigned lodepng_decode24_file(unsigned char** out, unsigned* w, unsigned* h, co
 
 void lodepng_decoder_settings_init(LodePNGDecoderSettings* settings) {
   settings->color_convert = 1;
+  settings->pool = 0;
 #ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
   settings->read_text_chunks = 1;
   settings->remember_unknown_chunks = 0;
@@ -6196,6 +7701,8 @@ const char* lodepng_error_text(unsigned code) {
     case 106: return "PNG file must have PLTE chunk if color type is palette";
     case 107: return "color convert from palette mode requested without setting the palette data in it";
     case 108: return "tried to add more than 256 values to a palette";
+    case 109: return "row pitch or output buffer too small for the image";
+    case 110: return "interlaced image can not be decoded row by row";
   }
   return "unknown error code";
 }
@@ -28,6 +28,8 @@ freely, subject to the following restrictions:
 
 #include <string.h> /*for size_t*/
 
+#include "thread_pool.h"
+
 extern const char* LODEPNG_VERSION_STRING;
 
 /*
@@ -274,7 +276,7 @@ struct LodePNGDecompressSettings {
   unsigned (*custom_zlib)(unsigned char**, size_t*,
                           const unsigned char*, size_t,
                           const LodePNGDecompressSettings*);
-  /*use custom deflate decoder instead of built in one (default: null)
+  /*use custom deflate decoder instead of built in one (default: lodepng_inflate_fast)
   if custom_zlib is not null, custom_inflate is ignored (the zlib format uses deflate)*/
   unsigned (*custom_inflate)(unsigned char**, size_t*,
                              const unsigned char*, size_t,
@@ -301,6 +303,14 @@ struct LodePNGCompressSettings /*deflate = compress*/ {
   unsigned minmatch; /*minimum lz77 length. 3 is normally best, 6 can be better for some PNGs. Default: 0*/
   unsigned nicematch; /*stop searching if >= this length found. Set to 258 for best compression. Default: 128*/
   unsigned lazymatching; /*use lazy matching: better compression but a bit slower. Default: true*/
+  /*if nonzero, deflate in chunks of at least 256KB, each chunk using the window before it as dictionary, as pigz
+  does, so that they can be compressed in parallel. At most this many chunks are compressed at once, on the pool and
+  the calling thread. The output depends only on whether this is nonzero, not on its value, and costs a few bytes per
+  chunk over one stream. No threads are started for it, see pool. Default: 0*/
+  unsigned numthreads;
+  /*if not NULL and numthreads is nonzero, the chunks are compressed across this pool and the calling thread,
+  otherwise on the calling thread alone. Default: NULL*/
+  thread_pool* pool;
 
   /*use custom zlib encoder instead of built in one (default: null)*/
   unsigned (*custom_zlib)(unsigned char**, size_t*,
@@ -637,6 +647,14 @@ typedef struct LodePNGDecoderSettings {
 
   unsigned color_convert; /*whether to convert the PNG to the color type you want. Default: yes*/
 
+  /*if not NULL, lodepng_decode inflates, unfilters and converts the colors of large images as a pipeline of stages
+  on this pool, passing batches of scanlines between them, which lowers the latency of a single image. Rows depend on
+  each other so no stage is split up, the stages only overlap. The calling thread takes part, and any stage no
+  thread is running is taken over, so decoding from a job of the same pool cannot deadlock. Images that are
+  interlaced, have rows not ending at a byte, or use custom_zlib or a custom_inflate, are decoded as usual.
+  Default: NULL*/
+  thread_pool* pool;
+
 #ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
   unsigned read_text_chunks; /*if false but remember_unknown_chunks is true, they're stored in the unknown chunks*/
   /*store all bytes from unknown chunks in the LodePNGInfo (off by default, useful for a png editor)*/
@@ -762,6 +780,39 @@ unsigned lodepng_decode(unsigned char** out, unsigned* w, unsigned* h,
                         LodePNGState* state,
                         const unsigned char* in, size_t insize);
 
+/*
+Called by lodepng_decode_rows with each row y of the image, from top to bottom.
+row holds the pixels in the color mode of info_raw and is only valid during the
+call. Return 0 to continue, anything else stops decoding and is returned as the
+error.
+*/
+typedef unsigned (*LodePNGRowCallback)(void* user, unsigned y, const unsigned char* row);
+
+/*
+Same as lodepng_decode, but the image is decoded a scanline at a time and never
+allocated as a whole: the compressed data is inflated only as far as the next
+scanline needs, and each row is given to the callback once it is unfiltered and
+converted. w and h are set before the first call of the callback.
+Interlaced images are not supported (error 110), since their rows are only done
+after the last pass, use lodepng_decode_into for those.
+The built in inflate is always used, custom_zlib and custom_inflate are ignored.
+*/
+unsigned lodepng_decode_rows(unsigned* w, unsigned* h, LodePNGState* state,
+                             const unsigned char* in, size_t insize,
+                             LodePNGRowCallback callback, void* user);
+
+/*
+Same as lodepng_decode_rows, but writes the rows into a buffer the caller owns,
+such as a mapped pixel buffer object: row y starts at out + y * rowpitch, and each
+row starts at a byte even if the pixels are smaller. Error 109 if rowpitch is
+smaller than a row, or outsize smaller than the image with that pitch; use
+lodepng_inspect first to get the size. Interlaced images are supported here.
+The built in inflate is always used, custom_zlib and custom_inflate are ignored.
+*/
+unsigned lodepng_decode_into(unsigned char* out, size_t outsize, size_t rowpitch,
+                             unsigned* w, unsigned* h, LodePNGState* state,
+                             const unsigned char* in, size_t insize);
+
 /*
 Read the PNG header, but not the actual data. This returns only the information
 that is in the IHDR chunk of the PNG, such as width, height and color type. The
@@ -903,6 +954,16 @@ unsigned lodepng_inflate(unsigned char** out, size_t* outsize,
                          const unsigned char* in, size_t insize,
                          const LodePNGDecompressSettings* settings);
 
+/*
+Inflates like lodepng_inflate, with a table driven decoder about twice as fast. This is the
+default custom_inflate of LodePNGDecompressSettings, lodepng_inflate is the reference it matches.
+Either, *out must be NULL, or, *out must be a valid buffer and *outsize its size in bytes, which
+is then used for the output before reallocating.
+*/
+unsigned lodepng_inflate_fast(unsigned char** out, size_t* outsize,
+                              const unsigned char* in, size_t insize,
+                              const LodePNGDecompressSettings* settings);
+
 /*
 Decompresses Zlib data. Reallocates the out buffer and appends the data. The
 data must be according to the zlib specification.
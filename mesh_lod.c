@@ -0,0 +1,627 @@
+#include "mesh_lod.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the most collapse passes spent reaching a single level before settling for what was reached */
+#define MESH_LOD_MAX_PASSES 128
+
+/* the area weighted sum of squared distances to planes, w is the total area so the error can be averaged */
+typedef struct {
+
+	double a00, a01, a02, a11, a12, a22;
+	double b0, b1, b2;
+	double c;
+	double w;
+} mesh_lod_quadric;
+
+typedef struct {
+
+	float cost;
+	unsigned int from;
+	unsigned int to;
+} mesh_lod_collapse;
+
+typedef struct {
+
+	mesh_lod_job* job;
+	unsigned int vertex_count;
+	float* positions;
+	unsigned char* locked;
+	mesh_lod_quadric* quadrics;
+	unsigned int* remap;
+	unsigned char* used;
+	unsigned int* adjacency_offsets;
+	unsigned int* adjacency;
+	mesh_lod_collapse* collapses;
+} mesh_lod_state;
+
+static unsigned int mesh_lod_read_index(const index_buffer* t_buffer, size_t t_index) {
+
+	if (t_buffer->type == GL_UNSIGNED_BYTE) {
+
+		return ((const unsigned char*)t_buffer->buffer)[t_index];
+	}
+	if (t_buffer->type == GL_UNSIGNED_SHORT) {
+
+		return ((const unsigned short*)t_buffer->buffer)[t_index];
+	}
+	return ((const unsigned int*)t_buffer->buffer)[t_index];
+}
+
+static size_t mesh_lod_get_index_size(unsigned int t_type) {
+
+	if (t_type == GL_UNSIGNED_BYTE) {
+
+		return sizeof(unsigned char);
+	}
+	if (t_type == GL_UNSIGNED_SHORT) {
+
+		return sizeof(unsigned short);
+	}
+	return sizeof(unsigned int);
+}
+
+static const float* mesh_lod_get_element(const vertex_attribute* t_attribute, unsigned int t_vertex) {
+
+	size_t stride = t_attribute->stride ? t_attribute->stride : t_attribute->size * sizeof(float);
+	return (const float*)((const char*)t_attribute->buffer + stride * t_vertex);
+}
+
+static unsigned int mesh_lod_hash_position(const float* t_position) {
+
+	unsigned int bits[3];
+	memcpy(bits, t_position, sizeof(bits));
+	return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+}
+
+/* hashes the position and every attribute of a vertex, equal vertices hash equally */
+static unsigned int mesh_lod_hash_vertex(const mesh_lod_job* t_job, unsigned int t_vertex) {
+
+	unsigned int hash = mesh_lod_hash_position(mesh_lod_get_element(t_job->position, t_vertex));
+	unsigned int i, j, bits;
+	for (i = 0; i < t_job->attribute_count; ++i) {
+
+		const float* element = mesh_lod_get_element(t_job->attributes + i, t_vertex);
+		for (j = 0; j < t_job->attributes[i].size; ++j) {
+
+			memcpy(&bits, element + j, sizeof(bits));
+			hash = (hash ^ bits) * 16777619u;
+		}
+	}
+	return hash;
+}
+
+static int mesh_lod_is_same_vertex(const mesh_lod_job* t_job, unsigned int t_a, unsigned int t_b) {
+
+	unsigned int i;
+	if (memcmp(mesh_lod_get_element(t_job->position, t_a), mesh_lod_get_element(t_job->position, t_b), sizeof(float) * 3)) {
+
+		return 0;
+	}
+	for (i = 0; i < t_job->attribute_count; ++i) {
+
+		const vertex_attribute* attribute = t_job->attributes + i;
+		if (memcmp(mesh_lod_get_element(attribute, t_a), mesh_lod_get_element(attribute, t_b), sizeof(float) * attribute->size)) {
+
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int mesh_lod_compare_edges(const void* t_a, const void* t_b) {
+
+	unsigned long long a = *(const unsigned long long*)t_a;
+	unsigned long long b = *(const unsigned long long*)t_b;
+	return (a > b) - (a < b);
+}
+
+static int mesh_lod_compare_collapses(const void* t_a, const void* t_b) {
+
+	const mesh_lod_collapse* a = t_a;
+	const mesh_lod_collapse* b = t_b;
+	if (a->cost != b->cost) {
+
+		return a->cost < b->cost ? -1 : 1;
+	}
+	if (a->from != b->from) {
+
+		return a->from < b->from ? -1 : 1;
+	}
+	return (a->to > b->to) - (a->to < b->to);
+}
+
+static void mesh_lod_quadric_add(mesh_lod_quadric* t_quadric, const mesh_lod_quadric* t_other) {
+
+	t_quadric->a00 += t_other->a00; t_quadric->a01 += t_other->a01; t_quadric->a02 += t_other->a02;
+	t_quadric->a11 += t_other->a11; t_quadric->a12 += t_other->a12; t_quadric->a22 += t_other->a22;
+	t_quadric->b0 += t_other->b0; t_quadric->b1 += t_other->b1; t_quadric->b2 += t_other->b2;
+	t_quadric->c += t_other->c;
+	t_quadric->w += t_other->w;
+}
+
+/* returns the mean squared distance to the planes of the quadric, independent of the area and count of its triangles */
+static double mesh_lod_quadric_evaluate(const mesh_lod_quadric* t_quadric, const float* t_position) {
+
+	double x = t_position[0], y = t_position[1], z = t_position[2];
+	double result
+		= t_quadric->a00 * x * x + t_quadric->a11 * y * y + t_quadric->a22 * z * z
+		+ 2.0 * (t_quadric->a01 * x * y + t_quadric->a02 * x * z + t_quadric->a12 * y * z)
+		+ 2.0 * (t_quadric->b0 * x + t_quadric->b1 * y + t_quadric->b2 * z)
+		+ t_quadric->c;
+	return result > 0.0 && t_quadric->w > 0.0 ? result / t_quadric->w : 0.0;
+}
+
+static void mesh_lod_triangle_normal(const float* t_a, const float* t_b, const float* t_c, double* t_out) {
+
+	double e0[3] = { t_b[0] - t_a[0], t_b[1] - t_a[1], t_b[2] - t_a[2] };
+	double e1[3] = { t_c[0] - t_a[0], t_c[1] - t_a[1], t_c[2] - t_a[2] };
+	t_out[0] = e0[1] * e1[2] - e0[2] * e1[1];
+	t_out[1] = e0[2] * e1[0] - e0[0] * e1[2];
+	t_out[2] = e0[0] * e1[1] - e0[1] * e1[0];
+}
+
+static int mesh_lod_prepare(mesh_lod_state* t_state, unsigned int* t_indices, unsigned int t_index_count) {
+
+	mesh_lod_job* job = t_state->job;
+	unsigned int vertex_count = t_state->vertex_count;
+	unsigned int i, j;
+	float minimum[3] = { 0.0f, 0.0f, 0.0f }, maximum[3] = { 0.0f, 0.0f, 0.0f }, scale = 0.0f;
+
+	/* positions are normalized to the unit extent so errors are comparable across meshes */
+	for (i = 0; i < vertex_count; ++i) {
+
+		const float* position = mesh_lod_get_element(job->position, i);
+		for (j = 0; j < 3; ++j) {
+
+			minimum[j] = (i == 0 || position[j] < minimum[j]) ? position[j] : minimum[j];
+			maximum[j] = (i == 0 || position[j] > maximum[j]) ? position[j] : maximum[j];
+		}
+	}
+	for (j = 0; j < 3; ++j) {
+
+		scale = maximum[j] - minimum[j] > scale ? maximum[j] - minimum[j] : scale;
+	}
+	scale = scale > 0.0f ? 1.0f / scale : 1.0f;
+	for (i = 0; i < vertex_count; ++i) {
+
+		const float* position = mesh_lod_get_element(job->position, i);
+		for (j = 0; j < 3; ++j) {
+
+			t_state->positions[i * 3 + j] = (position[j] - minimum[j]) * scale;
+		}
+	}
+
+	/* vertices equal in position and every attribute are welded to the first of them, so per corner vertex streams
+	 * simplify as one connected surface, while twins that only share a position stay apart across a seam */
+	unsigned int table_size = 1;
+	while (table_size < vertex_count * 2) {
+
+		table_size <<= 1;
+	}
+	unsigned int* table = malloc(sizeof(unsigned int) * table_size);
+	unsigned int* welded = malloc(sizeof(unsigned int) * (vertex_count ? vertex_count : 1));
+	unsigned long long* edges = malloc(sizeof(unsigned long long) * (t_index_count ? t_index_count : 1));
+	if (!table || !welded || !edges) {
+
+		free(table);
+		free(welded);
+		free(edges);
+		return 0;
+	}
+	memset(table, 0xff, sizeof(unsigned int) * table_size);
+	for (i = 0; i < vertex_count; ++i) {
+
+		unsigned int slot = mesh_lod_hash_vertex(job, i) & (table_size - 1);
+		while (table[slot] != ~0u && !mesh_lod_is_same_vertex(job, table[slot], i)) {
+
+			slot = (slot + 1) & (table_size - 1);
+		}
+		if (table[slot] == ~0u) {
+
+			table[slot] = i;
+		}
+		welded[i] = table[slot];
+	}
+	for (i = 0; i < t_index_count; ++i) {
+
+		t_indices[i] = welded[t_indices[i]];
+	}
+
+	/* edges used by a single welded triangle are borders or attribute seams, where the twins across the edge differ
+	 * in an attribute, and edges used by more than two are non-manifold, the vertices of all of them are kept */
+	unsigned int edge_count = 0;
+	for (i = 0; i + 2 < t_index_count; i += 3) {
+
+		for (j = 0; j < 3; ++j) {
+
+			unsigned int a = t_indices[i + j];
+			unsigned int b = t_indices[i + (j + 1) % 3];
+			if (a != b) {
+
+				edges[edge_count++] = a < b ? ((unsigned long long)a << 32) | b : ((unsigned long long)b << 32) | a;
+			}
+		}
+	}
+	qsort(edges, edge_count, sizeof(unsigned long long), mesh_lod_compare_edges);
+	for (i = 0; i < edge_count; i = j) {
+
+		for (j = i + 1; j < edge_count && edges[j] == edges[i]; ++j) {}
+		if (j - i != 2) {
+
+			t_state->locked[(unsigned int)(edges[i] >> 32)] = 1;
+			t_state->locked[(unsigned int)edges[i]] = 1;
+		}
+	}
+
+	/* every triangle contributes its area weighted plane to the quadric of each of its corners */
+	memset(t_state->quadrics, 0, sizeof(mesh_lod_quadric) * vertex_count);
+	for (i = 0; i + 2 < t_index_count; i += 3) {
+
+		const float* p0 = t_state->positions + t_indices[i] * 3;
+		double normal[3];
+		mesh_lod_triangle_normal(p0, t_state->positions + t_indices[i + 1] * 3, t_state->positions + t_indices[i + 2] * 3, normal);
+		double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		if (length <= 0.0) {
+
+			continue;
+		}
+		double area = length * 0.5;
+		double a = normal[0] / length, b = normal[1] / length, c = normal[2] / length;
+		double d = -(a * p0[0] + b * p0[1] + c * p0[2]);
+		mesh_lod_quadric plane = {
+			area * a * a, area * a * b, area * a * c, area * b * b, area * b * c, area * c * c,
+			area * a * d, area * b * d, area * c * d, area * d * d, area };
+		for (j = 0; j < 3; ++j) {
+
+			mesh_lod_quadric_add(t_state->quadrics + t_indices[i + j], &plane);
+		}
+	}
+
+	free(table);
+	free(welded);
+	free(edges);
+	return 1;
+}
+
+static float mesh_lod_collapse_cost(mesh_lod_state* t_state, unsigned int t_from, unsigned int t_to) {
+
+	mesh_lod_job* job = t_state->job;
+	mesh_lod_quadric quadric = t_state->quadrics[t_from];
+	mesh_lod_quadric_add(&quadric, t_state->quadrics + t_to);
+	double cost = mesh_lod_quadric_evaluate(&quadric, t_state->positions + t_to * 3);
+
+	/* the from vertex takes on the attributes of the to vertex, so their squared difference adds to the error, like the
+	 * averaged position error it does not grow with the area or density of the triangles around the vertex */
+	unsigned int i, j;
+	for (i = 0; i < job->attribute_count; ++i) {
+
+		const float* a = mesh_lod_get_element(job->attributes + i, t_from);
+		const float* b = mesh_lod_get_element(job->attributes + i, t_to);
+		double difference = 0.0;
+		for (j = 0; j < job->attributes[i].size; ++j) {
+
+			difference += (double)(a[j] - b[j]) * (a[j] - b[j]);
+		}
+		cost += difference * job->attribute_weights[i];
+	}
+	return (float)cost;
+}
+
+static int mesh_lod_is_flipped(mesh_lod_state* t_state, const unsigned int* t_indices, unsigned int t_from, unsigned int t_to) {
+
+	unsigned int i, j;
+	for (i = t_state->adjacency_offsets[t_from]; i < t_state->adjacency_offsets[t_from + 1]; ++i) {
+
+		const unsigned int* triangle = t_indices + t_state->adjacency[i] * 3;
+		if (triangle[0] == t_to || triangle[1] == t_to || triangle[2] == t_to) {
+
+			continue;
+		}
+		const float* before[3];
+		const float* after[3];
+		for (j = 0; j < 3; ++j) {
+
+			before[j] = t_state->positions + triangle[j] * 3;
+			after[j] = triangle[j] == t_from ? t_state->positions + t_to * 3 : before[j];
+		}
+		double normal_before[3], normal_after[3];
+		mesh_lod_triangle_normal(before[0], before[1], before[2], normal_before);
+		mesh_lod_triangle_normal(after[0], after[1], after[2], normal_after);
+		double dot = normal_before[0] * normal_after[0] + normal_before[1] * normal_after[1] + normal_before[2] * normal_after[2];
+		double before_length = normal_before[0] * normal_before[0] + normal_before[1] * normal_before[1] + normal_before[2] * normal_before[2];
+		double after_length = normal_after[0] * normal_after[0] + normal_after[1] * normal_after[1] + normal_after[2] * normal_after[2];
+
+		/* rejects triangles turning by more than about 75 degrees as well as outright flips */
+		if (dot <= 0.25 * sqrt(before_length * after_length)) {
+
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* collapses independent edges in cost order until t_target_count indices remain, returns the new index count */
+static unsigned int mesh_lod_collapse_pass
+	( mesh_lod_state* t_state
+	, unsigned int* t_indices
+	, unsigned int t_index_count
+	, unsigned int t_target_count
+	, float t_max_cost
+	, float* t_out_cost) {
+
+	unsigned int vertex_count = t_state->vertex_count;
+	unsigned int triangle_count = t_index_count / 3;
+	unsigned int i, j, collapse_count = 0;
+
+	memset(t_state->adjacency_offsets, 0, sizeof(unsigned int) * (vertex_count + 1));
+	for (i = 0; i < t_index_count; ++i) {
+
+		++t_state->adjacency_offsets[t_indices[i] + 1];
+	}
+	for (i = 0; i < vertex_count; ++i) {
+
+		t_state->adjacency_offsets[i + 1] += t_state->adjacency_offsets[i];
+	}
+	for (i = 0; i < t_index_count; ++i) {
+
+		t_state->adjacency[t_state->adjacency_offsets[t_indices[i]]++] = i / 3;
+	}
+	for (i = vertex_count; i > 0; --i) {
+
+		t_state->adjacency_offsets[i] = t_state->adjacency_offsets[i - 1];
+	}
+	t_state->adjacency_offsets[0] = 0;
+
+	for (i = 0; i < t_index_count; ++i) {
+
+		unsigned int from = t_indices[i];
+		unsigned int to = t_indices[i - i % 3 + (i + 1) % 3];
+		if (!t_state->locked[from]) {
+
+			float cost = mesh_lod_collapse_cost(t_state, from, to);
+			if (cost <= t_max_cost) {
+
+				mesh_lod_collapse collapse = { cost, from, to };
+				t_state->collapses[collapse_count++] = collapse;
+			}
+		}
+		if (!t_state->locked[to]) {
+
+			float cost = mesh_lod_collapse_cost(t_state, to, from);
+			if (cost <= t_max_cost) {
+
+				mesh_lod_collapse collapse = { cost, to, from };
+				t_state->collapses[collapse_count++] = collapse;
+			}
+		}
+	}
+	qsort(t_state->collapses, collapse_count, sizeof(mesh_lod_collapse), mesh_lod_compare_collapses);
+
+	memset(t_state->used, 0, vertex_count);
+	unsigned int removed = 0, target_removed = (t_index_count - t_target_count) / 3;
+	for (i = 0; i < collapse_count && removed < target_removed; ++i) {
+
+		unsigned int from = t_state->collapses[i].from;
+		unsigned int to = t_state->collapses[i].to;
+		if (t_state->used[from] || t_state->used[to] || mesh_lod_is_flipped(t_state, t_indices, from, to)) {
+
+			continue;
+		}
+
+		/* the neighbourhood of a collapse is frozen for the rest of the pass so flip checks stay valid */
+		t_state->remap[from] = to;
+		mesh_lod_quadric_add(t_state->quadrics + to, t_state->quadrics + from);
+		*t_out_cost = t_state->collapses[i].cost > *t_out_cost ? t_state->collapses[i].cost : *t_out_cost;
+		for (j = t_state->adjacency_offsets[from]; j < t_state->adjacency_offsets[from + 1]; ++j) {
+
+			const unsigned int* triangle = t_indices + t_state->adjacency[j] * 3;
+			removed += triangle[0] == to || triangle[1] == to || triangle[2] == to;
+			t_state->used[triangle[0]] = 1;
+			t_state->used[triangle[1]] = 1;
+			t_state->used[triangle[2]] = 1;
+		}
+	}
+
+	unsigned int index_count = 0;
+	for (i = 0; i < triangle_count; ++i) {
+
+		unsigned int a = t_state->remap[t_indices[i * 3]];
+		unsigned int b = t_state->remap[t_indices[i * 3 + 1]];
+		unsigned int c = t_state->remap[t_indices[i * 3 + 2]];
+		if (a != b && b != c && c != a) {
+
+			t_indices[index_count++] = a;
+			t_indices[index_count++] = b;
+			t_indices[index_count++] = c;
+		}
+	}
+	return index_count;
+}
+
+int mesh_lod_generate(mesh_lod_job* t_job) {
+
+	assert(t_job && t_job->position && t_job->indices);
+	assert(t_job->position->type == GL_FLOAT && t_job->position->size >= 3);
+	assert(!t_job->attribute_count || (t_job->attributes && t_job->attribute_weights));
+	assert(t_job->lod_count > 0 && t_job->reduction > 0.0f && t_job->reduction < 1.0f);
+
+	mesh_lod_state state;
+	size_t position_stride = t_job->position->stride ? t_job->position->stride : t_job->position->size * sizeof(float);
+	unsigned int vertex_count = (unsigned int)(t_job->position->buffer_size / position_stride);
+	unsigned int index_count = index_buffer_get_element_count((index_buffer*)t_job->indices) / 3 * 3;
+	unsigned int i;
+
+	t_job->out_indices.buffer = 0;
+	t_job->out_indices.buffer_size = 0;
+	t_job->out_indices.type = t_job->indices->type;
+	t_job->out_lods = 0;
+	t_job->out_lod_count = 0;
+	t_job->result = 0;
+
+	memset(&state, 0, sizeof(state));
+	state.job = t_job;
+	state.vertex_count = vertex_count;
+	state.positions = malloc(sizeof(float) * 3 * (vertex_count ? vertex_count : 1));
+	state.locked = calloc(vertex_count ? vertex_count : 1, 1);
+	state.used = malloc(vertex_count ? vertex_count : 1);
+	state.quadrics = malloc(sizeof(mesh_lod_quadric) * (vertex_count ? vertex_count : 1));
+	state.remap = malloc(sizeof(unsigned int) * (vertex_count ? vertex_count : 1));
+	state.adjacency_offsets = malloc(sizeof(unsigned int) * (vertex_count + 1));
+	state.adjacency = malloc(sizeof(unsigned int) * (index_count ? index_count : 1));
+	state.collapses = malloc(sizeof(mesh_lod_collapse) * 2 * (index_count ? index_count : 1));
+
+	/* the chain is built as 32 bit indices, the current level is simplified in place at the end of it */
+	size_t chain_capacity = (size_t)index_count * 2 + 1;
+	unsigned int* chain = malloc(sizeof(unsigned int) * chain_capacity);
+	t_job->out_lods = malloc(sizeof(mesh_lod) * t_job->lod_count);
+	unsigned int* current = malloc(sizeof(unsigned int) * (index_count ? index_count : 1));
+
+	if (!state.positions || !state.locked || !state.used || !state.quadrics || !state.remap
+		|| !state.adjacency_offsets || !state.adjacency || !state.collapses || !chain || !t_job->out_lods || !current) {
+
+		goto generate_final;
+	}
+
+	for (i = 0; i < index_count; ++i) {
+
+		current[i] = mesh_lod_read_index(t_job->indices, i);
+		assert(current[i] < vertex_count);
+	}
+	for (i = 0; i < vertex_count; ++i) {
+
+		state.remap[i] = i;
+	}
+
+	/* the first level is the source as given, the levels after it index the welded vertices */
+	size_t chain_size = index_count;
+	memcpy(chain, current, sizeof(unsigned int) * index_count);
+	if (!mesh_lod_prepare(&state, current, index_count)) {
+
+		goto generate_final;
+	}
+
+	t_job->out_lods[0].index_offset = 0;
+	t_job->out_lods[0].index_count = index_count;
+	t_job->out_lods[0].error = 0.0f;
+	t_job->out_lod_count = 1;
+
+	float max_cost = t_job->max_error * t_job->max_error, cost = 0.0f;
+	unsigned int current_count = index_count;
+	while (t_job->out_lod_count < t_job->lod_count) {
+
+		unsigned int previous_count = current_count, pass;
+		unsigned int target_count = (unsigned int)(previous_count / 3 * t_job->reduction) * 3;
+		for (pass = 0; pass < MESH_LOD_MAX_PASSES && current_count > target_count; ++pass) {
+
+			unsigned int count = mesh_lod_collapse_pass(&state, current, current_count, target_count, max_cost, &cost);
+			if (count == current_count) {
+
+				break;
+			}
+			current_count = count;
+		}
+		if (current_count == previous_count || !current_count) {
+
+			break;
+		}
+
+		if (chain_size + current_count > chain_capacity) {
+
+			size_t capacity = chain_capacity * 2;
+			unsigned int* grown = realloc(chain, sizeof(unsigned int) * capacity);
+			if (!grown) {
+
+				goto generate_final;
+			}
+			chain = grown;
+			chain_capacity = capacity;
+		}
+		memcpy(chain + chain_size, current, sizeof(unsigned int) * current_count);
+		t_job->out_lods[t_job->out_lod_count].index_offset = (unsigned int)chain_size;
+		t_job->out_lods[t_job->out_lod_count].index_count = current_count;
+		t_job->out_lods[t_job->out_lod_count].error = sqrtf(cost);
+		++t_job->out_lod_count;
+		chain_size += current_count;
+	}
+
+	/* the chain keeps the type of the source indices, the vertices never change so every index still fits */
+	size_t index_size = mesh_lod_get_index_size(t_job->indices->type);
+	t_job->out_indices.buffer = malloc(index_size * (chain_size ? chain_size : 1));
+	if (!t_job->out_indices.buffer) {
+
+		goto generate_final;
+	}
+	t_job->out_indices.buffer_size = index_size * chain_size;
+	for (i = 0; i < chain_size; ++i) {
+
+		if (index_size == sizeof(unsigned char)) {
+
+			((unsigned char*)t_job->out_indices.buffer)[i] = (unsigned char)chain[i];
+		}
+		else if (index_size == sizeof(unsigned short)) {
+
+			((unsigned short*)t_job->out_indices.buffer)[i] = (unsigned short)chain[i];
+		}
+		else {
+
+			((unsigned int*)t_job->out_indices.buffer)[i] = chain[i];
+		}
+	}
+	t_job->result = 1;
+
+generate_final:
+	if (!t_job->result) {
+
+		free(t_job->out_lods);
+		t_job->out_lods = 0;
+		t_job->out_lod_count = 0;
+	}
+	free(state.positions);
+	free(state.locked);
+	free(state.used);
+	free(state.quadrics);
+	free(state.remap);
+	free(state.adjacency_offsets);
+	free(state.adjacency);
+	free(state.collapses);
+	free(chain);
+	free(current);
+	return t_job->result;
+}
+
+static void mesh_lod_generate_range(void* t_context, size_t t_begin, size_t t_end) {
+
+	mesh_lod_job* jobs = t_context;
+	size_t i;
+	for (i = t_begin; i < t_end; ++i) {
+
+		mesh_lod_generate(jobs + i);
+	}
+}
+
+void mesh_lod_generate_batch(thread_pool* t_pool, mesh_lod_job* t_jobs, unsigned int t_job_count) {
+
+	assert(t_jobs || !t_job_count);
+
+	thread_pool_parallel_for(t_pool, t_job_count, 1, mesh_lod_generate_range, t_jobs);
+}
+
+void mesh_lod_job_final(mesh_lod_job* t_job, int t_free_indices) {
+
+	assert(t_job);
+
+	if (t_free_indices) {
+
+		free(t_job->out_indices.buffer);
+	}
+	free(t_job->out_lods);
+	t_job->out_indices.buffer = 0;
+	t_job->out_indices.buffer_size = 0;
+	t_job->out_lods = 0;
+	t_job->out_lod_count = 0;
+	t_job->result = 0;
+}
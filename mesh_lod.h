@@ -0,0 +1,67 @@
+/**
+ * mesh_lod.h
+ */
+
+#ifndef GRAPHICS_UTILS_MESH_LOD_H
+#define GRAPHICS_UTILS_MESH_LOD_H
+
+#include "graphics.h"
+#include "thread_pool.h"
+
+/**	@struct		mesh_lod_job
+ *	@brief		the inputs and outputs of simplifying one mesh into a chain of levels of detail
+ *	@member		mesh_lod_job::position - the GL_FLOAT position attribute of at least three components
+ *	@member		mesh_lod_job::attribute_count - the number of additional GL_FLOAT attributes in attributes
+ *	@member		mesh_lod_job::attributes - attributes such as normals or uvs whose change adds to the error, or 0
+ *	@member		mesh_lod_job::attribute_weights - attribute_count weights scaling each attribute's squared change
+ *	@member		mesh_lod_job::indices - the triangle list to simplify
+ *	@member		mesh_lod_job::lod_count - the largest number of levels to generate, including the original
+ *	@member		mesh_lod_job::reduction - the fraction of triangles each level keeps from the previous level
+ *	@member		mesh_lod_job::max_error - the largest error a level may reach, the root of the area weighted mean squared
+ *				distance of collapsed vertices from their original planes relative to the largest extent of the mesh, plus
+ *				the weighted squared attribute change, so it is independent of the scale and tessellation of the mesh
+ *	@member		mesh_lod_job::out_indices - receives a malloc'd index buffer of every level in sequence, of the input type
+ *	@member		mesh_lod_job::out_lods - receives a malloc'd array of out_lod_count levels ranging within out_indices
+ *	@member		mesh_lod_job::out_lod_count - receives the number of levels generated
+ *	@member		mesh_lod_job::result - receives nonzero if the job succeeded
+ */
+typedef struct {
+
+	const vertex_attribute* position;
+	unsigned int attribute_count;
+	const vertex_attribute* attributes;
+	const float* attribute_weights;
+	const index_buffer* indices;
+	unsigned int lod_count;
+	float reduction;
+	float max_error;
+	index_buffer out_indices;
+	mesh_lod* out_lods;
+	unsigned int out_lod_count;
+	int result;
+} mesh_lod_job;
+
+/** simplifies a mesh by quadric error edge collapses, every level reuses the original vertices so the
+ *	chain can be given to init_mesh alongside the original vertex attributes and then to mesh_set_lods
+ *	@memberof	mesh_lod_job
+ *	@param		t_job - the job to process
+ *	@returns	nonzero if the levels were generated
+ */
+int mesh_lod_generate(mesh_lod_job* t_job);
+
+/** processes a batch of jobs, one mesh per task, across a thread pool
+ *	@memberof	mesh_lod_job
+ *	@param		t_pool - an optional thread pool to process jobs across
+ *	@param		t_jobs - the jobs to process, each receives its own result
+ *	@param		t_job_count - the number of jobs
+ */
+void mesh_lod_generate_batch(thread_pool* t_pool, mesh_lod_job* t_jobs, unsigned int t_job_count);
+
+/** finalizes the outputs of a processed job
+ *	@memberof	mesh_lod_job
+ *	@param		t_job - the job to finalize
+ *	@param		t_free_indices - if non-zero, out_indices is free'd, pass zero once given to init_mesh
+ */
+void mesh_lod_job_final(mesh_lod_job* t_job, int t_free_indices);
+
+#endif
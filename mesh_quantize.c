@@ -0,0 +1,302 @@
+#include "mesh_quantize.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MESH_QUANTIZE_GRAIN 16384
+
+typedef struct {
+
+	const vertex_attribute* source;
+	void* out;
+	float offset[3];
+	float inverse_scale[3];
+	unsigned int mode;
+} mesh_quantize_context;
+
+static const float* mesh_quantize_get_element(const vertex_attribute* t_attribute, size_t t_vertex) {
+
+	size_t stride = t_attribute->stride ? t_attribute->stride : t_attribute->size * sizeof(float);
+	return (const float*)((const char*)t_attribute->buffer + stride * t_vertex);
+}
+
+static size_t mesh_quantize_get_count(const vertex_attribute* t_attribute) {
+
+	size_t stride = t_attribute->stride ? t_attribute->stride : t_attribute->size * sizeof(float);
+	return t_attribute->buffer_size / stride;
+}
+
+static unsigned short mesh_quantize_unorm16(float t_value) {
+
+	t_value = t_value < 0.0f ? 0.0f : (t_value > 1.0f ? 1.0f : t_value);
+	return (unsigned short)(t_value * 65535.0f + 0.5f);
+}
+
+/* computes the per component bounds of an attribute as an offset and the reciprocal of its extent in steps */
+static void mesh_quantize_bounds(const vertex_attribute* t_attribute, unsigned int t_components, float* t_offset, float* t_scale, float* t_inverse_scale) {
+
+	size_t count = mesh_quantize_get_count(t_attribute), i;
+	unsigned int k;
+	float maximum[3];
+
+	for (k = 0; k < t_components; ++k) {
+
+		t_offset[k] = count ? mesh_quantize_get_element(t_attribute, 0)[k] : 0.0f;
+		maximum[k] = t_offset[k];
+	}
+	for (i = 1; i < count; ++i) {
+
+		const float* element = mesh_quantize_get_element(t_attribute, i);
+		for (k = 0; k < t_components; ++k) {
+
+			t_offset[k] = element[k] < t_offset[k] ? element[k] : t_offset[k];
+			maximum[k] = element[k] > maximum[k] ? element[k] : maximum[k];
+		}
+	}
+	for (k = 0; k < t_components; ++k) {
+
+		t_scale[k] = maximum[k] - t_offset[k];
+		t_inverse_scale[k] = t_scale[k] > 0.0f ? 1.0f / t_scale[k] : 0.0f;
+	}
+}
+
+static void mesh_quantize_positions_range(void* t_context, size_t t_begin, size_t t_end) {
+
+	mesh_quantize_context* context = t_context;
+	unsigned short* out = context->out;
+	size_t i;
+	unsigned int k;
+
+	for (i = t_begin; i < t_end; ++i) {
+
+		const float* position = mesh_quantize_get_element(context->source, i);
+		for (k = 0; k < 3; ++k) {
+
+			out[i * 4 + k] = mesh_quantize_unorm16((position[k] - context->offset[k]) * context->inverse_scale[k]);
+		}
+		out[i * 4 + 3] = 0;
+	}
+}
+
+static void mesh_quantize_octahedral_decode(const short* t_encoded, float* t_out) {
+
+	float x = t_encoded[0] / 32767.0f, y = t_encoded[1] / 32767.0f;
+	x = x < -1.0f ? -1.0f : x;
+	y = y < -1.0f ? -1.0f : y;
+	float z = 1.0f - fabsf(x) - fabsf(y);
+	float fold = z < 0.0f ? -z : 0.0f;
+	x += x >= 0.0f ? -fold : fold;
+	y += y >= 0.0f ? -fold : fold;
+	float length = sqrtf(x * x + y * y + z * z);
+	t_out[0] = x / length;
+	t_out[1] = y / length;
+	t_out[2] = z / length;
+}
+
+/* projects onto the octahedron, then picks whichever of the four neighbouring grid points decodes closest */
+static void mesh_quantize_octahedral_encode(const float* t_direction, short* t_out) {
+
+	float sum = fabsf(t_direction[0]) + fabsf(t_direction[1]) + fabsf(t_direction[2]);
+	if (sum <= 0.0f) {
+
+		t_out[0] = 0;
+		t_out[1] = 0;
+		return;
+	}
+	float x = t_direction[0] / sum, y = t_direction[1] / sum;
+	if (t_direction[2] < 0.0f) {
+
+		float folded_x = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float folded_y = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = folded_x;
+		y = folded_y;
+	}
+
+	float best = -2.0f;
+	int i;
+	for (i = 0; i < 4; ++i) {
+
+		short candidate[2];
+		float decoded[3];
+		candidate[0] = (short)((i & 1) ? ceilf(x * 32767.0f) : floorf(x * 32767.0f));
+		candidate[1] = (short)((i & 2) ? ceilf(y * 32767.0f) : floorf(y * 32767.0f));
+		mesh_quantize_octahedral_decode(candidate, decoded);
+		float similarity = decoded[0] * t_direction[0] + decoded[1] * t_direction[1] + decoded[2] * t_direction[2];
+		if (similarity > best) {
+
+			best = similarity;
+			t_out[0] = candidate[0];
+			t_out[1] = candidate[1];
+		}
+	}
+}
+
+static void mesh_quantize_directions_range(void* t_context, size_t t_begin, size_t t_end) {
+
+	mesh_quantize_context* context = t_context;
+	short* out = context->out;
+	unsigned int stride = context->source->size >= 4 ? 4 : 2;
+	size_t i;
+
+	for (i = t_begin; i < t_end; ++i) {
+
+		const float* direction = mesh_quantize_get_element(context->source, i);
+		float length = sqrtf(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+		float unit[3] = { 0.0f, 0.0f, 1.0f };
+		if (length > 0.0f) {
+
+			unit[0] = direction[0] / length;
+			unit[1] = direction[1] / length;
+			unit[2] = direction[2] / length;
+		}
+		mesh_quantize_octahedral_encode(unit, out + i * stride);
+		if (stride == 4) {
+
+			out[i * 4 + 2] = direction[3] < 0.0f ? -32767 : 32767;
+			out[i * 4 + 3] = 0;
+		}
+	}
+}
+
+static void mesh_quantize_uvs_range(void* t_context, size_t t_begin, size_t t_end) {
+
+	mesh_quantize_context* context = t_context;
+	unsigned short* out = context->out;
+	size_t i;
+	unsigned int k;
+
+	for (i = t_begin; i < t_end; ++i) {
+
+		const float* uv = mesh_quantize_get_element(context->source, i);
+		for (k = 0; k < 2; ++k) {
+
+			out[i * 2 + k] = context->mode == MESH_QUANTIZE_UV_HALF
+				? mesh_quantize_half(uv[k])
+				: mesh_quantize_unorm16((uv[k] - context->offset[k]) * context->inverse_scale[k]);
+		}
+	}
+}
+
+unsigned short mesh_quantize_half(float t_value) {
+
+	unsigned int bits;
+	memcpy(&bits, &t_value, sizeof(bits));
+	unsigned int sign = (bits >> 16) & 0x8000u;
+	unsigned int magnitude = bits & 0x7fffffffu;
+
+	if (magnitude > 0x7f800000u) {
+
+		return (unsigned short)(sign | 0x7e00u);
+	}
+	if (magnitude >= 0x47800000u) {
+
+		return (unsigned short)(sign | 0x7c00u);
+	}
+	if (magnitude < 0x38800000u) {
+
+		/* below the smallest normal half, the result is a multiple of 2^-24 and rounding up may reach the smallest normal */
+		float absolute;
+		memcpy(&absolute, &magnitude, sizeof(absolute));
+		return (unsigned short)(sign | (unsigned int)lrintf(absolute * 16777216.0f));
+	}
+
+	unsigned int half = (magnitude - 0x38000000u) >> 13;
+	unsigned int remainder = magnitude & 0x1fffu;
+	half += remainder > 0x1000u || (remainder == 0x1000u && (half & 1));
+	return (unsigned short)(sign | half);
+}
+
+int mesh_quantize_positions(mesh_quantization* t_quantization, thread_pool* t_pool, const vertex_attribute* t_position, vertex_attribute* t_out) {
+
+	assert(t_quantization && t_position && t_out);
+	assert(t_position->type == GL_FLOAT && t_position->size >= 3);
+
+	mesh_quantize_context context;
+	size_t count = mesh_quantize_get_count(t_position);
+
+	memset(&context, 0, sizeof(context));
+	context.source = t_position;
+	context.out = malloc(sizeof(unsigned short) * 4 * (count ? count : 1));
+	if (!context.out) {
+
+		return 0;
+	}
+	mesh_quantize_bounds(t_position, 3, t_quantization->position_offset, t_quantization->position_scale, context.inverse_scale);
+	memcpy(context.offset, t_quantization->position_offset, sizeof(context.offset));
+	thread_pool_parallel_for(t_pool, count, MESH_QUANTIZE_GRAIN, mesh_quantize_positions_range, &context);
+
+	t_out->buffer = context.out;
+	t_out->buffer_size = sizeof(unsigned short) * 4 * count;
+	t_out->size = 3;
+	t_out->type = GL_UNSIGNED_SHORT;
+	t_out->stride = sizeof(unsigned short) * 4;
+	t_out->flags = VERTEX_ATTRIBUTE_NORMALIZED;
+	return 1;
+}
+
+int mesh_quantize_directions(thread_pool* t_pool, const vertex_attribute* t_direction, vertex_attribute* t_out) {
+
+	assert(t_direction && t_out);
+	assert(t_direction->type == GL_FLOAT && t_direction->size >= 3);
+
+	mesh_quantize_context context;
+	size_t count = mesh_quantize_get_count(t_direction);
+	unsigned int components = t_direction->size >= 4 ? 4 : 2;
+
+	memset(&context, 0, sizeof(context));
+	context.source = t_direction;
+	context.out = malloc(sizeof(short) * components * (count ? count : 1));
+	if (!context.out) {
+
+		return 0;
+	}
+	thread_pool_parallel_for(t_pool, count, MESH_QUANTIZE_GRAIN, mesh_quantize_directions_range, &context);
+
+	t_out->buffer = context.out;
+	t_out->buffer_size = sizeof(short) * components * count;
+	t_out->size = components == 4 ? 3 : 2;
+	t_out->type = GL_SHORT;
+	t_out->stride = sizeof(short) * components;
+	t_out->flags = VERTEX_ATTRIBUTE_NORMALIZED;
+	return 1;
+}
+
+int mesh_quantize_uvs(mesh_quantization* t_quantization, thread_pool* t_pool, const vertex_attribute* t_uv, unsigned int t_mode, vertex_attribute* t_out) {
+
+	assert(t_quantization && t_uv && t_out);
+	assert(t_uv->type == GL_FLOAT && t_uv->size >= 2);
+	assert(t_mode == MESH_QUANTIZE_UV_HALF || t_mode == MESH_QUANTIZE_UV_UNORM16);
+
+	mesh_quantize_context context;
+	size_t count = mesh_quantize_get_count(t_uv);
+
+	memset(&context, 0, sizeof(context));
+	context.source = t_uv;
+	context.mode = t_mode;
+	context.out = malloc(sizeof(unsigned short) * 2 * (count ? count : 1));
+	if (!context.out) {
+
+		return 0;
+	}
+	if (t_mode == MESH_QUANTIZE_UV_UNORM16) {
+
+		mesh_quantize_bounds(t_uv, 2, t_quantization->uv_offset, t_quantization->uv_scale, context.inverse_scale);
+		memcpy(context.offset, t_quantization->uv_offset, sizeof(float) * 2);
+	}
+	else {
+
+		t_quantization->uv_offset[0] = t_quantization->uv_offset[1] = 0.0f;
+		t_quantization->uv_scale[0] = t_quantization->uv_scale[1] = 1.0f;
+	}
+	thread_pool_parallel_for(t_pool, count, MESH_QUANTIZE_GRAIN, mesh_quantize_uvs_range, &context);
+
+	t_out->buffer = context.out;
+	t_out->buffer_size = sizeof(unsigned short) * 2 * count;
+	t_out->size = 2;
+	t_out->type = t_mode == MESH_QUANTIZE_UV_HALF ? GL_HALF_FLOAT : GL_UNSIGNED_SHORT;
+	t_out->stride = sizeof(unsigned short) * 2;
+	t_out->flags = t_mode == MESH_QUANTIZE_UV_HALF ? 0 : VERTEX_ATTRIBUTE_NORMALIZED;
+	return 1;
+}
@@ -0,0 +1,70 @@
+/**
+ * mesh_quantize.h
+ */
+
+#ifndef GRAPHICS_UTILS_MESH_QUANTIZE_H
+#define GRAPHICS_UTILS_MESH_QUANTIZE_H
+
+#include "graphics.h"
+#include "thread_pool.h"
+
+/* uvs stored as GL_HALF_FLOAT, suited to tiling uvs outside of [0, 1] */
+#define MESH_QUANTIZE_UV_HALF 0
+/* uvs stored as normalized GL_UNSIGNED_SHORT across the mesh's uv bounds, dequantized by uv_offset and uv_scale */
+#define MESH_QUANTIZE_UV_UNORM16 1
+
+/**	@struct		mesh_quantization
+ *	@brief		the per mesh dequantization constants, a shader reconstructs position = position_offset + position_scale * attribute
+ *				and, for MESH_QUANTIZE_UV_UNORM16, uv = uv_offset + uv_scale * attribute
+ *	@member		mesh_quantization::position_offset - the minimum of the mesh's positions
+ *	@member		mesh_quantization::position_scale - the extent of the mesh's positions
+ *	@member		mesh_quantization::uv_offset - the minimum of the mesh's uvs
+ *	@member		mesh_quantization::uv_scale - the extent of the mesh's uvs
+ */
+typedef struct {
+
+	float position_offset[3];
+	float position_scale[3];
+	float uv_offset[2];
+	float uv_scale[2];
+} mesh_quantization;
+
+/** quantizes positions to normalized GL_UNSIGNED_SHORT across the mesh's bounds, 8 bytes per vertex
+ *	@memberof	mesh_quantization
+ *	@param		t_quantization - receives the position dequantization constants
+ *	@param		t_pool - an optional thread pool to quantize vertices across
+ *	@param		t_position - the GL_FLOAT position attribute of at least three components
+ *	@param		t_out - receives a malloc'd three component attribute
+ *	@returns	nonzero if the positions were quantized
+ */
+int mesh_quantize_positions(mesh_quantization* t_quantization, thread_pool* t_pool, const vertex_attribute* t_position, vertex_attribute* t_out);
+
+/** octahedrally encodes unit directions to normalized GL_SHORT, a shader decodes xy by n = vec3(xy, 1 - |x| - |y|),
+ *	n.xy -= sign(n.xy) * max(-n.z, 0) and normalize(n), three component normals take 4 bytes per vertex and
+ *	four component tangents keep their w in z, taking 8 bytes per vertex
+ *	@memberof	mesh_quantization
+ *	@param		t_pool - an optional thread pool to encode vertices across
+ *	@param		t_direction - a GL_FLOAT normal of three components or tangent of four components
+ *	@param		t_out - receives a malloc'd two or three component attribute
+ *	@returns	nonzero if the directions were encoded
+ */
+int mesh_quantize_directions(thread_pool* t_pool, const vertex_attribute* t_direction, vertex_attribute* t_out);
+
+/** quantizes uvs to 4 bytes per vertex
+ *	@memberof	mesh_quantization
+ *	@param		t_quantization - receives the uv dequantization constants, identity for MESH_QUANTIZE_UV_HALF
+ *	@param		t_pool - an optional thread pool to quantize vertices across
+ *	@param		t_uv - the GL_FLOAT uv attribute of at least two components
+ *	@param		t_mode - MESH_QUANTIZE_UV_HALF or MESH_QUANTIZE_UV_UNORM16
+ *	@param		t_out - receives a malloc'd two component attribute
+ *	@returns	nonzero if the uvs were quantized
+ */
+int mesh_quantize_uvs(mesh_quantization* t_quantization, thread_pool* t_pool, const vertex_attribute* t_uv, unsigned int t_mode, vertex_attribute* t_out);
+
+/** converts a float to the nearest half float, rounding ties to even
+ *	@param		t_value - the value to convert
+ *	@returns	the half float bits
+ */
+unsigned short mesh_quantize_half(float t_value);
+
+#endif
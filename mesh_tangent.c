@@ -0,0 +1,581 @@
+#include "mesh_tangent.h"
+
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MESH_TANGENT_GRAIN 4096
+
+typedef struct {
+
+	float tangent[3];
+	float weight;
+	int is_preserving;
+	int is_degenerate;
+} mesh_tangent_corner;
+
+typedef struct {
+
+	unsigned int vertex;
+	unsigned int position;
+} mesh_tangent_key;
+
+typedef struct {
+
+	const vertex_attribute* position;
+	const vertex_attribute* normal;
+	const vertex_attribute* uv;
+	const unsigned int* indices;
+	unsigned int vertex_count;
+	unsigned int* canonical;
+	unsigned int* corner_offsets;
+	unsigned int* corners;
+	mesh_tangent_corner* corner_tangents;
+	mesh_tangent_key* keys;
+	unsigned int* roots;
+	mesh_tangent_corner* groups;
+	unsigned int* group_vertices;
+	unsigned int* corner_vertices;
+	unsigned int* extra_offsets;
+	unsigned int* out_remap;
+	float* out;
+} mesh_tangent_context;
+
+static const float* mesh_tangent_get_element(const vertex_attribute* t_attribute, unsigned int t_vertex) {
+
+	size_t stride = t_attribute->stride ? t_attribute->stride : t_attribute->size * sizeof(float);
+	return (const float*)((const char*)t_attribute->buffer + stride * t_vertex);
+}
+
+static float mesh_tangent_dot(const float* t_a, const float* t_b) {
+
+	return t_a[0] * t_b[0] + t_a[1] * t_b[1] + t_a[2] * t_b[2];
+}
+
+static void mesh_tangent_normalize(float* t_vector) {
+
+	float length = sqrtf(mesh_tangent_dot(t_vector, t_vector));
+	if (length > FLT_MIN) {
+
+		t_vector[0] /= length;
+		t_vector[1] /= length;
+		t_vector[2] /= length;
+	}
+}
+
+/* removes the component of t_vector along t_normal and normalizes the remainder */
+static void mesh_tangent_project(float* t_vector, const float* t_normal) {
+
+	float along = mesh_tangent_dot(t_vector, t_normal);
+	t_vector[0] -= t_normal[0] * along;
+	t_vector[1] -= t_normal[1] * along;
+	t_vector[2] -= t_normal[2] * along;
+	mesh_tangent_normalize(t_vector);
+}
+
+/* evaluates the texture space of each triangle and the angle weighted contribution of each of its corners */
+static void mesh_tangent_triangles(void* t_context, size_t t_begin, size_t t_end) {
+
+	mesh_tangent_context* context = t_context;
+	size_t triangle;
+	unsigned int i, k;
+
+	for (triangle = t_begin; triangle < t_end; ++triangle) {
+
+		const unsigned int* indices = context->indices + triangle * 3;
+		const float* positions[3];
+		const float* uvs[3];
+		for (i = 0; i < 3; ++i) {
+
+			positions[i] = mesh_tangent_get_element(context->position, indices[i]);
+			uvs[i] = mesh_tangent_get_element(context->uv, indices[i]);
+		}
+
+		float d1[3] = { positions[1][0] - positions[0][0], positions[1][1] - positions[0][1], positions[1][2] - positions[0][2] };
+		float d2[3] = { positions[2][0] - positions[0][0], positions[2][1] - positions[0][1], positions[2][2] - positions[0][2] };
+		float t21x = uvs[1][0] - uvs[0][0], t21y = uvs[1][1] - uvs[0][1];
+		float t31x = uvs[2][0] - uvs[0][0], t31y = uvs[2][1] - uvs[0][1];
+		float signed_area = t21x * t31y - t21y * t31x;
+		int is_preserving = signed_area > 0.0f;
+		float os[3] = { t31y * d1[0] - t21y * d2[0], t31y * d1[1] - t21y * d2[1], t31y * d1[2] - t21y * d2[2] };
+		float os_length = sqrtf(mesh_tangent_dot(os, os));
+		int is_degenerate = fabsf(signed_area) <= FLT_MIN || os_length <= FLT_MIN;
+		if (!is_degenerate) {
+
+			float scale = (is_preserving ? 1.0f : -1.0f) / os_length;
+			os[0] *= scale;
+			os[1] *= scale;
+			os[2] *= scale;
+		}
+
+		for (i = 0; i < 3; ++i) {
+
+			mesh_tangent_corner* corner = context->corner_tangents + triangle * 3 + i;
+			corner->is_preserving = is_preserving;
+			corner->is_degenerate = is_degenerate;
+			if (is_degenerate) {
+
+				memset(corner->tangent, 0, sizeof(corner->tangent));
+				corner->weight = 0.0f;
+				continue;
+			}
+
+			const float* normal = mesh_tangent_get_element(context->normal, indices[i]);
+			const float* previous = positions[(i + 2) % 3];
+			const float* next = positions[(i + 1) % 3];
+			float tangent[3] = { os[0], os[1], os[2] };
+			float e1[3] = { previous[0] - positions[i][0], previous[1] - positions[i][1], previous[2] - positions[i][2] };
+			float e2[3] = { next[0] - positions[i][0], next[1] - positions[i][1], next[2] - positions[i][2] };
+			mesh_tangent_project(tangent, normal);
+			mesh_tangent_project(e1, normal);
+			mesh_tangent_project(e2, normal);
+			float cosine = mesh_tangent_dot(e1, e2);
+			float angle = acosf(cosine > 1.0f ? 1.0f : (cosine < -1.0f ? -1.0f : cosine));
+			for (k = 0; k < 3; ++k) {
+
+				corner->tangent[k] = tangent[k] * angle;
+			}
+			corner->weight = angle;
+		}
+	}
+}
+
+static int mesh_tangent_compare_keys(const void* t_a, const void* t_b) {
+
+	const mesh_tangent_key* a = t_a;
+	const mesh_tangent_key* b = t_b;
+	if (a->vertex != b->vertex) {
+
+		return a->vertex < b->vertex ? -1 : 1;
+	}
+	return a->position < b->position ? -1 : (a->position > b->position);
+}
+
+static unsigned int mesh_tangent_find(unsigned int* t_roots, unsigned int t_position) {
+
+	while (t_roots[t_position] != t_position) {
+
+		t_roots[t_position] = t_roots[t_roots[t_position]];
+		t_position = t_roots[t_position];
+	}
+	return t_position;
+}
+
+/* the welded vertex a corner's triangle continues to, t_step of 1 is the next corner and 2 the previous */
+static unsigned int mesh_tangent_adjacent(const mesh_tangent_context* t_context, unsigned int t_corner, unsigned int t_step) {
+
+	unsigned int triangle = t_corner / 3;
+	return t_context->canonical[t_context->indices[triangle * 3 + (t_corner % 3 + t_step) % 3]];
+}
+
+/* splits the corners of each welded vertex into MikkTSpace's groups, corners whose triangles share an edge through
+ * the vertex with matching texture orientation, sums every group in corner order and gives each group at a vertex
+ * its own output vertex. groups are rooted at their first corner so the result does not depend upon the thread count */
+static void mesh_tangent_groups(void* t_context, size_t t_begin, size_t t_end) {
+
+	mesh_tangent_context* context = t_context;
+	size_t welded;
+	unsigned int i, j, k;
+
+	for (welded = t_begin; welded < t_end; ++welded) {
+
+		unsigned int begin = context->corner_offsets[welded];
+		unsigned int count = context->corner_offsets[welded + 1] - begin;
+		const unsigned int* corners = context->corners + begin;
+		mesh_tangent_key* keys = context->keys + begin;
+		unsigned int* roots = context->roots + begin;
+		mesh_tangent_corner* groups = context->groups + begin;
+		unsigned int* group_vertices = context->group_vertices + begin;
+		unsigned int extra_count = 0;
+
+		for (i = 0; i < count; ++i) {
+
+			keys[i].vertex = mesh_tangent_adjacent(context, corners[i], 2);
+			keys[i].position = i;
+			roots[i] = i;
+		}
+		qsort(keys, count, sizeof(mesh_tangent_key), mesh_tangent_compare_keys);
+
+		/* the edge to the next corner of one triangle is the edge to the previous corner of a neighbour wound the same way */
+		for (i = 0; i < count; ++i) {
+
+			const mesh_tangent_corner* corner = context->corner_tangents + corners[i];
+			unsigned int next = mesh_tangent_adjacent(context, corners[i], 1);
+			unsigned int low = 0, high = count;
+			if (corner->is_degenerate) {
+
+				continue;
+			}
+			while (low < high) {
+
+				unsigned int middle = low + (high - low) / 2;
+				if (keys[middle].vertex < next) {
+
+					low = middle + 1;
+				}
+				else {
+
+					high = middle;
+				}
+			}
+			for (j = low; j < count && keys[j].vertex == next; ++j) {
+
+				const mesh_tangent_corner* other = context->corner_tangents + corners[keys[j].position];
+				if (!other->is_degenerate && other->is_preserving == corner->is_preserving) {
+
+					unsigned int a = mesh_tangent_find(roots, i);
+					unsigned int b = mesh_tangent_find(roots, keys[j].position);
+					if (a < b) {
+
+						roots[b] = a;
+					}
+					else {
+
+						roots[a] = b;
+					}
+				}
+			}
+		}
+		for (i = 0; i < count; ++i) {
+
+			roots[i] = mesh_tangent_find(roots, i);
+		}
+
+		/* corners of degenerate triangles take the group of a valid corner of the same vertex, as MikkTSpace does */
+		for (i = 0; i < count; ++i) {
+
+			if (!context->corner_tangents[corners[i]].is_degenerate) {
+
+				continue;
+			}
+			for (j = 0; j < count; ++j) {
+
+				if (!context->corner_tangents[corners[j]].is_degenerate
+					&& context->indices[corners[j]] == context->indices[corners[i]]) {
+
+					roots[i] = roots[j];
+					break;
+				}
+			}
+		}
+
+		memset(groups, 0, sizeof(mesh_tangent_corner) * count);
+		for (i = 0; i < count; ++i) {
+
+			const mesh_tangent_corner* corner = context->corner_tangents + corners[i];
+			mesh_tangent_corner* group = groups + roots[i];
+			for (k = 0; k < 3; ++k) {
+
+				group->tangent[k] += corner->tangent[k];
+			}
+			group->weight += corner->weight;
+			if (roots[i] == i) {
+
+				group->is_preserving = corner->is_preserving;
+			}
+			group_vertices[i] = ~0u;
+		}
+		for (i = 0; i < count; ++i) {
+
+			if (roots[i] == i) {
+
+				mesh_tangent_normalize(groups[i].tangent);
+			}
+		}
+
+		/* the first group of each vertex keeps the vertex, further groups are numbered after the input vertices */
+		for (i = 0; i < count; ++i) {
+
+			keys[i].vertex = context->indices[corners[i]];
+			keys[i].position = i;
+		}
+		qsort(keys, count, sizeof(mesh_tangent_key), mesh_tangent_compare_keys);
+		for (i = 0; i < count; i = j) {
+
+			for (j = i; j < count && keys[j].vertex == keys[i].vertex; ++j) {
+
+				unsigned int root = roots[keys[j].position];
+				if (group_vertices[root] == ~0u) {
+
+					group_vertices[root] = j == i ? keys[i].vertex : context->vertex_count + extra_count++;
+				}
+				context->corner_vertices[corners[keys[j].position]] = group_vertices[root];
+			}
+			for (k = i; k < j; ++k) {
+
+				group_vertices[roots[keys[k].position]] = ~0u;
+			}
+		}
+		context->extra_offsets[welded] = extra_count;
+	}
+}
+
+/* writes the tangent of each group to its output vertex and renumbers the further groups by their welded vertex */
+static void mesh_tangent_write(void* t_context, size_t t_begin, size_t t_end) {
+
+	mesh_tangent_context* context = t_context;
+	size_t welded;
+	unsigned int i;
+
+	for (welded = t_begin; welded < t_end; ++welded) {
+
+		unsigned int begin = context->corner_offsets[welded];
+		for (i = begin; i < context->corner_offsets[welded + 1]; ++i) {
+
+			unsigned int corner = context->corners[i];
+			unsigned int vertex = context->corner_vertices[corner];
+			const mesh_tangent_corner* group = context->groups + begin + context->roots[i];
+			if (vertex >= context->vertex_count) {
+
+				vertex += context->extra_offsets[welded];
+				context->corner_vertices[corner] = vertex;
+			}
+			float* out = context->out + (size_t)vertex * 4;
+			memcpy(out, group->tangent, sizeof(float) * 3);
+			out[3] = group->is_preserving ? 1.0f : -1.0f;
+			context->out_remap[vertex] = context->indices[corner];
+		}
+	}
+}
+
+/* gives vertices without a usable texture space, or not referenced by any triangle, a direction perpendicular to their normal */
+static void mesh_tangent_vertices(void* t_context, size_t t_begin, size_t t_end) {
+
+	mesh_tangent_context* context = t_context;
+	size_t vertex;
+
+	for (vertex = t_begin; vertex < t_end; ++vertex) {
+
+		float* out = context->out + vertex * 4;
+		if (vertex < context->vertex_count) {
+
+			context->out_remap[vertex] = (unsigned int)vertex;
+		}
+		if (out[3] == 0.0f) {
+
+			out[3] = 1.0f;
+		}
+		if (mesh_tangent_dot(out, out) <= 0.5f) {
+
+			const float* normal = mesh_tangent_get_element(context->normal, context->out_remap[vertex]);
+			out[0] = fabsf(normal[0]) < 0.9f ? 1.0f : 0.0f;
+			out[1] = fabsf(normal[0]) < 0.9f ? 0.0f : 1.0f;
+			out[2] = 0.0f;
+			mesh_tangent_project(out, normal);
+		}
+	}
+}
+
+/* welds vertices of identical position, normal and texture coordinate, so a vertex repeated in the buffer sums all its corners */
+static int mesh_tangent_weld(mesh_tangent_context* t_context) {
+
+	unsigned int table_size = 1, i;
+	while (table_size < t_context->vertex_count * 2) {
+
+		table_size <<= 1;
+	}
+	unsigned int* table = malloc(sizeof(unsigned int) * table_size);
+	if (!table) {
+
+		return 0;
+	}
+	memset(table, 0xff, sizeof(unsigned int) * table_size);
+	for (i = 0; i < t_context->vertex_count; ++i) {
+
+		float key[8];
+		unsigned int bits[8], hash = 0, j;
+		memcpy(key, mesh_tangent_get_element(t_context->position, i), sizeof(float) * 3);
+		memcpy(key + 3, mesh_tangent_get_element(t_context->normal, i), sizeof(float) * 3);
+		memcpy(key + 6, mesh_tangent_get_element(t_context->uv, i), sizeof(float) * 2);
+		memcpy(bits, key, sizeof(bits));
+		for (j = 0; j < 8; ++j) {
+
+			hash = (hash ^ bits[j]) * 16777619u;
+		}
+		unsigned int slot = hash & (table_size - 1);
+		while (table[slot] != ~0u) {
+
+			unsigned int other = table[slot];
+			if (!memcmp(mesh_tangent_get_element(t_context->position, other), key, sizeof(float) * 3)
+				&& !memcmp(mesh_tangent_get_element(t_context->normal, other), key + 3, sizeof(float) * 3)
+				&& !memcmp(mesh_tangent_get_element(t_context->uv, other), key + 6, sizeof(float) * 2)) {
+
+				break;
+			}
+			slot = (slot + 1) & (table_size - 1);
+		}
+		if (table[slot] == ~0u) {
+
+			table[slot] = i;
+		}
+		t_context->canonical[i] = table[slot];
+	}
+	free(table);
+	return 1;
+}
+
+int mesh_tangents_generate
+	( thread_pool* t_pool
+	, const vertex_attribute* t_position
+	, const vertex_attribute* t_normal
+	, const vertex_attribute* t_uv
+	, const index_buffer* t_indices
+	, vertex_attribute* t_out_tangent
+	, index_buffer* t_out_indices
+	, unsigned int** t_out_remap
+	, unsigned int* t_out_vertex_count) {
+
+	assert(t_position && t_normal && t_uv && t_indices && t_out_tangent && t_out_indices && t_out_remap && t_out_vertex_count);
+	assert(t_position->type == GL_FLOAT && t_position->size >= 3);
+	assert(t_normal->type == GL_FLOAT && t_normal->size >= 3);
+	assert(t_uv->type == GL_FLOAT && t_uv->size >= 2);
+
+	mesh_tangent_context context;
+	size_t position_stride = t_position->stride ? t_position->stride : t_position->size * sizeof(float);
+	unsigned int index_count = index_buffer_get_element_count((index_buffer*)t_indices) / 3 * 3;
+	unsigned int i, extra_count = 0, vertex_count, result = 0;
+	unsigned int* indices = 0;
+	void* out_indices = 0;
+
+	memset(&context, 0, sizeof(context));
+	context.position = t_position;
+	context.normal = t_normal;
+	context.uv = t_uv;
+	context.vertex_count = (unsigned int)(t_position->buffer_size / position_stride);
+	context.canonical = malloc(sizeof(unsigned int) * (context.vertex_count ? context.vertex_count : 1));
+	context.corner_offsets = calloc(context.vertex_count + 1, sizeof(unsigned int));
+	context.corners = malloc(sizeof(unsigned int) * (index_count ? index_count : 1));
+	context.corner_tangents = malloc(sizeof(mesh_tangent_corner) * (index_count ? index_count : 1));
+	context.keys = malloc(sizeof(mesh_tangent_key) * (index_count ? index_count : 1));
+	context.roots = malloc(sizeof(unsigned int) * (index_count ? index_count : 1));
+	context.groups = malloc(sizeof(mesh_tangent_corner) * (index_count ? index_count : 1));
+	context.group_vertices = malloc(sizeof(unsigned int) * (index_count ? index_count : 1));
+	context.corner_vertices = malloc(sizeof(unsigned int) * (index_count ? index_count : 1));
+	context.extra_offsets = calloc(context.vertex_count + 1, sizeof(unsigned int));
+
+	if (t_indices->type == GL_UNSIGNED_INT) {
+
+		context.indices = t_indices->buffer;
+	}
+	else {
+
+		indices = malloc(sizeof(unsigned int) * (index_count ? index_count : 1));
+		for (i = 0; indices && i < index_count; ++i) {
+
+			indices[i] = t_indices->type == GL_UNSIGNED_SHORT
+				? ((const unsigned short*)t_indices->buffer)[i]
+				: ((const unsigned char*)t_indices->buffer)[i];
+		}
+		context.indices = indices;
+	}
+
+	if (!context.canonical || !context.corner_offsets || !context.corners || !context.corner_tangents || !context.keys
+		|| !context.roots || !context.groups || !context.group_vertices || !context.corner_vertices
+		|| !context.extra_offsets || !context.indices || !mesh_tangent_weld(&context)) {
+
+		goto generate_final;
+	}
+
+	for (i = 0; i < index_count; ++i) {
+
+		assert(context.indices[i] < context.vertex_count);
+		++context.corner_offsets[context.canonical[context.indices[i]] + 1];
+	}
+	for (i = 0; i < context.vertex_count; ++i) {
+
+		context.corner_offsets[i + 1] += context.corner_offsets[i];
+	}
+	for (i = 0; i < index_count; ++i) {
+
+		context.corners[context.corner_offsets[context.canonical[context.indices[i]]]++] = i;
+	}
+	for (i = context.vertex_count; i > 0; --i) {
+
+		context.corner_offsets[i] = context.corner_offsets[i - 1];
+	}
+	context.corner_offsets[0] = 0;
+
+	thread_pool_parallel_for(t_pool, index_count / 3, MESH_TANGENT_GRAIN, mesh_tangent_triangles, &context);
+	thread_pool_parallel_for(t_pool, context.vertex_count, MESH_TANGENT_GRAIN, mesh_tangent_groups, &context);
+
+	for (i = 0; i < context.vertex_count; ++i) {
+
+		unsigned int count = context.extra_offsets[i];
+		context.extra_offsets[i] = extra_count;
+		extra_count += count;
+	}
+	vertex_count = context.vertex_count + extra_count;
+	context.out = calloc((size_t)(vertex_count ? vertex_count : 1) * 4, sizeof(float));
+	context.out_remap = malloc(sizeof(unsigned int) * (vertex_count ? vertex_count : 1));
+	if (!context.out || !context.out_remap) {
+
+		goto generate_final;
+	}
+
+	thread_pool_parallel_for(t_pool, context.vertex_count, MESH_TANGENT_GRAIN, mesh_tangent_write, &context);
+	thread_pool_parallel_for(t_pool, vertex_count, MESH_TANGENT_GRAIN, mesh_tangent_vertices, &context);
+
+	/* the indices keep their type unless the further groups no longer fit it */
+	t_out_indices->type = t_indices->type;
+	if ((t_indices->type == GL_UNSIGNED_BYTE && vertex_count > 0x100) || (t_indices->type == GL_UNSIGNED_SHORT && vertex_count > 0x10000)) {
+
+		t_out_indices->type = GL_UNSIGNED_INT;
+	}
+	if (t_out_indices->type == GL_UNSIGNED_INT) {
+
+		out_indices = context.corner_vertices;
+		context.corner_vertices = 0;
+	}
+	else {
+
+		out_indices = malloc((t_out_indices->type == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : 1) * (index_count ? index_count : 1));
+		if (!out_indices) {
+
+			goto generate_final;
+		}
+		for (i = 0; i < index_count; ++i) {
+
+			if (t_out_indices->type == GL_UNSIGNED_SHORT) {
+
+				((unsigned short*)out_indices)[i] = (unsigned short)context.corner_vertices[i];
+			}
+			else {
+
+				((unsigned char*)out_indices)[i] = (unsigned char)context.corner_vertices[i];
+			}
+		}
+	}
+	t_out_indices->buffer = out_indices;
+	t_out_indices->buffer_size = (t_out_indices->type == GL_UNSIGNED_INT ? sizeof(unsigned int)
+		: (t_out_indices->type == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : 1)) * index_count;
+
+	t_out_tangent->buffer = context.out;
+	t_out_tangent->buffer_size = sizeof(float) * 4 * vertex_count;
+	t_out_tangent->size = 4;
+	t_out_tangent->type = GL_FLOAT;
+	t_out_tangent->stride = 0;
+	t_out_tangent->flags = 0;
+	*t_out_remap = context.out_remap;
+	*t_out_vertex_count = vertex_count;
+	context.out = 0;
+	context.out_remap = 0;
+	result = 1;
+
+generate_final:
+	free(context.canonical);
+	free(context.corner_offsets);
+	free(context.corners);
+	free(context.corner_tangents);
+	free(context.keys);
+	free(context.roots);
+	free(context.groups);
+	free(context.group_vertices);
+	free(context.corner_vertices);
+	free(context.extra_offsets);
+	free(context.out_remap);
+	free(context.out);
+	free(indices);
+	return result;
+}
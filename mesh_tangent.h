@@ -0,0 +1,40 @@
+/**
+ * mesh_tangent.h
+ */
+
+#ifndef GRAPHICS_UTILS_MESH_TANGENT_H
+#define GRAPHICS_UTILS_MESH_TANGENT_H
+
+#include "graphics.h"
+#include "thread_pool.h"
+
+/** generates MikkTSpace compatible tangents, the corners around each welded vertex are split into MikkTSpace's
+ *	groups of triangles connected through shared edges with matching texture orientation and every group receives
+ *	its own vertex, so vertices on mirrored or disconnected texture islands are split. triangles are processed in
+ *	parallel and every group sums its corners in index order so the result does not depend upon the thread count
+ *	@param		t_pool - an optional thread pool to process triangles and vertices across
+ *	@param		t_position - the GL_FLOAT position attribute of at least three components
+ *	@param		t_normal - the GL_FLOAT normal attribute of at least three components
+ *	@param		t_uv - the GL_FLOAT texture coordinate attribute of at least two components
+ *	@param		t_indices - the triangle list
+ *	@param		t_out_tangent - receives a malloc'd GL_FLOAT attribute of four components per output vertex, xyz is
+ *				the tangent and w is the sign of the bitangent, cross(normal, tangent) * w
+ *	@param		t_out_indices - receives a malloc'd triangle list of the output vertices, of the input type unless
+ *				the output vertices no longer fit it
+ *	@param		t_out_remap - receives a malloc'd array of the input vertex of each output vertex, the input vertices
+ *				keep their place and split vertices follow them, so other attributes are extended by copying through it
+ *	@param		t_out_vertex_count - receives the number of output vertices
+ *	@returns	nonzero if the tangents were generated
+ */
+int mesh_tangents_generate
+	( thread_pool* t_pool
+	, const vertex_attribute* t_position
+	, const vertex_attribute* t_normal
+	, const vertex_attribute* t_uv
+	, const index_buffer* t_indices
+	, vertex_attribute* t_out_tangent
+	, index_buffer* t_out_indices
+	, unsigned int** t_out_remap
+	, unsigned int* t_out_vertex_count);
+
+#endif
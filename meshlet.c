@@ -0,0 +1,394 @@
+#include "meshlet.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the score added per average edge length a candidate lies from the cluster centroid */
+#define MESHLET_COMPACTNESS 0.5f
+
+typedef struct {
+
+	unsigned int vertex_count;
+	unsigned int triangle_count;
+	unsigned int* triangles;
+	unsigned int* canonical;
+	unsigned int* adjacency_offsets;
+	unsigned int* adjacency;
+	float* normals;
+	float* centroids;
+	float spacing;
+	unsigned char* emitted;
+	unsigned int* vertex_stamps;
+	unsigned int* canonical_stamps;
+	unsigned int* candidates;
+	unsigned int candidate_capacity;
+} meshlet_state;
+
+static const float* meshlet_get_position(const vertex_attribute* t_position, unsigned int t_vertex) {
+
+	size_t stride = t_position->stride ? t_position->stride : t_position->size * sizeof(float);
+	return (const float*)((const char*)t_position->buffer + stride * t_vertex);
+}
+
+static unsigned int meshlet_read_index(const index_buffer* t_buffer, size_t t_index) {
+
+	if (t_buffer->type == GL_UNSIGNED_BYTE) {
+
+		return ((const unsigned char*)t_buffer->buffer)[t_index];
+	}
+	if (t_buffer->type == GL_UNSIGNED_SHORT) {
+
+		return ((const unsigned short*)t_buffer->buffer)[t_index];
+	}
+	return ((const unsigned int*)t_buffer->buffer)[t_index];
+}
+
+static void meshlet_write_index(index_buffer* t_buffer, size_t t_index, unsigned int t_value) {
+
+	if (t_buffer->type == GL_UNSIGNED_BYTE) {
+
+		((unsigned char*)t_buffer->buffer)[t_index] = (unsigned char)t_value;
+	}
+	else if (t_buffer->type == GL_UNSIGNED_SHORT) {
+
+		((unsigned short*)t_buffer->buffer)[t_index] = (unsigned short)t_value;
+	}
+	else {
+
+		((unsigned int*)t_buffer->buffer)[t_index] = t_value;
+	}
+}
+
+/* welds vertices by position so clusters grow across attribute seams and unwelded corner streams */
+static int meshlet_weld(meshlet_state* t_state, const vertex_attribute* t_position) {
+
+	unsigned int table_size = 1, i;
+	while (table_size < t_state->vertex_count * 2) {
+
+		table_size <<= 1;
+	}
+	unsigned int* table = malloc(sizeof(unsigned int) * table_size);
+	if (!table) {
+
+		return 0;
+	}
+	memset(table, 0xff, sizeof(unsigned int) * table_size);
+	for (i = 0; i < t_state->vertex_count; ++i) {
+
+		const float* position = meshlet_get_position(t_position, i);
+		unsigned int bits[3];
+		memcpy(bits, position, sizeof(bits));
+		unsigned int slot = ((bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u)) & (table_size - 1);
+		while (table[slot] != ~0u && memcmp(meshlet_get_position(t_position, table[slot]), position, sizeof(float) * 3)) {
+
+			slot = (slot + 1) & (table_size - 1);
+		}
+		if (table[slot] == ~0u) {
+
+			table[slot] = i;
+		}
+		t_state->canonical[i] = table[slot];
+	}
+	free(table);
+	return 1;
+}
+
+static void meshlet_compute_bounds(meshlet* t_meshlet, const meshlet_state* t_state, const vertex_attribute* t_position, const unsigned int* t_triangles) {
+
+	unsigned int triangle_count = t_meshlet->index_count / 3;
+	unsigned int i, j, k;
+
+	/* ritter's sphere, seeded from the pair of extreme points along the axis of greatest spread */
+	const float* first = meshlet_get_position(t_position, t_state->triangles[t_triangles[0] * 3]);
+	const float* minimum[3] = { first, first, first };
+	const float* maximum[3] = { first, first, first };
+	for (i = 0; i < triangle_count * 3; ++i) {
+
+		const float* position = meshlet_get_position(t_position, t_state->triangles[t_triangles[i / 3] * 3 + i % 3]);
+		for (k = 0; k < 3; ++k) {
+
+			minimum[k] = position[k] < minimum[k][k] ? position : minimum[k];
+			maximum[k] = position[k] > maximum[k][k] ? position : maximum[k];
+		}
+	}
+	float spread = -1.0f;
+	unsigned int axis = 0;
+	for (k = 0; k < 3; ++k) {
+
+		float dx = maximum[k][0] - minimum[k][0], dy = maximum[k][1] - minimum[k][1], dz = maximum[k][2] - minimum[k][2];
+		if (dx * dx + dy * dy + dz * dz > spread) {
+
+			spread = dx * dx + dy * dy + dz * dz;
+			axis = k;
+		}
+	}
+	float center[3], radius = sqrtf(spread) * 0.5f;
+	for (k = 0; k < 3; ++k) {
+
+		center[k] = (minimum[axis][k] + maximum[axis][k]) * 0.5f;
+	}
+	for (i = 0; i < triangle_count * 3; ++i) {
+
+		const float* position = meshlet_get_position(t_position, t_state->triangles[t_triangles[i / 3] * 3 + i % 3]);
+		float d[3] = { position[0] - center[0], position[1] - center[1], position[2] - center[2] };
+		float distance = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+		if (distance > radius) {
+
+			float grown = (radius + distance) * 0.5f;
+			for (k = 0; k < 3; ++k) {
+
+				center[k] += d[k] * ((grown - radius) / distance);
+			}
+			radius = grown;
+		}
+	}
+	memcpy(t_meshlet->center, center, sizeof(center));
+	t_meshlet->radius = radius;
+
+	/* the normal cone spans every triangle facing, clusters folding back past about 84 degrees are never cone culled */
+	float cone[3] = { 0.0f, 0.0f, 0.0f };
+	for (i = 0; i < triangle_count; ++i) {
+
+		for (k = 0; k < 3; ++k) {
+
+			cone[k] += t_state->normals[t_triangles[i] * 3 + k];
+		}
+	}
+	float length = sqrtf(cone[0] * cone[0] + cone[1] * cone[1] + cone[2] * cone[2]);
+	float minimum_dot = length > 0.0f ? 1.0f : -1.0f;
+	for (i = 0; i < triangle_count && length > 0.0f; ++i) {
+
+		const float* normal = t_state->normals + t_triangles[i] * 3;
+		float dot = (normal[0] * cone[0] + normal[1] * cone[1] + normal[2] * cone[2]) / length;
+		minimum_dot = dot < minimum_dot ? dot : minimum_dot;
+	}
+	for (j = 0; j < 3; ++j) {
+
+		t_meshlet->cone_axis[j] = minimum_dot > 0.1f ? cone[j] / length : 0.0f;
+	}
+	t_meshlet->cone_cutoff = minimum_dot > 0.1f ? sqrtf(1.0f - minimum_dot * minimum_dot) : 1.0f;
+}
+
+static int meshlet_push_candidates(meshlet_state* t_state, unsigned int* t_candidate_count, unsigned int t_canonical) {
+
+	unsigned int i;
+	unsigned int begin = t_state->adjacency_offsets[t_canonical], end = t_state->adjacency_offsets[t_canonical + 1];
+	if (*t_candidate_count + (end - begin) > t_state->candidate_capacity) {
+
+		unsigned int capacity = (*t_candidate_count + (end - begin)) * 2;
+		unsigned int* grown = realloc(t_state->candidates, sizeof(unsigned int) * capacity);
+		if (!grown) {
+
+			return 0;
+		}
+		t_state->candidates = grown;
+		t_state->candidate_capacity = capacity;
+	}
+	for (i = begin; i < end; ++i) {
+
+		if (!t_state->emitted[t_state->adjacency[i]]) {
+
+			t_state->candidates[(*t_candidate_count)++] = t_state->adjacency[i];
+		}
+	}
+	return 1;
+}
+
+int meshlet_build
+	( const vertex_attribute* t_position
+	, index_buffer* t_indices
+	, unsigned int t_index_offset
+	, unsigned int t_index_count
+	, meshlet** t_out_meshlets
+	, unsigned int* t_out_meshlet_count) {
+
+	assert(t_position && t_indices && t_out_meshlets && t_out_meshlet_count);
+	assert(t_position->type == GL_FLOAT && t_position->size >= 3);
+	assert(t_index_offset + t_index_count <= index_buffer_get_element_count(t_indices));
+
+	meshlet_state state;
+	size_t position_stride = t_position->stride ? t_position->stride : t_position->size * sizeof(float);
+	unsigned int triangle_count = t_index_count / 3;
+	unsigned int meshlet_capacity = triangle_count / MESHLET_MAX_TRIANGLES + 1, meshlet_count = 0;
+	unsigned int i, j, k, result = 0;
+
+	memset(&state, 0, sizeof(state));
+	state.vertex_count = (unsigned int)(t_position->buffer_size / position_stride);
+	state.triangle_count = triangle_count;
+	state.triangles = malloc(sizeof(unsigned int) * 3 * (triangle_count ? triangle_count : 1));
+	state.canonical = malloc(sizeof(unsigned int) * (state.vertex_count ? state.vertex_count : 1));
+	state.adjacency_offsets = calloc(state.vertex_count + 1, sizeof(unsigned int));
+	state.adjacency = malloc(sizeof(unsigned int) * 3 * (triangle_count ? triangle_count : 1));
+	state.normals = malloc(sizeof(float) * 3 * (triangle_count ? triangle_count : 1));
+	state.centroids = malloc(sizeof(float) * 3 * (triangle_count ? triangle_count : 1));
+	state.emitted = calloc(triangle_count ? triangle_count : 1, 1);
+	state.vertex_stamps = calloc(state.vertex_count ? state.vertex_count : 1, sizeof(unsigned int));
+	state.canonical_stamps = calloc(state.vertex_count ? state.vertex_count : 1, sizeof(unsigned int));
+	unsigned int* order = malloc(sizeof(unsigned int) * (triangle_count ? triangle_count : 1));
+	meshlet* meshlets = malloc(sizeof(meshlet) * meshlet_capacity);
+
+	if (!state.triangles || !state.canonical || !state.adjacency_offsets || !state.adjacency ||  !state.normals || !state.centroids
+		|| !state.emitted || !state.vertex_stamps || !state.canonical_stamps || !order || !meshlets
+		|| !meshlet_weld(&state, t_position)) {
+
+		goto build_final;
+	}
+
+	for (i = 0; i < triangle_count * 3; ++i) {
+
+		state.triangles[i] = meshlet_read_index(t_indices, t_index_offset + i);
+		assert(state.triangles[i] < state.vertex_count);
+		++state.adjacency_offsets[state.canonical[state.triangles[i]] + 1];
+	}
+	for (i = 0; i < state.vertex_count; ++i) {
+
+		state.adjacency_offsets[i + 1] += state.adjacency_offsets[i];
+	}
+	for (i = 0; i < triangle_count * 3; ++i) {
+
+		state.adjacency[state.adjacency_offsets[state.canonical[state.triangles[i]]]++] = i / 3;
+	}
+	for (i = state.vertex_count; i > 0; --i) {
+
+		state.adjacency_offsets[i] = state.adjacency_offsets[i - 1];
+	}
+	state.adjacency_offsets[0] = 0;
+
+	for (i = 0; i < triangle_count; ++i) {
+
+		const float* a = meshlet_get_position(t_position, state.triangles[i * 3]);
+		const float* b = meshlet_get_position(t_position, state.triangles[i * 3 + 1]);
+		const float* c = meshlet_get_position(t_position, state.triangles[i * 3 + 2]);
+		float e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		float e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		float normal[3] = { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0] };
+		float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		for (k = 0; k < 3; ++k) {
+
+			state.normals[i * 3 + k] = length > 0.0f ? normal[k] / length : 0.0f;
+			state.centroids[i * 3 + k] = (a[k] + b[k] + c[k]) / 3.0f;
+		}
+		state.spacing += sqrtf(e0[0] * e0[0] + e0[1] * e0[1] + e0[2] * e0[2]);
+	}
+	state.spacing = triangle_count && state.spacing > 0.0f ? state.spacing / triangle_count : 1.0f;
+
+	/* clusters grow greedily from the first unemitted triangle through position adjacency, preferring
+	 * triangles which add the fewest vertices, then those facing along and lying near the cluster */
+	unsigned int cursor = 0, emitted = 0;
+	while (emitted < triangle_count) {
+
+		while (state.emitted[cursor]) {
+
+			++cursor;
+		}
+		if (meshlet_count == meshlet_capacity) {
+
+			meshlet* grown = realloc(meshlets, sizeof(meshlet) * meshlet_capacity * 2);
+			if (!grown) {
+
+				goto build_final;
+			}
+			meshlets = grown;
+			meshlet_capacity *= 2;
+		}
+
+		unsigned int stamp = meshlet_count + 1, candidate_count = 0, vertex_count = 0, first = emitted;
+		float cone[3] = { 0.0f, 0.0f, 0.0f }, centroid[3] = { 0.0f, 0.0f, 0.0f };
+		unsigned int next = cursor;
+		while (next != ~0u) {
+
+			state.emitted[next] = 1;
+			order[emitted++] = next;
+			for (k = 0; k < 3; ++k) {
+
+				unsigned int vertex = state.triangles[next * 3 + k];
+				cone[k] += state.normals[next * 3 + k];
+				centroid[k] += state.centroids[next * 3 + k];
+				if (state.vertex_stamps[vertex] != stamp) {
+
+					state.vertex_stamps[vertex] = stamp;
+					++vertex_count;
+				}
+				if (state.canonical_stamps[state.canonical[vertex]] != stamp) {
+
+					state.canonical_stamps[state.canonical[vertex]] = stamp;
+					if (!meshlet_push_candidates(&state, &candidate_count, state.canonical[vertex])) {
+
+						goto build_final;
+					}
+				}
+			}
+			if (emitted - first == MESHLET_MAX_TRIANGLES) {
+
+				break;
+			}
+
+			float best_score = 0.0f;
+			next = ~0u;
+			for (j = 0; j < candidate_count; ) {
+
+				unsigned int candidate = state.candidates[j];
+				if (state.emitted[candidate]) {
+
+					state.candidates[j] = state.candidates[--candidate_count];
+					continue;
+				}
+				unsigned int added = 0;
+				for (k = 0; k < 3; ++k) {
+
+					added += state.vertex_stamps[state.triangles[candidate * 3 + k]] != stamp;
+				}
+				const float* normal = state.normals + candidate * 3;
+				const float* position = state.centroids + candidate * 3;
+				float size = (float)(emitted - first);
+				float d[3] = { position[0] - centroid[0] / size, position[1] - centroid[1] / size, position[2] - centroid[2] / size };
+				float score = (float)added
+					+ 0.5f * (1.0f - (normal[0] * cone[0] + normal[1] * cone[1] + normal[2] * cone[2])
+						/ (sqrtf(cone[0] * cone[0] + cone[1] * cone[1] + cone[2] * cone[2]) + 1e-20f))
+					+ MESHLET_COMPACTNESS * sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) / state.spacing;
+				if (vertex_count + added <= MESHLET_MAX_VERTICES && (next == ~0u || score < best_score)) {
+
+					best_score = score;
+					next = candidate;
+				}
+				++j;
+			}
+		}
+
+		meshlet* cluster = meshlets + meshlet_count++;
+		cluster->index_offset = t_index_offset + first * 3;
+		cluster->index_count = (emitted - first) * 3;
+		cluster->vertex_count = vertex_count;
+		meshlet_compute_bounds(cluster, &state, t_position, order + first);
+	}
+
+	for (i = 0; i < triangle_count * 3; ++i) {
+
+		meshlet_write_index(t_indices, t_index_offset + i, state.triangles[order[i / 3] * 3 + i % 3]);
+	}
+	result = 1;
+
+build_final:
+	if (!result) {
+
+		free(meshlets);
+		meshlets = 0;
+		meshlet_count = 0;
+	}
+	*t_out_meshlets = meshlets;
+	*t_out_meshlet_count = meshlet_count;
+	free(state.triangles);
+	free(state.canonical);
+	free(state.adjacency_offsets);
+	free(state.adjacency);
+	free(state.normals);
+	free(state.centroids);
+	free(state.emitted);
+	free(state.vertex_stamps);
+	free(state.canonical_stamps);
+	free(state.candidates);
+	free(order);
+	return result;
+}
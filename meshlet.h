@@ -0,0 +1,33 @@
+/**
+ * meshlet.h
+ */
+
+#ifndef GRAPHICS_UTILS_MESHLET_H
+#define GRAPHICS_UTILS_MESHLET_H
+
+#include "graphics.h"
+
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+/** partitions a range of a triangle list into clusters of at most MESHLET_MAX_VERTICES vertices and
+ *	MESHLET_MAX_TRIANGLES triangles, the range is reordered in place so every cluster is a contiguous
+ *	range suitable for mesh_render_part, and so it must be built before the indices are given to init_mesh
+ *	@memberof	meshlet
+ *	@param		t_position - the GL_FLOAT position attribute of at least three components
+ *	@param		t_indices - the triangle list to partition and reorder
+ *	@param		t_index_offset - the offset of the first index of the range, such as a level of detail
+ *	@param		t_index_count - the count of indices in the range
+ *	@param		t_out_meshlets - receives a malloc'd array of clusters in index order
+ *	@param		t_out_meshlet_count - receives the number of clusters
+ *	@returns	nonzero if the clusters were built
+ */
+int meshlet_build
+	( const vertex_attribute* t_position
+	, index_buffer* t_indices
+	, unsigned int t_index_offset
+	, unsigned int t_index_count
+	, meshlet** t_out_meshlets
+	, unsigned int* t_out_meshlet_count);
+
+#endif
@@ -0,0 +1,94 @@
+#include "simd.h"
+
+#if SIMD_X86_DISPATCH
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if SIMD_X86_DISPATCH
+static void simd_cpuid(int t_leaf, int t_subleaf, unsigned int t_out_registers[4]) {
+
+#if defined(_MSC_VER)
+	int registers[4];
+	__cpuidex(registers, t_leaf, t_subleaf);
+	t_out_registers[0] = (unsigned int)registers[0];
+	t_out_registers[1] = (unsigned int)registers[1];
+	t_out_registers[2] = (unsigned int)registers[2];
+	t_out_registers[3] = (unsigned int)registers[3];
+#else
+	__cpuid_count(t_leaf, t_subleaf, t_out_registers[0], t_out_registers[1], t_out_registers[2], t_out_registers[3]);
+#endif
+}
+
+static unsigned long long simd_xgetbv() {
+
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	unsigned int eax;
+	unsigned int edx;
+	__asm__ volatile ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+
+static unsigned int simd_detect_features() {
+
+	unsigned int registers[4];
+	unsigned int features = SIMD_FEATURE_SSE2;
+	unsigned int max_leaf;
+
+	simd_cpuid(0, 0, registers);
+	max_leaf = registers[0];
+
+	simd_cpuid(1, 0, registers);
+	if (registers[2] & (1u << 9)) {
+
+		features |= SIMD_FEATURE_SSSE3;
+	}
+	if (registers[2] & (1u << 19)) {
+
+		features |= SIMD_FEATURE_SSE41;
+	}
+	if (registers[2] & (1u << 1)) {
+
+		features |= SIMD_FEATURE_PCLMUL;
+	}
+
+	/* avx2 additionally requires the os to save the ymm registers */
+	if (max_leaf >= 7 && (registers[2] & (1u << 27)) && (registers[2] & (1u << 28)) && (simd_xgetbv() & 0x6) == 0x6) {
+
+		simd_cpuid(7, 0, registers);
+		if (registers[1] & (1u << 5)) {
+
+			features |= SIMD_FEATURE_AVX2;
+		}
+	}
+
+	return features;
+}
+#endif
+
+unsigned int simd_get_features() {
+
+#if SIMD_X86_DISPATCH
+	/* detection is idempotent, so a racing first call at worst detects twice */
+	static volatile int s_is_detected = 0;
+	static volatile unsigned int s_features = 0;
+
+	if (!s_is_detected) {
+
+		s_features = simd_detect_features();
+		s_is_detected = 1;
+	}
+
+	return s_features;
+#elif SIMD_SSE2
+	return SIMD_FEATURE_SSE2;
+#else
+	return 0;
+#endif
+}
@@ -0,0 +1,40 @@
+/**
+ * simd.h
+ */
+
+#ifndef GRAPHICS_UTILS_SIMD_H
+#define GRAPHICS_UTILS_SIMD_H
+
+/* SSE2 is the baseline of every x86-64 target, wider instruction sets are selected at runtime */
+#if !defined(SIMD_NO_SSE2) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SIMD_SSE2 1
+#include <emmintrin.h>
+#else
+#define SIMD_SSE2 0
+#endif
+
+#if SIMD_SSE2 && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#define SIMD_X86_DISPATCH 1
+#include <immintrin.h>
+#else
+#define SIMD_X86_DISPATCH 0
+#endif
+
+/* marks a function as compiled for an instruction set beyond the baseline */
+#if SIMD_X86_DISPATCH && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_TARGET(T_TARGET) __attribute__((target(T_TARGET)))
+#else
+#define SIMD_TARGET(T_TARGET)
+#endif
+
+#define SIMD_FEATURE_SSE2 0x01
+#define SIMD_FEATURE_SSSE3 0x02
+#define SIMD_FEATURE_SSE41 0x04
+#define SIMD_FEATURE_AVX2 0x08
+#define SIMD_FEATURE_PCLMUL 0x10
+
+/** returns the SIMD_FEATURE flags supported by the executing cpu
+ */
+unsigned int simd_get_features();
+
+#endif
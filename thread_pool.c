@@ -0,0 +1,500 @@
+#include "thread_pool.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION thread_pool_mutex;
+typedef CONDITION_VARIABLE thread_pool_condition;
+typedef HANDLE thread_pool_thread;
+#define THREAD_POOL_MUTEX_INIT(T_MUTEX) InitializeCriticalSection(T_MUTEX)
+#define THREAD_POOL_MUTEX_FINAL(T_MUTEX) DeleteCriticalSection(T_MUTEX)
+#define THREAD_POOL_LOCK(T_MUTEX) EnterCriticalSection(T_MUTEX)
+#define THREAD_POOL_UNLOCK(T_MUTEX) LeaveCriticalSection(T_MUTEX)
+#define THREAD_POOL_CONDITION_INIT(T_CONDITION) InitializeConditionVariable(T_CONDITION)
+#define THREAD_POOL_CONDITION_FINAL(T_CONDITION) ((void)(T_CONDITION))
+#define THREAD_POOL_WAIT(T_CONDITION, T_MUTEX) SleepConditionVariableCS(T_CONDITION, T_MUTEX, INFINITE)
+#define THREAD_POOL_BROADCAST(T_CONDITION) WakeAllConditionVariable(T_CONDITION)
+#else
+typedef pthread_mutex_t thread_pool_mutex;
+typedef pthread_cond_t thread_pool_condition;
+typedef pthread_t thread_pool_thread;
+#define THREAD_POOL_MUTEX_INIT(T_MUTEX) pthread_mutex_init(T_MUTEX, 0)
+#define THREAD_POOL_MUTEX_FINAL(T_MUTEX) pthread_mutex_destroy(T_MUTEX)
+#define THREAD_POOL_LOCK(T_MUTEX) pthread_mutex_lock(T_MUTEX)
+#define THREAD_POOL_UNLOCK(T_MUTEX) pthread_mutex_unlock(T_MUTEX)
+#define THREAD_POOL_CONDITION_INIT(T_CONDITION) pthread_cond_init(T_CONDITION, 0)
+#define THREAD_POOL_CONDITION_FINAL(T_CONDITION) pthread_cond_destroy(T_CONDITION)
+#define THREAD_POOL_WAIT(T_CONDITION, T_MUTEX) pthread_cond_wait(T_CONDITION, T_MUTEX)
+#define THREAD_POOL_BROADCAST(T_CONDITION) pthread_cond_broadcast(T_CONDITION)
+#endif
+
+typedef struct {
+
+	thread_pool_function function;
+	void* context;
+	thread_pool_group* group;
+} thread_pool_job;
+
+typedef struct {
+
+	thread_pool_mutex mutex;
+	thread_pool_condition job_available;
+	thread_pool_condition job_completed;
+	thread_pool_thread* threads;
+	thread_pool_job* jobs;
+	size_t job_capacity;
+	size_t job_head;
+	size_t job_count;
+	int is_stopping;
+} thread_pool_internal;
+
+unsigned int thread_pool_get_hardware_concurrency() {
+
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors ? (unsigned int)info.dwNumberOfProcessors : 1;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (unsigned int)count : 1;
+#endif
+}
+
+size_t thread_pool_load_acquire(const volatile size_t* t_value) {
+
+#ifdef _MSC_VER
+	size_t value = *t_value;
+	MemoryBarrier();
+	return value;
+#else
+	return __atomic_load_n(t_value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+void thread_pool_store_release(volatile size_t* t_value, size_t t_new_value) {
+
+#ifdef _MSC_VER
+	MemoryBarrier();
+	*t_value = t_new_value;
+#else
+	__atomic_store_n(t_value, t_new_value, __ATOMIC_RELEASE);
+#endif
+}
+
+size_t thread_pool_exchange(volatile size_t* t_value, size_t t_new_value) {
+
+#ifdef _WIN32
+	return (size_t)InterlockedExchangePointer((PVOID volatile*)t_value, (PVOID)t_new_value);
+#else
+	return __atomic_exchange_n(t_value, t_new_value, __ATOMIC_ACQ_REL);
+#endif
+}
+
+typedef struct {
+
+	thread_pool_mutex mutex;
+	thread_pool_condition signalled;
+} thread_pool_event_internal;
+
+int init_thread_pool_event(thread_pool_event* t_event) {
+
+	assert(t_event);
+
+	thread_pool_event_internal* internal = malloc(sizeof(thread_pool_event_internal));
+	if (!internal) {
+
+		return 0;
+	}
+	THREAD_POOL_MUTEX_INIT(&internal->mutex);
+	THREAD_POOL_CONDITION_INIT(&internal->signalled);
+	t_event->count = 0;
+	t_event->internal = internal;
+	return 1;
+}
+
+void final_thread_pool_event(thread_pool_event* t_event) {
+
+	assert(t_event);
+
+	thread_pool_event_internal* internal = (thread_pool_event_internal*)t_event->internal;
+	THREAD_POOL_CONDITION_FINAL(&internal->signalled);
+	THREAD_POOL_MUTEX_FINAL(&internal->mutex);
+	free(internal);
+	t_event->internal = 0;
+}
+
+size_t thread_pool_event_get_count(thread_pool_event* t_event) {
+
+	return thread_pool_load_acquire(&t_event->count);
+}
+
+void thread_pool_event_signal(thread_pool_event* t_event) {
+
+	thread_pool_event_internal* internal = (thread_pool_event_internal*)t_event->internal;
+	THREAD_POOL_LOCK(&internal->mutex);
+	thread_pool_store_release(&t_event->count, t_event->count + 1);
+	THREAD_POOL_BROADCAST(&internal->signalled);
+	THREAD_POOL_UNLOCK(&internal->mutex);
+}
+
+void thread_pool_event_wait(thread_pool_event* t_event, size_t t_count) {
+
+	thread_pool_event_internal* internal = (thread_pool_event_internal*)t_event->internal;
+	THREAD_POOL_LOCK(&internal->mutex);
+	while (t_event->count == t_count) {
+
+		THREAD_POOL_WAIT(&internal->signalled, &internal->mutex);
+	}
+	THREAD_POOL_UNLOCK(&internal->mutex);
+}
+
+/* must be called with the mutex held */
+static int thread_pool_pop(thread_pool_internal* t_internal, thread_pool_job* t_out_job) {
+
+	if (!t_internal->job_count) {
+
+		return 0;
+	}
+
+	*t_out_job = t_internal->jobs[t_internal->job_head];
+	t_internal->job_head = (t_internal->job_head + 1) % t_internal->job_capacity;
+	--t_internal->job_count;
+
+	return 1;
+}
+
+/* runs a popped job, must be called without the mutex held */
+static void thread_pool_run(thread_pool_internal* t_internal, thread_pool_job* t_job) {
+
+	t_job->function(t_job->context);
+
+	THREAD_POOL_LOCK(&t_internal->mutex);
+	if (t_job->group) {
+
+		--t_job->group->remaining;
+	}
+	THREAD_POOL_BROADCAST(&t_internal->job_completed);
+	THREAD_POOL_UNLOCK(&t_internal->mutex);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI thread_pool_worker(LPVOID t_argument) {
+#else
+static void* thread_pool_worker(void* t_argument) {
+#endif
+
+	thread_pool_internal* internal = (thread_pool_internal*)t_argument;
+	thread_pool_job job;
+
+	THREAD_POOL_LOCK(&internal->mutex);
+	for (;;) {
+
+		if (thread_pool_pop(internal, &job)) {
+
+			THREAD_POOL_UNLOCK(&internal->mutex);
+			thread_pool_run(internal, &job);
+			THREAD_POOL_LOCK(&internal->mutex);
+			continue;
+		}
+		if (internal->is_stopping) {
+
+			break;
+		}
+		THREAD_POOL_WAIT(&internal->job_available, &internal->mutex);
+	}
+	THREAD_POOL_UNLOCK(&internal->mutex);
+
+	return 0;
+}
+
+int init_thread_pool(thread_pool* t_pool, unsigned int t_thread_count) {
+
+	assert(t_pool);
+
+	unsigned int i;
+	thread_pool_internal* internal;
+
+	if (!t_thread_count) {
+
+		t_thread_count = thread_pool_get_hardware_concurrency();
+	}
+
+	internal = calloc(1, sizeof(thread_pool_internal));
+	if (!internal) {
+
+		return 0;
+	}
+	internal->threads = calloc(t_thread_count, sizeof(thread_pool_thread));
+	internal->job_capacity = 64;
+	internal->jobs = malloc(sizeof(thread_pool_job) * internal->job_capacity);
+	if (!internal->threads || !internal->jobs) {
+
+		free(internal->threads);
+		free(internal->jobs);
+		free(internal);
+		return 0;
+	}
+
+	THREAD_POOL_MUTEX_INIT(&internal->mutex);
+	THREAD_POOL_CONDITION_INIT(&internal->job_available);
+	THREAD_POOL_CONDITION_INIT(&internal->job_completed);
+
+	t_pool->internal = internal;
+	t_pool->thread_count = 0;
+	for (i = 0; i < t_thread_count; ++i) {
+
+#ifdef _WIN32
+		internal->threads[i] = CreateThread(0, 0, thread_pool_worker, internal, 0, 0);
+		if (!internal->threads[i]) {
+
+			break;
+		}
+#else
+		if (pthread_create(&internal->threads[i], 0, thread_pool_worker, internal)) {
+
+			break;
+		}
+#endif
+		++t_pool->thread_count;
+	}
+
+	if (!t_pool->thread_count) {
+
+		final_thread_pool(t_pool);
+		return 0;
+	}
+
+	return 1;
+}
+
+void final_thread_pool(thread_pool* t_pool) {
+
+	assert(t_pool && t_pool->internal);
+
+	unsigned int i;
+	thread_pool_internal* internal = (thread_pool_internal*)t_pool->internal;
+
+	THREAD_POOL_LOCK(&internal->mutex);
+	internal->is_stopping = 1;
+	THREAD_POOL_BROADCAST(&internal->job_available);
+	THREAD_POOL_UNLOCK(&internal->mutex);
+
+	for (i = 0; i < t_pool->thread_count; ++i) {
+
+#ifdef _WIN32
+		WaitForSingleObject(internal->threads[i], INFINITE);
+		CloseHandle(internal->threads[i]);
+#else
+		pthread_join(internal->threads[i], 0);
+#endif
+	}
+
+	THREAD_POOL_CONDITION_FINAL(&internal->job_available);
+	THREAD_POOL_CONDITION_FINAL(&internal->job_completed);
+	THREAD_POOL_MUTEX_FINAL(&internal->mutex);
+
+	free(internal->threads);
+	free(internal->jobs);
+	free(internal);
+
+	t_pool->internal = 0;
+	t_pool->thread_count = 0;
+}
+
+int thread_pool_push(thread_pool* t_pool, thread_pool_group* t_group, thread_pool_function t_function, void* t_context) {
+
+	assert(t_function);
+
+	thread_pool_internal* internal;
+	thread_pool_job job;
+
+	if (!t_pool) {
+
+		t_function(t_context);
+		return 1;
+	}
+
+	internal = (thread_pool_internal*)t_pool->internal;
+	job.function = t_function;
+	job.context = t_context;
+	job.group = t_group;
+
+	THREAD_POOL_LOCK(&internal->mutex);
+	if (internal->job_count == internal->job_capacity) {
+
+		size_t i;
+		size_t capacity = internal->job_capacity * 2;
+		thread_pool_job* jobs = malloc(sizeof(thread_pool_job) * capacity);
+		if (!jobs) {
+
+			THREAD_POOL_UNLOCK(&internal->mutex);
+			return 0;
+		}
+		for (i = 0; i < internal->job_count; ++i) {
+
+			jobs[i] = internal->jobs[(internal->job_head + i) % internal->job_capacity];
+		}
+		free(internal->jobs);
+		internal->jobs = jobs;
+		internal->job_capacity = capacity;
+		internal->job_head = 0;
+	}
+	internal->jobs[(internal->job_head + internal->job_count) % internal->job_capacity] = job;
+	++internal->job_count;
+	if (t_group) {
+
+		++t_group->remaining;
+	}
+	THREAD_POOL_BROADCAST(&internal->job_available);
+	THREAD_POOL_UNLOCK(&internal->mutex);
+
+	return 1;
+}
+
+void thread_pool_wait(thread_pool* t_pool, thread_pool_group* t_group) {
+
+	assert(t_group);
+
+	thread_pool_internal* internal;
+	thread_pool_job job;
+
+	if (!t_pool) {
+
+		return;
+	}
+
+	internal = (thread_pool_internal*)t_pool->internal;
+
+	THREAD_POOL_LOCK(&internal->mutex);
+	while (t_group->remaining) {
+
+		if (thread_pool_pop(internal, &job)) {
+
+			THREAD_POOL_UNLOCK(&internal->mutex);
+			thread_pool_run(internal, &job);
+			THREAD_POOL_LOCK(&internal->mutex);
+			continue;
+		}
+		THREAD_POOL_WAIT(&internal->job_completed, &internal->mutex);
+	}
+	THREAD_POOL_UNLOCK(&internal->mutex);
+}
+
+int thread_pool_is_done(thread_pool* t_pool, thread_pool_group* t_group) {
+
+	assert(t_group);
+
+	thread_pool_internal* internal;
+	int done;
+
+	if (!t_pool) {
+
+		return !t_group->remaining;
+	}
+
+	internal = (thread_pool_internal*)t_pool->internal;
+
+	/* remaining is only changed under the mutex, so reading it there sees the writes of the completed jobs */
+	THREAD_POOL_LOCK(&internal->mutex);
+	done = !t_group->remaining;
+	THREAD_POOL_UNLOCK(&internal->mutex);
+	return done;
+}
+
+typedef struct {
+
+	thread_pool_range_function function;
+	void* context;
+	size_t count;
+	size_t grain;
+	volatile long next;
+	thread_pool_mutex mutex;
+} thread_pool_parallel_for_state;
+
+static void thread_pool_parallel_for_job(void* t_context) {
+
+	thread_pool_parallel_for_state* state = (thread_pool_parallel_for_state*)t_context;
+	size_t range;
+	size_t begin;
+	size_t end;
+
+	/* ranges are claimed dynamically so that a slow range does not stall a whole worker's share */
+	for (;;) {
+
+		THREAD_POOL_LOCK(&state->mutex);
+		range = (size_t)state->next++;
+		THREAD_POOL_UNLOCK(&state->mutex);
+
+		begin = range * state->grain;
+		if (begin >= state->count) {
+
+			break;
+		}
+		end = begin + state->grain < state->count ? begin + state->grain : state->count;
+		state->function(state->context, begin, end);
+	}
+}
+
+void thread_pool_parallel_for
+	( thread_pool* t_pool
+	, size_t t_count
+	, size_t t_grain
+	, thread_pool_range_function t_function
+	, void* t_context) {
+
+	assert(t_function);
+
+	size_t i;
+	size_t range_count;
+	size_t job_count;
+	thread_pool_group group = { 0 };
+	thread_pool_parallel_for_state state;
+
+	if (!t_count) {
+
+		return;
+	}
+	if (!t_grain) {
+
+		t_grain = 1;
+	}
+
+	range_count = (t_count + t_grain - 1) / t_grain;
+	if (!t_pool || range_count == 1) {
+
+		for (i = 0; i < t_count; i += t_grain) {
+
+			t_function(t_context, i, i + t_grain < t_count ? i + t_grain : t_count);
+		}
+		return;
+	}
+
+	state.function = t_function;
+	state.context = t_context;
+	state.count = t_count;
+	state.grain = t_grain;
+	state.next = 0;
+	THREAD_POOL_MUTEX_INIT(&state.mutex);
+
+	/* one job per worker, the calling thread joins in through thread_pool_wait */
+	job_count = range_count < t_pool->thread_count ? range_count : t_pool->thread_count;
+	for (i = 0; i < job_count; ++i) {
+
+		if (!thread_pool_push(t_pool, &group, thread_pool_parallel_for_job, &state)) {
+
+			break;
+		}
+	}
+	thread_pool_parallel_for_job(&state);
+	thread_pool_wait(t_pool, &group);
+
+	THREAD_POOL_MUTEX_FINAL(&state.mutex);
+}
@@ -0,0 +1,165 @@
+/**
+ * thread_pool.h
+ */
+
+#ifndef GRAPHICS_UTILS_THREAD_POOL_H
+#define GRAPHICS_UTILS_THREAD_POOL_H
+
+#include <stddef.h>
+
+/** a job function pushed to a thread pool
+ *	@param		t_context - the user context given alongside the job
+ */
+typedef void (*thread_pool_function)(void* t_context);
+
+/** a range function used by thread_pool_parallel_for
+ *	@param		t_context - the user context given to thread_pool_parallel_for
+ *	@param		t_begin - the first index of the range to process
+ *	@param		t_end - one past the last index of the range to process
+ */
+typedef void (*thread_pool_range_function)(void* t_context, size_t t_begin, size_t t_end);
+
+/**	@struct		thread_pool_group
+ *	@brief		a counter of outstanding jobs which can be waited upon
+ *	@member		thread_pool_group::remaining - the number of jobs in the group yet to complete
+ */
+typedef struct {
+
+	volatile long remaining;
+} thread_pool_group;
+
+/**	@struct		thread_pool_event
+ *	@brief		a count of signals which threads can block upon until it moves
+ *	@member		thread_pool_event::count - the number of signals so far
+ *	@member		thread_pool_event::internal - the platform specific lock and condition
+ */
+typedef struct {
+
+	volatile size_t count;
+	void* internal;
+} thread_pool_event;
+
+/**	@struct		thread_pool
+ *	@brief		a fixed set of worker threads consuming a shared job queue
+ *	@member		thread_pool::thread_count - the number of worker threads
+ *	@member		thread_pool::internal - the platform specific queue and thread state
+ */
+typedef struct {
+
+	unsigned int thread_count;
+	void* internal;
+} thread_pool;
+
+/** returns the number of hardware threads available to the process
+ */
+unsigned int thread_pool_get_hardware_concurrency();
+
+/** reads a value published by another thread with thread_pool_store_release, reads and writes after
+ *	this are not moved before it, so everything written before the publishing store is visible
+ *	@param		t_value - the shared value
+ *	@returns	the current value
+ */
+size_t thread_pool_load_acquire(const volatile size_t* t_value);
+
+/** publishes a value to other threads, reads and writes before this are not moved after it
+ *	@param		t_value - the shared value
+ *	@param		t_new_value - the value to store
+ */
+void thread_pool_store_release(volatile size_t* t_value, size_t t_new_value);
+
+/** stores a value and returns the one it replaced in a single step, reads and writes are not moved across it
+ *	@param		t_value - the shared value
+ *	@param		t_new_value - the value to store
+ *	@returns	the previous value
+ */
+size_t thread_pool_exchange(volatile size_t* t_value, size_t t_new_value);
+
+/** initializes an event with a count of 0
+ *	@memberof	thread_pool_event
+ *	@param		t_event - an invalid event to be initialized
+ *	@returns	nonzero if initialized successfully
+ */
+int init_thread_pool_event(thread_pool_event* t_event);
+
+/** finalizes an event, no thread may be waiting upon it
+ *	@memberof	thread_pool_event
+ *	@param		t_event - a valid event to be finalized
+ */
+void final_thread_pool_event(thread_pool_event* t_event);
+
+/** returns the count of an event, to wait upon until it moves after checking for work
+ *	@memberof	thread_pool_event
+ *	@param		t_event - a valid event
+ *	@returns	the number of signals so far
+ */
+size_t thread_pool_event_get_count(thread_pool_event* t_event);
+
+/** increments the count of an event, waking every thread waiting upon it
+ *	@memberof	thread_pool_event
+ *	@param		t_event - a valid event
+ */
+void thread_pool_event_signal(thread_pool_event* t_event);
+
+/** blocks until the count of an event differs from one read earlier, so signals after that read are not missed
+ *	@memberof	thread_pool_event
+ *	@param		t_event - a valid event
+ *	@param		t_count - the count read with thread_pool_event_get_count
+ */
+void thread_pool_event_wait(thread_pool_event* t_event, size_t t_count);
+
+/** initializes a thread pool
+ *	@memberof	thread_pool
+ *	@param		t_pool - an invalid thread pool to be initialized
+ *	@param		t_thread_count - the number of workers, or 0 to use the hardware concurrency
+ *	@returns	nonzero if initialized successfully
+ */
+int init_thread_pool(thread_pool* t_pool, unsigned int t_thread_count);
+
+/** finalizes a thread pool, completing all queued jobs first
+ *	@memberof	thread_pool
+ *	@param		t_pool - a valid thread pool to be finalized
+ */
+void final_thread_pool(thread_pool* t_pool);
+
+/** pushes a job onto the thread pool queue
+ *	@memberof	thread_pool
+ *	@param		t_pool - a valid thread pool, or 0 to run the job immediately on the calling thread
+ *	@param		t_group - an optional group to count the job against
+ *	@param		t_function - the job function
+ *	@param		t_context - the context passed to the job function
+ *	@returns	nonzero if the job was queued or run
+ */
+int thread_pool_push(thread_pool* t_pool, thread_pool_group* t_group, thread_pool_function t_function, void* t_context);
+
+/** waits for every job in a group to complete, running queued jobs on the calling thread meanwhile
+ *	@memberof	thread_pool
+ *	@param		t_pool - a valid thread pool, or 0
+ *	@param		t_group - the group to wait upon
+ */
+void thread_pool_wait(thread_pool* t_pool, thread_pool_group* t_group);
+
+/** checks whether every job in a group has completed, without waiting
+ *	@memberof	thread_pool
+ *	@param		t_pool - a valid thread pool, or 0
+ *	@param		t_group - the group to check
+ *	@returns	nonzero if no job in the group is outstanding
+ */
+int thread_pool_is_done(thread_pool* t_pool, thread_pool_group* t_group);
+
+/** splits [0, t_count) into t_grain sized ranges and processes them across the pool, the split
+ *	depends only upon t_count and t_grain so results are independent of the thread count
+ *	@memberof	thread_pool
+ *	@param		t_pool - a valid thread pool, or 0 to process every range on the calling thread
+ *	@param		t_count - the number of indices to process
+ *	@param		t_grain - the number of indices per range
+ *	@param		t_function - the range function
+ *	@param		t_context - the context passed to the range function
+ */
+void thread_pool_parallel_for
+	( thread_pool* t_pool
+	, size_t t_count
+	, size_t t_grain
+	, thread_pool_range_function t_function
+	, void* t_context);
+
+#endif